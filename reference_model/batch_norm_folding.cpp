@@ -0,0 +1,230 @@
+#include "batch_norm_folding.h"
+#include <algorithm> // For std::max, std::min
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+ChannelAffine batch_norm_to_affine(const BatchNormParameters &batch_norm)
+{
+    size_t channels = batch_norm.gamma.size();
+    if (batch_norm.beta.size() != channels || batch_norm.mean.size() != channels || batch_norm.variance.size() != channels)
+    {
+        throw std::runtime_error("Batch norm parameters must all have one value per channel.");
+    }
+
+    ChannelAffine affine;
+    affine.scale.resize(channels);
+    affine.shift.resize(channels);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        if (batch_norm.variance[c] + batch_norm.epsilon <= 0.0f)
+        {
+            throw std::runtime_error("Batch norm variance + epsilon must be positive.");
+        }
+        affine.scale[c] = batch_norm.gamma[c] / std::sqrt(batch_norm.variance[c] + batch_norm.epsilon);
+        affine.shift[c] = batch_norm.beta[c] - batch_norm.mean[c] * affine.scale[c];
+    }
+    return affine;
+}
+
+static void validate_affine(const ChannelAffine &affine, int output_channels)
+{
+    if (affine.scale.size() != static_cast<size_t>(output_channels) ||
+        affine.shift.size() != static_cast<size_t>(output_channels))
+    {
+        throw std::runtime_error("Folded parameters must have one value per output channel.");
+    }
+}
+
+ConvolutionLayer fold_affine(const ConvolutionLayer &layer, const ChannelAffine &affine)
+{
+    validate_affine(affine, layer.output_channels());
+
+    const size_t filter_size = static_cast<size_t>(layer.input_channels()) * layer.kernel_size() * layer.kernel_size();
+    std::shared_ptr<float> weights(new float[layer.packed_weight_count()], std::default_delete<float[]>());
+    std::vector<float> bias(layer.output_channels());
+    for (int out_c = 0; out_c < layer.output_channels(); ++out_c)
+    {
+        const float scale = affine.scale[out_c];
+        const float *source = layer.packed_weights() + out_c * filter_size;
+        float *destination = weights.get() + out_c * filter_size;
+        for (size_t i = 0; i < filter_size; ++i)
+        {
+            destination[i] = source[i] * scale;
+        }
+        float old_bias = layer.bias().empty() ? 0.0f : layer.bias()[out_c];
+        bias[out_c] = old_bias * scale + affine.shift[out_c];
+    }
+
+    ConvolutionLayer folded = ConvolutionLayer::from_packed_weights(
+        layer.kernel_size(),
+        layer.stride(),
+        layer.padding_mode(),
+        layer.input_channels(),
+        layer.output_channels(),
+        weights);
+    folded.set_bias(bias);
+    folded.set_reduction_order(layer.reduction_order());
+    folded.set_border_mode(layer.border_mode());
+    if (layer.has_explicit_padding())
+    {
+        folded.set_explicit_padding(layer.explicit_padding());
+    }
+    return folded;
+}
+
+ConvolutionLayer fold_batch_norm(const ConvolutionLayer &layer, const BatchNormParameters &batch_norm)
+{
+    return fold_affine(layer, batch_norm_to_affine(batch_norm));
+}
+
+FixedPointLayer fold_affine_fixed_point(const FixedPointLayer &layer, const ChannelAffine &affine)
+{
+    validate_affine(affine, layer.output_channels);
+
+    const size_t filter_size = static_cast<size_t>(layer.input_channels) * layer.kernel_size * layer.kernel_size;
+    const double accumulator_scale = static_cast<double>(layer.input_scale) * layer.weight_scale;
+
+    // Largest folded weight in real units decides the new weight_scale: kept when everything
+    // still fits in 8 bits, otherwise coarsened so the largest folded weight becomes 255
+    double max_weight = 0.0;
+    for (int out_c = 0; out_c < layer.output_channels; ++out_c)
+    {
+        const double scale = affine.scale[out_c];
+        if (scale < 0.0)
+        {
+            throw std::runtime_error("Cannot fold a negative scale into unsigned fixed-point weights.");
+        }
+        for (size_t i = out_c * filter_size; i < (out_c + 1) * filter_size; ++i)
+        {
+            max_weight = std::max(max_weight, layer.weights[i] * layer.weight_scale * scale);
+        }
+    }
+    const double weight_scale = std::max(static_cast<double>(layer.weight_scale), max_weight / 255.0);
+    const double folded_accumulator_scale = static_cast<double>(layer.input_scale) * weight_scale;
+
+    FixedPointLayer folded = layer;
+    folded.weight_scale = static_cast<float>(weight_scale);
+    folded.bias.assign(layer.output_channels, 0);
+    for (int out_c = 0; out_c < layer.output_channels; ++out_c)
+    {
+        const double scale = affine.scale[out_c];
+        for (size_t i = out_c * filter_size; i < (out_c + 1) * filter_size; ++i)
+        {
+            long weight = std::lround(layer.weights[i] * layer.weight_scale * scale / weight_scale);
+            folded.weights[i] = static_cast<std::uint8_t>(std::min(weight, 255L));
+        }
+        double old_bias = layer.bias.empty() ? 0.0 : layer.bias[out_c] * accumulator_scale;
+        long long new_bias = std::llround((old_bias * scale + affine.shift[out_c]) / folded_accumulator_scale);
+        if (new_bias < INT32_MIN || new_bias > INT32_MAX)
+        {
+            throw std::runtime_error("Folded fixed-point bias does not fit in 32 bits.");
+        }
+        folded.bias[out_c] = static_cast<std::int32_t>(new_bias);
+    }
+    return folded;
+}
+
+FixedPointLayer fold_batch_norm_fixed_point(const FixedPointLayer &layer, const BatchNormParameters &batch_norm)
+{
+    return fold_affine_fixed_point(layer, batch_norm_to_affine(batch_norm));
+}
+
+std::vector<std::vector<std::vector<std::uint32_t>>> fixed_point_forward(
+    const FixedPointLayer &layer,
+    const std::vector<std::vector<std::vector<std::uint8_t>>> &input_image)
+{
+    if (input_image.size() != static_cast<size_t>(layer.input_channels) || input_image[0].empty() || input_image[0][0].empty())
+    {
+        throw std::runtime_error("Input image channels mismatch with layer input_channels.");
+    }
+
+    // Geometry is shared with the float layer; its placeholder weight is never read
+    ConvolutionLayer shape_only = ConvolutionLayer::from_packed_weights(
+        layer.kernel_size, layer.stride, layer.padding_mode, layer.input_channels, layer.output_channels,
+        std::make_shared<float>(0.0f));
+    shape_only.set_border_mode(layer.border_mode);
+    if (layer.has_explicit_padding)
+    {
+        shape_only.set_explicit_padding(layer.explicit_padding);
+    }
+    ConvolutionGeometry geometry = shape_only.compute_geometry(input_image[0].size(), input_image[0][0].size());
+
+    const std::int64_t max_output = (std::int64_t(1) << layer.output_width) - 1;
+    const int kernel_area = layer.kernel_size * layer.kernel_size;
+    std::vector<std::vector<std::vector<std::uint32_t>>> output_image(
+        layer.output_channels,
+        std::vector<std::vector<std::uint32_t>>(geometry.output_height, std::vector<std::uint32_t>(geometry.output_width)));
+
+    for (int out_c = 0; out_c < layer.output_channels; ++out_c)
+    {
+        const std::uint8_t *filter = layer.weights.data() + static_cast<size_t>(out_c) * layer.input_channels * kernel_area;
+        for (int out_h = 0; out_h < geometry.output_height; ++out_h)
+        {
+            for (int out_w = 0; out_w < geometry.output_width; ++out_w)
+            {
+                std::int64_t sum = 0; // exact, like ACC_WIDTH in mult_acc_comb
+                for (int in_c = 0; in_c < layer.input_channels; ++in_c)
+                {
+                    for (int k_h = 0; k_h < layer.kernel_size; ++k_h)
+                    {
+                        for (int k_w = 0; k_w < layer.kernel_size; ++k_w)
+                        {
+                            int h_idx = border_index(out_h * layer.stride + k_h - geometry.padding_h, geometry.input_height, layer.border_mode);
+                            int w_idx = border_index(out_w * layer.stride + k_w - geometry.padding_w, geometry.input_width, layer.border_mode);
+                            if (h_idx >= 0 && w_idx >= 0)
+                            {
+                                sum += input_image[in_c][h_idx][w_idx] * filter[in_c * kernel_area + k_h * layer.kernel_size + k_w];
+                            }
+                        }
+                    }
+                }
+                sum += layer.bias.empty() ? 0 : layer.bias[out_c];
+                output_image[out_c][out_h][out_w] = static_cast<std::uint32_t>(sum < 0 ? 0 : (sum > max_output ? max_output : sum));
+            }
+        }
+    }
+    return output_image;
+}
+
+void write_fixed_point_mem(
+    const FixedPointLayer &layer,
+    const std::string &weights_path,
+    const std::string &bias_path,
+    int bias_width)
+{
+    if (bias_width < 1 || bias_width > 32)
+    {
+        throw std::runtime_error("Bias width must be between 1 and 32 bits.");
+    }
+    FILE *weights_file = std::fopen(weights_path.c_str(), "w");
+    if (!weights_file)
+    {
+        throw std::runtime_error("Cannot create weight file: " + weights_path);
+    }
+    for (std::uint8_t weight : layer.weights)
+    {
+        std::fprintf(weights_file, "%02X\n", weight);
+    }
+    std::fclose(weights_file);
+
+    const std::int64_t limit = std::int64_t(1) << (bias_width - 1);
+    const std::uint64_t mask = (std::uint64_t(1) << bias_width) - 1;
+    FILE *bias_file = std::fopen(bias_path.c_str(), "w");
+    if (!bias_file)
+    {
+        throw std::runtime_error("Cannot create bias file: " + bias_path);
+    }
+    for (int out_c = 0; out_c < layer.output_channels; ++out_c)
+    {
+        std::int64_t bias = layer.bias.empty() ? 0 : layer.bias[out_c];
+        if (bias < -limit || bias >= limit)
+        {
+            std::fclose(bias_file);
+            throw std::runtime_error("Bias does not fit in bias_width bits.");
+        }
+        std::fprintf(bias_file, "%0*llX\n", (bias_width + 3) / 4, static_cast<unsigned long long>(static_cast<std::uint64_t>(bias) & mask));
+    }
+    std::fclose(bias_file);
+}
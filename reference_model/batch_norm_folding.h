@@ -0,0 +1,84 @@
+#ifndef BATCH_NORM_FOLDING_H
+#define BATCH_NORM_FOLDING_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "convolution.h"
+
+// Per-channel batch norm applied to a convolution output:
+// y = gamma * (x - mean) / sqrt(variance + epsilon) + beta
+struct BatchNormParameters
+{
+    std::vector<float> gamma;
+    std::vector<float> beta;
+    std::vector<float> mean;
+    std::vector<float> variance;
+    float epsilon = 1e-5f;
+};
+
+// Per-channel y = scale * x + shift (a scale layer, or batch norm in inference form)
+struct ChannelAffine
+{
+    std::vector<float> scale;
+    std::vector<float> shift;
+};
+
+ChannelAffine batch_norm_to_affine(const BatchNormParameters &batch_norm);
+
+// Layer computing affine(layer(x)) in one pass: the weights of output channel o are multiplied
+// by scale[o] and its bias becomes bias[o] * scale[o] + shift[o]. The border mode, explicit
+// padding and reduction order carry over. Throws if the parameter count does not match
+// output_channels.
+ConvolutionLayer fold_affine(const ConvolutionLayer &layer, const ChannelAffine &affine);
+ConvolutionLayer fold_batch_norm(const ConvolutionLayer &layer, const BatchNormParameters &batch_norm);
+
+// Quantized layer in the form the RTL computes (conv.v / mult_acc_comb.v): unsigned
+// DATA_WIDTH=8 pixels times unsigned WEIGHT_WIDTH=8 weights, summed exactly, plus a signed
+// per-filter bias, clamped to [0, 2^output_width - 1].
+// Real values are integer * scale: pixels use input_scale, weights weight_scale and the
+// accumulator and bias input_scale * weight_scale.
+struct FixedPointLayer
+{
+    int kernel_size;
+    int stride;
+    PaddingMode padding_mode;
+    int input_channels;
+    int output_channels;
+    std::vector<std::uint8_t> weights; // [out_c][in_c][k_h][k_w], the order of weights.mem
+    std::vector<std::int32_t> bias;    // [out_c]; empty: no bias
+    int output_width;                  // OUTPUT_WIDTH of conv.v
+    float input_scale;
+    float weight_scale;
+    BorderMode border_mode;            // fill rule for padded positions (BORDER_MODE of window.v)
+    bool has_explicit_padding;         // explicit_padding replaces padding_mode's amounts
+    PaddingAmounts explicit_padding;
+};
+
+// Integer counterpart of fold_affine. The folded weights w * scale[o] are requantized to 8 bits
+// under one new layer weight_scale: the old one when every folded weight still fits, otherwise
+// max(w * weight_scale * scale[o]) / 255, so the largest becomes 255. The bias is re-expressed
+// in the new accumulator scale input_scale * weight_scale, which is also the scale of the
+// outputs; read the returned layer's weight_scale rather than the input layer's.
+// Limitation: the RTL weights are unsigned, so a negative scale (batch norm with gamma < 0)
+// cannot be folded and throws. Such a channel has to stay a separate per-channel step after
+// the convolution, or be handled by the float fold_affine. Also throws if a folded bias leaves
+// the int32 range.
+FixedPointLayer fold_affine_fixed_point(const FixedPointLayer &layer, const ChannelAffine &affine);
+FixedPointLayer fold_batch_norm_fixed_point(const FixedPointLayer &layer, const BatchNormParameters &batch_norm);
+
+// Bit-exact software model of the fused fixed-point convolution
+std::vector<std::vector<std::vector<std::uint32_t>>> fixed_point_forward(
+    const FixedPointLayer &layer,
+    const std::vector<std::vector<std::vector<std::uint8_t>>> &input_image);
+
+// Write $readmemh files for conv.v: weights as two hex digits per line (INIT_FILE) and the bias
+// as bias_width-bit two's complement (BIAS_FILE). Throws unless 1 <= bias_width <= 32 and every
+// bias fits in bias_width bits.
+void write_fixed_point_mem(
+    const FixedPointLayer &layer,
+    const std::string &weights_path,
+    const std::string &bias_path,
+    int bias_width);
+
+#endif // BATCH_NORM_FOLDING_H
@@ -0,0 +1,400 @@
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iomanip> // For fixed and setprecision
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "convolution.h"
+#include "convolution_nd.h"
+#include "inference_server.h"
+#include "network.h"
+#include "pipeline.h"
+#include "plan_cache.h"
+#include "tensor_io.h"
+#include "transposed_convolution.h"
+
+using namespace std;
+
+typedef vector<vector<vector<float>>> Image;
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Stand-in for request decoding: fills an image from the request id
+static Image decode_request(int request_id, int channels, int height, int width)
+{
+    Image image(channels, vector<vector<float>>(height, vector<float>(width)));
+    for (int c = 0; c < channels; ++c)
+        for (int h = 0; h < height; ++h)
+            for (int w = 0; w < width; ++w)
+                image[c][h][w] = static_cast<float>((request_id + c * 7 + h * 3 + w) % 17);
+    return image;
+}
+
+// Stand-in for result serialization: reduces the output to a checksum
+static double serialize_result(const Image &image)
+{
+    double checksum = 0.0;
+    for (const auto &channel : image)
+        for (const auto &row : channel)
+            for (float value : row)
+                checksum += value;
+    return checksum;
+}
+
+static void report(const string &label, int requests, double elapsed, double checksum)
+{
+    cout << left << setw(28) << label << fixed << setprecision(3)
+         << elapsed * 1000.0 << " ms, " << setprecision(1) << requests / elapsed
+         << " req/s (checksum " << setprecision(0) << checksum << ")" << endl;
+}
+
+int main()
+{
+    const int KERNEL_SIZE = 3;
+    const int INPUT_CHANNELS = 3;
+    const int OUTPUT_CHANNELS = 8;
+    const int INPUT_HEIGHT = 64;
+    const int INPUT_WIDTH = 64;
+    const int REQUESTS = 64;
+    const size_t PIPELINE_DEPTH = 8; // requests in flight at once
+
+    vector<vector<vector<vector<float>>>> kernel_weights(
+        OUTPUT_CHANNELS,
+        vector<vector<vector<float>>>(
+            INPUT_CHANNELS,
+            vector<vector<float>>(KERNEL_SIZE, vector<float>(KERNEL_SIZE, 1.0f / (KERNEL_SIZE * KERNEL_SIZE)))));
+
+    ConvolutionLayer layer(KERNEL_SIZE, 1, PaddingMode::SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, kernel_weights);
+
+    cout << "Benchmark: " << REQUESTS << " requests of " << INPUT_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH
+         << ", " << OUTPUT_CHANNELS << " filters, " << layer.thread_pool()->size() << " pool threads" << endl;
+
+    // --- Serial: decode, convolve and serialize one request at a time ---
+    double serial_checksum = 0.0;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < REQUESTS; ++r)
+    {
+        Image input = decode_request(r, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+        serial_checksum += serialize_result(layer.forward(input));
+    }
+    report("forward (serial)", REQUESTS, seconds_since(start), serial_checksum);
+
+    // --- Pipelined: decoding and serialization overlap with in-flight convolutions ---
+    double async_checksum = 0.0;
+    deque<future<Image>> in_flight;
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < REQUESTS; ++r)
+    {
+        if (in_flight.size() >= PIPELINE_DEPTH)
+        {
+            async_checksum += serialize_result(in_flight.front().get());
+            in_flight.pop_front();
+        }
+        in_flight.push_back(layer.forward_async(decode_request(r, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH)));
+    }
+    while (!in_flight.empty())
+    {
+        async_checksum += serialize_result(in_flight.front().get());
+        in_flight.pop_front();
+    }
+    report("forward_async (pipelined)", REQUESTS, seconds_since(start), async_checksum);
+
+    // --- Streaming pipeline: reader -> decoders -> convolution workers -> writer ---
+    const size_t RECORD_BYTES = static_cast<size_t>(INPUT_CHANNELS) * INPUT_HEIGHT * INPUT_WIDTH;
+    int next_record = 0;
+    double pipeline_checksum = 0.0;
+    ConvolutionPipeline pipeline(layer);
+    start = chrono::steady_clock::now();
+    vector<StageStats> stage_stats = pipeline.run(
+        [&](vector<unsigned char> &raw) {
+            if (next_record == REQUESTS)
+                return false;
+            Image image = decode_request(next_record++, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+            raw.resize(RECORD_BYTES);
+            size_t offset = 0;
+            for (const auto &channel : image)
+                for (const auto &row : channel)
+                    for (float value : row)
+                        raw[offset++] = static_cast<unsigned char>(value);
+            return true;
+        },
+        [&](const vector<unsigned char> &raw) {
+            Image image(INPUT_CHANNELS, vector<vector<float>>(INPUT_HEIGHT, vector<float>(INPUT_WIDTH)));
+            size_t offset = 0;
+            for (auto &channel : image)
+                for (auto &row : channel)
+                    for (float &value : row)
+                        value = static_cast<float>(raw[offset++]);
+            return image;
+        },
+        [&](uint64_t, const Image &output) { pipeline_checksum += serialize_result(output); });
+    report("pipeline (load/conv/store)", REQUESTS, seconds_since(start), pipeline_checksum);
+    for (const StageStats &stats : stage_stats)
+    {
+        cout << "  " << left << setw(12) << stats.name << " threads " << stats.threads
+             << ", items " << stats.items << fixed << setprecision(3)
+             << ", busy " << stats.busy_seconds * 1000.0 << " ms"
+             << ", starved " << stats.starved_seconds * 1000.0 << " ms"
+             << ", backpressure " << stats.backpressure_seconds * 1000.0 << " ms" << endl;
+    }
+
+    // --- Skewed batch: one large image and many small ones, few output channels ---
+    // A static split by image count leaves most threads idle while one works through the
+    // large image; work stealing breaks every image into tiles that idle workers can take.
+    vector<Image> skewed_batch;
+    skewed_batch.push_back(decode_request(0, INPUT_CHANNELS, 256, 256));
+    for (int r = 1; r < 16; ++r)
+        skewed_batch.push_back(decode_request(r, INPUT_CHANNELS, 16, 16));
+
+    ConvolutionLayer narrow_layer(KERNEL_SIZE, 1, PaddingMode::SAME, INPUT_CHANNELS, 2,
+                                  vector<vector<vector<vector<float>>>>(kernel_weights.begin(), kernel_weights.begin() + 2));
+    ThreadPool static_pool;
+    WorkStealingScheduler scheduler;
+    cout << "\nSkewed batch: 1 x 256x256 + 15 x 16x16 images, 2 filters, "
+         << static_pool.size() << " threads" << endl;
+
+    start = chrono::steady_clock::now();
+    double static_checksum = 0.0;
+    for (const Image &output : narrow_layer.forward_batch(skewed_batch, static_pool))
+        static_checksum += serialize_result(output);
+    report("forward_batch (static)", static_cast<int>(skewed_batch.size()), seconds_since(start), static_checksum);
+
+    start = chrono::steady_clock::now();
+    double stealing_checksum = 0.0;
+    for (const Image &output : narrow_layer.forward_batch(skewed_batch, scheduler))
+        stealing_checksum += serialize_result(output);
+    report("forward_batch (stealing)", static_cast<int>(skewed_batch.size()), seconds_since(start), stealing_checksum);
+
+    // --- Deterministic reduction: cost of the fixed pairwise tree over the sequential sum ---
+    const int DEEP_CHANNELS = 32;
+    ConvolutionLayer deep_layer(KERNEL_SIZE, 1, PaddingMode::SAME, DEEP_CHANNELS, 4,
+                                vector<vector<vector<vector<float>>>>(
+                                    4, vector<vector<vector<float>>>(
+                                           DEEP_CHANNELS, vector<vector<float>>(KERNEL_SIZE, vector<float>(KERNEL_SIZE, 0.1f)))));
+    Image deep_input = decode_request(1, DEEP_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+    cout << "\nReduction order: " << DEEP_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << " input, 4 filters" << endl;
+
+    start = chrono::steady_clock::now();
+    double sequential_checksum = serialize_result(deep_layer.forward(deep_input));
+    report("forward (sequential)", 1, seconds_since(start), sequential_checksum);
+
+    deep_layer.set_reduction_order(ReductionOrder::BLOCKED_PAIRWISE);
+    start = chrono::steady_clock::now();
+    Image pairwise_output = deep_layer.forward(deep_input);
+    report("forward (blocked pairwise)", 1, seconds_since(start), serialize_result(pairwise_output));
+
+    start = chrono::steady_clock::now();
+    Image split_output = deep_layer.forward_split_reduction(deep_input, scheduler);
+    report("forward_split_reduction", 1, seconds_since(start), serialize_result(split_output));
+    cout << "Split-reduction output is " << (split_output == pairwise_output ? "bit-identical" : "NOT bit-identical")
+         << " to the serial pairwise forward." << endl;
+
+    // --- Thread placement: unpinned vs pinned workers with node-local weight replicas ---
+    const CpuTopology &topology = CpuTopology::get();
+    cout << "\nThread placement: " << topology.numa_node_count() << " NUMA node(s)";
+    for (int node = 0; node < topology.numa_node_count(); ++node)
+        cout << (node == 0 ? ", CPUs per node: " : "/") << topology.node_cpus(node).size();
+    cout << endl;
+
+    vector<Image> placement_batch;
+    for (int r = 0; r < 16; ++r)
+        placement_batch.push_back(decode_request(r, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH));
+
+    const ThreadAffinity placements[] = {ThreadAffinity::NONE, ThreadAffinity::COMPACT, ThreadAffinity::SPREAD};
+    const char *placement_names[] = {"forward_batch (unpinned)", "forward_batch (compact)", "forward_batch (spread)"};
+    ConvolutionLayer replicated_layer = layer;
+    replicated_layer.replicate_weights_per_numa_node();
+    for (int p = 0; p < 3; ++p)
+    {
+        WorkStealingScheduler placed_scheduler(0, placements[p]);
+        const ConvolutionLayer &placed_layer = placements[p] == ThreadAffinity::NONE ? layer : replicated_layer;
+        start = chrono::steady_clock::now();
+        double placement_checksum = 0.0;
+        for (const Image &output : placed_layer.forward_batch(placement_batch, placed_scheduler))
+            placement_checksum += serialize_result(output);
+        report(placement_names[p], static_cast<int>(placement_batch.size()), seconds_since(start), placement_checksum);
+    }
+    cout << "Weight replicas: " << replicated_layer.weight_replica_count() << endl;
+
+    // --- Plan cache: building a layer from nested weights vs mapping a saved plan. For one
+    // small layer already in memory the file mapping costs more than the copy; the network
+    // plan below is where loading pays. ---
+    const char *PLAN_PATH = "benchmark_layer.plan";
+    save_layer_plan(compile_layer_plan(layer, INPUT_HEIGHT, INPUT_WIDTH), PLAN_PATH);
+    const int PLAN_LOADS = 200;
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < PLAN_LOADS; ++r)
+        ConvolutionLayer rebuilt(KERNEL_SIZE, 1, PaddingMode::SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, kernel_weights);
+    double build_seconds = seconds_since(start);
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < PLAN_LOADS; ++r)
+        LayerPlan plan = load_layer_plan(PLAN_PATH);
+    double load_seconds = seconds_since(start);
+    LayerPlan loaded_plan = load_layer_plan(PLAN_PATH);
+    Image plan_input = decode_request(0, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+    bool plan_matches = loaded_plan.layer.forward(plan_input) == layer.forward(plan_input);
+    remove(PLAN_PATH);
+    cout << "\nPlan cache: construct " << setprecision(1) << build_seconds * 1e6 / PLAN_LOADS << " us, load "
+         << load_seconds * 1e6 / PLAN_LOADS << " us per layer; loaded plan "
+         << (plan_matches ? "matches" : "DIFFERS") << endl;
+
+    // --- Network plan: parsing a description (tensor files, batch-norm folding, planning)
+    // vs mapping the saved plan of the same three-layer network ---
+    const int NETWORK_LOADS = 50;
+    const int network_channels[] = {INPUT_CHANNELS, 32, 64, 64};
+    string network_description = "input channels=3 height=64 width=64\n";
+    for (int l = 0; l < 3; ++l)
+    {
+        const string index = to_string(l);
+        Image weights(network_channels[l + 1] * network_channels[l], vector<vector<float>>(KERNEL_SIZE, vector<float>(KERNEL_SIZE)));
+        for (size_t f = 0; f < weights.size(); ++f)
+            for (int k_h = 0; k_h < KERNEL_SIZE; ++k_h)
+                for (int k_w = 0; k_w < KERNEL_SIZE; ++k_w)
+                    weights[f][k_h][k_w] = static_cast<float>((f * 5 + k_h * 3 + k_w) % 11) * 0.01f - 0.05f;
+        Image gamma(1, vector<vector<float>>(1, vector<float>(network_channels[l + 1], 1.5f)));
+        Image beta(1, vector<vector<float>>(1, vector<float>(network_channels[l + 1], 0.25f)));
+        Image variance(1, vector<vector<float>>(1, vector<float>(network_channels[l + 1], 4.0f)));
+        save_tensor(weights, "benchmark_w" + index + ".cnnt");
+        save_tensor(gamma, "benchmark_gamma" + index + ".cnnt");
+        save_tensor(beta, "benchmark_beta" + index + ".cnnt");
+        save_tensor(variance, "benchmark_var" + index + ".cnnt");
+        network_description += "convolution filters=" + to_string(network_channels[l + 1]) + " kernel=3 stride=" + (l == 1 ? "2" : "1") +
+                               " weights=benchmark_w" + index + ".cnnt\nbatch_norm gamma=benchmark_gamma" + index +
+                               ".cnnt beta=benchmark_beta" + index + ".cnnt mean=benchmark_beta" + index +
+                               ".cnnt variance=benchmark_var" + index + ".cnnt\nrelu\n";
+    }
+    {
+        ofstream description_file("benchmark_network.txt");
+        description_file << network_description;
+    }
+    const char *NETWORK_PLAN_PATH = "benchmark_network.plan";
+    save_network_plan(Network::load("benchmark_network.txt"), NETWORK_PLAN_PATH);
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < NETWORK_LOADS; ++r)
+        Network parsed = Network::load("benchmark_network.txt");
+    double parse_seconds = seconds_since(start);
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < NETWORK_LOADS; ++r)
+        Network mapped = load_network_plan(NETWORK_PLAN_PATH);
+    double map_seconds = seconds_since(start);
+    Network parsed_network = Network::load("benchmark_network.txt");
+    Network mapped_network = load_network_plan(NETWORK_PLAN_PATH);
+    bool network_plan_matches = mapped_network.forward(plan_input) == parsed_network.forward(plan_input);
+    remove("benchmark_network.txt");
+    remove(NETWORK_PLAN_PATH);
+    for (int l = 0; l < 3; ++l)
+    {
+        const string index = to_string(l);
+        remove(("benchmark_w" + index + ".cnnt").c_str());
+        remove(("benchmark_gamma" + index + ".cnnt").c_str());
+        remove(("benchmark_beta" + index + ".cnnt").c_str());
+        remove(("benchmark_var" + index + ".cnnt").c_str());
+    }
+    cout << "Network plan (3 layers, " << setprecision(0) << (3 * 9 * 32 + 9 * 32 * 64 + 9 * 64 * 64) * 4 / 1024.0
+         << " KiB weights): parse " << setprecision(1) << parse_seconds * 1e6 / NETWORK_LOADS << " us, load plan "
+         << map_seconds * 1e6 / NETWORK_LOADS << " us; loaded network " << (network_plan_matches ? "matches" : "DIFFERS") << endl;
+
+    // --- Transposed convolution: phase-decomposed gather vs zero-stuffed input ---
+    const int UPSAMPLE_KERNEL = 4;
+    TransposedConvolutionLayer upsample_layer(UPSAMPLE_KERNEL, 2, PaddingMode::SAME, OUTPUT_CHANNELS, INPUT_CHANNELS,
+                                              vector<vector<vector<vector<float>>>>(
+                                                  OUTPUT_CHANNELS, vector<vector<vector<float>>>(
+                                                                       INPUT_CHANNELS, vector<vector<float>>(UPSAMPLE_KERNEL, vector<float>(UPSAMPLE_KERNEL, 0.1f)))));
+    Image upsample_input = decode_request(2, OUTPUT_CHANNELS, INPUT_HEIGHT / 2, INPUT_WIDTH / 2);
+    cout << "\nTransposed convolution: " << OUTPUT_CHANNELS << "x" << INPUT_HEIGHT / 2 << "x" << INPUT_WIDTH / 2
+         << " input, " << UPSAMPLE_KERNEL << "x" << UPSAMPLE_KERNEL << " kernel, stride 2" << endl;
+    start = chrono::steady_clock::now();
+    Image stuffed_output = upsample_layer.forward_zero_stuffing(upsample_input);
+    report("forward_zero_stuffing", 1, seconds_since(start), serialize_result(stuffed_output));
+    start = chrono::steady_clock::now();
+    Image upsample_output = upsample_layer.forward(upsample_input);
+    report("forward (phase-decomposed)", 1, seconds_since(start), serialize_result(upsample_output));
+    bool upsample_matches = upsample_output == stuffed_output;
+    cout << "Phase-decomposed output is " << (upsample_matches ? "bit-identical" : "NOT bit-identical")
+         << " to the zero-stuffing reference." << endl;
+
+    // --- Dimension-generic engine: tiled im2col/GEMM vs the direct 2D loops ---
+    ConvolutionEngineND deep_engine(2, KERNEL_SIZE, 1, PaddingMode::SAME, DEEP_CHANNELS, 4,
+                                    vector<float>(deep_layer.packed_weights(), deep_layer.packed_weights() + deep_layer.packed_weight_count()));
+    vector<float> deep_flat;
+    for (const auto &channel : deep_input)
+        for (const auto &row : channel)
+            deep_flat.insert(deep_flat.end(), row.begin(), row.end());
+    deep_layer.set_reduction_order(ReductionOrder::SEQUENTIAL);
+    cout << "\nN-d engine (2D case): " << DEEP_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << " input, 4 filters" << endl;
+    start = chrono::steady_clock::now();
+    Image direct_output = deep_layer.forward(deep_input);
+    report("forward (direct)", 1, seconds_since(start), serialize_result(direct_output));
+    start = chrono::steady_clock::now();
+    vector<float> engine_output = deep_engine.forward(deep_flat.data(), deep_engine.compute_axes({INPUT_HEIGHT, INPUT_WIDTH}), &static_pool);
+    double engine_checksum = 0.0;
+    for (float value : engine_output)
+        engine_checksum += value;
+    report("ConvolutionEngineND (pool)", 1, seconds_since(start), engine_checksum);
+    bool engine_matches = true;
+    for (size_t c = 0, i = 0; c < direct_output.size(); ++c)
+        for (const auto &row : direct_output[c])
+            for (float value : row)
+                engine_matches = engine_matches && value == engine_output[i++];
+    cout << "N-d engine output is " << (engine_matches ? "bit-identical" : "NOT bit-identical") << " to ConvolutionLayer::forward." << endl;
+
+    // --- Backward pass: im2col/GEMM gradients, serial vs thread pool ---
+    Image deep_gradient = deep_layer.forward(deep_input);
+    cout << "\nBackward pass: " << DEEP_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << " input, 4 filters" << endl;
+    start = chrono::steady_clock::now();
+    Image serial_input_gradient = deep_layer.backward_data(deep_gradient, INPUT_HEIGHT, INPUT_WIDTH);
+    vector<Image> serial_weight_gradient = deep_layer.backward_weights(deep_input, deep_gradient);
+    report("backward (serial)", 1, seconds_since(start), serialize_result(serial_input_gradient));
+    start = chrono::steady_clock::now();
+    Image pool_input_gradient = deep_layer.backward_data(deep_gradient, INPUT_HEIGHT, INPUT_WIDTH, static_pool);
+    vector<Image> pool_weight_gradient = deep_layer.backward_weights(deep_input, deep_gradient, static_pool);
+    report("backward (thread pool)", 1, seconds_since(start), serialize_result(pool_input_gradient));
+    bool gradients_match = pool_input_gradient == serial_input_gradient && pool_weight_gradient == serial_weight_gradient;
+    cout << "Thread-pool gradients are " << (gradients_match ? "bit-identical" : "NOT bit-identical") << " to the serial ones." << endl;
+
+    // --- Inference server: concurrent clients, requests batched within a latency budget ---
+    const int CLIENTS = 8;
+    ServerConfig server_config;
+    server_config.socket_path = "benchmark_server.sock";
+    server_config.max_batch_size = CLIENTS;
+    InferenceServer server(layer, server_config);
+    server.start();
+    vector<double> client_checksums(CLIENTS, 0.0);
+    vector<thread> clients;
+    start = chrono::steady_clock::now();
+    for (int c = 0; c < CLIENTS; ++c)
+    {
+        clients.emplace_back([&, c]() {
+            InferenceClient client(server_config.socket_path);
+            for (int r = c; r < REQUESTS; r += CLIENTS)
+                client_checksums[c] += serialize_result(client.forward(decode_request(r, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH)));
+        });
+    }
+    for (thread &client : clients)
+        client.join();
+    double server_elapsed = seconds_since(start);
+    double server_checksum = 0.0;
+    for (double checksum : client_checksums)
+        server_checksum += checksum;
+    ServerMetrics server_metrics = server.metrics();
+    server.stop();
+    cout << endl;
+    report("inference server", REQUESTS, server_elapsed, server_checksum);
+    cout << "Server: " << server_metrics.batches << " batches, mean size " << setprecision(1)
+         << server_metrics.mean_batch_size << ", queue latency mean " << setprecision(3)
+         << server_metrics.mean_queue_seconds * 1000.0 << " ms / max " << server_metrics.max_queue_seconds * 1000.0
+         << " ms" << endl;
+
+    return (serial_checksum == async_checksum && serial_checksum == pipeline_checksum &&
+            static_checksum == stealing_checksum && split_output == pairwise_output && plan_matches && network_plan_matches && upsample_matches && gradients_match && engine_matches &&
+            serial_checksum == server_checksum)
+               ? 0
+               : 1;
+}
@@ -1,155 +1,1076 @@
-#include "convolution.h"
-#include <iostream> // For potential debugging, can be removed later
-#include <cmath>    // For std::ceil
-
-ConvolutionLayer::ConvolutionLayer(
-    int kernel_size,
-    int stride,
-    PaddingMode padding_mode,
-    int input_channels,
-    int output_channels,
-    const std::vector<std::vector<std::vector<std::vector<float>>>> &initial_kernel_weights) : kernel_size_(kernel_size),
-                                                                                               stride_(stride),
-                                                                                               padding_mode_(padding_mode),
-                                                                                               input_channels_(input_channels),
-                                                                                               output_channels_(output_channels),
-                                                                                               kernel_weights_(initial_kernel_weights)
-{
-    // Basic validation
-    if (kernel_size <= 0)
-    {
-        throw std::runtime_error("Kernel size must be positive.");
-    }
-    if (stride <= 0)
-    {
-        throw std::runtime_error("Stride must be positive.");
-    }
-    if (input_channels <= 0)
-    {
-        throw std::runtime_error("Input channels must be positive.");
-    }
-    if (output_channels <= 0)
-    {
-        throw std::runtime_error("Output channels must be positive.");
-    }
-    if (kernel_weights_.empty() && output_channels_ > 0)
-    {
-        throw std::runtime_error("Initial kernel weights cannot be empty if output channels > 0.");
-    }
-    if (!kernel_weights_.empty())
-    {
-        if (kernel_weights_.size() != static_cast<size_t>(output_channels_))
-        {
-            throw std::runtime_error("Mismatch between output_channels and kernel_weights_ first dimension.");
-        }
-        if (!kernel_weights_[0].empty())
-        {
-            if (kernel_weights_[0].size() != static_cast<size_t>(input_channels_))
-            {
-                throw std::runtime_error("Mismatch between input_channels and kernel_weights_ second dimension.");
-            }
-            if (!kernel_weights_[0][0].empty())
-            {
-                if (kernel_weights_[0][0].size() != static_cast<size_t>(kernel_size_))
-                {
-                    throw std::runtime_error("Mismatch between kernel_size and kernel_weights_ third dimension.");
-                }
-                if (!kernel_weights_[0][0][0].empty())
-                {
-                    if (kernel_weights_[0][0][0].size() != static_cast<size_t>(kernel_size_))
-                    {
-                        throw std::runtime_error("Mismatch between kernel_size and kernel_weights_ fourth dimension.");
-                    }
-                }
-            }
-        }
-    }
-}
-
-int ConvolutionLayer::calculate_padding_amount(int input_dim, int output_dim_target) const
-{
-    // pad = ((output_dim_target - 1) * stride + kernel_size - input_dim) / 2
-    // This formula is derived for one side, so total padding is 2 * pad.
-    // However, the problem usually refers to padding on each side.
-    int pad = ((output_dim_target - 1) * stride_ + kernel_size_ - input_dim) / 2;
-    return std::max(0, pad); // Ensure padding is not negative
-}
-
-std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward(
-    const std::vector<std::vector<std::vector<float>>> &input_image) const
-{
-    if (input_image.empty() || input_image[0].empty() || input_image[0][0].empty())
-    {
-        throw std::runtime_error("Input image cannot be empty.");
-    }
-    if (input_image.size() != static_cast<size_t>(input_channels_))
-    {
-        throw std::runtime_error("Input image channels mismatch with layer input_channels.");
-    }
-
-    int input_height = input_image[0].size();
-    int input_width = input_image[0][0].size();
-
-    int output_height;
-    int output_width;
-    int padding_h = 0;
-    int padding_w = 0;
-
-    if (padding_mode_ == PaddingMode::VALID)
-    {
-        output_height = (input_height - kernel_size_) / stride_ + 1;
-        output_width = (input_width - kernel_size_) / stride_ + 1;
-    }
-    else
-    { // PaddingMode::SAME
-        output_height = static_cast<int>(std::ceil(static_cast<float>(input_height) / stride_));
-        output_width = static_cast<int>(std::ceil(static_cast<float>(input_width) / stride_));
-        padding_h = calculate_padding_amount(input_height, output_height);
-        padding_w = calculate_padding_amount(input_width, output_width);
-    }
-
-    if (output_height <= 0 || output_width <= 0)
-    {
-        throw std::runtime_error("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.");
-    }
-
-    std::vector<std::vector<std::vector<float>>> output_image(
-        output_channels_,
-        std::vector<std::vector<float>>(
-            output_height,
-            std::vector<float>(output_width, 0.0f)));
-
-    for (int out_c = 0; out_c < output_channels_; ++out_c)
-    {
-        for (int out_h = 0; out_h < output_height; ++out_h)
-        {
-            for (int out_w = 0; out_w < output_width; ++out_w)
-            {
-                float sum = 0.0f;
-                for (int in_c = 0; in_c < input_channels_; ++in_c)
-                {
-                    for (int k_h = 0; k_h < kernel_size_; ++k_h)
-                    {
-                        for (int k_w = 0; k_w < kernel_size_; ++k_w)
-                        {
-                            int h_idx = out_h * stride_ + k_h - padding_h;
-                            int w_idx = out_w * stride_ + k_w - padding_w;
-
-                            float pixel_value = 0.0f;
-                            if (h_idx >= 0 && h_idx < input_height && w_idx >= 0 && w_idx < input_width)
-                            {
-                                pixel_value = input_image[in_c][h_idx][w_idx];
-                            }
-                            // else: it's padding, pixel_value remains 0.0f as initialized
-
-                            sum += pixel_value * kernel_weights_[out_c][in_c][k_h][k_w];
-                        }
-                    }
-                }
-                output_image[out_c][out_h][out_w] = sum;
-            }
-        }
-    }
-
-    return output_image;
+#include "convolution.h"
+#include "im2col.h"
+#include <iostream> // For potential debugging, can be removed later
+#include <algorithm> // For std::min
+#include <cmath>    // For std::ceil
+#include <cstddef>  // For std::ptrdiff_t
+#include <mutex>    // For std::mutex
+#include <thread>   // For std::thread
+#include <utility>  // For std::move
+
+ConvolutionLayer::ConvolutionLayer(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &initial_kernel_weights) : kernel_size_(kernel_size),
+                                                                                               stride_(stride),
+                                                                                               padding_mode_(padding_mode),
+                                                                                               input_channels_(input_channels),
+                                                                                               output_channels_(output_channels),
+                                                                                               kernel_weights_(initial_kernel_weights),
+                                                                                               reduction_order_(ReductionOrder::SEQUENTIAL),
+                                                                                               border_mode_(BorderMode::ZERO),
+                                                                                               has_explicit_padding_(false),
+                                                                                               explicit_padding_()
+{
+    // Basic validation
+    validate_parameters(kernel_size, stride, input_channels, output_channels);
+    if (kernel_weights_.empty() && output_channels_ > 0)
+    {
+        throw std::runtime_error("Initial kernel weights cannot be empty if output channels > 0.");
+    }
+    if (!kernel_weights_.empty())
+    {
+        if (kernel_weights_.size() != static_cast<size_t>(output_channels_))
+        {
+            throw std::runtime_error("Mismatch between output_channels and kernel_weights_ first dimension.");
+        }
+        if (!kernel_weights_[0].empty())
+        {
+            if (kernel_weights_[0].size() != static_cast<size_t>(input_channels_))
+            {
+                throw std::runtime_error("Mismatch between input_channels and kernel_weights_ second dimension.");
+            }
+            if (!kernel_weights_[0][0].empty())
+            {
+                if (kernel_weights_[0][0].size() != static_cast<size_t>(kernel_size_))
+                {
+                    throw std::runtime_error("Mismatch between kernel_size and kernel_weights_ third dimension.");
+                }
+                if (!kernel_weights_[0][0][0].empty())
+                {
+                    if (kernel_weights_[0][0][0].size() != static_cast<size_t>(kernel_size_))
+                    {
+                        throw std::runtime_error("Mismatch between kernel_size and kernel_weights_ fourth dimension.");
+                    }
+                }
+            }
+        }
+    }
+
+    pack_weights();
+}
+
+ConvolutionLayer::ConvolutionLayer(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    std::shared_ptr<const float> packed_weights) : kernel_size_(kernel_size),
+                                                   stride_(stride),
+                                                   padding_mode_(padding_mode),
+                                                   input_channels_(input_channels),
+                                                   output_channels_(output_channels),
+                                                   reduction_order_(ReductionOrder::SEQUENTIAL),
+                                                   border_mode_(BorderMode::ZERO),
+                                                   has_explicit_padding_(false),
+                                                   explicit_padding_()
+{
+    validate_parameters(kernel_size, stride, input_channels, output_channels);
+    if (!packed_weights)
+    {
+        throw std::runtime_error("Packed kernel weights cannot be null.");
+    }
+    packed_weights_.assign(1, std::move(packed_weights));
+}
+
+ConvolutionLayer ConvolutionLayer::from_packed_weights(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    std::shared_ptr<const float> packed_weights)
+{
+    return ConvolutionLayer(kernel_size, stride, padding_mode, input_channels, output_channels, std::move(packed_weights));
+}
+
+void ConvolutionLayer::validate_parameters(int kernel_size, int stride, int input_channels, int output_channels)
+{
+    if (kernel_size <= 0)
+    {
+        throw std::runtime_error("Kernel size must be positive.");
+    }
+    if (stride <= 0)
+    {
+        throw std::runtime_error("Stride must be positive.");
+    }
+    if (input_channels <= 0)
+    {
+        throw std::runtime_error("Input channels must be positive.");
+    }
+    if (output_channels <= 0)
+    {
+        throw std::runtime_error("Output channels must be positive.");
+    }
+}
+
+void ConvolutionLayer::pack_weights()
+{
+    std::shared_ptr<std::vector<float>> packed = std::make_shared<std::vector<float>>();
+    packed->reserve(packed_weight_count());
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+        for (int in_c = 0; in_c < input_channels_; ++in_c)
+            for (int k_h = 0; k_h < kernel_size_; ++k_h)
+                for (int k_w = 0; k_w < kernel_size_; ++k_w)
+                    packed->push_back(kernel_weights_[out_c][in_c][k_h][k_w]);
+
+    // Aliasing constructor: the pointer refers to the data, ownership stays with the vector
+    packed_weights_.assign(1, std::shared_ptr<const float>(packed, packed->data()));
+}
+
+void ConvolutionLayer::replicate_weights_per_numa_node()
+{
+    const CpuTopology &topology = CpuTopology::get();
+    const std::shared_ptr<const float> master = packed_weights_[0];
+    if (topology.numa_node_count() <= 1)
+    {
+        packed_weights_.assign(1, master);
+        return;
+    }
+
+    // Each replica is allocated and written by a thread pinned to its node, so first-touch
+    // places its pages in that node's memory
+    const size_t count = packed_weight_count();
+    std::vector<std::shared_ptr<const float>> replicas(topology.numa_node_count());
+    for (int node = 0; node < topology.numa_node_count(); ++node)
+    {
+        std::thread copier([&replicas, &master, &topology, count, node]() {
+            pin_current_thread(topology.node_cpus(node)[0]);
+            std::shared_ptr<std::vector<float>> replica =
+                std::make_shared<std::vector<float>>(master.get(), master.get() + count);
+            replicas[node] = std::shared_ptr<const float>(replica, replica->data());
+        });
+        copier.join();
+    }
+    packed_weights_ = replicas;
+}
+
+const float *ConvolutionLayer::local_packed_weights() const
+{
+    if (packed_weights_.size() == 1)
+    {
+        return packed_weights_[0].get();
+    }
+    return packed_weights_[current_numa_node() % packed_weights_.size()].get();
+}
+
+// Per-thread scratch. It is allocated by the worker that uses it, so first-touch places it
+// on that worker's NUMA node.
+static std::vector<float> &worker_scratch(size_t size)
+{
+    thread_local std::vector<float> scratch;
+    if (scratch.size() < size)
+    {
+        scratch.resize(size);
+    }
+    return scratch;
+}
+
+int ConvolutionLayer::calculate_padding_amount(int input_dim, int output_dim_target) const
+{
+    // pad = ((output_dim_target - 1) * stride + kernel_size - input_dim) / 2
+    // This formula is derived for one side, so total padding is 2 * pad.
+    // However, the problem usually refers to padding on each side.
+    int pad = ((output_dim_target - 1) * stride_ + kernel_size_ - input_dim) / 2;
+    return std::max(0, pad); // Ensure padding is not negative
+}
+
+ConvolutionGeometry ConvolutionLayer::compute_geometry(int input_height, int input_width) const
+{
+    ConvolutionGeometry geometry;
+    geometry.input_height = input_height;
+    geometry.input_width = input_width;
+    geometry.padding_h = 0;
+    geometry.padding_w = 0;
+
+    if (has_explicit_padding_)
+    {
+        int padded_height = input_height + explicit_padding_.top + explicit_padding_.bottom;
+        int padded_width = input_width + explicit_padding_.left + explicit_padding_.right;
+        if (padded_height < kernel_size_ || padded_width < kernel_size_)
+        {
+            throw std::runtime_error("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.");
+        }
+        geometry.output_height = (padded_height - kernel_size_) / stride_ + 1;
+        geometry.output_width = (padded_width - kernel_size_) / stride_ + 1;
+        geometry.padding_h = explicit_padding_.top;
+        geometry.padding_w = explicit_padding_.left;
+    }
+    else if (padding_mode_ == PaddingMode::VALID)
+    {
+        geometry.output_height = (input_height - kernel_size_) / stride_ + 1;
+        geometry.output_width = (input_width - kernel_size_) / stride_ + 1;
+    }
+    else
+    { // PaddingMode::SAME
+        geometry.output_height = static_cast<int>(std::ceil(static_cast<float>(input_height) / stride_));
+        geometry.output_width = static_cast<int>(std::ceil(static_cast<float>(input_width) / stride_));
+        geometry.padding_h = calculate_padding_amount(input_height, geometry.output_height);
+        geometry.padding_w = calculate_padding_amount(input_width, geometry.output_width);
+    }
+
+    if (geometry.output_height <= 0 || geometry.output_width <= 0)
+    {
+        throw std::runtime_error("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.");
+    }
+
+    if (border_mode_ == BorderMode::REFLECT || border_mode_ == BorderMode::CIRCULAR)
+    {
+        // Rows/columns the last output reads below/right of the image
+        int below = (geometry.output_height - 1) * stride_ + kernel_size_ - geometry.padding_h - input_height;
+        int right = (geometry.output_width - 1) * stride_ + kernel_size_ - geometry.padding_w - input_width;
+        int slack = border_mode_ == BorderMode::REFLECT ? 1 : 0;
+        if (std::max(geometry.padding_h, below) > input_height - slack || std::max(geometry.padding_w, right) > input_width - slack)
+        {
+            throw std::runtime_error("Padding too large for the border mode: REFLECT needs padding < input size, CIRCULAR padding <= input size.");
+        }
+    }
+
+    return geometry;
+}
+
+void ConvolutionLayer::set_explicit_padding(const PaddingAmounts &padding)
+{
+    if (padding.top < 0 || padding.bottom < 0 || padding.left < 0 || padding.right < 0)
+    {
+        throw std::runtime_error("Padding amounts must not be negative.");
+    }
+    explicit_padding_ = padding;
+    has_explicit_padding_ = true;
+}
+
+void ConvolutionLayer::set_bias(const std::vector<float> &bias)
+{
+    if (!bias.empty() && bias.size() != static_cast<size_t>(output_channels_))
+    {
+        throw std::runtime_error("Bias size must match output_channels.");
+    }
+    bias_ = bias;
+}
+
+void ConvolutionLayer::validate_input(const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    if (input_image.empty() || input_image[0].empty() || input_image[0][0].empty())
+    {
+        throw std::runtime_error("Input image cannot be empty.");
+    }
+    if (input_image.size() != static_cast<size_t>(input_channels_))
+    {
+        throw std::runtime_error("Input image channels mismatch with layer input_channels.");
+    }
+}
+
+void ConvolutionLayer::validate_region(const OutputRegion &region, const ConvolutionGeometry &geometry) const
+{
+    if (region.height <= 0 || region.width <= 0)
+    {
+        throw std::runtime_error("Output region must have positive height and width.");
+    }
+    if (region.top < 0 || region.left < 0 ||
+        region.top + region.height > geometry.output_height ||
+        region.left + region.width > geometry.output_width)
+    {
+        throw std::runtime_error("Output region lies outside the output image.");
+    }
+}
+
+// Float32 CHW image read in place through element strides (a DLPack tensor's memory)
+struct StridedImage
+{
+    const float *data;
+    std::ptrdiff_t channel_stride;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t column_stride;
+};
+
+// Pixel access for the Input types of compute_region and compute_channel_region
+static inline float pixel(const std::vector<std::vector<std::vector<float>>> &image, int c, int h, int w)
+{
+    return image[c][h][w];
+}
+
+static inline float pixel(const StridedImage &image, int c, int h, int w)
+{
+    return image.data[c * image.channel_stride + h * image.row_stride + w * image.column_stride];
+}
+
+// Contiguous output plane of a planned forward; plane[row][column] like a nested vector
+struct OutputPlane
+{
+    float *data;
+    int width;
+
+    float *operator[](int row) const { return data + static_cast<size_t>(row) * width; }
+};
+
+template <typename Input>
+void ConvolutionLayer::compute_region(
+    const Input &input_image,
+    const ConvolutionGeometry &geometry,
+    const OutputRegion &region,
+    std::vector<std::vector<std::vector<float>>> &output_image,
+    int dst_top,
+    int dst_left) const
+{
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        compute_channel_region(input_image, geometry, region, out_c, output_image[out_c], dst_top, dst_left);
+    }
+}
+
+template <typename Input, typename OutputChannel>
+void ConvolutionLayer::compute_channel_region(
+    const Input &input_image,
+    const ConvolutionGeometry &geometry,
+    const OutputRegion &region,
+    int out_c,
+    OutputChannel &output_channel,
+    int dst_top,
+    int dst_left,
+    float *channel_sums) const
+{
+    const int input_height = geometry.input_height;
+    const int input_width = geometry.input_width;
+    const int padding_h = geometry.padding_h;
+    const int padding_w = geometry.padding_w;
+    const int kernel_area = kernel_size_ * kernel_size_;
+    const float *filter_weights = local_packed_weights() + static_cast<size_t>(out_c) * input_channels_ * kernel_area;
+    const float channel_bias = bias_.empty() ? 0.0f : bias_[out_c];
+
+    if (reduction_order_ == ReductionOrder::BLOCKED_PAIRWISE)
+    {
+        if (!channel_sums)
+        {
+            channel_sums = worker_scratch(input_channels_).data();
+        }
+        for (int out_h = region.top; out_h < region.top + region.height; ++out_h)
+        {
+            for (int out_w = region.left; out_w < region.left + region.width; ++out_w)
+            {
+                for (int in_c = 0; in_c < input_channels_; ++in_c)
+                {
+                    float sum = 0.0f;
+                    for (int k_h = 0; k_h < kernel_size_; ++k_h)
+                    {
+                        for (int k_w = 0; k_w < kernel_size_; ++k_w)
+                        {
+                            int h_idx = out_h * stride_ + k_h - padding_h;
+                            int w_idx = out_w * stride_ + k_w - padding_w;
+
+                            float pixel_value = 0.0f;
+                            if (h_idx >= 0 && h_idx < input_height && w_idx >= 0 && w_idx < input_width)
+                            {
+                                pixel_value = pixel(input_image, in_c, h_idx, w_idx);
+                            }
+                            else if (border_mode_ != BorderMode::ZERO)
+                            {
+                                pixel_value = pixel(input_image, in_c, border_index(h_idx, input_height, border_mode_),
+                                                    border_index(w_idx, input_width, border_mode_));
+                            }
+                            sum += pixel_value * filter_weights[in_c * kernel_area + k_h * kernel_size_ + k_w];
+                        }
+                    }
+                    channel_sums[in_c] = sum;
+                }
+                output_channel[out_h - region.top + dst_top][out_w - region.left + dst_left] =
+                    pairwise_sum(channel_sums, input_channels_) + channel_bias;
+            }
+        }
+        return;
+    }
+
+    for (int out_h = region.top; out_h < region.top + region.height; ++out_h)
+    {
+        for (int out_w = region.left; out_w < region.left + region.width; ++out_w)
+        {
+            float sum = 0.0f;
+            for (int in_c = 0; in_c < input_channels_; ++in_c)
+            {
+                for (int k_h = 0; k_h < kernel_size_; ++k_h)
+                {
+                    for (int k_w = 0; k_w < kernel_size_; ++k_w)
+                    {
+                        int h_idx = out_h * stride_ + k_h - padding_h;
+                        int w_idx = out_w * stride_ + k_w - padding_w;
+
+                        float pixel_value = 0.0f;
+                        if (h_idx >= 0 && h_idx < input_height && w_idx >= 0 && w_idx < input_width)
+                        {
+                            pixel_value = pixel(input_image, in_c, h_idx, w_idx);
+                        }
+                        else if (border_mode_ != BorderMode::ZERO)
+                        {
+                            // Border path: read the mirrored/clamped/wrapped source pixel in place
+                            pixel_value = pixel(input_image, in_c, border_index(h_idx, input_height, border_mode_),
+                                                border_index(w_idx, input_width, border_mode_));
+                        }
+                        // else: it's zero padding, pixel_value remains 0.0f as initialized
+
+                        sum += pixel_value * filter_weights[in_c * kernel_area + k_h * kernel_size_ + k_w];
+                    }
+                }
+            }
+            output_channel[out_h - region.top + dst_top][out_w - region.left + dst_left] = sum + channel_bias;
+        }
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward(
+    const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height,
+            std::vector<float>(geometry.output_width, 0.0f)));
+
+    OutputRegion full_region = {0, 0, geometry.output_height, geometry.output_width};
+    compute_region(input_image, geometry, full_region, output_image, 0, 0);
+
+    return output_image;
+}
+
+void ConvolutionLayer::forward_into(const float *input, const ConvolutionGeometry &geometry, float *output, float *workspace) const
+{
+    const std::ptrdiff_t plane = static_cast<std::ptrdiff_t>(geometry.input_height) * geometry.input_width;
+    StridedImage image = {input, plane, geometry.input_width, 1};
+    OutputRegion full_region = {0, 0, geometry.output_height, geometry.output_width};
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        OutputPlane output_channel = {output + static_cast<size_t>(out_c) * geometry.output_height * geometry.output_width,
+                                      geometry.output_width};
+        compute_channel_region(image, geometry, full_region, out_c, output_channel, 0, 0, workspace);
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward(const conv_dl_tensor &input_tensor) const
+{
+    conv_dl_chw view;
+    if (!conv_dl_tensor_to_chw(&input_tensor, &view))
+    {
+        throw std::runtime_error("Unsupported input tensor: expected a CPU float32, float64 or uint8 tensor of shape [C,H,W] or [1,C,H,W].");
+    }
+    if (view.channels != input_channels_)
+    {
+        throw std::runtime_error("Input image channels mismatch with layer input_channels.");
+    }
+    ConvolutionGeometry geometry = compute_geometry(view.height, view.width);
+
+    StridedImage image = {reinterpret_cast<const float *>(view.data), view.channel_stride, view.row_stride, view.column_stride};
+    std::vector<float> converted;
+    if (view.element != CONV_DL_ELEMENT_FLOAT32)
+    {
+        // The kernels read float32 only, so other element types are converted once up front
+        converted.resize(static_cast<size_t>(view.channels) * view.height * view.width);
+        float *destination = converted.data();
+        for (int c = 0; c < view.channels; ++c)
+            for (int h = 0; h < view.height; ++h)
+                for (int w = 0; w < view.width; ++w)
+                    *destination++ = conv_dl_chw_load(&view, c, h, w);
+        image.data = converted.data();
+        image.channel_stride = static_cast<std::ptrdiff_t>(view.height) * view.width;
+        image.row_stride = view.width;
+        image.column_stride = 1;
+    }
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height,
+            std::vector<float>(geometry.output_width, 0.0f)));
+
+    OutputRegion full_region = {0, 0, geometry.output_height, geometry.output_width};
+    compute_region(image, geometry, full_region, output_image, 0, 0);
+
+    return output_image;
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::forward_roi(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const std::vector<OutputRegion> &regions) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> region_outputs;
+    region_outputs.reserve(regions.size());
+
+    for (const OutputRegion &region : regions)
+    {
+        validate_region(region, geometry);
+
+        region_outputs.emplace_back(
+            output_channels_,
+            std::vector<std::vector<float>>(
+                region.height,
+                std::vector<float>(region.width, 0.0f)));
+        compute_region(input_image, geometry, region, region_outputs.back(), 0, 0);
+    }
+
+    return region_outputs;
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward_roi_full(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const std::vector<OutputRegion> &regions) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    for (const OutputRegion &region : regions)
+    {
+        validate_region(region, geometry);
+    }
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height,
+            std::vector<float>(geometry.output_width, 0.0f)));
+
+    // Overlapping regions simply recompute the shared positions with identical results
+    for (const OutputRegion &region : regions)
+    {
+        compute_region(input_image, geometry, region, output_image, region.top, region.left);
+    }
+
+    return output_image;
+}
+
+std::vector<std::vector<float>> ConvolutionLayer::forward_channel(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    int out_c) const
+{
+    validate_input(input_image);
+    if (out_c < 0 || out_c >= output_channels_)
+    {
+        throw std::runtime_error("Output channel index out of range.");
+    }
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    std::vector<std::vector<float>> output_channel(
+        geometry.output_height,
+        std::vector<float>(geometry.output_width, 0.0f));
+
+    OutputRegion full_region = {0, 0, geometry.output_height, geometry.output_width};
+    compute_channel_region(input_image, geometry, full_region, out_c, output_channel, 0, 0);
+
+    return output_channel;
+}
+
+LazyConvolutionOutput ConvolutionLayer::forward_lazy(std::vector<std::vector<std::vector<float>>> input_image) const
+{
+    validate_input(input_image);
+    return LazyConvolutionOutput(
+        *this,
+        std::make_shared<const std::vector<std::vector<std::vector<float>>>>(std::move(input_image)));
+}
+
+std::future<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::forward_async(
+    std::vector<std::vector<std::vector<float>>> input_image) const
+{
+    // C++11 lambdas cannot move-capture, so the image is shared rather than copied
+    std::shared_ptr<std::vector<std::vector<std::vector<float>>>> input =
+        std::make_shared<std::vector<std::vector<std::vector<float>>>>(std::move(input_image));
+    return thread_pool()->submit([this, input]() { return forward(*input); });
+}
+
+// Output rows per work-stealing tile: small enough to balance, large enough to amortize a task
+static const int TILE_ROWS = 4;
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward_parallel(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    ThreadPool &thread_pool) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height,
+            std::vector<float>(geometry.output_width, 0.0f)));
+
+    // Rows of all channels laid end to end: row r is channel r / output_height
+    thread_pool.parallel_for(output_channels_ * geometry.output_height, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row)
+        {
+            int out_c = row / geometry.output_height;
+            OutputRegion region = {row % geometry.output_height, 0, 1, geometry.output_width};
+            compute_channel_region(input_image, geometry, region, out_c, output_image[out_c], region.top, 0);
+        }
+    });
+
+    return output_image;
+}
+
+void ConvolutionLayer::spawn_tile_tasks(
+    TaskGroup &group,
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const ConvolutionGeometry &geometry,
+    std::vector<std::vector<std::vector<float>>> &output_image) const
+{
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int top = 0; top < geometry.output_height; top += TILE_ROWS)
+        {
+            OutputRegion region = {top, 0, std::min(TILE_ROWS, geometry.output_height - top), geometry.output_width};
+            std::vector<std::vector<float>> *output_channel = &output_image[out_c];
+            const ConvolutionGeometry *tile_geometry = &geometry;
+            group.run([this, &input_image, tile_geometry, region, out_c, output_channel]() {
+                compute_channel_region(input_image, *tile_geometry, region, out_c, *output_channel, region.top, 0);
+            });
+        }
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward_parallel(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    WorkStealingScheduler &scheduler) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height,
+            std::vector<float>(geometry.output_width, 0.0f)));
+
+    TaskGroup group(scheduler);
+    spawn_tile_tasks(group, input_image, geometry, output_image);
+    group.wait();
+
+    return output_image;
+}
+
+void ConvolutionLayer::forward_into(
+    const float *input,
+    const ConvolutionGeometry &geometry,
+    float *output,
+    float *workspace,
+    WorkStealingScheduler &scheduler) const
+{
+    const std::ptrdiff_t plane = static_cast<std::ptrdiff_t>(geometry.input_height) * geometry.input_width;
+    const StridedImage image = {input, plane, geometry.input_width, 1};
+    const size_t output_plane = static_cast<size_t>(geometry.output_height) * geometry.output_width;
+    std::mutex outside_slot_mutex; // guards the slot of threads that are not workers
+
+    TaskGroup group(scheduler);
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int top = 0; top < geometry.output_height; top += TILE_ROWS)
+        {
+            OutputRegion region = {top, 0, std::min(TILE_ROWS, geometry.output_height - top), geometry.output_width};
+            group.run([this, &image, &geometry, &scheduler, &outside_slot_mutex, region, out_c, output, output_plane, workspace]() {
+                OutputPlane output_channel = {output + out_c * output_plane, geometry.output_width};
+                if (!workspace)
+                {
+                    compute_channel_region(image, geometry, region, out_c, output_channel, region.top, 0);
+                    return;
+                }
+                int worker_index = scheduler.current_worker_index();
+                if (worker_index >= 0)
+                {
+                    float *slot = workspace + static_cast<size_t>(worker_index) * input_channels_;
+                    compute_channel_region(image, geometry, region, out_c, output_channel, region.top, 0, slot);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(outside_slot_mutex);
+                float *slot = workspace + static_cast<size_t>(scheduler.size()) * input_channels_;
+                compute_channel_region(image, geometry, region, out_c, output_channel, region.top, 0, slot);
+            });
+        }
+    }
+    group.wait();
+}
+
+void ConvolutionLayer::compute_channel_partial(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const ConvolutionGeometry &geometry,
+    const OutputRegion &region,
+    int out_c,
+    int in_c,
+    std::vector<std::vector<float>> &partial_plane) const
+{
+    const float *kernel = local_packed_weights() + (static_cast<size_t>(out_c) * input_channels_ + in_c) * kernel_size_ * kernel_size_;
+    const std::vector<std::vector<float>> &input_channel = input_image[in_c];
+
+    for (int out_h = region.top; out_h < region.top + region.height; ++out_h)
+    {
+        for (int out_w = region.left; out_w < region.left + region.width; ++out_w)
+        {
+            // Same product order as the BLOCKED_PAIRWISE branch of compute_channel_region
+            float sum = 0.0f;
+            for (int k_h = 0; k_h < kernel_size_; ++k_h)
+            {
+                for (int k_w = 0; k_w < kernel_size_; ++k_w)
+                {
+                    int h_idx = out_h * stride_ + k_h - geometry.padding_h;
+                    int w_idx = out_w * stride_ + k_w - geometry.padding_w;
+
+                    float pixel_value = 0.0f;
+                    if (h_idx >= 0 && h_idx < geometry.input_height && w_idx >= 0 && w_idx < geometry.input_width)
+                    {
+                        pixel_value = input_channel[h_idx][w_idx];
+                    }
+                    else if (border_mode_ != BorderMode::ZERO)
+                    {
+                        pixel_value = input_channel[border_index(h_idx, geometry.input_height, border_mode_)]
+                                                   [border_index(w_idx, geometry.input_width, border_mode_)];
+                    }
+                    sum += pixel_value * kernel[k_h * kernel_size_ + k_w];
+                }
+            }
+            partial_plane[out_h - region.top][out_w - region.left] = sum;
+        }
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::forward_split_reduction(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    WorkStealingScheduler &scheduler) const
+{
+    validate_input(input_image);
+
+    int input_height = input_image[0].size();
+    int input_width = input_image[0][0].size();
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+    const int output_height = geometry.output_height;
+    const int output_width = geometry.output_width;
+    OutputRegion full_region = {0, 0, output_height, output_width};
+
+    // partials[out_c][in_c] is one partial-sum plane
+    std::vector<std::vector<std::vector<std::vector<float>>>> partials(
+        output_channels_,
+        std::vector<std::vector<std::vector<float>>>(
+            input_channels_,
+            std::vector<std::vector<float>>(output_height, std::vector<float>(output_width, 0.0f))));
+
+    TaskGroup partial_group(scheduler);
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int in_c = 0; in_c < input_channels_; ++in_c)
+        {
+            partial_group.run([this, &input_image, &geometry, &full_region, &partials, out_c, in_c]() {
+                compute_channel_partial(input_image, geometry, full_region, out_c, in_c, partials[out_c][in_c]);
+            });
+        }
+    }
+    partial_group.wait();
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(output_height, std::vector<float>(output_width, 0.0f)));
+
+    // The combine step is another fixed tree per output; rows are independent tasks
+    TaskGroup combine_group(scheduler);
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int out_h = 0; out_h < output_height; ++out_h)
+        {
+            combine_group.run([this, &partials, &output_image, output_width, out_c, out_h]() {
+                float *channel_sums = worker_scratch(input_channels_).data();
+                const float channel_bias = bias_.empty() ? 0.0f : bias_[out_c];
+                for (int out_w = 0; out_w < output_width; ++out_w)
+                {
+                    for (int in_c = 0; in_c < input_channels_; ++in_c)
+                    {
+                        channel_sums[in_c] = partials[out_c][in_c][out_h][out_w];
+                    }
+                    output_image[out_c][out_h][out_w] = pairwise_sum(channel_sums, input_channels_) + channel_bias;
+                }
+            });
+        }
+    }
+    combine_group.wait();
+
+    return output_image;
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::forward_batch(
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &input_images,
+    ThreadPool &thread_pool) const
+{
+    std::vector<std::vector<std::vector<std::vector<float>>>> output_images(input_images.size());
+    thread_pool.parallel_for(static_cast<int>(input_images.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            output_images[i] = forward(input_images[i]);
+        }
+    });
+    return output_images;
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::forward_batch(
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &input_images,
+    WorkStealingScheduler &scheduler) const
+{
+    std::vector<std::vector<std::vector<std::vector<float>>>> output_images(input_images.size());
+
+    TaskGroup batch_group(scheduler);
+    for (size_t i = 0; i < input_images.size(); ++i)
+    {
+        batch_group.run([this, &input_images, &output_images, &scheduler, i]() {
+            output_images[i] = forward_parallel(input_images[i], scheduler); // nested tile tasks
+        });
+    }
+    batch_group.wait();
+
+    return output_images;
+}
+
+// Run body(begin, end) over [0, count) on the pool, or inline when there is none
+static void for_each_block(ThreadPool *thread_pool, int count, const std::function<void(int begin, int end)> &body)
+{
+    if (thread_pool)
+    {
+        thread_pool->parallel_for(count, body);
+    }
+    else
+    {
+        body(0, count);
+    }
+}
+
+std::vector<float> ConvolutionLayer::flatten_output_gradient(
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    const ConvolutionGeometry &geometry) const
+{
+    if (output_gradient.size() != static_cast<size_t>(output_channels_))
+    {
+        throw std::runtime_error("Output gradient channels mismatch with layer output_channels.");
+    }
+    const size_t output_positions = static_cast<size_t>(geometry.output_height) * geometry.output_width;
+    std::vector<float> flattened;
+    flattened.reserve(output_channels_ * output_positions);
+    for (const auto &channel : output_gradient)
+    {
+        if (channel.size() != static_cast<size_t>(geometry.output_height))
+        {
+            throw std::runtime_error("Output gradient height does not match the layer output.");
+        }
+        for (const auto &row : channel)
+        {
+            if (row.size() != static_cast<size_t>(geometry.output_width))
+            {
+                throw std::runtime_error("Output gradient width does not match the layer output.");
+            }
+            flattened.insert(flattened.end(), row.begin(), row.end());
+        }
+    }
+    return flattened;
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::backward_data_impl(
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    int input_height,
+    int input_width,
+    ThreadPool *thread_pool) const
+{
+    ConvolutionGeometry geometry = compute_geometry(input_height, input_width);
+    const std::vector<float> gradient = flatten_output_gradient(output_gradient, geometry);
+    const int output_positions = geometry.output_height * geometry.output_width;
+    const int kernel_area = kernel_size_ * kernel_size_;
+    const int filter_size = input_channels_ * kernel_area;
+    const float *weights = packed_weights();
+
+    std::vector<std::vector<std::vector<float>>> input_gradient(
+        input_channels_,
+        std::vector<std::vector<float>>(input_height, std::vector<float>(input_width, 0.0f)));
+
+    // Input channel in_c owns rows [in_c * k * k, (in_c + 1) * k * k) of W^T * dY and is the
+    // only one col2im writes into, so channels need no synchronisation
+    for_each_block(thread_pool, input_channels_, [&](int begin, int end) {
+        float *columns = worker_scratch(static_cast<size_t>(kernel_area) * output_positions).data();
+        for (int in_c = begin; in_c < end; ++in_c)
+        {
+            gemm_tn(kernel_area, output_positions, output_channels_,
+                    weights + in_c * kernel_area, filter_size,
+                    gradient.data(), output_positions,
+                    columns, output_positions);
+            col2im_channel(columns, geometry, kernel_size_, stride_, border_mode_, input_gradient[in_c]);
+        }
+    });
+    return input_gradient;
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::backward_data(
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    int input_height,
+    int input_width) const
+{
+    return backward_data_impl(output_gradient, input_height, input_width, nullptr);
+}
+
+std::vector<std::vector<std::vector<float>>> ConvolutionLayer::backward_data(
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    int input_height,
+    int input_width,
+    ThreadPool &thread_pool) const
+{
+    return backward_data_impl(output_gradient, input_height, input_width, &thread_pool);
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::backward_weights_impl(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    ThreadPool *thread_pool) const
+{
+    validate_input(input_image);
+    ConvolutionGeometry geometry = compute_geometry(input_image[0].size(), input_image[0][0].size());
+    const std::vector<float> gradient = flatten_output_gradient(output_gradient, geometry);
+    const int output_positions = geometry.output_height * geometry.output_width;
+    const int kernel_area = kernel_size_ * kernel_size_;
+    const int filter_size = input_channels_ * kernel_area;
+
+    std::vector<float> columns(static_cast<size_t>(filter_size) * output_positions);
+    for_each_block(thread_pool, input_channels_, [&](int begin, int end) {
+        for (int in_c = begin; in_c < end; ++in_c)
+        {
+            im2col_channel(input_image[in_c], geometry, kernel_size_, stride_, border_mode_,
+                           columns.data() + static_cast<size_t>(in_c) * kernel_area * output_positions);
+        }
+    });
+
+    std::vector<float> weight_gradient(static_cast<size_t>(output_channels_) * filter_size);
+    for_each_block(thread_pool, output_channels_, [&](int begin, int end) {
+        gemm_nt(end - begin, filter_size, output_positions,
+                gradient.data() + static_cast<size_t>(begin) * output_positions, output_positions,
+                columns.data(), output_positions,
+                weight_gradient.data() + static_cast<size_t>(begin) * filter_size, filter_size);
+    });
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> result(
+        output_channels_,
+        std::vector<std::vector<std::vector<float>>>(
+            input_channels_,
+            std::vector<std::vector<float>>(kernel_size_, std::vector<float>(kernel_size_))));
+    const float *value = weight_gradient.data();
+    for (auto &filter : result)
+    {
+        for (auto &kernel : filter)
+        {
+            for (auto &kernel_row : kernel)
+            {
+                for (float &weight : kernel_row)
+                {
+                    weight = *value++;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::backward_weights(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const std::vector<std::vector<std::vector<float>>> &output_gradient) const
+{
+    return backward_weights_impl(input_image, output_gradient, nullptr);
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer::backward_weights(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    const std::vector<std::vector<std::vector<float>>> &output_gradient,
+    ThreadPool &thread_pool) const
+{
+    return backward_weights_impl(input_image, output_gradient, &thread_pool);
+}
+
+std::vector<float> ConvolutionLayer::backward_bias(const std::vector<std::vector<std::vector<float>>> &output_gradient) const
+{
+    if (output_gradient.size() != static_cast<size_t>(output_channels_))
+    {
+        throw std::runtime_error("Output gradient channels mismatch with layer output_channels.");
+    }
+    std::vector<float> bias_gradient(output_channels_, 0.0f);
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (const auto &row : output_gradient[out_c])
+        {
+            for (float value : row)
+            {
+                bias_gradient[out_c] += value;
+            }
+        }
+    }
+    return bias_gradient;
+}
+
+LazyConvolutionOutput::LazyConvolutionOutput(
+    const ConvolutionLayer &layer,
+    std::shared_ptr<const std::vector<std::vector<std::vector<float>>>> input_image) : layer_(&layer),
+                                                                                       input_image_(std::move(input_image)),
+                                                                                       geometry_(layer.compute_geometry((*input_image_)[0].size(), (*input_image_)[0][0].size())),
+                                                                                       channel_cache_(layer.output_channels()),
+                                                                                       computed_(layer.output_channels(), false)
+{
+}
+
+const std::vector<std::vector<float>> &LazyConvolutionOutput::channel(int out_c) const
+{
+    if (out_c < 0 || out_c >= channels())
+    {
+        throw std::runtime_error("Output channel index out of range.");
+    }
+    if (!computed_[out_c])
+    {
+        channel_cache_[out_c] = layer_->forward_channel(*input_image_, out_c);
+        computed_[out_c] = true;
+    }
+    return channel_cache_[out_c];
+}
+
+bool LazyConvolutionOutput::is_computed(int out_c) const
+{
+    if (out_c < 0 || out_c >= channels())
+    {
+        throw std::runtime_error("Output channel index out of range.");
+    }
+    return computed_[out_c];
+}
+
+std::vector<std::vector<std::vector<float>>> LazyConvolutionOutput::materialize() const
+{
+    for (int out_c = 0; out_c < channels(); ++out_c)
+    {
+        channel(out_c);
+    }
+    return channel_cache_;
 }
\ No newline at end of file
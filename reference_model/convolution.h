@@ -1,43 +1,426 @@
-#ifndef CONVOLUTION_H
-#define CONVOLUTION_H
-
-#include <vector>
-#include <string>
-#include <stdexcept> // Required for std::runtime_error
-
-// Define an enum for padding modes
-enum class PaddingMode
-{
-    VALID,
-    SAME
-};
-
-class ConvolutionLayer
-{
-public:
-    // Constructor
-    ConvolutionLayer(
-        int kernel_size,
-        int stride,
-        PaddingMode padding_mode,
-        int input_channels,
-        int output_channels,
-        const std::vector<std::vector<std::vector<std::vector<float>>>> &initial_kernel_weights);
-
-    // Perform convolution
-    std::vector<std::vector<std::vector<float>>> forward(
-        const std::vector<std::vector<std::vector<float>>> &input_image) const;
-
-private:
-    int kernel_size_;
-    int stride_;
-    PaddingMode padding_mode_;
-    int input_channels_;
-    int output_channels_;
-    std::vector<std::vector<std::vector<std::vector<float>>>> kernel_weights_; // [out_c][in_c][k_h][k_w]
-
-    // Helper to get padding amount for SAME mode
-    int calculate_padding_amount(int input_dim, int output_dim_target) const;
-};
-
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <vector>
+#include <string>
+#include <future>    // For std::future
+#include <memory>    // For std::shared_ptr
+#include <stdexcept> // Required for std::runtime_error
+#include "dl_tensor.h"
+#include "thread_pool.h"
+#include "work_stealing.h"
+
+// Define an enum for padding modes
+enum class PaddingMode
+{
+    VALID,
+    SAME
+};
+
+// Value read at positions outside the image (the padding). ZERO is the original behaviour.
+// For an image of n rows, row -1 reads: REFLECT row 1 (mirror without repeating the edge),
+// REPLICATE row 0, CIRCULAR row n - 1; columns likewise. REFLECT needs padding < n and
+// CIRCULAR padding <= n on every side. The kernels map border indices on the fly; no padded
+// copy of the image is made.
+enum class BorderMode
+{
+    ZERO,
+    REFLECT,
+    REPLICATE,
+    CIRCULAR
+};
+
+// Explicit per-side padding, used instead of the VALID/SAME rule when set on a layer
+struct PaddingAmounts
+{
+    int top;
+    int bottom;
+    int left;
+    int right;
+};
+
+// Source index for position index of an axis of length size: index itself when inside,
+// otherwise the border_mode mapping, or -1 for ZERO (read 0.0f). index must lie within the
+// padding limits above.
+inline int border_index(int index, int size, BorderMode border_mode)
+{
+    if (index >= 0 && index < size)
+    {
+        return index;
+    }
+    switch (border_mode)
+    {
+    case BorderMode::REFLECT:
+        return index < 0 ? -index : 2 * (size - 1) - index;
+    case BorderMode::REPLICATE:
+        return index < 0 ? 0 : size - 1;
+    case BorderMode::CIRCULAR:
+        return index < 0 ? index + size : index - size;
+    default:
+        return -1;
+    }
+}
+
+// Order in which the in_c x k_h x k_w products of one output are summed.
+// SEQUENTIAL adds them one after another (the original loop order).
+// BLOCKED_PAIRWISE sums each input channel's k_h x k_w block sequentially and then combines
+// the per-channel partial sums in a fixed balanced binary tree. The tree depends only on
+// input_channels, so forward, forward_parallel and forward_split_reduction return
+// bit-identical results for any thread count. The number of additions is unchanged; the
+// extra cost is one store and reload per input channel per output, which has measured from
+// parity to roughly half again the SEQUENTIAL time depending on the machine and run.
+// forward_split_reduction also writes every partial plane to memory and has measured 1.5x to
+// 2x the serial time on a single core, which extra threads recover when the output alone is
+// too small to split. benchmark.cpp times all of these on its 32-channel 3x3 layer.
+enum class ReductionOrder
+{
+    SEQUENTIAL,
+    BLOCKED_PAIRWISE
+};
+
+// Rectangle in output coordinates: rows [top, top + height), columns [left, left + width)
+struct OutputRegion
+{
+    int top;
+    int left;
+    int height;
+    int width;
+};
+
+// Output size and padding offsets derived from an input size
+struct ConvolutionGeometry
+{
+    int input_height;
+    int input_width;
+    int output_height;
+    int output_width;
+    int padding_h; // rows of padding above the image (SAME or explicit padding)
+    int padding_w; // columns of padding left of the image (SAME or explicit padding)
+};
+
+class LazyConvolutionOutput;
+
+class ConvolutionLayer
+{
+public:
+    // Constructor
+    ConvolutionLayer(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &initial_kernel_weights);
+
+    // Layer over weights already packed as a contiguous [out_c][in_c][k_h][k_w] array.
+    // The array is shared, not copied (it may live in a memory-mapped plan file).
+    static ConvolutionLayer from_packed_weights(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        std::shared_ptr<const float> packed_weights);
+
+    // Perform convolution
+    std::vector<std::vector<std::vector<float>>> forward(
+        const std::vector<std::vector<std::vector<float>>> &input_image) const;
+
+    // Convolve a DLPack-style tensor of shape [in_c, H, W] or [1, in_c, H, W] with any strides
+    // (row padding, channel-interleaved storage, ...). float32 tensors are read in place; float64
+    // and uint8 tensors are first converted into a compact float32 copy. Throws for tensors
+    // that are not on the CPU, have another dtype or rank, or have the wrong channel count.
+    std::vector<std::vector<std::vector<float>>> forward(const conv_dl_tensor &input_tensor) const;
+
+    // Planned forward that allocates nothing: input is a contiguous [in_c][H][W] array, output
+    // a contiguous [out_c][out_h][out_w] array for geometry = compute_geometry(H, W). For the
+    // BLOCKED_PAIRWISE order workspace holds LayerPlan::scratch_bytes_per_thread (plan_cache.h);
+    // otherwise it may be null. Results are identical to forward.
+    void forward_into(const float *input, const ConvolutionGeometry &geometry, float *output, float *workspace) const;
+
+    // Same with one task per (output channel, row tile) on the scheduler. workspace holds
+    // scheduler.size() + 1 slots of scratch_bytes_per_thread: one per worker and one shared, in
+    // turn, by threads outside the scheduler that help while waiting.
+    void forward_into(
+        const float *input,
+        const ConvolutionGeometry &geometry,
+        float *output,
+        float *workspace,
+        WorkStealingScheduler &scheduler) const;
+
+    // Compute only the requested output regions; one compact [out_c][region.height][region.width]
+    // image is returned per region. Only the input footprint of each region is read, so the
+    // cost scales with the region area rather than with the full output size.
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward_roi(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const std::vector<OutputRegion> &regions) const;
+
+    // Same as forward_roi, but writes every region into a full-sized output image.
+    // Positions outside all regions are left at 0.0f.
+    std::vector<std::vector<std::vector<float>>> forward_roi_full(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const std::vector<OutputRegion> &regions) const;
+
+    // Compute a single output channel [output_height][output_width]
+    std::vector<std::vector<float>> forward_channel(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        int out_c) const;
+
+    // Deferred forward: output channels are computed on first access and cached.
+    // The input is taken by value (move it in to avoid a copy); the layer must outlive the result.
+    LazyConvolutionOutput forward_lazy(std::vector<std::vector<std::vector<float>>> input_image) const;
+
+    // Run forward on the layer's thread pool and return immediately. The input is taken by
+    // value (move it in to avoid a copy); the layer must outlive the returned future.
+    // Blocks only when the pool's in-flight limit is reached.
+    std::future<std::vector<std::vector<std::vector<float>>>> forward_async(
+        std::vector<std::vector<std::vector<float>>> input_image) const;
+
+    // Pool used by forward_async; ThreadPool::shared_default() when none is assigned
+    void set_thread_pool(std::shared_ptr<ThreadPool> thread_pool) { thread_pool_ = std::move(thread_pool); }
+    std::shared_ptr<ThreadPool> thread_pool() const { return thread_pool_ ? thread_pool_ : ThreadPool::shared_default(); }
+
+    // Parallel forward with a static split: output rows of all channels are cut into one
+    // contiguous block per pool thread
+    std::vector<std::vector<std::vector<float>>> forward_parallel(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        ThreadPool &thread_pool) const;
+
+    // Parallel forward with dynamic load balancing: every (output channel, row tile) is a
+    // task on the work-stealing scheduler. Results are identical to forward.
+    std::vector<std::vector<std::vector<float>>> forward_parallel(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        WorkStealingScheduler &scheduler) const;
+
+    // Batched forward with a static split: images are divided evenly (by count) over the pool threads
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward_batch(
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &input_images,
+        ThreadPool &thread_pool) const;
+
+    // Batched forward where every image is a task that spawns its own tile tasks, so
+    // batches of differently sized images still keep every worker busy
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward_batch(
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &input_images,
+        WorkStealingScheduler &scheduler) const;
+
+    // Parallel forward that also splits the reduction: every (output channel, input channel)
+    // partial-sum plane is a task, and the planes are combined in the fixed BLOCKED_PAIRWISE
+    // tree. Useful when the output is too small to keep all workers busy. Always uses
+    // BLOCKED_PAIRWISE order, so it matches forward in that mode bit for bit.
+    // Needs output_channels * input_channels * output_height * output_width floats of scratch.
+    std::vector<std::vector<std::vector<float>>> forward_split_reduction(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        WorkStealingScheduler &scheduler) const;
+
+    // Gradients for training (loss L, output gradient dL/d(output) with the shape forward
+    // returns for an input of input_height x input_width). Both are GEMMs over the im2col matrix
+    // of im2col.h: backward_data computes W^T * dL/d(output) and folds it back with col2im one
+    // input channel at a time; backward_weights computes dL/d(output) * X^T for a block of output
+    // channels at a time. Every value is produced by one thread in a fixed order, so the pool
+    // overloads return the same bits as the serial ones. Throws if the gradient shape is wrong.
+
+    // dL/d(input), [in_c][input_height][input_width]
+    std::vector<std::vector<std::vector<float>>> backward_data(
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        int input_height,
+        int input_width) const;
+    std::vector<std::vector<std::vector<float>>> backward_data(
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        int input_height,
+        int input_width,
+        ThreadPool &thread_pool) const;
+
+    // dL/d(weights), [out_c][in_c][k_h][k_w]. Needs in_c * k * k * output positions floats of columns.
+    std::vector<std::vector<std::vector<std::vector<float>>>> backward_weights(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const std::vector<std::vector<std::vector<float>>> &output_gradient) const;
+    std::vector<std::vector<std::vector<std::vector<float>>>> backward_weights(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        ThreadPool &thread_pool) const;
+
+    // dL/d(bias), [out_c]: the output gradient summed over each channel
+    std::vector<float> backward_bias(const std::vector<std::vector<std::vector<float>>> &output_gradient) const;
+
+    // Give every NUMA node its own copy of the packed weights, placed in that node's memory.
+    // Workers pinned with ThreadAffinity then read their local copy. A no-op on single-node machines.
+    void replicate_weights_per_numa_node();
+    int weight_replica_count() const { return static_cast<int>(packed_weights_.size()); }
+
+    // Per-output-channel bias added to every output of that channel (after the reduction).
+    // An empty vector removes the bias; any other size must equal output_channels.
+    void set_bias(const std::vector<float> &bias);
+    const std::vector<float> &bias() const { return bias_; }
+
+    // Values read in the padding (ZERO by default); see BorderMode
+    void set_border_mode(BorderMode border_mode) { border_mode_ = border_mode; }
+    BorderMode border_mode() const { return border_mode_; }
+
+    // Pad by exactly these amounts, possibly asymmetric, instead of the VALID/SAME rule.
+    // Throws if any amount is negative.
+    void set_explicit_padding(const PaddingAmounts &padding);
+    void clear_explicit_padding() { has_explicit_padding_ = false; }
+    bool has_explicit_padding() const { return has_explicit_padding_; }
+    const PaddingAmounts &explicit_padding() const { return explicit_padding_; }
+
+    void set_reduction_order(ReductionOrder reduction_order) { reduction_order_ = reduction_order; }
+    ReductionOrder reduction_order() const { return reduction_order_; }
+
+    // Output dimensions and padding offsets for a given input size. Throws if the padding
+    // exceeds what the border mode allows for this size.
+    ConvolutionGeometry compute_geometry(int input_height, int input_width) const;
+
+    // Layer configuration
+    int kernel_size() const { return kernel_size_; }
+    int stride() const { return stride_; }
+    PaddingMode padding_mode() const { return padding_mode_; }
+    int input_channels() const { return input_channels_; }
+    int output_channels() const { return output_channels_; }
+
+    // Contiguous [out_c][in_c][k_h][k_w] weights and their element count
+    const float *packed_weights() const { return packed_weights_[0].get(); }
+    size_t packed_weight_count() const
+    {
+        return static_cast<size_t>(output_channels_) * input_channels_ * kernel_size_ * kernel_size_;
+    }
+
+private:
+    int kernel_size_;
+    int stride_;
+    PaddingMode padding_mode_;
+    int input_channels_;
+    int output_channels_;
+    std::vector<std::vector<std::vector<std::vector<float>>>> kernel_weights_; // [out_c][in_c][k_h][k_w]; empty if built from packed weights
+    std::shared_ptr<ThreadPool> thread_pool_;                                  // null: shared default pool
+    ReductionOrder reduction_order_;
+    // kernel_weights_ flattened to one contiguous [out_c][in_c][k_h][k_w] array, used by the
+    // kernels; one replica per NUMA node after replicate_weights_per_numa_node()
+    std::vector<std::shared_ptr<const float>> packed_weights_;
+    std::vector<float> bias_; // [out_c]; empty: no bias
+    BorderMode border_mode_;
+    bool has_explicit_padding_;
+    PaddingAmounts explicit_padding_;
+
+    // Helper to get padding amount for SAME mode
+    int calculate_padding_amount(int input_dim, int output_dim_target) const;
+
+    ConvolutionLayer(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        std::shared_ptr<const float> packed_weights);
+
+    // Throws if any size parameter is not positive
+    static void validate_parameters(int kernel_size, int stride, int input_channels, int output_channels);
+
+    // Rebuild packed_weights_ (a single replica) from kernel_weights_
+    void pack_weights();
+
+    // Packed weights replica for the NUMA node of the calling thread
+    const float *local_packed_weights() const;
+
+    // Throws if the input image is empty or its channel count does not match the layer
+    void validate_input(const std::vector<std::vector<std::vector<float>>> &input_image) const;
+
+    // Throws if output_gradient does not have the output shape described by geometry.
+    // Returns it flattened to an out_c x (output_height * output_width) matrix.
+    std::vector<float> flatten_output_gradient(
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        const ConvolutionGeometry &geometry) const;
+
+    // Shared by the serial (thread_pool == nullptr) and pooled backward passes
+    std::vector<std::vector<std::vector<float>>> backward_data_impl(
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        int input_height,
+        int input_width,
+        ThreadPool *thread_pool) const;
+    std::vector<std::vector<std::vector<std::vector<float>>>> backward_weights_impl(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const std::vector<std::vector<std::vector<float>>> &output_gradient,
+        ThreadPool *thread_pool) const;
+
+    // Throws if the region does not lie inside the output described by geometry
+    void validate_region(const OutputRegion &region, const ConvolutionGeometry &geometry) const;
+
+    // Compute output positions inside region for every output channel and store them
+    // at output[out_c][out_h - region.top + dst_top][out_w - region.left + dst_left].
+    // Input is a nested [in_c][height][width] vector or a strided view (see convolution.cpp).
+    template <typename Input>
+    void compute_region(
+        const Input &input_image,
+        const ConvolutionGeometry &geometry,
+        const OutputRegion &region,
+        std::vector<std::vector<std::vector<float>>> &output_image,
+        int dst_top,
+        int dst_left) const;
+
+    // Spawn one task per (output channel, row tile) into group, writing into output_image
+    void spawn_tile_tasks(
+        TaskGroup &group,
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const ConvolutionGeometry &geometry,
+        std::vector<std::vector<std::vector<float>>> &output_image) const;
+
+    // Sum of the k_h x k_w products of one input channel for every output position in region,
+    // stored at partial_plane[out_h - region.top][out_w - region.left]
+    void compute_channel_partial(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        const ConvolutionGeometry &geometry,
+        const OutputRegion &region,
+        int out_c,
+        int in_c,
+        std::vector<std::vector<float>> &partial_plane) const;
+
+    // Compute output positions inside region for a single output channel and store them
+    // at output[out_h - region.top + dst_top][out_w - region.left + dst_left]. Output is a
+    // nested [height][width] vector or a contiguous plane (see convolution.cpp). channel_sums
+    // is input_channels floats of scratch for BLOCKED_PAIRWISE; null uses the thread's own.
+    template <typename Input, typename OutputChannel>
+    void compute_channel_region(
+        const Input &input_image,
+        const ConvolutionGeometry &geometry,
+        const OutputRegion &region,
+        int out_c,
+        OutputChannel &output_channel,
+        int dst_top,
+        int dst_left,
+        float *channel_sums = nullptr) const;
+};
+
+// Output of ConvolutionLayer::forward_lazy. Each output channel is computed the first time it
+// is accessed and cached afterwards, so channels that are never read cost nothing. Results are
+// identical to ConvolutionLayer::forward. Not thread-safe: accesses must be externally synchronized.
+class LazyConvolutionOutput
+{
+public:
+    LazyConvolutionOutput(
+        const ConvolutionLayer &layer,
+        std::shared_ptr<const std::vector<std::vector<std::vector<float>>>> input_image);
+
+    int channels() const { return static_cast<int>(channel_cache_.size()); }
+    int height() const { return geometry_.output_height; }
+    int width() const { return geometry_.output_width; }
+
+    // Output channel [output_height][output_width], computed on first access
+    const std::vector<std::vector<float>> &channel(int out_c) const;
+
+    // Single output value; computes its whole channel on first access
+    float at(int out_c, int out_h, int out_w) const { return channel(out_c)[out_h][out_w]; }
+
+    // True if the channel has already been computed
+    bool is_computed(int out_c) const;
+
+    // Compute every remaining channel and return the full [out_c][height][width] image
+    std::vector<std::vector<std::vector<float>>> materialize() const;
+
+private:
+    const ConvolutionLayer *layer_;
+    std::shared_ptr<const std::vector<std::vector<std::vector<float>>>> input_image_;
+    ConvolutionGeometry geometry_;
+    mutable std::vector<std::vector<std::vector<float>>> channel_cache_;
+    mutable std::vector<bool> computed_;
+};
+
 #endif // CONVOLUTION_H
\ No newline at end of file
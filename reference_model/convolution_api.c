@@ -0,0 +1,526 @@
+#include "convolution_api.h"
+#include <pthread.h>
+#include <stdlib.h> // For malloc, free
+#include <string.h> // For memcpy
+#include <unistd.h> // For sysconf
+#include "convolution_c_simd.h"
+
+struct conv_layer
+{
+    conv_layer_desc desc;
+    float *weights; // [out_c][in_c][k_h][k_w]
+    conv_allocator allocator;
+};
+
+// Work handed to the pool: body(argument, begin, end) over [0, count), split statically
+typedef void (*conv_job_body)(void *argument, int begin, int end);
+
+struct conv_context
+{
+    conv_allocator allocator;
+    float *workspace;
+    size_t workspace_bytes;
+
+    pthread_t *workers; // thread_count - 1 workers; the calling thread takes part 0
+    int thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+    unsigned long generation; // bumped once per job
+    int pending;              // workers still running the current job
+    int stopping;
+
+    conv_job_body job_body;
+    void *job_argument;
+    int job_count;
+    int next_part; // next part number a woken worker takes
+
+    ConvSimdLevelC simd_level; // row kernel level for this context's calls
+};
+
+// Arguments shared by the pack and compute phases of one conv_forward_into call
+typedef struct
+{
+    const conv_layer *layer;
+    conv_dl_chw input; // float32 for conv_buffer inputs, any supported element type for DLPack
+    const conv_buffer *output;
+    float *padded; // [in_c][padded_height][padded_width], border already applied
+    int padded_height;
+    int padded_width;
+    int padding_h;
+    int padding_w;
+    ConvRowKernelC row_kernel; // used when output rows are contiguous
+} conv_forward_job;
+
+static void *default_allocate(void *user_data, size_t size)
+{
+    (void)user_data;
+    return malloc(size);
+}
+
+static void default_release(void *user_data, void *pointer)
+{
+    (void)user_data;
+    free(pointer);
+}
+
+static conv_allocator resolve_allocator(const conv_allocator *allocator)
+{
+    conv_allocator resolved = {default_allocate, default_release, NULL};
+    if (allocator && allocator->allocate && allocator->release)
+    {
+        resolved = *allocator;
+    }
+    return resolved;
+}
+
+// Same output size and SAME padding rule as forward_convolution_c; 0 if the border mode
+// cannot fill the padding
+static int compute_geometry(const conv_layer_desc *desc, int input_height, int input_width,
+                            int *output_height, int *output_width, int *padding_h, int *padding_w)
+{
+    if (input_height <= 0 || input_width <= 0)
+        return 0;
+    if (desc->padding == CONV_PADDING_VALID)
+    {
+        if (input_height < desc->kernel_size || input_width < desc->kernel_size)
+            return 0;
+        *output_height = (input_height - desc->kernel_size) / desc->stride + 1;
+        *output_width = (input_width - desc->kernel_size) / desc->stride + 1;
+        *padding_h = 0;
+        *padding_w = 0;
+    }
+    else
+    {
+        *output_height = (input_height + desc->stride - 1) / desc->stride;
+        *output_width = (input_width + desc->stride - 1) / desc->stride;
+        *padding_h = ((*output_height - 1) * desc->stride + desc->kernel_size - input_height) / 2;
+        *padding_w = ((*output_width - 1) * desc->stride + desc->kernel_size - input_width) / 2;
+        if (*padding_h < 0)
+            *padding_h = 0;
+        if (*padding_w < 0)
+            *padding_w = 0;
+    }
+    return conv_border_fits(*padding_h, (*output_height - 1) * desc->stride + desc->kernel_size - *padding_h - input_height,
+                            input_height, desc->border) &&
+           conv_border_fits(*padding_w, (*output_width - 1) * desc->stride + desc->kernel_size - *padding_w - input_width,
+                            input_width, desc->border);
+}
+
+const char *conv_status_string(conv_status status)
+{
+    switch (status)
+    {
+    case CONV_OK:
+        return "ok";
+    case CONV_ERROR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case CONV_ERROR_SHAPE_MISMATCH:
+        return "buffer shape does not match the layer";
+    case CONV_ERROR_OUT_OF_MEMORY:
+        return "out of memory";
+    case CONV_ERROR_THREAD:
+        return "thread creation failed";
+    }
+    return "unknown status";
+}
+
+conv_status conv_layer_create(const conv_layer_desc *desc, const float *weights,
+                              const conv_allocator *allocator, conv_layer **out_layer)
+{
+    if (!desc || !weights || !out_layer || desc->kernel_size <= 0 || desc->stride <= 0 ||
+        desc->input_channels <= 0 || desc->output_channels <= 0 ||
+        (desc->padding != CONV_PADDING_VALID && desc->padding != CONV_PADDING_SAME) ||
+        desc->border < CONV_BORDER_ZERO || desc->border > CONV_BORDER_CIRCULAR)
+    {
+        return CONV_ERROR_INVALID_ARGUMENT;
+    }
+
+    conv_allocator resolved = resolve_allocator(allocator);
+    size_t weight_count = (size_t)desc->output_channels * desc->input_channels * desc->kernel_size * desc->kernel_size;
+    conv_layer *layer = (conv_layer *)resolved.allocate(resolved.user_data, sizeof(conv_layer));
+    if (!layer)
+        return CONV_ERROR_OUT_OF_MEMORY;
+    layer->weights = (float *)resolved.allocate(resolved.user_data, weight_count * sizeof(float));
+    if (!layer->weights)
+    {
+        resolved.release(resolved.user_data, layer);
+        return CONV_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(layer->weights, weights, weight_count * sizeof(float));
+    layer->desc = *desc;
+    layer->allocator = resolved;
+
+    *out_layer = layer;
+    return CONV_OK;
+}
+
+void conv_layer_destroy(conv_layer *layer)
+{
+    if (!layer)
+        return;
+    conv_allocator allocator = layer->allocator;
+    allocator.release(allocator.user_data, layer->weights);
+    allocator.release(allocator.user_data, layer);
+}
+
+conv_status conv_layer_output_shape(const conv_layer *layer, int input_height, int input_width,
+                                    int *output_height, int *output_width)
+{
+    int padding_h, padding_w;
+    if (!layer || !output_height || !output_width ||
+        !compute_geometry(&layer->desc, input_height, input_width, output_height, output_width, &padding_h, &padding_w))
+    {
+        return CONV_ERROR_INVALID_ARGUMENT;
+    }
+    return CONV_OK;
+}
+
+conv_status conv_layer_workspace_size(const conv_layer *layer, int input_height, int input_width,
+                                      size_t *workspace_bytes)
+{
+    int output_height, output_width, padding_h, padding_w;
+    if (!layer || !workspace_bytes ||
+        !compute_geometry(&layer->desc, input_height, input_width, &output_height, &output_width, &padding_h, &padding_w))
+    {
+        return CONV_ERROR_INVALID_ARGUMENT;
+    }
+    size_t padded_height = (size_t)(output_height - 1) * layer->desc.stride + layer->desc.kernel_size;
+    size_t padded_width = (size_t)(output_width - 1) * layer->desc.stride + layer->desc.kernel_size;
+    *workspace_bytes = (size_t)layer->desc.input_channels * padded_height * padded_width * sizeof(float);
+    return CONV_OK;
+}
+
+static void run_part(conv_job_body body, void *argument, int count, int part, int parts)
+{
+    int begin = (int)((long long)count * part / parts);
+    int end = (int)((long long)count * (part + 1) / parts);
+    if (begin < end)
+        body(argument, begin, end);
+}
+
+static void *worker_main(void *argument)
+{
+    conv_context *context = (conv_context *)argument;
+    unsigned long seen_generation = 0;
+
+    pthread_mutex_lock(&context->mutex);
+    while (1)
+    {
+        while (context->generation == seen_generation && !context->stopping)
+            pthread_cond_wait(&context->job_ready, &context->mutex);
+        if (context->stopping)
+            break;
+        seen_generation = context->generation;
+        int part = context->next_part++;
+        conv_job_body body = context->job_body;
+        void *job_argument = context->job_argument;
+        int count = context->job_count;
+        pthread_mutex_unlock(&context->mutex);
+
+        run_part(body, job_argument, count, part, context->thread_count);
+
+        pthread_mutex_lock(&context->mutex);
+        if (--context->pending == 0)
+            pthread_cond_signal(&context->job_done);
+    }
+    pthread_mutex_unlock(&context->mutex);
+    return NULL;
+}
+
+// Run body over [0, count) on all threads of the context and wait for it to finish
+static void run_parallel(conv_context *context, conv_job_body body, void *argument, int count)
+{
+    if (context->thread_count == 1)
+    {
+        run_part(body, argument, count, 0, 1);
+        return;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+    context->job_body = body;
+    context->job_argument = argument;
+    context->job_count = count;
+    context->next_part = 1; // part 0 belongs to the caller
+    context->pending = context->thread_count - 1;
+    ++context->generation;
+    pthread_cond_broadcast(&context->job_ready);
+    pthread_mutex_unlock(&context->mutex);
+
+    run_part(body, argument, count, 0, context->thread_count);
+
+    pthread_mutex_lock(&context->mutex);
+    while (context->pending > 0)
+        pthread_cond_wait(&context->job_done, &context->mutex);
+    pthread_mutex_unlock(&context->mutex);
+}
+
+static void stop_workers(conv_context *context, int started)
+{
+    pthread_mutex_lock(&context->mutex);
+    context->stopping = 1;
+    pthread_cond_broadcast(&context->job_ready);
+    pthread_mutex_unlock(&context->mutex);
+    for (int t = 0; t < started; ++t)
+        pthread_join(context->workers[t], NULL);
+}
+
+conv_status conv_context_create(const conv_context_desc *desc, conv_context **out_context)
+{
+    if (!out_context)
+        return CONV_ERROR_INVALID_ARGUMENT;
+
+    conv_allocator resolved = resolve_allocator(desc ? desc->allocator : NULL);
+    conv_context *context = (conv_context *)resolved.allocate(resolved.user_data, sizeof(conv_context));
+    if (!context)
+        return CONV_ERROR_OUT_OF_MEMORY;
+    memset(context, 0, sizeof(*context));
+    context->allocator = resolved;
+
+    int thread_count = desc ? desc->num_threads : 0;
+    if (thread_count <= 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = online > 0 ? (int)online : 1;
+    }
+    context->thread_count = thread_count;
+    context->simd_level = conv_simd_detect();
+
+    if (desc && desc->workspace_bytes > 0 && conv_context_reserve(context, desc->workspace_bytes) != CONV_OK)
+    {
+        resolved.release(resolved.user_data, context);
+        return CONV_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_init(&context->mutex, NULL);
+    pthread_cond_init(&context->job_ready, NULL);
+    pthread_cond_init(&context->job_done, NULL);
+    if (thread_count > 1)
+    {
+        context->workers = (pthread_t *)resolved.allocate(resolved.user_data, (size_t)(thread_count - 1) * sizeof(pthread_t));
+        if (!context->workers)
+        {
+            context->thread_count = 1;
+            conv_context_destroy(context);
+            return CONV_ERROR_OUT_OF_MEMORY;
+        }
+        for (int t = 0; t < thread_count - 1; ++t)
+        {
+            if (pthread_create(&context->workers[t], NULL, worker_main, context) != 0)
+            {
+                stop_workers(context, t);
+                context->thread_count = 1; // workers already joined
+                conv_context_destroy(context);
+                return CONV_ERROR_THREAD;
+            }
+        }
+    }
+
+    *out_context = context;
+    return CONV_OK;
+}
+
+void conv_context_destroy(conv_context *context)
+{
+    if (!context)
+        return;
+    if (context->thread_count > 1)
+        stop_workers(context, context->thread_count - 1);
+    pthread_cond_destroy(&context->job_done);
+    pthread_cond_destroy(&context->job_ready);
+    pthread_mutex_destroy(&context->mutex);
+
+    conv_allocator allocator = context->allocator;
+    if (context->workers)
+        allocator.release(allocator.user_data, context->workers);
+    if (context->workspace)
+        allocator.release(allocator.user_data, context->workspace);
+    allocator.release(allocator.user_data, context);
+}
+
+conv_status conv_context_reserve(conv_context *context, size_t workspace_bytes)
+{
+    if (!context)
+        return CONV_ERROR_INVALID_ARGUMENT;
+    if (workspace_bytes <= context->workspace_bytes)
+        return CONV_OK;
+
+    float *workspace = (float *)context->allocator.allocate(context->allocator.user_data, workspace_bytes);
+    if (!workspace)
+        return CONV_ERROR_OUT_OF_MEMORY;
+    if (context->workspace)
+        context->allocator.release(context->allocator.user_data, context->workspace);
+    context->workspace = workspace;
+    context->workspace_bytes = workspace_bytes;
+    return CONV_OK;
+}
+
+int conv_context_thread_count(const conv_context *context)
+{
+    return context ? context->thread_count : 0;
+}
+
+conv_status conv_context_set_simd_level(conv_context *context, ConvSimdLevelC level)
+{
+    if (!context || level < CONV_SIMD_SCALAR || level > CONV_SIMD_AVX2)
+        return CONV_ERROR_INVALID_ARGUMENT;
+    ConvSimdLevelC detected = conv_simd_detect();
+    context->simd_level = level > detected ? detected : level;
+    return CONV_OK;
+}
+
+ConvSimdLevelC conv_context_simd_level(const conv_context *context)
+{
+    return context ? context->simd_level : CONV_SIMD_SCALAR;
+}
+
+// Phase 1, one item per input channel: copy the strided input into the bordered workspace
+// (zeros or the border mode's source pixels) so the compute phase needs neither bounds checks
+// nor stride arithmetic.
+// This is also where non-float32 DLPack inputs are converted.
+static void pack_input_channels(void *argument, int begin, int end)
+{
+    const conv_forward_job *job = (const conv_forward_job *)argument;
+    const conv_dl_chw *input = &job->input;
+    const float *input_floats = (const float *)input->data;
+    const ConvBorderModeC border = job->layer->desc.border;
+    for (int c = begin; c < end; ++c)
+    {
+        float *plane = job->padded + (size_t)c * job->padded_height * job->padded_width;
+        for (int y = 0; y < job->padded_height; ++y)
+        {
+            int h = conv_border_index(y - job->padding_h, input->height, border);
+            float *row = plane + (size_t)y * job->padded_width;
+            for (int x = 0; x < job->padded_width; ++x)
+            {
+                int w = conv_border_index(x - job->padding_w, input->width, border);
+                if (h < 0 || w < 0)
+                    row[x] = 0.0f;
+                else if (input->element == CONV_DL_ELEMENT_FLOAT32)
+                    row[x] = input_floats[c * input->channel_stride + h * input->row_stride + w * input->column_stride];
+                else
+                    row[x] = conv_dl_chw_load(input, c, h, w);
+            }
+        }
+    }
+}
+
+// Phase 2, one item per (out_c, out_h) output row. Accumulates in the same order as
+// forward_convolution_c (in_c, k_h, k_w), so results match it exactly.
+static void compute_output_rows(void *argument, int begin, int end)
+{
+    const conv_forward_job *job = (const conv_forward_job *)argument;
+    const conv_layer_desc *desc = &job->layer->desc;
+    const conv_buffer *output = job->output;
+    const size_t plane_size = (size_t)job->padded_height * job->padded_width;
+    const size_t filter_size = (size_t)desc->input_channels * desc->kernel_size * desc->kernel_size;
+
+    for (int item = begin; item < end; ++item)
+    {
+        int out_c = item / output->height;
+        int out_h = item % output->height;
+        const float *filter = job->layer->weights + out_c * filter_size;
+        float *destination = output->data + out_c * output->channel_stride + out_h * output->row_stride;
+
+        if (output->column_stride == 1)
+        {
+            job->row_kernel(job->padded, plane_size, job->padded_width, filter, desc->input_channels,
+                            desc->kernel_size, desc->stride, out_h, output->width, destination);
+            continue;
+        }
+
+        // Strided output row: the vector kernels store contiguously, so accumulate here
+        for (int out_w = 0; out_w < output->width; ++out_w)
+        {
+            float sum = 0.0f;
+            const float *weight = filter;
+            for (int in_c = 0; in_c < desc->input_channels; ++in_c)
+            {
+                const float *window = job->padded + in_c * plane_size +
+                                      (size_t)(out_h * desc->stride) * job->padded_width + out_w * desc->stride;
+                for (int k_h = 0; k_h < desc->kernel_size; ++k_h)
+                {
+                    const float *window_row = window + (size_t)k_h * job->padded_width;
+                    for (int k_w = 0; k_w < desc->kernel_size; ++k_w)
+                        sum += window_row[k_w] * *weight++;
+                }
+            }
+            destination[out_w * output->column_stride] = sum;
+        }
+    }
+}
+
+// Shared by conv_forward_into and conv_forward_dl once the input is a CHW view
+static conv_status forward_view(const conv_layer *layer, conv_context *context,
+                                const conv_dl_chw *input, const conv_buffer *output)
+{
+    conv_forward_job job;
+    int output_height, output_width;
+    if (!compute_geometry(&layer->desc, input->height, input->width,
+                          &output_height, &output_width, &job.padding_h, &job.padding_w))
+    {
+        return CONV_ERROR_SHAPE_MISMATCH;
+    }
+    if (input->channels != layer->desc.input_channels || output->channels != layer->desc.output_channels ||
+        output->height != output_height || output->width != output_width)
+    {
+        return CONV_ERROR_SHAPE_MISMATCH;
+    }
+
+    size_t workspace_bytes;
+    conv_layer_workspace_size(layer, input->height, input->width, &workspace_bytes);
+    conv_status status = conv_context_reserve(context, workspace_bytes);
+    if (status != CONV_OK)
+        return status;
+
+    job.layer = layer;
+    job.input = *input;
+    job.output = output;
+    job.padded = context->workspace;
+    job.padded_height = (output_height - 1) * layer->desc.stride + layer->desc.kernel_size;
+    job.padded_width = (output_width - 1) * layer->desc.stride + layer->desc.kernel_size;
+    job.row_kernel = conv_simd_select_row_kernel(context->simd_level, layer->desc.kernel_size, layer->desc.stride);
+
+    run_parallel(context, pack_input_channels, &job, layer->desc.input_channels);
+    run_parallel(context, compute_output_rows, &job, layer->desc.output_channels * output_height);
+    return CONV_OK;
+}
+
+conv_status conv_forward_into(const conv_layer *layer, conv_context *context,
+                              const conv_buffer *input, const conv_buffer *output)
+{
+    if (!layer || !context || !input || !output || !input->data || !output->data)
+        return CONV_ERROR_INVALID_ARGUMENT;
+
+    conv_dl_chw view;
+    view.data = (const char *)input->data;
+    view.element = CONV_DL_ELEMENT_FLOAT32;
+    view.channels = input->channels;
+    view.height = input->height;
+    view.width = input->width;
+    view.channel_stride = input->channel_stride;
+    view.row_stride = input->row_stride;
+    view.column_stride = input->column_stride;
+    return forward_view(layer, context, &view, output);
+}
+
+conv_status conv_forward_dl(const conv_layer *layer, conv_context *context,
+                            const conv_dl_tensor *input, const conv_dl_tensor *output)
+{
+    conv_dl_chw input_view, output_view;
+    if (!layer || !context || !conv_dl_tensor_to_chw(input, &input_view) ||
+        !conv_dl_tensor_to_chw(output, &output_view) || output_view.element != CONV_DL_ELEMENT_FLOAT32)
+    {
+        return CONV_ERROR_INVALID_ARGUMENT;
+    }
+
+    conv_buffer output_buffer;
+    output_buffer.data = (float *)output_view.data;
+    output_buffer.channels = output_view.channels;
+    output_buffer.height = output_view.height;
+    output_buffer.width = output_view.width;
+    output_buffer.channel_stride = output_view.channel_stride;
+    output_buffer.row_stride = output_view.row_stride;
+    output_buffer.column_stride = output_view.column_stride;
+    return forward_view(layer, context, &input_view, &output_buffer);
+}
@@ -0,0 +1,124 @@
+#ifndef CONVOLUTION_API_H
+#define CONVOLUTION_API_H
+
+#include <stddef.h> // For size_t, ptrdiff_t
+#include "convolution_c_simd.h"
+#include "dl_tensor.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Embeddable C API. Unlike convolution_c.h it keeps no global state, never prints and
+    // never allocates inside conv_forward_into once the context's workspace is large enough:
+    //   - conv_layer holds immutable, contiguously packed weights and may be shared by any
+    //     number of threads;
+    //   - conv_context owns worker threads and scratch memory; one context serves one call at a
+    //     time, so give each calling thread its own context;
+    //   - input and output are caller-owned strided buffers.
+    // Threads use POSIX pthreads.
+
+    typedef enum
+    {
+        CONV_OK = 0,
+        CONV_ERROR_INVALID_ARGUMENT,
+        CONV_ERROR_SHAPE_MISMATCH,
+        CONV_ERROR_OUT_OF_MEMORY,
+        CONV_ERROR_THREAD
+    } conv_status;
+
+    typedef enum
+    {
+        CONV_PADDING_VALID,
+        CONV_PADDING_SAME
+    } conv_padding;
+
+    // Optional allocator; NULL members (or a NULL allocator) fall back to malloc/free
+    typedef struct
+    {
+        void *(*allocate)(void *user_data, size_t size);
+        void (*release)(void *user_data, void *pointer);
+        void *user_data;
+    } conv_allocator;
+
+    typedef struct
+    {
+        int kernel_size;
+        int stride;
+        conv_padding padding;
+        int input_channels;
+        int output_channels;
+        ConvBorderModeC border; // fill rule for the padding; CONV_BORDER_ZERO (0) when left unset
+    } conv_layer_desc;
+
+    typedef struct
+    {
+        int num_threads;        // total threads including the caller; <= 0 uses the online CPU count
+        size_t workspace_bytes; // initial scratch reservation, see conv_layer_workspace_size
+        const conv_allocator *allocator;
+    } conv_context_desc;
+
+    // CHW view of caller memory. Strides are in elements and may describe padded rows,
+    // interleaved (HWC) storage or any other layout.
+    typedef struct
+    {
+        float *data;
+        int channels;
+        int height;
+        int width;
+        ptrdiff_t channel_stride;
+        ptrdiff_t row_stride;
+        ptrdiff_t column_stride;
+    } conv_buffer;
+
+    typedef struct conv_layer conv_layer;
+    typedef struct conv_context conv_context;
+
+    const char *conv_status_string(conv_status status);
+
+    // weights: contiguous [out_c][in_c][k_h][k_w], copied into the layer
+    conv_status conv_layer_create(const conv_layer_desc *desc, const float *weights,
+                                  const conv_allocator *allocator, conv_layer **out_layer);
+    void conv_layer_destroy(conv_layer *layer);
+
+    // CONV_ERROR_INVALID_ARGUMENT also covers inputs too small for the border mode
+    conv_status conv_layer_output_shape(const conv_layer *layer, int input_height, int input_width,
+                                        int *output_height, int *output_width);
+
+    // Scratch conv_forward_into needs for an input of this size
+    conv_status conv_layer_workspace_size(const conv_layer *layer, int input_height, int input_width,
+                                          size_t *workspace_bytes);
+
+    conv_status conv_context_create(const conv_context_desc *desc, conv_context **out_context);
+    void conv_context_destroy(conv_context *context);
+
+    // Grow the context's workspace to at least workspace_bytes (the only call that allocates)
+    conv_status conv_context_reserve(conv_context *context, size_t workspace_bytes);
+
+    int conv_context_thread_count(const conv_context *context);
+
+    // Row kernel level used by this context's calls, conv_simd_detect() by default. Lower it
+    // e.g. to compare kernels; levels above the detected one are clamped. Set it only while
+    // no call is running on the context.
+    conv_status conv_context_set_simd_level(conv_context *context, ConvSimdLevelC level);
+    ConvSimdLevelC conv_context_simd_level(const conv_context *context);
+
+    // Convolve input into output, which must already have the layer's output shape.
+    // Results are bit-identical to forward_convolution_c. If the workspace is too small it
+    // is grown once through the context's allocator.
+    conv_status conv_forward_into(const conv_layer *layer, conv_context *context,
+                                  const conv_buffer *input, const conv_buffer *output);
+
+    // Same as conv_forward_into for DLPack-style tensors ([C,H,W] or [1,C,H,W], any strides).
+    // The input may be float32, float64 or uint8 and is converted while it is copied into the
+    // workspace; the output must be float32. Returns CONV_ERROR_INVALID_ARGUMENT for tensors
+    // that are not on the CPU or have another dtype or rank.
+    conv_status conv_forward_dl(const conv_layer *layer, conv_context *context,
+                                const conv_dl_tensor *input, const conv_dl_tensor *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONVOLUTION_API_H
@@ -1,330 +1,460 @@
-#include "convolution_c.h"
-#include <string.h> // For memcpy if needed, or manual copy
-
-// Helper function for max, similar to std::max
-static inline int max_c(int a, int b)
-{
-    return a > b ? a : b;
-}
-
-// Helper to calculate padding amount for SAME mode (internal to this file)
-static int calculate_padding_amount_c(int input_dim, int output_dim_target, int kernel_size, int stride)
-{
-    int pad = ((output_dim_target - 1) * stride + kernel_size - input_dim) / 2;
-    return max_c(0, pad);
-}
-
-// Function to allocate a 4D float array
-static float ****allocate_4d_float_array(int d1, int d2, int d3, int d4)
-{
-    float ****array = (float ****)malloc(d1 * sizeof(float ***));
-    if (!array)
-        return NULL;
-
-    for (int i = 0; i < d1; ++i)
-    {
-        array[i] = (float ***)malloc(d2 * sizeof(float **));
-        if (!array[i])
-        {
-            // Free previously allocated memory before returning NULL
-            for (int k = 0; k < i; ++k)
-            {
-                // Needs further nested freeing if d3 was allocated
-                for (int l = 0; l < d2; ++l)
-                { // This is incorrect, should check if array[k][l] was allocated
-                  // This level of cleanup is complex, simplified for now.
-                }
-                // Simplified: free(array[k][?]) and free(array[k])
-            }
-            // A full cleanup here is complex. For brevity, assume outer allocations fail first or handle it more robustly in production.
-            // For now, just free the top level if second level fails
-            for (int k = 0; k < i; ++k)
-            {
-                for (int l = 0; l < d2; ++l)
-                {
-                    // Assuming d3, d4 not yet allocated for array[k][l]
-                }
-                free(array[k]);
-            }
-            free(array);
-            return NULL;
-        }
-        for (int j = 0; j < d2; ++j)
-        {
-            array[i][j] = (float **)malloc(d3 * sizeof(float *));
-            if (!array[i][j])
-            { /* Similar complex cleanup needed */
-                free(array);
-                return NULL;
-            }
-            for (int k = 0; k < d3; ++k)
-            {
-                array[i][j][k] = (float *)malloc(d4 * sizeof(float));
-                if (!array[i][j][k])
-                { /* Similar complex cleanup needed */
-                    free(array);
-                    return NULL;
-                }
-            }
-        }
-    }
-    return array;
-}
-
-// Function to free a 4D float array
-static void free_4d_float_array(float ****array, int d1, int d2, int d3)
-{
-    if (!array)
-        return;
-    for (int i = 0; i < d1; ++i)
-    {
-        if (array[i])
-        {
-            for (int j = 0; j < d2; ++j)
-            {
-                if (array[i][j])
-                {
-                    for (int k = 0; k < d3; ++k)
-                    {
-                        free(array[i][j][k]);
-                    }
-                    free(array[i][j]);
-                }
-            }
-            free(array[i]);
-        }
-    }
-    free(array);
-}
-
-// Function to allocate a 3D float array
-static float ***allocate_3d_float_array(int d1, int d2, int d3)
-{
-    float ***array = (float ***)malloc(d1 * sizeof(float **));
-    if (!array)
-        return NULL;
-    for (int i = 0; i < d1; ++i)
-    {
-        array[i] = (float **)malloc(d2 * sizeof(float *));
-        if (!array[i])
-        { /* Complex cleanup */
-            free(array);
-            return NULL;
-        }
-        for (int j = 0; j < d2; ++j)
-        {
-            array[i][j] = (float *)malloc(d3 * sizeof(float));
-            if (!array[i][j])
-            { /* Complex cleanup */
-                free(array);
-                return NULL;
-            }
-        }
-    }
-    return array;
-}
-
-// Function to free a 3D float array
-void free_3d_float_array(float ***array, int d1, int d2)
-{ // Made non-static to be callable from main_c.c
-    if (!array)
-        return;
-    for (int i = 0; i < d1; ++i)
-    {
-        if (array[i])
-        {
-            for (int j = 0; j < d2; ++j)
-            {
-                free(array[i][j]);
-            }
-            free(array[i]);
-        }
-    }
-    free(array);
-}
-
-ConvolutionLayerC *create_convolution_layer_c(
-    int kernel_size,
-    int stride,
-    PaddingModeC padding_mode,
-    int input_channels,
-    int output_channels,
-    const float ****initial_kernel_weights)
-{
-
-    if (kernel_size <= 0 || stride <= 0 || input_channels <= 0 || output_channels <= 0)
-    {
-        fprintf(stderr, "Error: Invalid parameters for convolution layer creation.\n");
-        return NULL;
-    }
-    if (!initial_kernel_weights && output_channels > 0)
-    {
-        fprintf(stderr, "Error: initial_kernel_weights cannot be NULL if output_channels > 0.\n");
-        return NULL;
-    }
-
-    ConvolutionLayerC *layer = (ConvolutionLayerC *)malloc(sizeof(ConvolutionLayerC));
-    if (!layer)
-    {
-        perror("Error allocating memory for ConvolutionLayerC");
-        return NULL;
-    }
-
-    layer->kernel_size = kernel_size;
-    layer->stride = stride;
-    layer->padding_mode = padding_mode;
-    layer->input_channels = input_channels;
-    layer->output_channels = output_channels;
-
-    layer->kernel_weights = allocate_4d_float_array(output_channels, input_channels, kernel_size, kernel_size);
-    if (!layer->kernel_weights)
-    {
-        fprintf(stderr, "Error: Failed to allocate memory for kernel weights.\n");
-        free(layer);
-        return NULL;
-    }
-
-    // Copy initial_kernel_weights
-    for (int oc = 0; oc < output_channels; ++oc)
-    {
-        if (!initial_kernel_weights[oc])
-        { /* Error check needed */
-            free_4d_float_array(layer->kernel_weights, oc, 0, 0);
-            free(layer);
-            return NULL;
-        }
-        for (int ic = 0; ic < input_channels; ++ic)
-        {
-            if (!initial_kernel_weights[oc][ic])
-            { /* Error check needed */
-                free_4d_float_array(layer->kernel_weights, output_channels, ic, 0);
-                free(layer);
-                return NULL;
-            }
-            for (int kh = 0; kh < kernel_size; ++kh)
-            {
-                if (!initial_kernel_weights[oc][ic][kh])
-                { /* Error check needed */
-                    free_4d_float_array(layer->kernel_weights, output_channels, input_channels, kh);
-                    free(layer);
-                    return NULL;
-                }
-                for (int kw = 0; kw < kernel_size; ++kw)
-                {
-                    layer->kernel_weights[oc][ic][kh][kw] = initial_kernel_weights[oc][ic][kh][kw];
-                }
-            }
-        }
-    }
-
-    return layer;
-}
-
-void destroy_convolution_layer_c(ConvolutionLayerC *layer)
-{
-    if (!layer)
-        return;
-
-    free_4d_float_array(layer->kernel_weights, layer->output_channels, layer->input_channels, layer->kernel_size);
-    free(layer);
-}
-
-float ***forward_convolution_c(
-    const ConvolutionLayerC *layer,
-    const float ***input_image, // [in_c][input_height][input_width]
-    int input_height,
-    int input_width,
-    OutputDimensions *out_dims)
-{
-
-    if (!layer || !input_image || !out_dims)
-    {
-        fprintf(stderr, "Error: NULL pointer passed to forward_convolution_c.\n");
-        return NULL;
-    }
-    if (input_height <= 0 || input_width <= 0)
-    {
-        fprintf(stderr, "Error: Invalid input dimensions.\n");
-        return NULL;
-    }
-    // Validate input_image dimensions against layer->input_channels (difficult without knowing input_image's channel count directly)
-    // This would typically be an assertion or checked if the input format also passed channel count.
-
-    int output_h, output_w;
-    int padding_h = 0;
-    int padding_w = 0;
-
-    if (layer->padding_mode == PADDING_VALID)
-    {
-        output_h = (input_height - layer->kernel_size) / layer->stride + 1;
-        output_w = (input_width - layer->kernel_size) / layer->stride + 1;
-    }
-    else
-    { // PADDING_SAME
-        output_h = (int)ceilf((float)input_height / layer->stride);
-        output_w = (int)ceilf((float)input_width / layer->stride);
-        padding_h = calculate_padding_amount_c(input_height, output_h, layer->kernel_size, layer->stride);
-        padding_w = calculate_padding_amount_c(input_width, output_w, layer->kernel_size, layer->stride);
-    }
-
-    if (output_h <= 0 || output_w <= 0)
-    {
-        fprintf(stderr, "Error: Calculated output dimensions are non-positive.\n");
-        return NULL;
-    }
-
-    out_dims->height = output_h;
-    out_dims->width = output_w;
-    out_dims->channels = layer->output_channels;
-
-    float ***output_image = allocate_3d_float_array(layer->output_channels, output_h, output_w);
-    if (!output_image)
-    {
-        fprintf(stderr, "Error: Failed to allocate memory for output image.\n");
-        return NULL;
-    }
-
-    // Initialize output_image to zeros
-    for (int oc = 0; oc < layer->output_channels; ++oc)
-    {
-        for (int oh = 0; oh < output_h; ++oh)
-        {
-            for (int ow = 0; ow < output_w; ++ow)
-            {
-                output_image[oc][oh][ow] = 0.0f;
-            }
-        }
-    }
-
-    for (int out_c = 0; out_c < layer->output_channels; ++out_c)
-    {
-        for (int out_h = 0; out_h < output_h; ++out_h)
-        {
-            for (int out_w = 0; out_w < output_w; ++out_w)
-            {
-                float sum = 0.0f;
-                for (int in_c = 0; in_c < layer->input_channels; ++in_c)
-                {
-                    for (int k_h = 0; k_h < layer->kernel_size; ++k_h)
-                    {
-                        for (int k_w = 0; k_w < layer->kernel_size; ++k_w)
-                        {
-                            int h_idx = out_h * layer->stride + k_h - padding_h;
-                            int w_idx = out_w * layer->stride + k_w - padding_w;
-
-                            float pixel_value = 0.0f;
-                            if (h_idx >= 0 && h_idx < input_height && w_idx >= 0 && w_idx < input_width)
-                            {
-                                pixel_value = input_image[in_c][h_idx][w_idx];
-                            }
-                            sum += pixel_value * layer->kernel_weights[out_c][in_c][k_h][k_w];
-                        }
-                    }
-                }
-                output_image[out_c][out_h][out_w] = sum;
-            }
-        }
-    }
-
-    return output_image;
+#include "convolution_c.h"
+#include <string.h> // For memcpy if needed, or manual copy
+#include "convolution_c_simd.h"
+
+// Helper function for max, similar to std::max
+static inline int max_c(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+// Helper to calculate padding amount for SAME mode (internal to this file)
+static int calculate_padding_amount_c(int input_dim, int output_dim_target, int kernel_size, int stride)
+{
+    int pad = ((output_dim_target - 1) * stride + kernel_size - input_dim) / 2;
+    return max_c(0, pad);
+}
+
+// Function to allocate a 4D float array
+static float ****allocate_4d_float_array(int d1, int d2, int d3, int d4)
+{
+    float ****array = (float ****)malloc(d1 * sizeof(float ***));
+    if (!array)
+        return NULL;
+
+    for (int i = 0; i < d1; ++i)
+    {
+        array[i] = (float ***)malloc(d2 * sizeof(float **));
+        if (!array[i])
+        {
+            // Free previously allocated memory before returning NULL
+            for (int k = 0; k < i; ++k)
+            {
+                // Needs further nested freeing if d3 was allocated
+                for (int l = 0; l < d2; ++l)
+                { // This is incorrect, should check if array[k][l] was allocated
+                  // This level of cleanup is complex, simplified for now.
+                }
+                // Simplified: free(array[k][?]) and free(array[k])
+            }
+            // A full cleanup here is complex. For brevity, assume outer allocations fail first or handle it more robustly in production.
+            // For now, just free the top level if second level fails
+            for (int k = 0; k < i; ++k)
+            {
+                for (int l = 0; l < d2; ++l)
+                {
+                    // Assuming d3, d4 not yet allocated for array[k][l]
+                }
+                free(array[k]);
+            }
+            free(array);
+            return NULL;
+        }
+        for (int j = 0; j < d2; ++j)
+        {
+            array[i][j] = (float **)malloc(d3 * sizeof(float *));
+            if (!array[i][j])
+            { /* Similar complex cleanup needed */
+                free(array);
+                return NULL;
+            }
+            for (int k = 0; k < d3; ++k)
+            {
+                array[i][j][k] = (float *)malloc(d4 * sizeof(float));
+                if (!array[i][j][k])
+                { /* Similar complex cleanup needed */
+                    free(array);
+                    return NULL;
+                }
+            }
+        }
+    }
+    return array;
+}
+
+// Function to free a 4D float array
+static void free_4d_float_array(float ****array, int d1, int d2, int d3)
+{
+    if (!array)
+        return;
+    for (int i = 0; i < d1; ++i)
+    {
+        if (array[i])
+        {
+            for (int j = 0; j < d2; ++j)
+            {
+                if (array[i][j])
+                {
+                    for (int k = 0; k < d3; ++k)
+                    {
+                        free(array[i][j][k]);
+                    }
+                    free(array[i][j]);
+                }
+            }
+            free(array[i]);
+        }
+    }
+    free(array);
+}
+
+// Function to allocate a 3D float array
+static float ***allocate_3d_float_array(int d1, int d2, int d3)
+{
+    float ***array = (float ***)malloc(d1 * sizeof(float **));
+    if (!array)
+        return NULL;
+    for (int i = 0; i < d1; ++i)
+    {
+        array[i] = (float **)malloc(d2 * sizeof(float *));
+        if (!array[i])
+        { /* Complex cleanup */
+            free(array);
+            return NULL;
+        }
+        for (int j = 0; j < d2; ++j)
+        {
+            array[i][j] = (float *)malloc(d3 * sizeof(float));
+            if (!array[i][j])
+            { /* Complex cleanup */
+                free(array);
+                return NULL;
+            }
+        }
+    }
+    return array;
+}
+
+// Function to free a 3D float array
+void free_3d_float_array(float ***array, int d1, int d2)
+{ // Made non-static to be callable from main_c.c
+    if (!array)
+        return;
+    for (int i = 0; i < d1; ++i)
+    {
+        if (array[i])
+        {
+            for (int j = 0; j < d2; ++j)
+            {
+                free(array[i][j]);
+            }
+            free(array[i]);
+        }
+    }
+    free(array);
+}
+
+ConvolutionLayerC *create_convolution_layer_c(
+    int kernel_size,
+    int stride,
+    PaddingModeC padding_mode,
+    int input_channels,
+    int output_channels,
+    const float ****initial_kernel_weights)
+{
+
+    if (kernel_size <= 0 || stride <= 0 || input_channels <= 0 || output_channels <= 0)
+    {
+        fprintf(stderr, "Error: Invalid parameters for convolution layer creation.\n");
+        return NULL;
+    }
+    if (!initial_kernel_weights && output_channels > 0)
+    {
+        fprintf(stderr, "Error: initial_kernel_weights cannot be NULL if output_channels > 0.\n");
+        return NULL;
+    }
+
+    ConvolutionLayerC *layer = (ConvolutionLayerC *)malloc(sizeof(ConvolutionLayerC));
+    if (!layer)
+    {
+        perror("Error allocating memory for ConvolutionLayerC");
+        return NULL;
+    }
+
+    layer->kernel_size = kernel_size;
+    layer->stride = stride;
+    layer->padding_mode = padding_mode;
+    layer->input_channels = input_channels;
+    layer->output_channels = output_channels;
+    layer->simd_level = conv_simd_detect();
+    layer->border_mode = CONV_BORDER_ZERO;
+
+    layer->kernel_weights = allocate_4d_float_array(output_channels, input_channels, kernel_size, kernel_size);
+    if (!layer->kernel_weights)
+    {
+        fprintf(stderr, "Error: Failed to allocate memory for kernel weights.\n");
+        free(layer);
+        return NULL;
+    }
+    layer->packed_weights = (float *)malloc((size_t)output_channels * input_channels * kernel_size * kernel_size * sizeof(float));
+    if (!layer->packed_weights)
+    {
+        fprintf(stderr, "Error: Failed to allocate memory for packed kernel weights.\n");
+        free_4d_float_array(layer->kernel_weights, output_channels, input_channels, kernel_size);
+        free(layer);
+        return NULL;
+    }
+
+    // Copy initial_kernel_weights
+    for (int oc = 0; oc < output_channels; ++oc)
+    {
+        if (!initial_kernel_weights[oc])
+        { /* Error check needed */
+            free_4d_float_array(layer->kernel_weights, oc, 0, 0);
+            free(layer->packed_weights);
+            free(layer);
+            return NULL;
+        }
+        for (int ic = 0; ic < input_channels; ++ic)
+        {
+            if (!initial_kernel_weights[oc][ic])
+            { /* Error check needed */
+                free_4d_float_array(layer->kernel_weights, output_channels, ic, 0);
+                free(layer->packed_weights);
+                free(layer);
+                return NULL;
+            }
+            for (int kh = 0; kh < kernel_size; ++kh)
+            {
+                if (!initial_kernel_weights[oc][ic][kh])
+                { /* Error check needed */
+                    free_4d_float_array(layer->kernel_weights, output_channels, input_channels, kh);
+                    free(layer->packed_weights);
+                    free(layer);
+                    return NULL;
+                }
+                for (int kw = 0; kw < kernel_size; ++kw)
+                {
+                    layer->kernel_weights[oc][ic][kh][kw] = initial_kernel_weights[oc][ic][kh][kw];
+                    layer->packed_weights[((oc * input_channels + ic) * kernel_size + kh) * kernel_size + kw] =
+                        initial_kernel_weights[oc][ic][kh][kw];
+                }
+            }
+        }
+    }
+
+    return layer;
+}
+
+void destroy_convolution_layer_c(ConvolutionLayerC *layer)
+{
+    if (!layer)
+        return;
+
+    free_4d_float_array(layer->kernel_weights, layer->output_channels, layer->input_channels, layer->kernel_size);
+    free(layer->packed_weights);
+    free(layer);
+}
+
+float ***forward_convolution_c_reference(
+    const ConvolutionLayerC *layer,
+    const float ***input_image, // [in_c][input_height][input_width]
+    int input_height,
+    int input_width,
+    OutputDimensions *out_dims)
+{
+
+    if (!layer || !input_image || !out_dims)
+    {
+        fprintf(stderr, "Error: NULL pointer passed to forward_convolution_c_reference.\n");
+        return NULL;
+    }
+    if (input_height <= 0 || input_width <= 0)
+    {
+        fprintf(stderr, "Error: Invalid input dimensions.\n");
+        return NULL;
+    }
+    // Validate input_image dimensions against layer->input_channels (difficult without knowing input_image's channel count directly)
+    // This would typically be an assertion or checked if the input format also passed channel count.
+
+    int output_h, output_w;
+    int padding_h = 0;
+    int padding_w = 0;
+
+    if (layer->padding_mode == PADDING_VALID)
+    {
+        output_h = (input_height - layer->kernel_size) / layer->stride + 1;
+        output_w = (input_width - layer->kernel_size) / layer->stride + 1;
+    }
+    else
+    { // PADDING_SAME
+        output_h = (int)ceilf((float)input_height / layer->stride);
+        output_w = (int)ceilf((float)input_width / layer->stride);
+        padding_h = calculate_padding_amount_c(input_height, output_h, layer->kernel_size, layer->stride);
+        padding_w = calculate_padding_amount_c(input_width, output_w, layer->kernel_size, layer->stride);
+    }
+
+    if (output_h <= 0 || output_w <= 0)
+    {
+        fprintf(stderr, "Error: Calculated output dimensions are non-positive.\n");
+        return NULL;
+    }
+    if (!conv_border_fits(padding_h, (output_h - 1) * layer->stride + layer->kernel_size - padding_h - input_height, input_height,
+                          layer->border_mode) ||
+        !conv_border_fits(padding_w, (output_w - 1) * layer->stride + layer->kernel_size - padding_w - input_width, input_width,
+                          layer->border_mode))
+    {
+        fprintf(stderr, "Error: Padding too large for the border mode.\n");
+        return NULL;
+    }
+
+    out_dims->height = output_h;
+    out_dims->width = output_w;
+    out_dims->channels = layer->output_channels;
+
+    float ***output_image = allocate_3d_float_array(layer->output_channels, output_h, output_w);
+    if (!output_image)
+    {
+        fprintf(stderr, "Error: Failed to allocate memory for output image.\n");
+        return NULL;
+    }
+
+    // Initialize output_image to zeros
+    for (int oc = 0; oc < layer->output_channels; ++oc)
+    {
+        for (int oh = 0; oh < output_h; ++oh)
+        {
+            for (int ow = 0; ow < output_w; ++ow)
+            {
+                output_image[oc][oh][ow] = 0.0f;
+            }
+        }
+    }
+
+    for (int out_c = 0; out_c < layer->output_channels; ++out_c)
+    {
+        for (int out_h = 0; out_h < output_h; ++out_h)
+        {
+            for (int out_w = 0; out_w < output_w; ++out_w)
+            {
+                float sum = 0.0f;
+                for (int in_c = 0; in_c < layer->input_channels; ++in_c)
+                {
+                    for (int k_h = 0; k_h < layer->kernel_size; ++k_h)
+                    {
+                        for (int k_w = 0; k_w < layer->kernel_size; ++k_w)
+                        {
+                            int h_idx = conv_border_index(out_h * layer->stride + k_h - padding_h, input_height, layer->border_mode);
+                            int w_idx = conv_border_index(out_w * layer->stride + k_w - padding_w, input_width, layer->border_mode);
+
+                            float pixel_value = 0.0f;
+                            if (h_idx >= 0 && w_idx >= 0)
+                            {
+                                pixel_value = input_image[in_c][h_idx][w_idx];
+                            }
+                            sum += pixel_value * layer->kernel_weights[out_c][in_c][k_h][k_w];
+                        }
+                    }
+                }
+                output_image[out_c][out_h][out_w] = sum;
+            }
+        }
+    }
+
+    return output_image;
+}
+
+float ***forward_convolution_c(
+    const ConvolutionLayerC *layer,
+    const float ***input_image, // [in_c][input_height][input_width]
+    int input_height,
+    int input_width,
+    OutputDimensions *out_dims)
+{
+
+    if (!layer || !input_image || !out_dims)
+    {
+        fprintf(stderr, "Error: NULL pointer passed to forward_convolution_c.\n");
+        return NULL;
+    }
+    if (input_height <= 0 || input_width <= 0)
+    {
+        fprintf(stderr, "Error: Invalid input dimensions.\n");
+        return NULL;
+    }
+
+    int output_h, output_w;
+    int padding_h = 0;
+    int padding_w = 0;
+
+    if (layer->padding_mode == PADDING_VALID)
+    {
+        output_h = (input_height - layer->kernel_size) / layer->stride + 1;
+        output_w = (input_width - layer->kernel_size) / layer->stride + 1;
+    }
+    else
+    { // PADDING_SAME
+        output_h = (int)ceilf((float)input_height / layer->stride);
+        output_w = (int)ceilf((float)input_width / layer->stride);
+        padding_h = calculate_padding_amount_c(input_height, output_h, layer->kernel_size, layer->stride);
+        padding_w = calculate_padding_amount_c(input_width, output_w, layer->kernel_size, layer->stride);
+    }
+
+    if (output_h <= 0 || output_w <= 0)
+    {
+        fprintf(stderr, "Error: Calculated output dimensions are non-positive.\n");
+        return NULL;
+    }
+    if (!conv_border_fits(padding_h, (output_h - 1) * layer->stride + layer->kernel_size - padding_h - input_height, input_height,
+                          layer->border_mode) ||
+        !conv_border_fits(padding_w, (output_w - 1) * layer->stride + layer->kernel_size - padding_w - input_width, input_width,
+                          layer->border_mode))
+    {
+        fprintf(stderr, "Error: Padding too large for the border mode.\n");
+        return NULL;
+    }
+
+    out_dims->height = output_h;
+    out_dims->width = output_w;
+    out_dims->channels = layer->output_channels;
+
+    // Contiguous copy of the input with the border filled, so the row kernels read every
+    // window without bounds checks. Covers exactly the rows and columns the windows touch.
+    int padded_h = (output_h - 1) * layer->stride + layer->kernel_size;
+    int padded_w = (output_w - 1) * layer->stride + layer->kernel_size;
+    size_t plane_size = (size_t)padded_h * padded_w;
+    float *padded = (float *)malloc(plane_size * layer->input_channels * sizeof(float));
+    if (!padded)
+    {
+        fprintf(stderr, "Error: Failed to allocate memory for padded input.\n");
+        return NULL;
+    }
+    for (int in_c = 0; in_c < layer->input_channels; ++in_c)
+    {
+        for (int y = 0; y < padded_h; ++y)
+        {
+            int h_idx = conv_border_index(y - padding_h, input_height, layer->border_mode);
+            float *padded_row = padded + in_c * plane_size + (size_t)y * padded_w;
+            for (int x = 0; x < padded_w; ++x)
+            {
+                int w_idx = conv_border_index(x - padding_w, input_width, layer->border_mode);
+                padded_row[x] = (h_idx >= 0 && w_idx >= 0)
+                                    ? input_image[in_c][h_idx][w_idx]
+                                    : 0.0f;
+            }
+        }
+    }
+
+    float ***output_image = allocate_3d_float_array(layer->output_channels, output_h, output_w);
+    if (!output_image)
+    {
+        fprintf(stderr, "Error: Failed to allocate memory for output image.\n");
+        free(padded);
+        return NULL;
+    }
+
+    ConvRowKernelC row_kernel = conv_simd_select_row_kernel(layer->simd_level, layer->kernel_size, layer->stride);
+    size_t filter_size = (size_t)layer->input_channels * layer->kernel_size * layer->kernel_size;
+    for (int out_c = 0; out_c < layer->output_channels; ++out_c)
+    {
+        for (int out_h = 0; out_h < output_h; ++out_h)
+        {
+            row_kernel(padded, plane_size, padded_w, layer->packed_weights + out_c * filter_size,
+                       layer->input_channels, layer->kernel_size, layer->stride, out_h, output_w,
+                       output_image[out_c][out_h]);
+        }
+    }
+
+    free(padded);
+    return output_image;
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "convolution_c_simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef CONV_SIMD_X86
+#define CONV_ALWAYS_INLINE inline __attribute__((always_inline))
+#define CONV_TARGET_SSE __attribute__((target("sse2")))
+#define CONV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Scalar accumulation of output columns [out_w_begin, output_width); also the vector kernels' tail
+static void scalar_columns(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int out_w_begin, int output_width,
+    float *destination)
+{
+    for (int out_w = out_w_begin; out_w < output_width; ++out_w)
+    {
+        float sum = 0.0f;
+        const float *weight = filter;
+        for (int in_c = 0; in_c < input_channels; ++in_c)
+        {
+            const float *window = padded + in_c * plane_size + (size_t)(out_h * stride) * padded_width + out_w * stride;
+            for (int k_h = 0; k_h < kernel_size; ++k_h)
+            {
+                const float *window_row = window + (size_t)k_h * padded_width;
+                for (int k_w = 0; k_w < kernel_size; ++k_w)
+                    sum += window_row[k_w] * *weight++;
+            }
+        }
+        destination[out_w] = sum;
+    }
+}
+
+static void scalar_row(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)
+{
+    scalar_columns(padded, plane_size, padded_width, filter, input_channels, kernel_size, stride,
+                   out_h, 0, output_width, destination);
+}
+
+#ifdef CONV_SIMD_X86
+
+// Number of leading output columns a vector of `lanes` outputs can cover without reading
+// past the padded row. Stride 2 loads 2*lanes inputs per tap, one more than it uses.
+static int vector_columns(int padded_width, int kernel_size, int stride, int output_width, int lanes)
+{
+    int columns = 0;
+    while (columns + lanes <= output_width &&
+           columns * stride + (kernel_size - 1) + lanes * stride <= padded_width)
+        columns += lanes;
+    return columns;
+}
+
+// --- SSE: 4 output columns per vector ---
+
+static CONV_ALWAYS_INLINE CONV_TARGET_SSE __m128 sse_load(const float *source, int stride)
+{
+    if (stride == 1)
+        return _mm_loadu_ps(source);
+    // stride 2: keep the even elements of 8 consecutive inputs
+    return _mm_shuffle_ps(_mm_loadu_ps(source), _mm_loadu_ps(source + 4), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+static CONV_ALWAYS_INLINE CONV_TARGET_SSE void sse_row_impl(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)
+{
+    int columns = vector_columns(padded_width, kernel_size, stride, output_width, 4);
+    for (int out_w = 0; out_w < columns; out_w += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        const float *weight = filter;
+        for (int in_c = 0; in_c < input_channels; ++in_c)
+        {
+            const float *window = padded + in_c * plane_size + (size_t)(out_h * stride) * padded_width + out_w * stride;
+            for (int k_h = 0; k_h < kernel_size; ++k_h)
+            {
+                const float *window_row = window + (size_t)k_h * padded_width;
+                for (int k_w = 0; k_w < kernel_size; ++k_w)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(sse_load(window_row + k_w, stride), _mm_set1_ps(*weight++)));
+            }
+        }
+        _mm_storeu_ps(destination + out_w, sum);
+    }
+    scalar_columns(padded, plane_size, padded_width, filter, input_channels, kernel_size, stride,
+                   out_h, columns, output_width, destination);
+}
+
+// --- AVX2: 8 output columns per vector ---
+
+static CONV_ALWAYS_INLINE CONV_TARGET_AVX2 __m256 avx2_load(const float *source, int stride)
+{
+    if (stride == 1)
+        return _mm256_loadu_ps(source);
+    // stride 2: even elements of 16 inputs, then undo the per-lane interleave of shuffle_ps
+    __m256 even = _mm256_shuffle_ps(_mm256_loadu_ps(source), _mm256_loadu_ps(source + 8), _MM_SHUFFLE(2, 0, 2, 0));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+static CONV_ALWAYS_INLINE CONV_TARGET_AVX2 void avx2_row_impl(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)
+{
+    int columns = vector_columns(padded_width, kernel_size, stride, output_width, 8);
+    for (int out_w = 0; out_w < columns; out_w += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        const float *weight = filter;
+        for (int in_c = 0; in_c < input_channels; ++in_c)
+        {
+            const float *window = padded + in_c * plane_size + (size_t)(out_h * stride) * padded_width + out_w * stride;
+            for (int k_h = 0; k_h < kernel_size; ++k_h)
+            {
+                const float *window_row = window + (size_t)k_h * padded_width;
+                for (int k_w = 0; k_w < kernel_size; ++k_w)
+                    sum = _mm256_add_ps(sum, _mm256_mul_ps(avx2_load(window_row + k_w, stride), _mm256_set1_ps(*weight++)));
+            }
+        }
+        _mm256_storeu_ps(destination + out_w, sum);
+    }
+    scalar_columns(padded, plane_size, padded_width, filter, input_channels, kernel_size, stride,
+                   out_h, columns, output_width, destination);
+}
+
+// Specialisations: constant kernel size and stride let the compiler unroll the taps and
+// drop the stride branch in the loads. The kernel_size/stride arguments are ignored.
+#define CONV_DEFINE_ROW_KERNEL(isa, target, name, constant_kernel, constant_stride)                               \
+    static target void isa##_row_##name(                                                                           \
+        const float *padded, size_t plane_size, int padded_width, const float *filter,                             \
+        int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)          \
+    {                                                                                                              \
+        (void)kernel_size;                                                                                         \
+        (void)stride;                                                                                              \
+        isa##_row_impl(padded, plane_size, padded_width, filter, input_channels, constant_kernel, constant_stride, \
+                       out_h, output_width, destination);                                                          \
+    }
+
+CONV_DEFINE_ROW_KERNEL(sse, CONV_TARGET_SSE, k3s1, 3, 1)
+CONV_DEFINE_ROW_KERNEL(sse, CONV_TARGET_SSE, k3s2, 3, 2)
+CONV_DEFINE_ROW_KERNEL(sse, CONV_TARGET_SSE, k5s1, 5, 1)
+CONV_DEFINE_ROW_KERNEL(sse, CONV_TARGET_SSE, k5s2, 5, 2)
+CONV_DEFINE_ROW_KERNEL(avx2, CONV_TARGET_AVX2, k3s1, 3, 1)
+CONV_DEFINE_ROW_KERNEL(avx2, CONV_TARGET_AVX2, k3s2, 3, 2)
+CONV_DEFINE_ROW_KERNEL(avx2, CONV_TARGET_AVX2, k5s1, 5, 1)
+CONV_DEFINE_ROW_KERNEL(avx2, CONV_TARGET_AVX2, k5s2, 5, 2)
+
+// Any kernel size, stride 1 or 2
+static CONV_TARGET_SSE void sse_row_generic(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)
+{
+    sse_row_impl(padded, plane_size, padded_width, filter, input_channels, kernel_size, stride,
+                 out_h, output_width, destination);
+}
+
+static CONV_TARGET_AVX2 void avx2_row_generic(
+    const float *padded, size_t plane_size, int padded_width, const float *filter,
+    int input_channels, int kernel_size, int stride, int out_h, int output_width, float *destination)
+{
+    avx2_row_impl(padded, plane_size, padded_width, filter, input_channels, kernel_size, stride,
+                  out_h, output_width, destination);
+}
+
+#endif // CONV_SIMD_X86
+
+ConvSimdLevelC conv_simd_detect(void)
+{
+#ifdef CONV_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return CONV_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return CONV_SIMD_SSE;
+#endif
+    return CONV_SIMD_SCALAR;
+}
+
+const char *conv_simd_level_name(ConvSimdLevelC level)
+{
+    switch (level)
+    {
+    case CONV_SIMD_SCALAR:
+        return "scalar";
+    case CONV_SIMD_SSE:
+        return "SSE";
+    case CONV_SIMD_AVX2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+ConvRowKernelC conv_simd_select_row_kernel(ConvSimdLevelC level, int kernel_size, int stride)
+{
+#ifdef CONV_SIMD_X86
+    ConvSimdLevelC detected = conv_simd_detect();
+    if ((int)level > (int)detected)
+        level = detected;
+    if (level != CONV_SIMD_SCALAR && (stride == 1 || stride == 2))
+    {
+        int avx2 = (level == CONV_SIMD_AVX2);
+        if (kernel_size == 3)
+            return stride == 1 ? (avx2 ? avx2_row_k3s1 : sse_row_k3s1) : (avx2 ? avx2_row_k3s2 : sse_row_k3s2);
+        if (kernel_size == 5)
+            return stride == 1 ? (avx2 ? avx2_row_k5s1 : sse_row_k5s1) : (avx2 ? avx2_row_k5s2 : sse_row_k5s2);
+        return avx2 ? avx2_row_generic : sse_row_generic;
+    }
+#else
+    (void)level;
+    (void)kernel_size;
+    (void)stride;
+#endif
+    return scalar_row;
+}
@@ -0,0 +1,95 @@
+#ifndef CONVOLUTION_C_SIMD_H
+#define CONVOLUTION_C_SIMD_H
+
+#include <stddef.h> // For size_t
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Instruction set used by the row kernels, picked at run time from what the CPU supports
+    typedef enum
+    {
+        CONV_SIMD_SCALAR,
+        CONV_SIMD_SSE,
+        CONV_SIMD_AVX2
+    } ConvSimdLevelC;
+
+    // Value read at padded positions, as BorderMode in convolution.h: for an image of n rows,
+    // row -1 reads REFLECT row 1, REPLICATE row 0, CIRCULAR row n - 1. REFLECT needs padding < n
+    // and CIRCULAR padding <= n on every side.
+    typedef enum
+    {
+        CONV_BORDER_ZERO,
+        CONV_BORDER_REFLECT,
+        CONV_BORDER_REPLICATE,
+        CONV_BORDER_CIRCULAR
+    } ConvBorderModeC;
+
+    // Source index for position index of an axis of length size, or -1 for a zero fill
+    static inline int conv_border_index(int index, int size, ConvBorderModeC border_mode)
+    {
+        if (index >= 0 && index < size)
+            return index;
+        switch (border_mode)
+        {
+        case CONV_BORDER_REFLECT:
+            return index < 0 ? -index : 2 * (size - 1) - index;
+        case CONV_BORDER_REPLICATE:
+            return index < 0 ? 0 : size - 1;
+        case CONV_BORDER_CIRCULAR:
+            return index < 0 ? index + size : index - size;
+        default:
+            return -1;
+        }
+    }
+
+    // 1 if the padding (before) and the rows or columns read past the end (after) of an axis of
+    // length size stay within the limits of border_mode
+    static inline int conv_border_fits(int before, int after, int size, ConvBorderModeC border_mode)
+    {
+        if (border_mode != CONV_BORDER_REFLECT && border_mode != CONV_BORDER_CIRCULAR)
+            return 1;
+        int limit = border_mode == CONV_BORDER_REFLECT ? size - 1 : size;
+        return before <= limit && after <= limit;
+    }
+
+    /**
+     * @brief Computes one output row of one output channel from a bordered input.
+     *
+     * padded holds the input as contiguous [in_c][padded_height][padded_width] planes
+     * of plane_size floats each, with the convolution padding already filled (zeros or
+     * the border mode's source pixels), and
+     * filter is that output channel's contiguous [in_c][k_h][k_w] weights. All levels
+     * accumulate in the order of the scalar loop (in_c, k_h, k_w) with separate multiply
+     * and add, so every level produces bit-identical results as long as the compiler
+     * does not contract the scalar loops into FMAs (-std=c99 implies -ffp-contract=off).
+     */
+    typedef void (*ConvRowKernelC)(
+        const float *padded,
+        size_t plane_size,
+        int padded_width,
+        const float *filter,
+        int input_channels,
+        int kernel_size,
+        int stride,
+        int out_h,
+        int output_width,
+        float *destination); // output_width contiguous floats
+
+    // Best level this CPU supports
+    ConvSimdLevelC conv_simd_detect(void);
+
+    const char *conv_simd_level_name(ConvSimdLevelC level);
+
+    // Kernel for the given level, specialised for K=3/K=5 and stride 1/2 where available.
+    // The level is chosen by the caller (a layer or context field), so there is no shared
+    // state; requests above the detected level are clamped.
+    ConvRowKernelC conv_simd_select_row_kernel(ConvSimdLevelC level, int kernel_size, int stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONVOLUTION_C_SIMD_H
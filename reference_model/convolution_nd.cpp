@@ -0,0 +1,422 @@
+#include "convolution_nd.h"
+#include <algorithm> // For std::max, std::min
+#include <cmath>     // For std::ceil
+#include <stdexcept>
+
+// Output positions per tile: the tile's columns (in_c * k^rank rows) stay cache-sized
+static const int TILE_POSITIONS = 256;
+
+static std::vector<float> &tile_scratch(size_t size)
+{
+    thread_local std::vector<float> scratch;
+    if (scratch.size() < size)
+    {
+        scratch.resize(size);
+    }
+    return scratch;
+}
+
+static int kernel_taps(int rank, int kernel_size)
+{
+    int taps = 1;
+    for (int a = 0; a < rank; ++a)
+    {
+        taps *= kernel_size;
+    }
+    return taps;
+}
+
+// Flatten nested [out_c][in_c][k...] weights, checking every dimension
+static std::vector<float> pack_weights_1d(
+    const std::vector<std::vector<std::vector<float>>> &kernel_weights,
+    int kernel_size,
+    int input_channels,
+    int output_channels)
+{
+    if (kernel_weights.size() != static_cast<size_t>(output_channels))
+    {
+        throw std::runtime_error("Mismatch between output_channels and kernel_weights first dimension.");
+    }
+    std::vector<float> packed;
+    for (const auto &filter : kernel_weights)
+    {
+        if (filter.size() != static_cast<size_t>(input_channels))
+        {
+            throw std::runtime_error("Mismatch between input_channels and kernel_weights second dimension.");
+        }
+        for (const auto &kernel : filter)
+        {
+            if (kernel.size() != static_cast<size_t>(kernel_size))
+            {
+                throw std::runtime_error("Mismatch between kernel_size and kernel_weights third dimension.");
+            }
+            packed.insert(packed.end(), kernel.begin(), kernel.end());
+        }
+    }
+    return packed;
+}
+
+static std::vector<float> pack_weights_3d(
+    const std::vector<std::vector<std::vector<std::vector<std::vector<float>>>>> &kernel_weights,
+    int kernel_size,
+    int input_channels,
+    int output_channels)
+{
+    if (kernel_weights.size() != static_cast<size_t>(output_channels))
+    {
+        throw std::runtime_error("Mismatch between output_channels and kernel_weights first dimension.");
+    }
+    std::vector<float> packed;
+    for (const auto &filter : kernel_weights)
+    {
+        if (filter.size() != static_cast<size_t>(input_channels))
+        {
+            throw std::runtime_error("Mismatch between input_channels and kernel_weights second dimension.");
+        }
+        for (const auto &kernel : filter)
+        {
+            if (kernel.size() != static_cast<size_t>(kernel_size))
+            {
+                throw std::runtime_error("Mismatch between kernel_size and kernel_weights third dimension.");
+            }
+            for (const auto &kernel_plane : kernel)
+            {
+                if (kernel_plane.size() != static_cast<size_t>(kernel_size))
+                {
+                    throw std::runtime_error("Mismatch between kernel_size and kernel_weights fourth dimension.");
+                }
+                for (const auto &kernel_row : kernel_plane)
+                {
+                    if (kernel_row.size() != static_cast<size_t>(kernel_size))
+                    {
+                        throw std::runtime_error("Mismatch between kernel_size and kernel_weights fifth dimension.");
+                    }
+                    packed.insert(packed.end(), kernel_row.begin(), kernel_row.end());
+                }
+            }
+        }
+    }
+    return packed;
+}
+
+ConvolutionEngineND::ConvolutionEngineND(
+    int rank,
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    std::vector<float> packed_weights) : rank_(rank),
+                                         kernel_size_(kernel_size),
+                                         stride_(stride),
+                                         padding_mode_(padding_mode),
+                                         input_channels_(input_channels),
+                                         output_channels_(output_channels),
+                                         packed_weights_(std::move(packed_weights)),
+                                         border_mode_(BorderMode::ZERO),
+                                         reduction_order_(ReductionOrder::SEQUENTIAL)
+{
+    if (rank < 1 || rank > 3)
+    {
+        throw std::runtime_error("Convolution rank must be 1, 2 or 3.");
+    }
+    if (kernel_size <= 0 || stride <= 0 || input_channels <= 0 || output_channels <= 0)
+    {
+        throw std::runtime_error("Kernel size, stride and channel counts must be positive.");
+    }
+    if (packed_weights_.size() != static_cast<size_t>(output_channels) * input_channels * kernel_taps(rank, kernel_size))
+    {
+        throw std::runtime_error("Packed weight count does not match the layer configuration.");
+    }
+}
+
+void ConvolutionEngineND::set_bias(const std::vector<float> &bias)
+{
+    if (!bias.empty() && bias.size() != static_cast<size_t>(output_channels_))
+    {
+        throw std::runtime_error("Bias size must match output_channels.");
+    }
+    bias_ = bias;
+}
+
+void ConvolutionEngineND::set_explicit_padding(const std::vector<AxisPadding> &padding)
+{
+    if (padding.size() != static_cast<size_t>(rank_))
+    {
+        throw std::runtime_error("Explicit padding needs one entry per axis.");
+    }
+    for (const AxisPadding &axis_padding : padding)
+    {
+        if (axis_padding.before < 0 || axis_padding.after < 0)
+        {
+            throw std::runtime_error("Padding amounts must not be negative.");
+        }
+    }
+    explicit_padding_ = padding;
+}
+
+std::vector<ConvolutionAxis> ConvolutionEngineND::compute_axes(const std::vector<int> &input_shape) const
+{
+    if (input_shape.size() != static_cast<size_t>(rank_))
+    {
+        throw std::runtime_error("Input rank does not match the layer rank.");
+    }
+    std::vector<ConvolutionAxis> axes;
+    for (int a = 0; a < rank_; ++a)
+    {
+        const int input_size = input_shape[a];
+        ConvolutionAxis axis = {input_size, 0, kernel_size_, stride_, 0};
+        if (!explicit_padding_.empty())
+        {
+            int padded_size = input_size + explicit_padding_[a].before + explicit_padding_[a].after;
+            axis.output_size = padded_size < kernel_size_ ? 0 : (padded_size - kernel_size_) / stride_ + 1;
+            axis.padding = explicit_padding_[a].before;
+        }
+        else if (padding_mode_ == PaddingMode::VALID)
+        {
+            axis.output_size = (input_size - kernel_size_) / stride_ + 1;
+        }
+        else
+        { // PaddingMode::SAME, same rule as ConvolutionLayer::calculate_padding_amount
+            axis.output_size = static_cast<int>(std::ceil(static_cast<float>(input_size) / stride_));
+            axis.padding = std::max(0, ((axis.output_size - 1) * stride_ + kernel_size_ - input_size) / 2);
+        }
+        if (input_size <= 0 || axis.output_size <= 0)
+        {
+            throw std::runtime_error("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.");
+        }
+        if (border_mode_ == BorderMode::REFLECT || border_mode_ == BorderMode::CIRCULAR)
+        {
+            // Same limits as ConvolutionLayer::compute_geometry, per axis
+            int after = (axis.output_size - 1) * stride_ + kernel_size_ - axis.padding - input_size;
+            int slack = border_mode_ == BorderMode::REFLECT ? 1 : 0;
+            if (std::max(axis.padding, after) > input_size - slack)
+            {
+                throw std::runtime_error("Padding too large for the border mode: REFLECT needs padding < input size, CIRCULAR padding <= input size.");
+            }
+        }
+        axes.push_back(axis);
+    }
+    return axes;
+}
+
+std::vector<float> ConvolutionEngineND::forward(
+    const float *input,
+    const std::vector<ConvolutionAxis> &axes,
+    ThreadPool *thread_pool) const
+{
+    int output_positions = 1;
+    for (const ConvolutionAxis &axis : axes)
+    {
+        output_positions *= axis.output_size;
+    }
+    const int taps = kernel_taps(rank_, kernel_size_);
+    const int rows = input_channels_ * taps;
+    const int tiles = (output_positions + TILE_POSITIONS - 1) / TILE_POSITIONS;
+    const bool pairwise = reduction_order_ == ReductionOrder::BLOCKED_PAIRWISE;
+    std::vector<float> output(static_cast<size_t>(output_channels_) * output_positions);
+
+    auto run_tiles = [&](int begin, int end) {
+        // columns, then for BLOCKED_PAIRWISE the [in_c][out_c][position] per-channel sums
+        // and one position's in_c sums gathered for pairwise_sum
+        size_t column_floats = static_cast<size_t>(rows) * TILE_POSITIONS;
+        size_t partial_floats = pairwise ? static_cast<size_t>(input_channels_) * output_channels_ * TILE_POSITIONS : 0;
+        float *columns = tile_scratch(column_floats + partial_floats + (pairwise ? input_channels_ : 0)).data();
+        float *partials = columns + column_floats;
+        float *channel_sums = partials + partial_floats;
+        for (int tile = begin; tile < end; ++tile)
+        {
+            int first = tile * TILE_POSITIONS;
+            int count = std::min(TILE_POSITIONS, output_positions - first);
+            im2col_nd(input, input_channels_, axes, border_mode_, first, count, columns);
+            if (!pairwise)
+            {
+                gemm_nn(output_channels_, count, rows, packed_weights_.data(), rows, columns, count,
+                        output.data() + first, output_positions);
+            }
+            else
+            {
+                for (int in_c = 0; in_c < input_channels_; ++in_c)
+                {
+                    gemm_nn(output_channels_, count, taps, packed_weights_.data() + in_c * taps, rows,
+                            columns + static_cast<size_t>(in_c) * taps * count, count,
+                            partials + static_cast<size_t>(in_c) * output_channels_ * count, count);
+                }
+                for (int out_c = 0; out_c < output_channels_; ++out_c)
+                {
+                    float *output_row = output.data() + static_cast<size_t>(out_c) * output_positions + first;
+                    for (int p = 0; p < count; ++p)
+                    {
+                        for (int in_c = 0; in_c < input_channels_; ++in_c)
+                        {
+                            channel_sums[in_c] = partials[(static_cast<size_t>(in_c) * output_channels_ + out_c) * count + p];
+                        }
+                        output_row[p] = pairwise_sum(channel_sums, input_channels_);
+                    }
+                }
+            }
+            if (!bias_.empty())
+            {
+                for (int out_c = 0; out_c < output_channels_; ++out_c)
+                {
+                    float *output_row = output.data() + static_cast<size_t>(out_c) * output_positions + first;
+                    for (int p = 0; p < count; ++p)
+                    {
+                        output_row[p] += bias_[out_c];
+                    }
+                }
+            }
+        }
+    };
+    if (thread_pool)
+    {
+        thread_pool->parallel_for(tiles, run_tiles);
+    }
+    else
+    {
+        run_tiles(0, tiles);
+    }
+    return output;
+}
+
+ConvolutionLayer1D::ConvolutionLayer1D(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    const std::vector<std::vector<std::vector<float>>> &kernel_weights)
+    : engine_(1, kernel_size, stride, padding_mode, input_channels, output_channels,
+              pack_weights_1d(kernel_weights, kernel_size, input_channels, output_channels))
+{
+}
+
+std::vector<std::vector<float>> ConvolutionLayer1D::forward_impl(
+    const std::vector<std::vector<float>> &input_signal,
+    ThreadPool *thread_pool) const
+{
+    if (input_signal.size() != static_cast<size_t>(engine_.input_channels()) || input_signal[0].empty())
+    {
+        throw std::runtime_error("Input signal channels mismatch with layer input_channels.");
+    }
+    const int length = static_cast<int>(input_signal[0].size());
+    std::vector<float> input;
+    input.reserve(static_cast<size_t>(engine_.input_channels()) * length);
+    for (const auto &channel : input_signal)
+    {
+        if (channel.size() != static_cast<size_t>(length))
+        {
+            throw std::runtime_error("Input signal channels have different lengths.");
+        }
+        input.insert(input.end(), channel.begin(), channel.end());
+    }
+
+    std::vector<ConvolutionAxis> axes = engine_.compute_axes(std::vector<int>(1, length));
+    std::vector<float> output = engine_.forward(input.data(), axes, thread_pool);
+
+    const int output_length = axes[0].output_size;
+    std::vector<std::vector<float>> output_signal(engine_.output_channels());
+    for (int out_c = 0; out_c < engine_.output_channels(); ++out_c)
+    {
+        output_signal[out_c].assign(output.begin() + out_c * output_length, output.begin() + (out_c + 1) * output_length);
+    }
+    return output_signal;
+}
+
+std::vector<std::vector<float>> ConvolutionLayer1D::forward(const std::vector<std::vector<float>> &input_signal) const
+{
+    return forward_impl(input_signal, nullptr);
+}
+
+std::vector<std::vector<float>> ConvolutionLayer1D::forward(
+    const std::vector<std::vector<float>> &input_signal,
+    ThreadPool &thread_pool) const
+{
+    return forward_impl(input_signal, &thread_pool);
+}
+
+ConvolutionLayer3D::ConvolutionLayer3D(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    const std::vector<std::vector<std::vector<std::vector<std::vector<float>>>>> &kernel_weights)
+    : engine_(3, kernel_size, stride, padding_mode, input_channels, output_channels,
+              pack_weights_3d(kernel_weights, kernel_size, input_channels, output_channels))
+{
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer3D::forward_impl(
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume,
+    ThreadPool *thread_pool) const
+{
+    if (input_volume.size() != static_cast<size_t>(engine_.input_channels()) || input_volume[0].empty() ||
+        input_volume[0][0].empty() || input_volume[0][0][0].empty())
+    {
+        throw std::runtime_error("Input volume is empty or its channels mismatch with layer input_channels.");
+    }
+    const int depth = static_cast<int>(input_volume[0].size());
+    const int height = static_cast<int>(input_volume[0][0].size());
+    const int width = static_cast<int>(input_volume[0][0][0].size());
+    std::vector<float> input;
+    input.reserve(static_cast<size_t>(engine_.input_channels()) * depth * height * width);
+    for (const auto &channel : input_volume)
+    {
+        if (channel.size() != static_cast<size_t>(depth))
+        {
+            throw std::runtime_error("Input volume channels have different depths.");
+        }
+        for (const auto &plane : channel)
+        {
+            if (plane.size() != static_cast<size_t>(height))
+            {
+                throw std::runtime_error("Input volume planes have different heights.");
+            }
+            for (const auto &row : plane)
+            {
+                if (row.size() != static_cast<size_t>(width))
+                {
+                    throw std::runtime_error("Input volume rows have different widths.");
+                }
+                input.insert(input.end(), row.begin(), row.end());
+            }
+        }
+    }
+
+    int shape[3] = {depth, height, width};
+    std::vector<ConvolutionAxis> axes = engine_.compute_axes(std::vector<int>(shape, shape + 3));
+    std::vector<float> output = engine_.forward(input.data(), axes, thread_pool);
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> output_volume(
+        engine_.output_channels(),
+        std::vector<std::vector<std::vector<float>>>(
+            axes[0].output_size,
+            std::vector<std::vector<float>>(axes[1].output_size, std::vector<float>(axes[2].output_size))));
+    const float *value = output.data();
+    for (auto &channel : output_volume)
+    {
+        for (auto &plane : channel)
+        {
+            for (auto &row : plane)
+            {
+                row.assign(value, value + row.size());
+                value += row.size();
+            }
+        }
+    }
+    return output_volume;
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer3D::forward(
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume) const
+{
+    return forward_impl(input_volume, nullptr);
+}
+
+std::vector<std::vector<std::vector<std::vector<float>>>> ConvolutionLayer3D::forward(
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume,
+    ThreadPool &thread_pool) const
+{
+    return forward_impl(input_volume, &thread_pool);
+}
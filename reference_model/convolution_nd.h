@@ -0,0 +1,163 @@
+#ifndef CONVOLUTION_ND_H
+#define CONVOLUTION_ND_H
+
+#include <vector>
+#include "convolution.h"
+#include "im2col.h"
+#include "thread_pool.h"
+
+// Explicit padding of one axis, used instead of the VALID/SAME rule when set on an engine
+struct AxisPadding
+{
+    int before;
+    int after;
+};
+
+// Dimension-generic engine behind ConvolutionLayer1D and ConvolutionLayer3D (and usable for 2D):
+// a cubic kernel over one to three spatial axes with the padding, stride and border mode rules
+// of ConvolutionLayer applied per axis. The output positions are cut into tiles; each tile is an
+// im2col_nd block times the packed [out_c][in_c][k...] weight matrix (gemm_nn), so memory stays
+// bounded and tiles are the unit of work on a ThreadPool. Bias, reduction order, border mode and
+// explicit padding follow ConvolutionLayer, so in 2D the result is bit-identical to
+// ConvolutionLayer::forward with the same settings.
+class ConvolutionEngineND
+{
+public:
+    // packed_weights: [out_c][in_c][k_0]...[k_rank-1], kernel_size^rank taps per filter
+    ConvolutionEngineND(
+        int rank,
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        std::vector<float> packed_weights);
+
+    // Fill rule for padded positions, ZERO by default; the limits of BorderMode apply per axis
+    void set_border_mode(BorderMode border_mode) { border_mode_ = border_mode; }
+    BorderMode border_mode() const { return border_mode_; }
+
+    // Per-output-channel bias added after the reduction. An empty vector removes the bias; any
+    // other size must equal output_channels.
+    void set_bias(const std::vector<float> &bias);
+    const std::vector<float> &bias() const { return bias_; }
+
+    // SEQUENTIAL by default. BLOCKED_PAIRWISE sums each input channel's taps in order and
+    // combines the per-channel sums with pairwise_sum, like ConvolutionLayer.
+    void set_reduction_order(ReductionOrder reduction_order) { reduction_order_ = reduction_order; }
+    ReductionOrder reduction_order() const { return reduction_order_; }
+
+    // Pad each axis (rank entries, outermost first) by exactly these amounts instead of the
+    // VALID/SAME rule. Throws on a wrong count or a negative amount.
+    void set_explicit_padding(const std::vector<AxisPadding> &padding);
+    void clear_explicit_padding() { explicit_padding_.clear(); }
+    bool has_explicit_padding() const { return !explicit_padding_.empty(); }
+    const std::vector<AxisPadding> &explicit_padding() const { return explicit_padding_; }
+
+    // Per-axis sizes and padding for the given spatial input shape (rank entries). Throws if
+    // the padding is too large for the border mode.
+    std::vector<ConvolutionAxis> compute_axes(const std::vector<int> &input_shape) const;
+
+    // input: contiguous [in_c][input_shape...]; returns contiguous [out_c][output sizes...].
+    // Tiles run on thread_pool, or on the calling thread when it is null.
+    std::vector<float> forward(
+        const float *input,
+        const std::vector<ConvolutionAxis> &axes,
+        ThreadPool *thread_pool) const;
+
+    int rank() const { return rank_; }
+    int kernel_size() const { return kernel_size_; }
+    int stride() const { return stride_; }
+    PaddingMode padding_mode() const { return padding_mode_; }
+    int input_channels() const { return input_channels_; }
+    int output_channels() const { return output_channels_; }
+
+private:
+    int rank_;
+    int kernel_size_;
+    int stride_;
+    PaddingMode padding_mode_;
+    int input_channels_;
+    int output_channels_;
+    std::vector<float> packed_weights_;
+    std::vector<float> bias_; // [out_c]; empty: no bias
+    BorderMode border_mode_;
+    ReductionOrder reduction_order_;
+    std::vector<AxisPadding> explicit_padding_; // empty: VALID/SAME rule
+};
+
+// 1D convolution over [in_c][length] signals (sensor streams)
+class ConvolutionLayer1D
+{
+public:
+    // kernel_weights: [out_c][in_c][k]
+    ConvolutionLayer1D(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        const std::vector<std::vector<std::vector<float>>> &kernel_weights);
+
+    // Returns [out_c][output_length]
+    std::vector<std::vector<float>> forward(const std::vector<std::vector<float>> &input_signal) const;
+    std::vector<std::vector<float>> forward(const std::vector<std::vector<float>> &input_signal, ThreadPool &thread_pool) const;
+
+    // Same meaning as the ConvolutionLayer/ConvolutionEngineND settings
+    void set_border_mode(BorderMode border_mode) { engine_.set_border_mode(border_mode); }
+    void set_bias(const std::vector<float> &bias) { engine_.set_bias(bias); }
+    void set_reduction_order(ReductionOrder reduction_order) { engine_.set_reduction_order(reduction_order); }
+    void set_explicit_padding(const AxisPadding &padding)
+    {
+        engine_.set_explicit_padding(std::vector<AxisPadding>(1, padding));
+    }
+    void clear_explicit_padding() { engine_.clear_explicit_padding(); }
+    const ConvolutionEngineND &engine() const { return engine_; }
+
+private:
+    ConvolutionEngineND engine_;
+
+    std::vector<std::vector<float>> forward_impl(const std::vector<std::vector<float>> &input_signal, ThreadPool *thread_pool) const;
+};
+
+// 3D convolution over [in_c][depth][height][width] volumes
+class ConvolutionLayer3D
+{
+public:
+    // kernel_weights: [out_c][in_c][k_d][k_h][k_w]
+    ConvolutionLayer3D(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        const std::vector<std::vector<std::vector<std::vector<std::vector<float>>>>> &kernel_weights);
+
+    // Returns [out_c][output_depth][output_height][output_width]
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward(
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume) const;
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward(
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume,
+        ThreadPool &thread_pool) const;
+
+    // Same meaning as the ConvolutionLayer/ConvolutionEngineND settings
+    void set_border_mode(BorderMode border_mode) { engine_.set_border_mode(border_mode); }
+    void set_bias(const std::vector<float> &bias) { engine_.set_bias(bias); }
+    void set_reduction_order(ReductionOrder reduction_order) { engine_.set_reduction_order(reduction_order); }
+    void set_explicit_padding(const AxisPadding &depth, const AxisPadding &height, const AxisPadding &width)
+    {
+        AxisPadding padding[3] = {depth, height, width};
+        engine_.set_explicit_padding(std::vector<AxisPadding>(padding, padding + 3));
+    }
+    void clear_explicit_padding() { engine_.clear_explicit_padding(); }
+    const ConvolutionEngineND &engine() const { return engine_; }
+
+private:
+    ConvolutionEngineND engine_;
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> forward_impl(
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &input_volume,
+        ThreadPool *thread_pool) const;
+};
+
+#endif // CONVOLUTION_ND_H
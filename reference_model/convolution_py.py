@@ -1,205 +1,438 @@
-import math
-
-class ConvolutionLayer:
-    def __init__(self, kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights):
-        if not (isinstance(kernel_size, int) and kernel_size > 0):
-            raise ValueError("Kernel size must be a positive integer.")
-        if not (isinstance(stride, int) and stride > 0):
-            raise ValueError("Stride must be a positive integer.")
-        if padding_mode not in [0, 1]: # 0 for VALID, 1 for SAME
-            raise ValueError("Padding mode must be 0 (VALID) or 1 (SAME).")
-        if not (isinstance(input_channels, int) and input_channels > 0):
-            raise ValueError("Input channels must be a positive integer.")
-        if not (isinstance(output_channels, int) and output_channels > 0):
-            raise ValueError("Output channels must be a positive integer.")
-        if not initial_kernel_weights:
-            raise ValueError("Initial kernel weights cannot be empty.")
-
-        self.kernel_size = kernel_size
-        self.stride = stride
-        self.padding_mode = padding_mode # Now stores 0 or 1
-        self.input_channels = input_channels
-        self.output_channels = output_channels
-        self.kernel_weights = initial_kernel_weights # Expected: [out_c][in_c][k_h][k_w]
-
-        # Validate kernel weights dimensions
-        if len(self.kernel_weights) != self.output_channels:
-            raise ValueError(f"Kernel weights outer dimension mismatch. Expected {self.output_channels}, got {len(self.kernel_weights)}")
-        for oc_weights in self.kernel_weights:
-            if len(oc_weights) != self.input_channels:
-                raise ValueError(f"Kernel weights input_channels dimension mismatch. Expected {self.input_channels}, got {len(oc_weights)}")
-            for ic_weights in oc_weights:
-                if len(ic_weights) != self.kernel_size:
-                    raise ValueError(f"Kernel weights height dimension mismatch. Expected {self.kernel_size}, got {len(ic_weights)}")
-                for k_row in ic_weights:
-                    if len(k_row) != self.kernel_size:
-                        raise ValueError(f"Kernel weights width dimension mismatch. Expected {self.kernel_size}, got {len(k_row)}")
-
-    def _calculate_padding_amount(self, input_dim, target_output_dim):
-        """Calculates padding needed on one side for 'SAME' padding."""
-        padding = ((target_output_dim - 1) * self.stride + self.kernel_size - input_dim) / 2
-        return max(0, int(padding))
-
-    def forward(self, input_image):
-        """
-        Performs convolution.
-        input_image: 3D list [input_channels][input_height][input_width]
-        Returns: 3D list [output_channels][output_height][output_width]
-        """
-        if not input_image or not input_image[0] or not input_image[0][0]:
-            raise ValueError("Input image cannot be empty.")
-        if len(input_image) != self.input_channels:
-            raise ValueError(f"Input image channels mismatch. Expected {self.input_channels}, got {len(input_image)}")
-
-        input_height = len(input_image[0])
-        input_width = len(input_image[0][0])
-
-        padding_h = 0
-        padding_w = 0
-
-        if self.padding_mode == 0: # VALID padding
-            output_height = (input_height - self.kernel_size) // self.stride + 1
-            output_width = (input_width - self.kernel_size) // self.stride + 1
-        elif self.padding_mode == 1: # SAME padding
-            output_height = math.ceil(input_height / self.stride)
-            output_width = math.ceil(input_width / self.stride)
-            padding_h = self._calculate_padding_amount(input_height, output_height)
-            padding_w = self._calculate_padding_amount(input_width, output_width)
-        else:
-            # This case should ideally not be reached due to __init__ validation
-            raise ValueError("Invalid padding mode internal state.") 
-
-        if output_height <= 0 or output_width <= 0:
-            raise ValueError("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.")
-
-        output_image = [
-            [[0.0 for _ in range(output_width)] for _ in range(output_height)]
-            for _ in range(self.output_channels)
-        ]
-
-        for out_c in range(self.output_channels):
-            for out_h in range(output_height):
-                for out_w in range(output_width):
-                    current_sum = 0.0
-                    for in_c in range(self.input_channels):
-                        for k_h in range(self.kernel_size):
-                            for k_w in range(self.kernel_size):
-                                h_idx = out_h * self.stride + k_h - padding_h
-                                w_idx = out_w * self.stride + k_w - padding_w
-
-                                pixel_value = 0.0
-                                if 0 <= h_idx < input_height and 0 <= w_idx < input_width:
-                                    pixel_value = input_image[in_c][h_idx][w_idx]
-                                
-                                current_sum += pixel_value * self.kernel_weights[out_c][in_c][k_h][k_w]
-                    output_image[out_c][out_h][out_w] = current_sum
-        
-        return output_image
-
-def print_image_py(image, label):
-    if not image:
-        print(f"{label} is empty.")
-        return
-
-    channels = len(image)
-    height = len(image[0]) if channels > 0 else 0
-    width = len(image[0][0]) if height > 0 else 0
-
-    print(f"{label} (Channels: {channels}, Height: {height}, Width: {width})")
-    for c_idx, channel_data in enumerate(image):
-        print(f"Channel {c_idx}:")
-        if not channel_data:
-            print("  Empty channel.")
-            continue
-        for r_idx, row_data in enumerate(channel_data):
-            print("  ", end="")
-            if not row_data:
-                print("Empty row.")
-                continue
-            for val in row_data:
-                print(f"{val:8.2f}", end="")
-            print()
-        print()
-
-if __name__ == "__main__":
-    # Parameters from readme.md
-    KERNEL_SIZE = 3
-    STRIDE = 1
-    PADDING_MODE_VALID = 0 # readme: 0 Valid
-    PADDING_MODE_SAME = 1   # readme: 1 Same
-    INPUT_CHANNELS = 3  # readme: (默认为 3 RGB)
-    OUTPUT_CHANNELS = 1 # readme: (默认为 1)
-    INPUT_HEIGHT = 32
-    INPUT_WIDTH = 32
-
-    print("Initializing Python Convolution Layer...")
-    print(f"Kernel Size: {KERNEL_SIZE}")
-    print(f"Input Channels: {INPUT_CHANNELS}, Output Channels: {OUTPUT_CHANNELS}")
-    print(f"Input Dimensions: {INPUT_CHANNELS}x{INPUT_HEIGHT}x{INPUT_WIDTH}")
-
-    # --- 1. Initialize Kernel Weights ---
-    avg_kernel_val = 1.0 / (KERNEL_SIZE * KERNEL_SIZE)
-    kernel_weights = [
-        [
-            [
-                [avg_kernel_val for _ in range(KERNEL_SIZE)] for _ in range(KERNEL_SIZE)
-            ] for _ in range(INPUT_CHANNELS)
-        ] for _ in range(OUTPUT_CHANNELS)
-    ]
-
-    if INPUT_CHANNELS > 1 and KERNEL_SIZE == 3 and OUTPUT_CHANNELS > 0:
-        kernel_weights[0][1] = [
-            [0.0, 0.0, 0.0],
-            [0.0, 1.0, 0.0],
-            [0.0, 0.0, 0.0]
-        ]
-
-    # --- 2. Create Input Image Data ---
-    input_image_data = [
-        [
-            [float(c * 100 + h * 10 + w) for w in range(INPUT_WIDTH)] for h in range(INPUT_HEIGHT)
-        ] for c in range(INPUT_CHANNELS)
-    ]
-
-    # --- Test Case 1: VALID padding (0), Stride 1 ---
-    current_padding_mode_val = PADDING_MODE_VALID
-    print(f"\n--- Test Case 1: Stride {STRIDE}, Padding Mode: {current_padding_mode_val} ({'VALID' if current_padding_mode_val == 0 else 'SAME'}) ---")
-    try:
-        conv_layer_valid = ConvolutionLayer(
-            kernel_size=KERNEL_SIZE,
-            stride=STRIDE,
-            padding_mode=current_padding_mode_val,
-            input_channels=INPUT_CHANNELS,
-            output_channels=OUTPUT_CHANNELS,
-            initial_kernel_weights=kernel_weights
-        )
-        print("Performing convolution...")
-        output_image_valid = conv_layer_valid.forward(input_image_data)
-        print("Convolution complete.")
-        print_image_py(output_image_valid, f"Output Image (Padding {current_padding_mode_val}, Stride {STRIDE})")
-
-    except ValueError as e:
-        print(f"Error: {e}")
-
-    # --- Test Case 2: SAME padding (1), Stride 2 ---
-    STRIDE_2 = 2
-    current_padding_mode_val = PADDING_MODE_SAME
-    print(f"\n--- Test Case 2: Stride {STRIDE_2}, Padding Mode: {current_padding_mode_val} ({'VALID' if current_padding_mode_val == 0 else 'SAME'}) ---")
-    try:
-        conv_layer_same_s2 = ConvolutionLayer(
-            kernel_size=KERNEL_SIZE,
-            stride=STRIDE_2,
-            padding_mode=current_padding_mode_val,
-            input_channels=INPUT_CHANNELS,
-            output_channels=OUTPUT_CHANNELS,
-            initial_kernel_weights=kernel_weights
-        )
-        print("Performing convolution...")
-        output_image_same_s2 = conv_layer_same_s2.forward(input_image_data)
-        print("Convolution complete.")
-        print_image_py(output_image_same_s2, f"Output Image (Padding {current_padding_mode_val}, Stride {STRIDE_2})")
-
-    except ValueError as e:
-        print(f"Error: {e}")
-
+import array
+import ctypes
+import math
+import os
+import sys
+import threading
+
+class ConvolutionLayer:
+    def __init__(self, kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights):
+        if not (isinstance(kernel_size, int) and kernel_size > 0):
+            raise ValueError("Kernel size must be a positive integer.")
+        if not (isinstance(stride, int) and stride > 0):
+            raise ValueError("Stride must be a positive integer.")
+        if padding_mode not in [0, 1]: # 0 for VALID, 1 for SAME
+            raise ValueError("Padding mode must be 0 (VALID) or 1 (SAME).")
+        if not (isinstance(input_channels, int) and input_channels > 0):
+            raise ValueError("Input channels must be a positive integer.")
+        if not (isinstance(output_channels, int) and output_channels > 0):
+            raise ValueError("Output channels must be a positive integer.")
+        if not initial_kernel_weights:
+            raise ValueError("Initial kernel weights cannot be empty.")
+
+        self.kernel_size = kernel_size
+        self.stride = stride
+        self.padding_mode = padding_mode # Now stores 0 or 1
+        self.input_channels = input_channels
+        self.output_channels = output_channels
+        self.kernel_weights = initial_kernel_weights # Expected: [out_c][in_c][k_h][k_w]
+
+        # Validate kernel weights dimensions
+        if len(self.kernel_weights) != self.output_channels:
+            raise ValueError(f"Kernel weights outer dimension mismatch. Expected {self.output_channels}, got {len(self.kernel_weights)}")
+        for oc_weights in self.kernel_weights:
+            if len(oc_weights) != self.input_channels:
+                raise ValueError(f"Kernel weights input_channels dimension mismatch. Expected {self.input_channels}, got {len(oc_weights)}")
+            for ic_weights in oc_weights:
+                if len(ic_weights) != self.kernel_size:
+                    raise ValueError(f"Kernel weights height dimension mismatch. Expected {self.kernel_size}, got {len(ic_weights)}")
+                for k_row in ic_weights:
+                    if len(k_row) != self.kernel_size:
+                        raise ValueError(f"Kernel weights width dimension mismatch. Expected {self.kernel_size}, got {len(k_row)}")
+
+    def _calculate_padding_amount(self, input_dim, target_output_dim):
+        """Calculates padding needed on one side for 'SAME' padding."""
+        padding = ((target_output_dim - 1) * self.stride + self.kernel_size - input_dim) / 2
+        return max(0, int(padding))
+
+    def forward(self, input_image):
+        """
+        Performs convolution.
+        input_image: 3D list [input_channels][input_height][input_width]
+        Returns: 3D list [output_channels][output_height][output_width]
+        """
+        if not input_image or not input_image[0] or not input_image[0][0]:
+            raise ValueError("Input image cannot be empty.")
+        if len(input_image) != self.input_channels:
+            raise ValueError(f"Input image channels mismatch. Expected {self.input_channels}, got {len(input_image)}")
+
+        input_height = len(input_image[0])
+        input_width = len(input_image[0][0])
+
+        padding_h = 0
+        padding_w = 0
+
+        if self.padding_mode == 0: # VALID padding
+            output_height = (input_height - self.kernel_size) // self.stride + 1
+            output_width = (input_width - self.kernel_size) // self.stride + 1
+        elif self.padding_mode == 1: # SAME padding
+            output_height = math.ceil(input_height / self.stride)
+            output_width = math.ceil(input_width / self.stride)
+            padding_h = self._calculate_padding_amount(input_height, output_height)
+            padding_w = self._calculate_padding_amount(input_width, output_width)
+        else:
+            # This case should ideally not be reached due to __init__ validation
+            raise ValueError("Invalid padding mode internal state.") 
+
+        if output_height <= 0 or output_width <= 0:
+            raise ValueError("Output dimensions are non-positive. Check kernel size, stride, and input dimensions.")
+
+        output_image = [
+            [[0.0 for _ in range(output_width)] for _ in range(output_height)]
+            for _ in range(self.output_channels)
+        ]
+
+        for out_c in range(self.output_channels):
+            for out_h in range(output_height):
+                for out_w in range(output_width):
+                    current_sum = 0.0
+                    for in_c in range(self.input_channels):
+                        for k_h in range(self.kernel_size):
+                            for k_w in range(self.kernel_size):
+                                h_idx = out_h * self.stride + k_h - padding_h
+                                w_idx = out_w * self.stride + k_w - padding_w
+
+                                pixel_value = 0.0
+                                if 0 <= h_idx < input_height and 0 <= w_idx < input_width:
+                                    pixel_value = input_image[in_c][h_idx][w_idx]
+                                
+                                current_sum += pixel_value * self.kernel_weights[out_c][in_c][k_h][k_w]
+                    output_image[out_c][out_h][out_w] = current_sum
+        
+        return output_image
+
+# --- Native engine binding -------------------------------------------------------------
+# NativeConvolutionLayer calls the C API (convolution_api.h) through ctypes. Build the
+# shared library next to this file, e.g.
+#   cc -O2 -shared -fPIC -pthread convolution_api.c convolution_c_simd.c -o libconvolution_api.so
+# or point CNN_NATIVE_LIBRARY at it. create_convolution_layer() falls back to the pure-Python
+# ConvolutionLayer when the library cannot be loaded.
+
+class _DLDevice(ctypes.Structure):
+    _fields_ = [("device_type", ctypes.c_int32), ("device_id", ctypes.c_int32)]
+
+class _DLDataType(ctypes.Structure):
+    _fields_ = [("code", ctypes.c_uint8), ("bits", ctypes.c_uint8), ("lanes", ctypes.c_uint16)]
+
+class _DLTensor(ctypes.Structure):
+    _fields_ = [("data", ctypes.c_void_p), ("device", _DLDevice), ("ndim", ctypes.c_int32),
+                ("dtype", _DLDataType), ("shape", ctypes.POINTER(ctypes.c_int64)),
+                ("strides", ctypes.POINTER(ctypes.c_int64)), ("byte_offset", ctypes.c_uint64)]
+
+class _LayerDesc(ctypes.Structure):
+    _fields_ = [("kernel_size", ctypes.c_int), ("stride", ctypes.c_int), ("padding", ctypes.c_int),
+                ("input_channels", ctypes.c_int), ("output_channels", ctypes.c_int)]
+
+class _ContextDesc(ctypes.Structure):
+    _fields_ = [("num_threads", ctypes.c_int), ("workspace_bytes", ctypes.c_size_t), ("allocator", ctypes.c_void_p)]
+
+class _PyBuffer(ctypes.Structure):
+    # CPython's Py_buffer, filled by PyObject_GetBuffer
+    _fields_ = [("buf", ctypes.c_void_p), ("obj", ctypes.py_object), ("len", ctypes.c_ssize_t),
+                ("itemsize", ctypes.c_ssize_t), ("readonly", ctypes.c_int), ("ndim", ctypes.c_int),
+                ("format", ctypes.c_char_p), ("shape", ctypes.POINTER(ctypes.c_ssize_t)),
+                ("strides", ctypes.POINTER(ctypes.c_ssize_t)), ("suboffsets", ctypes.POINTER(ctypes.c_ssize_t)),
+                ("internal", ctypes.c_void_p)]
+
+_PyBUF_WRITABLE = 0x0001
+_PyBUF_FORMAT = 0x0004
+_PyBUF_STRIDES = 0x0018
+_DL_CPU = 1
+_DL_DTYPES = {"f": (2, 32), "d": (2, 64), "B": (1, 8)}  # buffer format -> (DLPack code, bits)
+
+_native_library = None
+
+def _load_native_library():
+    """Returns the loaded C API library, or None if it is not available."""
+    global _native_library
+    if _native_library is not None:
+        return _native_library or None
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates = [os.environ.get("CNN_NATIVE_LIBRARY")]
+    candidates += [os.path.join(here, name) for name in
+                   ("libconvolution_api.so", "libconvolution_api.dylib", "convolution_api.dll")]
+    for path in candidates:
+        if not path or not os.path.exists(path):
+            continue
+        try:
+            library = ctypes.CDLL(path)
+        except OSError:
+            continue
+        library.conv_layer_create.argtypes = [ctypes.POINTER(_LayerDesc), ctypes.POINTER(ctypes.c_float),
+                                              ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p)]
+        library.conv_layer_destroy.argtypes = [ctypes.c_void_p]
+        library.conv_layer_output_shape.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int,
+                                                    ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+        library.conv_context_create.argtypes = [ctypes.POINTER(_ContextDesc), ctypes.POINTER(ctypes.c_void_p)]
+        library.conv_context_destroy.argtypes = [ctypes.c_void_p]
+        library.conv_forward_dl.argtypes = [ctypes.c_void_p, ctypes.c_void_p,
+                                            ctypes.POINTER(_DLTensor), ctypes.POINTER(_DLTensor)]
+        library.conv_status_string.restype = ctypes.c_char_p
+        _native_library = library
+        return library
+    _native_library = False
+    return None
+
+def native_available():
+    return _load_native_library() is not None
+
+class _BorrowedBuffer:
+    """Buffer-protocol view of an object as a DLPack tensor, without copying its memory."""
+
+    def __init__(self, obj, shape=None, writable=False, dtype=None):
+        self._view = _PyBuffer()
+        flags = _PyBUF_STRIDES | _PyBUF_FORMAT | (_PyBUF_WRITABLE if writable else 0)
+        get_buffer = ctypes.pythonapi.PyObject_GetBuffer
+        get_buffer.argtypes = [ctypes.py_object, ctypes.POINTER(_PyBuffer), ctypes.c_int]
+        if get_buffer(obj, ctypes.byref(self._view), flags) != 0:
+            raise TypeError("Object does not expose a suitable buffer.")
+        try:
+            fmt = dtype or (self._view.format or b"B").decode().lstrip("@=<")
+            if fmt not in _DL_DTYPES or (dtype is None and self._view.itemsize * 8 != _DL_DTYPES[fmt][1]):
+                raise TypeError(f"Unsupported buffer format '{fmt}'; expected float32 ('f'), float64 ('d') or uint8 ('B').")
+            itemsize = _DL_DTYPES[fmt][1] // 8
+            dims = [self._view.shape[i] for i in range(self._view.ndim)]
+            strides = [self._view.strides[i] for i in range(self._view.ndim)]
+            if shape is not None:
+                # Flat buffers (bytes, array.array) need an explicit CHW shape
+                if (self._view.ndim != 1 or strides[0] != self._view.itemsize or
+                        math.prod(shape) * itemsize != self._view.len):
+                    raise ValueError(f"shape {tuple(shape)} does not describe this contiguous buffer of {self._view.len} bytes.")
+                dims = list(shape)
+                strides = [itemsize * math.prod(dims[i + 1:]) for i in range(len(dims))]
+            elif dtype is not None and fmt != (self._view.format or b"B").decode().lstrip("@=<"):
+                raise ValueError("dtype can only reinterpret flat buffers given with shape.")
+            if any(stride % itemsize for stride in strides):
+                raise ValueError("Buffer strides must be whole elements.")
+            self.shape = tuple(dims)
+            self._shape = (ctypes.c_int64 * len(dims))(*dims)
+            self._strides = (ctypes.c_int64 * len(dims))(*[stride // itemsize for stride in strides])
+            code, bits = _DL_DTYPES[fmt]
+            self.tensor = _DLTensor(self._view.buf, _DLDevice(_DL_CPU, 0), len(dims), _DLDataType(code, bits, 1),
+                                    self._shape, self._strides, 0)
+        except Exception:
+            self.release()
+            raise
+
+    def release(self):
+        if self._view.obj is not None:
+            release = ctypes.pythonapi.PyBuffer_Release
+            release.argtypes = [ctypes.POINTER(_PyBuffer)]
+            release(ctypes.byref(self._view))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.release()
+
+class NativeConvolutionLayer:
+    """Same constructor and forward() as ConvolutionLayer, computed by the C engine in float32.
+
+    forward() takes either a nested list (returns a nested list, like ConvolutionLayer) or any
+    buffer-protocol object - NumPy arrays, memoryviews, array.array, bytes - of float32,
+    float64 or uint8 elements. Buffers are read in place, with any strides; flat buffers need
+    shape=(C, H, W), and dtype='f', 'd' or 'B' reinterprets them, e.g. float32 data in bytes.
+    For buffer input the result is returned as a float32 memoryview of shape
+    (out_c, out_h, out_w), or written into out (a writable float32 buffer of that shape) when given.
+    Calls on one layer are serialised; use one layer per thread for parallel inference.
+    """
+
+    def __init__(self, kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights):
+        library = _load_native_library()
+        if library is None:
+            raise RuntimeError("Native convolution library not found; set CNN_NATIVE_LIBRARY.")
+        # Validation and the nested weight layout are shared with the pure-Python class
+        reference = ConvolutionLayer(kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights)
+        self.kernel_size = kernel_size
+        self.stride = stride
+        self.padding_mode = padding_mode
+        self.input_channels = input_channels
+        self.output_channels = output_channels
+        self.kernel_weights = reference.kernel_weights
+
+        flat = array.array("f", (w for oc in self.kernel_weights for ic in oc for row in ic for w in row))
+        weights = (ctypes.c_float * len(flat)).from_buffer(flat)
+        desc = _LayerDesc(kernel_size, stride, padding_mode, input_channels, output_channels)
+        self._library = library
+        self._layer = ctypes.c_void_p()
+        self._context = ctypes.c_void_p()
+        self._check(library.conv_layer_create(ctypes.byref(desc), weights, None, ctypes.byref(self._layer)))
+        self._check(library.conv_context_create(ctypes.byref(_ContextDesc(0, 0, None)), ctypes.byref(self._context)))
+        self._lock = threading.Lock()
+
+    def __del__(self):
+        library = getattr(self, "_library", None)
+        if library is not None:
+            library.conv_context_destroy(self._context)
+            library.conv_layer_destroy(self._layer)
+
+    def _check(self, status):
+        if status != 0:
+            raise ValueError(self._library.conv_status_string(status).decode())
+
+    def output_shape(self, input_height, input_width):
+        height, width = ctypes.c_int(), ctypes.c_int()
+        self._check(self._library.conv_layer_output_shape(self._layer, input_height, input_width,
+                                                          ctypes.byref(height), ctypes.byref(width)))
+        return (self.output_channels, height.value, width.value)
+
+    def forward(self, input_image, shape=None, out=None, dtype=None):
+        if isinstance(input_image, list):
+            if not input_image or not input_image[0] or not input_image[0][0]:
+                raise ValueError("Input image cannot be empty.")
+            channels, height, width = len(input_image), len(input_image[0]), len(input_image[0][0])
+            flat = array.array("f", (v for channel in input_image for row in channel for v in row))
+            result = self.forward(flat, shape=(channels, height, width))
+            return result.tolist()
+
+        with _BorrowedBuffer(input_image, shape, dtype=dtype) as source:
+            if len(source.shape) not in (3, 4) or source.shape[-3] != self.input_channels:
+                raise ValueError(f"Input image channels mismatch. Expected {self.input_channels}, got shape {source.shape}")
+            out_shape = self.output_shape(source.shape[-2], source.shape[-1])
+            result = None
+            if out is None:
+                result = array.array("f", bytes(4 * math.prod(out_shape)))
+                out = result
+            with _BorrowedBuffer(out, out_shape if result is not None else None, writable=True) as target:
+                if target.shape[-3:] != out_shape:
+                    raise ValueError(f"out has shape {target.shape}, expected {out_shape}")
+                with self._lock:
+                    self._check(self._library.conv_forward_dl(self._layer, self._context,
+                                                              ctypes.byref(source.tensor), ctypes.byref(target.tensor)))
+        if result is None:
+            return out
+        return memoryview(result).cast("B").cast("f", out_shape)
+
+def create_convolution_layer(kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights):
+    """NativeConvolutionLayer when the C library is available, otherwise ConvolutionLayer."""
+    if native_available():
+        return NativeConvolutionLayer(kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights)
+    return ConvolutionLayer(kernel_size, stride, padding_mode, input_channels, output_channels, initial_kernel_weights)
+
+def print_image_py(image, label):
+    if not image:
+        print(f"{label} is empty.")
+        return
+
+    channels = len(image)
+    height = len(image[0]) if channels > 0 else 0
+    width = len(image[0][0]) if height > 0 else 0
+
+    print(f"{label} (Channels: {channels}, Height: {height}, Width: {width})")
+    for c_idx, channel_data in enumerate(image):
+        print(f"Channel {c_idx}:")
+        if not channel_data:
+            print("  Empty channel.")
+            continue
+        for r_idx, row_data in enumerate(channel_data):
+            print("  ", end="")
+            if not row_data:
+                print("Empty row.")
+                continue
+            for val in row_data:
+                print(f"{val:8.2f}", end="")
+            print()
+        print()
+
+if __name__ == "__main__":
+    # Parameters from readme.md
+    KERNEL_SIZE = 3
+    STRIDE = 1
+    PADDING_MODE_VALID = 0 # readme: 0 Valid
+    PADDING_MODE_SAME = 1   # readme: 1 Same
+    INPUT_CHANNELS = 3  # readme: (默认为 3 RGB)
+    OUTPUT_CHANNELS = 1 # readme: (默认为 1)
+    INPUT_HEIGHT = 32
+    INPUT_WIDTH = 32
+
+    print("Initializing Python Convolution Layer...")
+    print(f"Kernel Size: {KERNEL_SIZE}")
+    print(f"Input Channels: {INPUT_CHANNELS}, Output Channels: {OUTPUT_CHANNELS}")
+    print(f"Input Dimensions: {INPUT_CHANNELS}x{INPUT_HEIGHT}x{INPUT_WIDTH}")
+
+    # --- 1. Initialize Kernel Weights ---
+    avg_kernel_val = 1.0 / (KERNEL_SIZE * KERNEL_SIZE)
+    kernel_weights = [
+        [
+            [
+                [avg_kernel_val for _ in range(KERNEL_SIZE)] for _ in range(KERNEL_SIZE)
+            ] for _ in range(INPUT_CHANNELS)
+        ] for _ in range(OUTPUT_CHANNELS)
+    ]
+
+    if INPUT_CHANNELS > 1 and KERNEL_SIZE == 3 and OUTPUT_CHANNELS > 0:
+        kernel_weights[0][1] = [
+            [0.0, 0.0, 0.0],
+            [0.0, 1.0, 0.0],
+            [0.0, 0.0, 0.0]
+        ]
+
+    # --- 2. Create Input Image Data ---
+    input_image_data = [
+        [
+            [float(c * 100 + h * 10 + w) for w in range(INPUT_WIDTH)] for h in range(INPUT_HEIGHT)
+        ] for c in range(INPUT_CHANNELS)
+    ]
+
+    # --- Test Case 1: VALID padding (0), Stride 1 ---
+    current_padding_mode_val = PADDING_MODE_VALID
+    print(f"\n--- Test Case 1: Stride {STRIDE}, Padding Mode: {current_padding_mode_val} ({'VALID' if current_padding_mode_val == 0 else 'SAME'}) ---")
+    try:
+        conv_layer_valid = ConvolutionLayer(
+            kernel_size=KERNEL_SIZE,
+            stride=STRIDE,
+            padding_mode=current_padding_mode_val,
+            input_channels=INPUT_CHANNELS,
+            output_channels=OUTPUT_CHANNELS,
+            initial_kernel_weights=kernel_weights
+        )
+        print("Performing convolution...")
+        output_image_valid = conv_layer_valid.forward(input_image_data)
+        print("Convolution complete.")
+        print_image_py(output_image_valid, f"Output Image (Padding {current_padding_mode_val}, Stride {STRIDE})")
+
+    except ValueError as e:
+        print(f"Error: {e}")
+
+    # --- Test Case 2: SAME padding (1), Stride 2 ---
+    STRIDE_2 = 2
+    current_padding_mode_val = PADDING_MODE_SAME
+    print(f"\n--- Test Case 2: Stride {STRIDE_2}, Padding Mode: {current_padding_mode_val} ({'VALID' if current_padding_mode_val == 0 else 'SAME'}) ---")
+    try:
+        conv_layer_same_s2 = ConvolutionLayer(
+            kernel_size=KERNEL_SIZE,
+            stride=STRIDE_2,
+            padding_mode=current_padding_mode_val,
+            input_channels=INPUT_CHANNELS,
+            output_channels=OUTPUT_CHANNELS,
+            initial_kernel_weights=kernel_weights
+        )
+        print("Performing convolution...")
+        output_image_same_s2 = conv_layer_same_s2.forward(input_image_data)
+        print("Convolution complete.")
+        print_image_py(output_image_same_s2, f"Output Image (Padding {current_padding_mode_val}, Stride {STRIDE_2})")
+
+    except ValueError as e:
+        print(f"Error: {e}")
+
+    # --- Native engine: same forward() on nested lists and zero-copy buffers ---
+    if native_available():
+        import time
+        native_layer = create_convolution_layer(KERNEL_SIZE, STRIDE_2, PADDING_MODE_SAME,
+                                                INPUT_CHANNELS, OUTPUT_CHANNELS, kernel_weights)
+        start = time.perf_counter()
+        native_output = native_layer.forward(input_image_data)
+        native_ms = (time.perf_counter() - start) * 1000.0
+        max_difference = max(abs(a - b) for ca, cb in zip(native_output, output_image_same_s2)
+                             for ra, rb in zip(ca, cb) for a, b in zip(ra, rb))
+        print(f"\nNative engine: {native_ms:.3f} ms, max difference from pure Python {max_difference:.2e}")
+
+        flat_input = array.array("f", (v for channel in input_image_data for row in channel for v in row))
+        buffer_output = native_layer.forward(flat_input, shape=(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH))
+        print(f"Buffer input: output memoryview shape {buffer_output.shape}, "
+              f"{'matches' if buffer_output.tolist() == native_output else 'DOES NOT match'} list input")
+    else:
+        print("\nNative engine not built; pure-Python ConvolutionLayer only.")
+
     print("\nPython convolution demo finished.") 
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "cpu_topology.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+// NUMA node recorded by place_current_thread; -1 until the thread is placed
+thread_local int placed_numa_node = -1;
+
+// Parse a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parse_cpu_list(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool cpu_usable(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return true;
+    }
+    return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+#else
+    (void)cpu;
+    return true;
+#endif
+}
+} // namespace
+
+CpuTopology::CpuTopology()
+{
+#ifdef __linux__
+    for (int node = 0;; ++node)
+    {
+        std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpulist)
+        {
+            break;
+        }
+        std::string text;
+        std::getline(cpulist, text);
+        std::vector<int> usable;
+        try
+        {
+            for (int cpu : parse_cpu_list(text))
+            {
+                if (cpu_usable(cpu))
+                {
+                    usable.push_back(cpu);
+                }
+            }
+        }
+        catch (const std::exception &)
+        {
+            usable.clear(); // malformed list: treat the node as unusable
+        }
+        if (!usable.empty())
+        {
+            node_cpus_.push_back(usable);
+        }
+    }
+#endif
+
+    if (node_cpus_.empty())
+    {
+        // Single-node fallback with every usable CPU
+        int cpu_count = static_cast<int>(std::thread::hardware_concurrency());
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < (cpu_count > 0 ? cpu_count : 1); ++cpu)
+        {
+            if (cpu_usable(cpu))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty())
+        {
+            cpus.push_back(0);
+        }
+        node_cpus_.push_back(cpus);
+    }
+
+    for (size_t node = 0; node < node_cpus_.size(); ++node)
+    {
+        for (int cpu : node_cpus_[node])
+        {
+            if (cpu >= static_cast<int>(cpu_nodes_.size()))
+            {
+                cpu_nodes_.resize(cpu + 1, -1);
+            }
+            cpu_nodes_[cpu] = static_cast<int>(node);
+        }
+    }
+}
+
+const CpuTopology &CpuTopology::get()
+{
+    static const CpuTopology topology;
+    return topology;
+}
+
+int CpuTopology::node_of_cpu(int cpu) const
+{
+    if (cpu < 0 || cpu >= static_cast<int>(cpu_nodes_.size()) || cpu_nodes_[cpu] < 0)
+    {
+        return 0;
+    }
+    return cpu_nodes_[cpu];
+}
+
+int CpuTopology::cpu_for_worker(int worker_index, ThreadAffinity affinity) const
+{
+    if (affinity == ThreadAffinity::NONE)
+    {
+        return -1;
+    }
+
+    std::vector<int> order;
+    if (affinity == ThreadAffinity::COMPACT)
+    {
+        for (const std::vector<int> &cpus : node_cpus_)
+        {
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+    }
+    else
+    {
+        // SPREAD: first CPU of every node, then the second of every node, ...
+        for (size_t rank = 0;; ++rank)
+        {
+            bool added = false;
+            for (const std::vector<int> &cpus : node_cpus_)
+            {
+                if (rank < cpus.size())
+                {
+                    order.push_back(cpus[rank]);
+                    added = true;
+                }
+            }
+            if (!added)
+            {
+                break;
+            }
+        }
+    }
+    return order[worker_index % order.size()];
+}
+
+bool pin_current_thread(int cpu)
+{
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        return false;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void place_current_thread(int worker_index, ThreadAffinity affinity)
+{
+    const CpuTopology &topology = CpuTopology::get();
+    int cpu = topology.cpu_for_worker(worker_index, affinity);
+    if (cpu >= 0 && pin_current_thread(cpu))
+    {
+        placed_numa_node = topology.node_of_cpu(cpu);
+    }
+}
+
+int current_numa_node()
+{
+    if (placed_numa_node >= 0)
+    {
+        return placed_numa_node;
+    }
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0)
+    {
+        return CpuTopology::get().node_of_cpu(cpu);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <vector>
+
+// How worker threads are placed on CPUs
+enum class ThreadAffinity
+{
+    NONE,    // let the OS schedule (and migrate) workers freely
+    COMPACT, // pin workers to consecutive CPUs, filling one NUMA node before the next
+    SPREAD   // pin workers round-robin across NUMA nodes
+};
+
+// CPU and NUMA layout of the machine, restricted to the CPUs this process may run on.
+// On Linux it is read from sysfs; elsewhere, or if sysfs is unavailable, the machine is
+// reported as a single node holding every CPU, and pinning is a no-op.
+class CpuTopology
+{
+public:
+    static const CpuTopology &get();
+
+    int numa_node_count() const { return static_cast<int>(node_cpus_.size()); }
+    const std::vector<int> &node_cpus(int node) const { return node_cpus_[node]; }
+
+    // NUMA node of a CPU, or 0 if unknown
+    int node_of_cpu(int cpu) const;
+
+    // CPU for worker worker_index under the given affinity policy; -1 for ThreadAffinity::NONE
+    int cpu_for_worker(int worker_index, ThreadAffinity affinity) const;
+
+private:
+    CpuTopology();
+
+    std::vector<std::vector<int>> node_cpus_; // usable CPUs of each node
+    std::vector<int> cpu_nodes_;              // indexed by CPU id, -1 if unusable
+};
+
+// Pin the calling thread to cpu. Returns false if pinning is unsupported or failed;
+// callers treat that as "run unpinned".
+bool pin_current_thread(int cpu);
+
+// Apply the placement for worker worker_index; also records the worker's NUMA node
+void place_current_thread(int worker_index, ThreadAffinity affinity);
+
+// NUMA node the calling thread runs on (recorded at placement, otherwise queried)
+int current_numa_node();
+
+#endif // CPU_TOPOLOGY_H
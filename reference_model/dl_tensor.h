@@ -0,0 +1,138 @@
+#ifndef DL_TENSOR_H
+#define DL_TENSOR_H
+
+#include <stddef.h> // For ptrdiff_t
+#include <stdint.h> // For fixed-width integers
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Tensor descriptor with the same memory layout as DLPack's DLTensor, so a DLTensor
+    // (or the dl_tensor of a DLManagedTensor) from another library can be passed by
+    // casting its address. Strides are in elements; NULL strides mean compact row-major.
+
+    typedef enum
+    {
+        CONV_DL_CPU = 1 // kDLCPU; the only device read here
+    } conv_dl_device_type;
+
+    typedef enum
+    {
+        CONV_DL_INT = 0,  // kDLInt
+        CONV_DL_UINT = 1, // kDLUInt
+        CONV_DL_FLOAT = 2 // kDLFloat
+    } conv_dl_type_code;
+
+    typedef struct
+    {
+        int32_t device_type; // conv_dl_device_type
+        int32_t device_id;
+    } conv_dl_device;
+
+    typedef struct
+    {
+        uint8_t code; // conv_dl_type_code
+        uint8_t bits;
+        uint16_t lanes;
+    } conv_dl_dtype;
+
+    typedef struct
+    {
+        void *data;
+        conv_dl_device device;
+        int32_t ndim;
+        conv_dl_dtype dtype;
+        int64_t *shape;
+        int64_t *strides;
+        uint64_t byte_offset;
+    } conv_dl_tensor;
+
+    // Element types the convolution code can read
+    typedef enum
+    {
+        CONV_DL_ELEMENT_FLOAT32,
+        CONV_DL_ELEMENT_FLOAT64,
+        CONV_DL_ELEMENT_UINT8
+    } conv_dl_element;
+
+    // A CPU tensor of shape [C, H, W] or [1, C, H, W] reduced to a CHW view
+    typedef struct
+    {
+        const char *data; // first element, byte_offset applied
+        conv_dl_element element;
+        int channels;
+        int height;
+        int width;
+        ptrdiff_t channel_stride; // in elements
+        ptrdiff_t row_stride;
+        ptrdiff_t column_stride;
+    } conv_dl_chw;
+
+    // Returns 1 and fills view if tensor is a readable CHW image, 0 otherwise
+    // (not on the CPU, unsupported dtype, wrong rank, batch other than 1, or empty).
+    // Inline like conv_dl_chw_load, so the C and C++ builds need no extra object file.
+    static inline int conv_dl_tensor_to_chw(const conv_dl_tensor *tensor, conv_dl_chw *view)
+    {
+        if (!tensor || !view || !tensor->data || !tensor->shape || tensor->device.device_type != CONV_DL_CPU)
+            return 0;
+        if (tensor->ndim != 3 && !(tensor->ndim == 4 && tensor->shape[0] == 1))
+            return 0;
+        if (tensor->dtype.lanes != 1)
+            return 0;
+
+        if (tensor->dtype.code == CONV_DL_FLOAT && tensor->dtype.bits == 32)
+            view->element = CONV_DL_ELEMENT_FLOAT32;
+        else if (tensor->dtype.code == CONV_DL_FLOAT && tensor->dtype.bits == 64)
+            view->element = CONV_DL_ELEMENT_FLOAT64;
+        else if (tensor->dtype.code == CONV_DL_UINT && tensor->dtype.bits == 8)
+            view->element = CONV_DL_ELEMENT_UINT8;
+        else
+            return 0;
+
+        const int first = tensor->ndim - 3; // skip the batch dimension
+        const int64_t *shape = tensor->shape + first;
+        if (shape[0] <= 0 || shape[1] <= 0 || shape[2] <= 0 ||
+            shape[0] > INT32_MAX || shape[1] > INT32_MAX || shape[2] > INT32_MAX)
+            return 0;
+        view->channels = (int)shape[0];
+        view->height = (int)shape[1];
+        view->width = (int)shape[2];
+
+        if (tensor->strides)
+        {
+            view->channel_stride = (ptrdiff_t)tensor->strides[first];
+            view->row_stride = (ptrdiff_t)tensor->strides[first + 1];
+            view->column_stride = (ptrdiff_t)tensor->strides[first + 2];
+        }
+        else
+        {
+            view->column_stride = 1;
+            view->row_stride = view->width;
+            view->channel_stride = (ptrdiff_t)view->height * view->width;
+        }
+        view->data = (const char *)tensor->data + tensor->byte_offset;
+        return 1;
+    }
+
+    // Element (c, h, w) of a view converted to float
+    static inline float conv_dl_chw_load(const conv_dl_chw *view, int c, int h, int w)
+    {
+        ptrdiff_t index = c * view->channel_stride + h * view->row_stride + w * view->column_stride;
+        switch (view->element)
+        {
+        case CONV_DL_ELEMENT_FLOAT64:
+            return (float)((const double *)view->data)[index];
+        case CONV_DL_ELEMENT_UINT8:
+            return (float)((const uint8_t *)view->data)[index];
+        default:
+            return ((const float *)view->data)[index];
+        }
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DL_TENSOR_H
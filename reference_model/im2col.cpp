@@ -0,0 +1,236 @@
+#include "im2col.h"
+#include <algorithm> // For std::fill
+
+void im2col_channel(
+    const std::vector<std::vector<float>> &channel,
+    const ConvolutionGeometry &geometry,
+    int kernel_size,
+    int stride,
+    BorderMode border_mode,
+    float *columns)
+{
+    const int output_positions = geometry.output_height * geometry.output_width;
+    for (int k_h = 0; k_h < kernel_size; ++k_h)
+    {
+        for (int k_w = 0; k_w < kernel_size; ++k_w)
+        {
+            float *row = columns + static_cast<size_t>(k_h * kernel_size + k_w) * output_positions;
+            for (int out_h = 0; out_h < geometry.output_height; ++out_h)
+            {
+                int h_idx = border_index(out_h * stride + k_h - geometry.padding_h, geometry.input_height, border_mode);
+                float *out = row + out_h * geometry.output_width;
+                if (h_idx < 0)
+                {
+                    std::fill(out, out + geometry.output_width, 0.0f);
+                    continue;
+                }
+                const std::vector<float> &input_row = channel[h_idx];
+                for (int out_w = 0; out_w < geometry.output_width; ++out_w)
+                {
+                    int w_idx = border_index(out_w * stride + k_w - geometry.padding_w, geometry.input_width, border_mode);
+                    out[out_w] = w_idx >= 0 ? input_row[w_idx] : 0.0f;
+                }
+            }
+        }
+    }
+}
+
+void col2im_channel(
+    const float *columns,
+    const ConvolutionGeometry &geometry,
+    int kernel_size,
+    int stride,
+    BorderMode border_mode,
+    std::vector<std::vector<float>> &channel)
+{
+    const int output_positions = geometry.output_height * geometry.output_width;
+    for (int k_h = 0; k_h < kernel_size; ++k_h)
+    {
+        for (int k_w = 0; k_w < kernel_size; ++k_w)
+        {
+            const float *row = columns + static_cast<size_t>(k_h * kernel_size + k_w) * output_positions;
+            for (int out_h = 0; out_h < geometry.output_height; ++out_h)
+            {
+                int h_idx = border_index(out_h * stride + k_h - geometry.padding_h, geometry.input_height, border_mode);
+                if (h_idx < 0)
+                {
+                    continue;
+                }
+                std::vector<float> &input_row = channel[h_idx];
+                const float *in = row + out_h * geometry.output_width;
+                for (int out_w = 0; out_w < geometry.output_width; ++out_w)
+                {
+                    int w_idx = border_index(out_w * stride + k_w - geometry.padding_w, geometry.input_width, border_mode);
+                    if (w_idx >= 0)
+                    {
+                        input_row[w_idx] += in[out_w];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void im2col_nd(
+    const float *input,
+    int input_channels,
+    const std::vector<ConvolutionAxis> &axes,
+    BorderMode border_mode,
+    int first_position,
+    int position_count,
+    float *columns)
+{
+    // Lower ranks are padded with leading unit axes so one three-axis walk serves all ranks
+    std::vector<ConvolutionAxis> axis(3 - axes.size(), ConvolutionAxis{1, 1, 1, 1, 0});
+    axis.insert(axis.end(), axes.begin(), axes.end());
+
+    // source[a][k * output_size + o]: input index read by tap k at output coordinate o, or -1
+    std::vector<int> source[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        source[a].resize(static_cast<size_t>(axis[a].kernel_size) * axis[a].output_size);
+        for (int k = 0; k < axis[a].kernel_size; ++k)
+        {
+            for (int o = 0; o < axis[a].output_size; ++o)
+            {
+                source[a][k * axis[a].output_size + o] = border_index(o * axis[a].stride + k - axis[a].padding,
+                                                                      axis[a].input_size, border_mode);
+            }
+        }
+    }
+
+    const size_t plane = static_cast<size_t>(axis[1].input_size) * axis[2].input_size;
+    const size_t channel_size = axis[0].input_size * plane;
+    const int first_2 = first_position % axis[2].output_size;
+    const int first_1 = first_position / axis[2].output_size % axis[1].output_size;
+    const int first_0 = first_position / axis[2].output_size / axis[1].output_size;
+
+    float *row = columns;
+    for (int in_c = 0; in_c < input_channels; ++in_c)
+    {
+        const float *channel = input + in_c * channel_size;
+        for (int k_0 = 0; k_0 < axis[0].kernel_size; ++k_0)
+        {
+            const int *source_0 = source[0].data() + k_0 * axis[0].output_size;
+            for (int k_1 = 0; k_1 < axis[1].kernel_size; ++k_1)
+            {
+                const int *source_1 = source[1].data() + k_1 * axis[1].output_size;
+                for (int k_2 = 0; k_2 < axis[2].kernel_size; ++k_2, row += position_count)
+                {
+                    const int *source_2 = source[2].data() + k_2 * axis[2].output_size;
+                    int o_0 = first_0, o_1 = first_1, o_2 = first_2;
+                    for (int j = 0; j < position_count; ++j)
+                    {
+                        int i_0 = source_0[o_0], i_1 = source_1[o_1], i_2 = source_2[o_2];
+                        row[j] = (i_0 >= 0 && i_1 >= 0 && i_2 >= 0) ? channel[i_0 * plane + i_1 * axis[2].input_size + i_2] : 0.0f;
+                        if (++o_2 == axis[2].output_size)
+                        {
+                            o_2 = 0;
+                            if (++o_1 == axis[1].output_size)
+                            {
+                                o_1 = 0;
+                                ++o_0;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void gemm_nn(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        const float *a_row = a + static_cast<size_t>(i) * lda;
+        float *c_row = c + static_cast<size_t>(i) * ldc;
+        std::fill(c_row, c_row + n, 0.0f);
+        // Rank-1 updates along the row: contiguous in B and C, and each entry still sums l in order
+        for (int l = 0; l < k; ++l)
+        {
+            const float scale = a_row[l];
+            const float *b_row = b + static_cast<size_t>(l) * ldb;
+            for (int j = 0; j < n; ++j)
+            {
+                c_row[j] += scale * b_row[j];
+            }
+        }
+    }
+}
+
+void gemm_nt(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc)
+{
+    // Four rows of A at a time, so every row of B streamed from memory serves four dot products
+    int i = 0;
+    for (; i + 4 <= m; i += 4)
+    {
+        const float *a0 = a + static_cast<size_t>(i) * lda;
+        const float *a1 = a0 + lda;
+        const float *a2 = a1 + lda;
+        const float *a3 = a2 + lda;
+        for (int j = 0; j < n; ++j)
+        {
+            const float *b_row = b + static_cast<size_t>(j) * ldb;
+            float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+            for (int l = 0; l < k; ++l)
+            {
+                sum0 += a0[l] * b_row[l];
+                sum1 += a1[l] * b_row[l];
+                sum2 += a2[l] * b_row[l];
+                sum3 += a3[l] * b_row[l];
+            }
+            c[static_cast<size_t>(i) * ldc + j] = sum0;
+            c[static_cast<size_t>(i + 1) * ldc + j] = sum1;
+            c[static_cast<size_t>(i + 2) * ldc + j] = sum2;
+            c[static_cast<size_t>(i + 3) * ldc + j] = sum3;
+        }
+    }
+    for (; i < m; ++i)
+    {
+        const float *a_row = a + static_cast<size_t>(i) * lda;
+        for (int j = 0; j < n; ++j)
+        {
+            const float *b_row = b + static_cast<size_t>(j) * ldb;
+            float sum = 0.0f;
+            for (int l = 0; l < k; ++l)
+            {
+                sum += a_row[l] * b_row[l];
+            }
+            c[static_cast<size_t>(i) * ldc + j] = sum;
+        }
+    }
+}
+
+void gemm_tn(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        std::fill(c + static_cast<size_t>(i) * ldc, c + static_cast<size_t>(i) * ldc + n, 0.0f);
+    }
+    // Rank-1 updates: row l of B is scaled into every row of C, all accesses contiguous
+    for (int l = 0; l < k; ++l)
+    {
+        const float *a_row = a + static_cast<size_t>(l) * lda;
+        const float *b_row = b + static_cast<size_t>(l) * ldb;
+        for (int i = 0; i < m; ++i)
+        {
+            const float scale = a_row[i];
+            float *c_row = c + static_cast<size_t>(i) * ldc;
+            for (int j = 0; j < n; ++j)
+            {
+                c_row[j] += scale * b_row[j];
+            }
+        }
+    }
+}
+
+float pairwise_sum(const float *values, int count)
+{
+    if (count == 1)
+    {
+        return values[0];
+    }
+    int half = count / 2;
+    return pairwise_sum(values, half) + pairwise_sum(values + half, count - half);
+}
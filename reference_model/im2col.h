@@ -0,0 +1,73 @@
+#ifndef IM2COL_H
+#define IM2COL_H
+
+#include <vector>
+#include "convolution.h"
+
+// Column ("im2col") layout for the GEMM formulation of convolution. For one input channel
+// there are kernel_size * kernel_size rows, row k_h * kernel_size + k_w; column
+// p = out_h * output_width + out_w holds the input pixel that tap multiplies for output p
+// (0 in zero padding, the border_mode source pixel otherwise). Stacking the rows of all input channels gives an
+// (in_c * k * k) x (output_height * output_width) matrix X, and with the packed
+// [out_c][in_c][k_h][k_w] weights read as an out_c x (in_c * k * k) matrix W the convolution
+// is W * X. Channels are handled one at a time so callers can split the work over channels.
+
+// Write the kernel_size^2 rows of one input channel to columns (row-major, one row per tap)
+void im2col_channel(
+    const std::vector<std::vector<float>> &channel,
+    const ConvolutionGeometry &geometry,
+    int kernel_size,
+    int stride,
+    BorderMode border_mode,
+    float *columns);
+
+// Adjoint of im2col_channel: add every column entry back onto the pixel it was read from
+// (for non-zero border modes, the source pixel of the padding). Zero-padding entries are dropped.
+void col2im_channel(
+    const float *columns,
+    const ConvolutionGeometry &geometry,
+    int kernel_size,
+    int stride,
+    BorderMode border_mode,
+    std::vector<std::vector<float>> &channel);
+
+// One spatial axis of a convolution with up to three spatial dimensions
+struct ConvolutionAxis
+{
+    int input_size;
+    int output_size;
+    int kernel_size;
+    int stride;
+    int padding; // leading padding (SAME mode)
+};
+
+// im2col over one to three spatial axes (outermost first) for the output positions
+// [first_position, first_position + position_count), numbered row-major over the output axes.
+// input is a contiguous [in_c][axis 0]...[axis n-1] array. Writes in_c * prod(kernel_size) rows
+// of position_count values; row (in_c, k_0, ..., k_n-1) is numbered row-major like the packed
+// weights, so the 2D case matches im2col_channel restricted to the position range. Positions
+// in the padding read the border_mode source pixel of every axis, or 0 for ZERO.
+void im2col_nd(
+    const float *input,
+    int input_channels,
+    const std::vector<ConvolutionAxis> &axes,
+    BorderMode border_mode,
+    int first_position,
+    int position_count,
+    float *columns);
+
+// C (m x n) = A (m x k) * B, where B is k x n. Each C entry is summed over l = 0..k-1 in
+// order, the order of the direct SEQUENTIAL loops. Row-major with leading dimensions lda/ldb/ldc.
+void gemm_nn(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc);
+
+// Fixed balanced binary tree over values[0, count): the association depends only on count.
+// The BLOCKED_PAIRWISE combine step of ConvolutionLayer and ConvolutionEngineND.
+float pairwise_sum(const float *values, int count);
+
+// C (m x n) = A (m x k) * B^T, where B is n x k. Row-major with leading dimensions lda/ldb/ldc.
+void gemm_nt(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc);
+
+// C (m x n) = A^T * B, where A is k x m and B is k x n. Row-major with leading dimensions lda/ldb/ldc.
+void gemm_tn(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc);
+
+#endif // IM2COL_H
@@ -0,0 +1,348 @@
+#include "incremental_convolution.h"
+#include <algorithm> // For std::min, std::max, std::sort, std::unique
+#include <utility>   // For std::pair
+
+// Integer division rounding towards negative infinity (numerator may be negative)
+static int floor_div(int numerator, int denominator)
+{
+    int quotient = numerator / denominator;
+    if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0)))
+    {
+        --quotient;
+    }
+    return quotient;
+}
+
+// Widen [first, last] by the outputs whose receptive fields overlap padded indices [low, high]
+// of one axis (output o reads indices [o * stride - padding, o * stride - padding + kernel_size - 1])
+static void add_affected_outputs(int low, int high, int padding, int kernel_size, int stride, int outputs,
+                                 int &first, int &last)
+{
+    int range_first = std::max(-floor_div(-(low + padding - (kernel_size - 1)), stride), 0);
+    int range_last = std::min(floor_div(high + padding, stride), outputs - 1);
+    if (range_first <= range_last)
+    {
+        first = std::min(first, range_first);
+        last = std::max(last, range_last);
+    }
+}
+
+// Outputs of one axis affected by input indices [low, high]: besides the direct overlap, a
+// non-zero border also feeds those inputs into padded positions of the other windows
+static void affected_axis_outputs(int low, int high, int size, int padding, int kernel_size, int stride, int outputs,
+                                  BorderMode border_mode, int &first, int &last)
+{
+    first = outputs;
+    last = -1;
+    const int reach = stride * outputs + kernel_size; // beyond any padded index a window reads
+    switch (border_mode)
+    {
+    case BorderMode::REPLICATE:
+        add_affected_outputs(low == 0 ? -reach : low, high == size - 1 ? size - 1 + reach : high,
+                             padding, kernel_size, stride, outputs, first, last);
+        break;
+    case BorderMode::REFLECT:
+        add_affected_outputs(low, high, padding, kernel_size, stride, outputs, first, last);
+        add_affected_outputs(-high, -low, padding, kernel_size, stride, outputs, first, last);
+        add_affected_outputs(2 * (size - 1) - high, 2 * (size - 1) - low, padding, kernel_size, stride, outputs,
+                             first, last);
+        break;
+    case BorderMode::CIRCULAR:
+        add_affected_outputs(low, high, padding, kernel_size, stride, outputs, first, last);
+        add_affected_outputs(low - size, high - size, padding, kernel_size, stride, outputs, first, last);
+        add_affected_outputs(low + size, high + size, padding, kernel_size, stride, outputs, first, last);
+        break;
+    default:
+        add_affected_outputs(low, high, padding, kernel_size, stride, outputs, first, last);
+        break;
+    }
+}
+
+// Disjoint rectangles covering the union of regions. Horizontal bands between consecutive
+// region edges are split into merged column intervals, and an interval continuing the one
+// directly above it extends that rectangle, so vertically stacked regions come out as one.
+// Work depends on the number of regions, not on the output size.
+static std::vector<OutputRegion> disjoint_union(const std::vector<OutputRegion> &regions)
+{
+    std::vector<int> edges;
+    for (const OutputRegion &region : regions)
+    {
+        edges.push_back(region.top);
+        edges.push_back(region.top + region.height);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<OutputRegion> result;
+    std::vector<size_t> open; // rectangles of result ending at the top of the current band
+    for (size_t b = 0; b + 1 < edges.size(); ++b)
+    {
+        const int band_top = edges[b];
+        const int band_bottom = edges[b + 1];
+        std::vector<std::pair<int, int>> intervals; // [left, right)
+        for (const OutputRegion &region : regions)
+        {
+            if (region.top <= band_top && region.top + region.height >= band_bottom)
+            {
+                intervals.push_back(std::make_pair(region.left, region.left + region.width));
+            }
+        }
+        std::sort(intervals.begin(), intervals.end());
+
+        std::vector<size_t> next_open;
+        size_t i = 0;
+        while (i < intervals.size())
+        {
+            int left = intervals[i].first;
+            int right = intervals[i].second;
+            for (++i; i < intervals.size() && intervals[i].first <= right; ++i)
+            {
+                right = std::max(right, intervals[i].second);
+            }
+
+            size_t index = result.size();
+            for (size_t candidate : open)
+            {
+                if (result[candidate].left == left && result[candidate].width == right - left)
+                {
+                    index = candidate;
+                    break;
+                }
+            }
+            if (index == result.size())
+            {
+                OutputRegion region;
+                region.top = band_top;
+                region.left = left;
+                region.height = 0;
+                region.width = right - left;
+                result.push_back(region);
+            }
+            result[index].height += band_bottom - band_top;
+            next_open.push_back(index);
+        }
+        open.swap(next_open);
+    }
+    return result;
+}
+
+IncrementalConvolution::IncrementalConvolution(const ConvolutionLayer &layer, int diff_tile_size) : layer_(layer),
+                                                                                                     diff_tile_size_(diff_tile_size),
+                                                                                                     has_previous_(false),
+                                                                                                     geometry_(),
+                                                                                                     last_recomputed_positions_(0)
+{
+    if (diff_tile_size <= 0)
+    {
+        throw std::runtime_error("Diff tile size must be positive.");
+    }
+}
+
+void IncrementalConvolution::reset()
+{
+    has_previous_ = false;
+    previous_input_.clear();
+    output_.clear();
+    last_recomputed_positions_ = 0;
+}
+
+bool IncrementalConvolution::matches_previous_shape(const std::vector<std::vector<std::vector<float>>> &frame) const
+{
+    return has_previous_ &&
+           frame.size() == previous_input_.size() &&
+           !frame.empty() && frame[0].size() == previous_input_[0].size() &&
+           !frame[0].empty() && frame[0][0].size() == previous_input_[0][0].size();
+}
+
+void IncrementalConvolution::full_update(const std::vector<std::vector<std::vector<float>>> &frame)
+{
+    output_ = layer_.forward(frame);
+    previous_input_ = frame;
+    geometry_ = layer_.compute_geometry(frame[0].size(), frame[0][0].size());
+    has_previous_ = true;
+    last_recomputed_positions_ = static_cast<long long>(geometry_.output_height) * geometry_.output_width;
+}
+
+const std::vector<std::vector<std::vector<float>>> &IncrementalConvolution::update(
+    const std::vector<std::vector<std::vector<float>>> &frame)
+{
+    if (!matches_previous_shape(frame))
+    {
+        full_update(frame);
+        return output_;
+    }
+
+    apply_dirty_regions(frame, diff_regions(frame));
+    return output_;
+}
+
+const std::vector<std::vector<std::vector<float>>> &IncrementalConvolution::update(
+    const std::vector<std::vector<std::vector<float>>> &frame,
+    const std::vector<InputRegion> &dirty_regions)
+{
+    if (!matches_previous_shape(frame))
+    {
+        full_update(frame);
+        return output_;
+    }
+
+    for (const InputRegion &region : dirty_regions)
+    {
+        if (region.top < 0 || region.left < 0 || region.height < 0 || region.width < 0 ||
+            region.top + region.height > geometry_.input_height ||
+            region.left + region.width > geometry_.input_width)
+        {
+            throw std::runtime_error("Dirty region lies outside the input frame.");
+        }
+    }
+
+    apply_dirty_regions(frame, dirty_regions);
+    return output_;
+}
+
+std::vector<InputRegion> IncrementalConvolution::diff_regions(
+    const std::vector<std::vector<std::vector<float>>> &frame) const
+{
+    const int height = geometry_.input_height;
+    const int width = geometry_.input_width;
+    const int tiles_x = (width + diff_tile_size_ - 1) / diff_tile_size_;
+
+    std::vector<InputRegion> regions;
+    std::vector<bool> dirty_tiles(tiles_x);
+
+    for (int tile_top = 0; tile_top < height; tile_top += diff_tile_size_)
+    {
+        int tile_bottom = std::min(tile_top + diff_tile_size_, height);
+
+        for (int tx = 0; tx < tiles_x; ++tx)
+        {
+            int tile_left = tx * diff_tile_size_;
+            int tile_right = std::min(tile_left + diff_tile_size_, width);
+            bool dirty = false;
+            for (size_t c = 0; c < frame.size() && !dirty; ++c)
+            {
+                for (int h = tile_top; h < tile_bottom && !dirty; ++h)
+                {
+                    const std::vector<float> &new_row = frame[c][h];
+                    const std::vector<float> &old_row = previous_input_[c][h];
+                    for (int w = tile_left; w < tile_right; ++w)
+                    {
+                        if (new_row[w] != old_row[w])
+                        {
+                            dirty = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            dirty_tiles[tx] = dirty;
+        }
+
+        // One region per horizontal run of dirty tiles. The dilated output regions of runs in
+        // neighbouring bands still overlap; apply_dirty_regions makes them disjoint.
+        int tx = 0;
+        while (tx < tiles_x)
+        {
+            if (!dirty_tiles[tx])
+            {
+                ++tx;
+                continue;
+            }
+            int run_start = tx;
+            while (tx < tiles_x && dirty_tiles[tx])
+            {
+                ++tx;
+            }
+            InputRegion region;
+            region.top = tile_top;
+            region.left = run_start * diff_tile_size_;
+            region.height = tile_bottom - tile_top;
+            region.width = std::min(tx * diff_tile_size_, width) - region.left;
+            regions.push_back(region);
+        }
+    }
+
+    return regions;
+}
+
+OutputRegion IncrementalConvolution::map_to_output(const InputRegion &region) const
+{
+    // Output o reads input rows [o * stride - pad, o * stride - pad + kernel_size - 1], so it is
+    // affected by rows [top, bottom] when o * stride lies in [top + pad - (kernel_size - 1), bottom + pad].
+    // With a non-zero border the mirrored/replicated/wrapped copies of the region count as well;
+    // the result is the bounding rectangle of all of them.
+    const int kernel_size = layer_.kernel_size();
+    const int stride = layer_.stride();
+
+    int first_h, last_h, first_w, last_w;
+    affected_axis_outputs(region.top, region.top + region.height - 1, geometry_.input_height, geometry_.padding_h,
+                          kernel_size, stride, geometry_.output_height, layer_.border_mode(), first_h, last_h);
+    affected_axis_outputs(region.left, region.left + region.width - 1, geometry_.input_width, geometry_.padding_w,
+                          kernel_size, stride, geometry_.output_width, layer_.border_mode(), first_w, last_w);
+
+    OutputRegion output_region;
+    output_region.top = first_h;
+    output_region.left = first_w;
+    output_region.height = std::max(0, last_h - first_h + 1);
+    output_region.width = std::max(0, last_w - first_w + 1);
+    return output_region;
+}
+
+void IncrementalConvolution::apply_dirty_regions(
+    const std::vector<std::vector<std::vector<float>>> &frame,
+    const std::vector<InputRegion> &dirty_regions)
+{
+    last_recomputed_positions_ = 0;
+
+    // Bring the stored frame up to date first: a dilated output region may read pixels of a
+    // neighbouring dirty region.
+    std::vector<OutputRegion> output_regions;
+    for (const InputRegion &region : dirty_regions)
+    {
+        if (region.height == 0 || region.width == 0)
+        {
+            continue;
+        }
+        for (size_t c = 0; c < frame.size(); ++c)
+        {
+            for (int h = region.top; h < region.top + region.height; ++h)
+            {
+                std::copy(frame[c][h].begin() + region.left,
+                          frame[c][h].begin() + region.left + region.width,
+                          previous_input_[c][h].begin() + region.left);
+            }
+        }
+
+        OutputRegion output_region = map_to_output(region);
+        if (output_region.height > 0 && output_region.width > 0)
+        {
+            output_regions.push_back(output_region);
+        }
+    }
+
+    if (output_regions.empty())
+    {
+        return;
+    }
+    // Receptive-field dilation makes the regions of neighbouring dirty areas overlap; compute
+    // (and count) every output position once
+    output_regions = disjoint_union(output_regions);
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> region_outputs =
+        layer_.forward_roi(previous_input_, output_regions);
+
+    for (size_t r = 0; r < output_regions.size(); ++r)
+    {
+        const OutputRegion &region = output_regions[r];
+        for (size_t c = 0; c < output_.size(); ++c)
+        {
+            for (int h = 0; h < region.height; ++h)
+            {
+                std::copy(region_outputs[r][c][h].begin(),
+                          region_outputs[r][c][h].end(),
+                          output_[c][region.top + h].begin() + region.left);
+            }
+        }
+        last_recomputed_positions_ += static_cast<long long>(region.height) * region.width;
+    }
+}
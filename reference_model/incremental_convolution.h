@@ -0,0 +1,74 @@
+#ifndef INCREMENTAL_CONVOLUTION_H
+#define INCREMENTAL_CONVOLUTION_H
+
+#include <vector>
+#include "convolution.h"
+
+// Rectangle in input coordinates: rows [top, top + height), columns [left, left + width)
+struct InputRegion
+{
+    int top;
+    int left;
+    int height;
+    int width;
+};
+
+// Re-convolution of a stream of frames that differ in small regions.
+// The previous input and output are kept; for each new frame only the outputs whose
+// receptive field touches a changed input pixel are recomputed (dirty area dilated by
+// kernel_size - 1 and mapped through the stride), so the per-frame cost is proportional
+// to the changed area instead of the frame size.
+class IncrementalConvolution
+{
+public:
+    // diff_tile_size: granularity (in input pixels) used when dirty regions are found by diffing
+    explicit IncrementalConvolution(const ConvolutionLayer &layer, int diff_tile_size = 8);
+
+    // Process a new frame, finding the changed regions by comparing it with the previous frame.
+    // The first frame, or a frame whose size differs from the previous one, runs a full forward.
+    const std::vector<std::vector<std::vector<float>>> &update(
+        const std::vector<std::vector<std::vector<float>>> &frame);
+
+    // Process a new frame whose changes are known to lie inside dirty_regions.
+    // Pixels outside these regions are assumed unchanged and are not read.
+    const std::vector<std::vector<std::vector<float>>> &update(
+        const std::vector<std::vector<std::vector<float>>> &frame,
+        const std::vector<InputRegion> &dirty_regions);
+
+    // Output of the most recent frame
+    const std::vector<std::vector<std::vector<float>>> &output() const { return output_; }
+
+    // Forget the previous frame; the next update runs a full forward
+    void reset();
+
+    // Number of distinct output positions (per channel) recomputed by the most recent update
+    long long last_recomputed_positions() const { return last_recomputed_positions_; }
+
+private:
+    ConvolutionLayer layer_;
+    int diff_tile_size_;
+    bool has_previous_;
+    ConvolutionGeometry geometry_;
+    std::vector<std::vector<std::vector<float>>> previous_input_;
+    std::vector<std::vector<std::vector<float>>> output_;
+    long long last_recomputed_positions_;
+
+    // True if a previous frame exists and has the same shape as frame
+    bool matches_previous_shape(const std::vector<std::vector<std::vector<float>>> &frame) const;
+
+    // Full forward pass, storing the frame and its output
+    void full_update(const std::vector<std::vector<std::vector<float>>> &frame);
+
+    // Changed regions of frame relative to previous_input_, at diff_tile_size_ granularity
+    std::vector<InputRegion> diff_regions(const std::vector<std::vector<std::vector<float>>> &frame) const;
+
+    // Output rectangle whose receptive fields overlap the input region (empty height/width if none)
+    OutputRegion map_to_output(const InputRegion &region) const;
+
+    // Copy dirty input regions into previous_input_ and recompute the affected outputs
+    void apply_dirty_regions(
+        const std::vector<std::vector<std::vector<float>>> &frame,
+        const std::vector<InputRegion> &dirty_regions);
+};
+
+#endif // INCREMENTAL_CONVOLUTION_H
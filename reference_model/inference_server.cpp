@@ -0,0 +1,455 @@
+#include "inference_server.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "tensor_io.h"
+
+namespace
+{
+const char ERROR_MAGIC[4] = {'C', 'N', 'N', 'E'};
+const int ACCEPT_POLL_MS = 100; // how quickly the accept loop notices stop()
+
+bool read_fully(int fd, unsigned char *buffer, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t received = recv(fd, buffer, size, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        buffer += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool write_fully(int fd, const unsigned char *buffer, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(fd, buffer, size, MSG_NOSIGNAL); // a vanished peer must not raise SIGPIPE
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        buffer += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool write_error(int fd, const std::string &message)
+{
+    std::vector<unsigned char> frame(8 + message.size());
+    std::memcpy(frame.data(), ERROR_MAGIC, sizeof(ERROR_MAGIC));
+    for (int b = 0; b < 4; ++b)
+        frame[4 + b] = static_cast<unsigned char>(message.size() >> (8 * b));
+    std::memcpy(frame.data() + 8, message.data(), message.size());
+    return write_fully(fd, frame.data(), frame.size());
+}
+
+sockaddr_un socket_address(const std::string &path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Invalid socket path: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return address;
+}
+} // namespace
+
+InferenceServer::InferenceServer(const ConvolutionLayer &layer, const ServerConfig &config) : layer_(layer),
+                                                                                              config_(config),
+                                                                                              scheduler_(config.worker_threads),
+                                                                                              listen_fd_(-1),
+                                                                                              running_(false),
+                                                                                              stop_batching_(false),
+                                                                                              requests_(0),
+                                                                                              failures_(0),
+                                                                                              batches_(0),
+                                                                                              batched_requests_(0),
+                                                                                              total_queue_seconds_(0.0),
+                                                                                              max_queue_seconds_(0.0)
+{
+    if (config_.max_batch_size == 0)
+    {
+        config_.max_batch_size = 1;
+    }
+    if (config_.max_connections == 0)
+    {
+        config_.max_connections = 1;
+    }
+}
+
+InferenceServer::~InferenceServer()
+{
+    stop();
+}
+
+void InferenceServer::start()
+{
+    if (running_)
+    {
+        return;
+    }
+
+    sockaddr_un address = socket_address(config_.socket_path);
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+    {
+        throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    unlink(config_.socket_path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd_, 64) != 0)
+    {
+        std::string reason = std::strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        throw std::runtime_error("Cannot listen on " + config_.socket_path + ": " + reason);
+    }
+
+    started_ = std::chrono::steady_clock::now();
+    stop_batching_ = false;
+    running_ = true;
+    batch_thread_ = std::thread(&InferenceServer::batch_loop, this);
+    accept_thread_ = std::thread(&InferenceServer::accept_loop, this);
+}
+
+void InferenceServer::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    accept_thread_.join();
+    close(listen_fd_);
+    listen_fd_ = -1;
+    unlink(config_.socket_path.c_str());
+
+    // Unblock connection threads waiting on their peers; a thread waiting for a result
+    // still receives it because the batcher keeps running until all of them are joined
+    std::list<Connection> connections;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (Connection &connection : connections_)
+        {
+            if (connection.fd >= 0)
+            {
+                shutdown(connection.fd, SHUT_RDWR);
+            }
+        }
+        connections.swap(connections_);
+    }
+    for (Connection &connection : connections)
+    {
+        connection.thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_batching_ = true;
+    }
+    queue_changed_.notify_all();
+    batch_thread_.join();
+}
+
+ServerMetrics InferenceServer::metrics() const
+{
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    ServerMetrics metrics;
+    metrics.requests = requests_;
+    metrics.failures = failures_;
+    metrics.batches = batches_;
+    metrics.mean_batch_size = batches_ ? static_cast<double>(batched_requests_) / batches_ : 0.0;
+    metrics.mean_queue_seconds = batched_requests_ ? total_queue_seconds_ / batched_requests_ : 0.0;
+    metrics.max_queue_seconds = max_queue_seconds_;
+    metrics.uptime_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    metrics.requests_per_second = metrics.uptime_seconds > 0.0 ? requests_ / metrics.uptime_seconds : 0.0;
+    return metrics;
+}
+
+void InferenceServer::accept_loop()
+{
+    while (running_)
+    {
+        // Join the threads of connections that have closed
+        std::list<Connection> finished;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            for (std::list<Connection>::iterator it = connections_.begin(); it != connections_.end();)
+            {
+                std::list<Connection>::iterator next = std::next(it);
+                if (it->fd < 0)
+                {
+                    finished.splice(finished.end(), connections_, it);
+                }
+                it = next;
+            }
+        }
+        for (Connection &connection : finished)
+        {
+            connection.thread.join();
+        }
+
+        pollfd listener = {listen_fd_, POLLIN, 0};
+        if (poll(&listener, 1, ACCEPT_POLL_MS) <= 0)
+        {
+            continue;
+        }
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0)
+        {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        size_t open_connections = 0;
+        for (const Connection &connection : connections_)
+        {
+            open_connections += connection.fd >= 0 ? 1 : 0;
+        }
+        if (open_connections >= config_.max_connections)
+        {
+            write_error(fd, "Server has max_connections open connections");
+            close(fd);
+            continue;
+        }
+        connections_.emplace_back();
+        Connection *connection = &connections_.back();
+        connection->fd = fd;
+        connection->thread = std::thread(&InferenceServer::serve_connection, this, connection);
+    }
+}
+
+void InferenceServer::serve_connection(Connection *connection)
+{
+    const int fd = connection->fd;
+    unsigned char header[TENSOR_HEADER_BYTES];
+    std::vector<unsigned char> payload;
+
+    // Any exception here (e.g. bad_alloc) ends this connection only; escaping the
+    // thread function would terminate the whole server
+    try
+    {
+        while (read_fully(fd, header, sizeof(header)))
+        {
+            TensorShape shape;
+            std::size_t request_bytes;
+            try
+            {
+                shape = decode_tensor_header(header);
+                // Every row is decoded into its own vector, so a tall, narrow tensor costs far
+                // more memory than its payload; both count against the limit
+                request_bytes = tensor_payload_bytes(shape) +
+                                static_cast<std::size_t>(shape.channels) * shape.height * sizeof(std::vector<float>);
+            }
+            catch (const std::exception &error)
+            {
+                // The stream cannot be resynchronised after a bad frame
+                write_error(fd, error.what());
+                record_request(true);
+                break;
+            }
+            if (request_bytes > config_.max_request_bytes)
+            {
+                write_error(fd, "Request exceeds max_request_bytes");
+                record_request(true);
+                break;
+            }
+            payload.resize(tensor_payload_bytes(shape));
+            if (!read_fully(fd, payload.data(), payload.size()))
+            {
+                break;
+            }
+
+            PendingRequest request;
+            request.input = decode_tensor_payload(shape, payload.data());
+            request.arrival = std::chrono::steady_clock::now();
+            std::future<std::vector<std::vector<std::vector<float>>>> output = request.output.get_future();
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                queue_.push_back(&request);
+            }
+            queue_changed_.notify_one();
+
+            bool sent;
+            try
+            {
+                std::vector<unsigned char> response = encode_tensor(output.get());
+                sent = write_fully(fd, response.data(), response.size());
+                record_request(false);
+            }
+            catch (const std::exception &error)
+            {
+                sent = write_error(fd, error.what());
+                record_request(true);
+            }
+            if (!sent)
+            {
+                break;
+            }
+        }
+    }
+    catch (const std::exception &error)
+    {
+        write_error(fd, error.what());
+        record_request(true);
+    }
+
+    // Closed under the lock so stop() never shuts down a descriptor number already reused
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    close(fd);
+    connection->fd = -1;
+}
+
+void InferenceServer::batch_loop()
+{
+    std::vector<PendingRequest *> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_changed_.wait(lock, [this]() { return stop_batching_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                return; // stopping and drained
+            }
+
+            // Hold the batch open until it is full or the oldest request's budget runs out
+            std::chrono::steady_clock::time_point deadline = queue_.front()->arrival + config_.max_batch_delay;
+            queue_changed_.wait_until(lock, deadline, [this]() {
+                return stop_batching_ || queue_.size() >= config_.max_batch_size;
+            });
+
+            size_t count = std::min(queue_.size(), config_.max_batch_size);
+            batch.assign(queue_.begin(), queue_.begin() + count);
+            queue_.erase(queue_.begin(), queue_.begin() + count);
+        }
+        run_batch(batch);
+    }
+}
+
+void InferenceServer::run_batch(std::vector<PendingRequest *> &batch)
+{
+    std::chrono::steady_clock::time_point batch_start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        ++batches_;
+        batched_requests_ += batch.size();
+        for (PendingRequest *request : batch)
+        {
+            double queued = std::chrono::duration<double>(batch_start - request->arrival).count();
+            total_queue_seconds_ += queued;
+            max_queue_seconds_ = std::max(max_queue_seconds_, queued);
+        }
+    }
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> inputs(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        inputs[i].swap(batch[i]->input);
+    }
+
+    std::vector<std::vector<std::vector<std::vector<float>>>> outputs;
+    try
+    {
+        outputs = layer_.forward_batch(inputs, scheduler_);
+    }
+    catch (const std::exception &)
+    {
+        // One bad input fails the whole batch; rerun individually so only it gets the error
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            try
+            {
+                batch[i]->output.set_value(layer_.forward(inputs[i]));
+            }
+            catch (...)
+            {
+                batch[i]->output.set_exception(std::current_exception());
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        batch[i]->output.set_value(std::move(outputs[i]));
+    }
+}
+
+void InferenceServer::record_request(bool failed)
+{
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    ++requests_;
+    if (failed)
+    {
+        ++failures_;
+    }
+}
+
+InferenceClient::InferenceClient(const std::string &socket_path) : fd_(-1)
+{
+    sockaddr_un address = socket_address(socket_path);
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        std::string reason = std::strerror(errno);
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+        throw std::runtime_error("Cannot connect to " + socket_path + ": " + reason);
+    }
+}
+
+InferenceClient::~InferenceClient()
+{
+    close(fd_);
+}
+
+std::vector<std::vector<std::vector<float>>> InferenceClient::forward(const std::vector<std::vector<std::vector<float>>> &input)
+{
+    std::vector<unsigned char> request = encode_tensor(input);
+    unsigned char header[TENSOR_HEADER_BYTES];
+    if (!write_fully(fd_, request.data(), request.size()) || !read_fully(fd_, header, 8))
+    {
+        throw std::runtime_error("Inference server connection lost");
+    }
+
+    if (std::memcmp(header, ERROR_MAGIC, sizeof(ERROR_MAGIC)) == 0)
+    {
+        std::uint32_t length = 0;
+        for (int b = 0; b < 4; ++b)
+            length |= static_cast<std::uint32_t>(header[4 + b]) << (8 * b);
+        std::string message(length, '\0');
+        if (length > 0 && !read_fully(fd_, reinterpret_cast<unsigned char *>(&message[0]), length))
+        {
+            throw std::runtime_error("Inference server connection lost");
+        }
+        throw std::runtime_error("Inference server error: " + message);
+    }
+
+    if (!read_fully(fd_, header + 8, sizeof(header) - 8))
+    {
+        throw std::runtime_error("Inference server connection lost");
+    }
+    TensorShape shape = decode_tensor_header(header);
+    std::vector<unsigned char> payload(tensor_payload_bytes(shape));
+    if (!read_fully(fd_, payload.data(), payload.size()))
+    {
+        throw std::runtime_error("Inference server connection lost");
+    }
+    return decode_tensor_payload(shape, payload.data());
+}
@@ -0,0 +1,137 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "convolution.h"
+#include "work_stealing.h"
+
+struct ServerConfig
+{
+    std::string socket_path;
+    std::size_t max_batch_size = 16;
+    std::chrono::microseconds max_batch_delay = std::chrono::microseconds(2000); // latency budget for batching
+    int worker_threads = 0;                                                      // <= 0: hardware concurrency
+    std::size_t max_request_bytes = 64u << 20;                                   // larger tensors (payload plus per-row vectors) are rejected
+    std::size_t max_connections = 64;                                            // further clients get an error frame and are disconnected
+};
+
+struct ServerMetrics
+{
+    std::uint64_t requests;   // completed, including failed ones
+    std::uint64_t failures;   // requests answered with an error frame
+    std::uint64_t batches;    // calls into forward_batch
+    double mean_batch_size;
+    double mean_queue_seconds; // arrival to start of its batch
+    double max_queue_seconds;
+    double uptime_seconds;
+    double requests_per_second;
+};
+
+// Local inference server for one layer. Clients connect to a Unix domain socket and send
+// CHW tensors in the binary tensor format (tensor_io.h); each request is answered with the
+// output tensor, or with an error frame ("CNNE", little-endian uint32 length, message)
+// if the input does not fit the layer. A connection may carry any number of requests in
+// sequence. Each open connection has its own thread; at most max_connections are served at
+// once, and a client connecting beyond that receives an error frame and is disconnected.
+//
+// Requests from all connections go into one queue. The batcher takes a batch once
+// max_batch_size requests are waiting or the oldest has waited max_batch_delay, then runs
+// it through forward_batch on the server's work-stealing scheduler. POSIX only.
+class InferenceServer
+{
+public:
+    InferenceServer(const ConvolutionLayer &layer, const ServerConfig &config);
+    ~InferenceServer(); // stops the server
+
+    InferenceServer(const InferenceServer &) = delete;
+    InferenceServer &operator=(const InferenceServer &) = delete;
+
+    // Bind the socket (replacing a stale socket file) and start serving.
+    // Throws std::runtime_error if the socket cannot be created.
+    void start();
+
+    // Close the socket, drop open connections and join all threads. Requests already
+    // batched finish first.
+    void stop();
+
+    ServerMetrics metrics() const;
+
+private:
+    struct PendingRequest
+    {
+        std::vector<std::vector<std::vector<float>>> input;
+        std::promise<std::vector<std::vector<std::vector<float>>>> output;
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    const ConvolutionLayer &layer_;
+    ServerConfig config_;
+    WorkStealingScheduler scheduler_;
+
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::thread accept_thread_;
+    std::thread batch_thread_;
+
+    // One per accepted connection until its thread has been joined
+    struct Connection
+    {
+        int fd; // -1 once the connection thread has closed it
+        std::thread thread;
+    };
+
+    std::mutex connections_mutex_;
+    std::list<Connection> connections_; // list: serve_connection keeps a pointer to its entry
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_changed_;
+    std::deque<PendingRequest *> queue_;
+    bool stop_batching_;
+
+    mutable std::mutex metrics_mutex_;
+    std::uint64_t requests_;
+    std::uint64_t failures_;
+    std::uint64_t batches_;
+    std::uint64_t batched_requests_;
+    double total_queue_seconds_;
+    double max_queue_seconds_;
+    std::chrono::steady_clock::time_point started_;
+
+    void accept_loop();
+    void serve_connection(Connection *connection);
+    void batch_loop();
+    void run_batch(std::vector<PendingRequest *> &batch);
+    void record_request(bool failed);
+};
+
+// Blocking client for InferenceServer; one connection, one request at a time
+class InferenceClient
+{
+public:
+    // Throws std::runtime_error if the server cannot be reached
+    explicit InferenceClient(const std::string &socket_path);
+    ~InferenceClient();
+
+    InferenceClient(const InferenceClient &) = delete;
+    InferenceClient &operator=(const InferenceClient &) = delete;
+
+    // Send one image and wait for its output. Throws std::runtime_error with the server's
+    // message on an error frame, or if the connection fails.
+    std::vector<std::vector<std::vector<float>>> forward(const std::vector<std::vector<std::vector<float>>> &input);
+
+private:
+    int fd_;
+};
+
+#endif // INFERENCE_SERVER_H
@@ -1,158 +1,755 @@
-#include <iostream>
-#include <vector>
-#include <iomanip> // For fixed and setprecision
-#include "convolution.h"
-
-using namespace std;
-
-// Helper function to print a 3D vector (image)
-void print_image(const vector<vector<vector<float>>> &image, const string &label)
-{
-    if (image.empty())
-    {
-        cout << label << " is empty." << endl;
-        return;
-    }
-    cout << label << " (Channels: " << image.size()
-         << ", Height: " << (image.empty() ? 0 : image[0].size())
-         << ", Width: " << (image.empty() || image[0].empty() ? 0 : image[0][0].size())
-         << ")" << endl;
-
-    for (size_t c = 0; c < image.size(); ++c)
-    {
-        cout << "Channel " << c << ":" << endl;
-        if (image[c].empty())
-        {
-            cout << "  Empty channel." << endl;
-            continue;
-        }
-        for (size_t h = 0; h < image[c].size(); ++h)
-        {
-            cout << "  ";
-            if (image[c][h].empty())
-            {
-                cout << "Empty row." << endl;
-                continue;
-            }
-            for (size_t w = 0; w < image[c][h].size(); ++w)
-            {
-                cout << fixed << setprecision(2) << image[c][h][w] << "\t";
-            }
-            cout << endl;
-        }
-        cout << endl;
-    }
-}
-
-int main()
-{
-    // Define parameters based on readme.md defaults
-    const int KERNEL_SIZE = 3;
-    const int STRIDE = 1;                                // readme supports 1 and 2
-    const PaddingMode PADDING_MODE = PaddingMode::VALID; // readme: 0 Valid; 1 Same
-    const int INPUT_CHANNELS = 3;                        // readme: (默认为 3 RGB)
-    const int OUTPUT_CHANNELS = 1;                       // readme: (默认为 1)
-    const int INPUT_HEIGHT = 32;
-    const int INPUT_WIDTH = 32;
-
-    cout << "Initializing Convolution Layer..." << endl;
-    cout << "Kernel Size: " << KERNEL_SIZE << endl;
-    cout << "Stride: " << STRIDE << endl;
-    cout << "Padding Mode: " << (PADDING_MODE == PaddingMode::VALID ? "VALID" : "SAME") << endl;
-    cout << "Input Channels: " << INPUT_CHANNELS << endl;
-    cout << "Output Channels: " << OUTPUT_CHANNELS << endl;
-    cout << "Input Dimensions: " << INPUT_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << endl;
-
-    // --- 1. Initialize Kernel Weights ---
-    // kernel_weights_: [out_c][in_c][k_h][k_w]
-    // For simplicity, let's create a simple averaging kernel for each input channel to the single output channel.
-    vector<vector<vector<vector<float>>>> kernel_weights(
-        OUTPUT_CHANNELS,
-        vector<vector<vector<float>>>(
-            INPUT_CHANNELS,
-            vector<vector<float>>(
-                KERNEL_SIZE,
-                vector<float>(KERNEL_SIZE, 1.0f / (KERNEL_SIZE * KERNEL_SIZE)) // Averaging filter
-                )));
-
-    // Example: Make one kernel slightly different to show effect if multiple input channels contribute
-    // If input_channels > 1, let's make the second channel's kernel identity-like in center
-    if (INPUT_CHANNELS > 1 && KERNEL_SIZE == 3)
-    {
-        kernel_weights[0][1] = {
-            {0.0f, 0.0f, 0.0f},
-            {0.0f, 1.0f, 0.0f},
-            {0.0f, 0.0f, 0.0f}};
-    }
-
-    // --- 2. Create Input Image Data ---
-    // input_image: [in_c][height][width]
-    // Simple ramp pattern for each channel for easy visual inspection
-    vector<vector<vector<float>>> input_image(
-        INPUT_CHANNELS,
-        vector<vector<float>>(
-            INPUT_HEIGHT,
-            vector<float>(INPUT_WIDTH)));
-
-    for (int c = 0; c < INPUT_CHANNELS; ++c)
-    {
-        for (int h = 0; h < INPUT_HEIGHT; ++h)
-        {
-            for (int w = 0; w < INPUT_WIDTH; ++w)
-            {
-                input_image[c][h][w] = static_cast<float>(c * 100 + h * 10 + w); // Example data
-            }
-        }
-    }
-    // print_image(input_image, "Input Image"); // Optional: print if small enough
-
-    try
-    {
-        // --- 3. Create Convolution Layer ---
-        ConvolutionLayer conv_layer(
-            KERNEL_SIZE,
-            STRIDE,
-            PADDING_MODE,
-            INPUT_CHANNELS,
-            OUTPUT_CHANNELS,
-            kernel_weights);
-
-        // --- 4. Perform Convolution ---
-        cout << "\nPerforming convolution..." << endl;
-        vector<vector<vector<float>>> output_image = conv_layer.forward(input_image);
-        cout << "Convolution complete." << endl;
-
-        // --- 5. Print Output Image ---
-        print_image(output_image, "Output Image");
-
-        // --- Test with SAME padding and stride 2 ---
-        const int STRIDE_2 = 2;
-        const PaddingMode PADDING_MODE_SAME = PaddingMode::SAME;
-        cout << "\n\nInitializing Convolution Layer (Stride 2, SAME padding)..." << endl;
-        cout << "Kernel Size: " << KERNEL_SIZE << endl;
-        cout << "Stride: " << STRIDE_2 << endl;
-        cout << "Padding Mode: " << (PADDING_MODE_SAME == PaddingMode::VALID ? "VALID" : "SAME") << endl;
-        cout << "Input Channels: " << INPUT_CHANNELS << endl;
-        cout << "Output Channels: " << OUTPUT_CHANNELS << endl;
-        cout << "Input Dimensions: " << INPUT_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << endl;
-
-        ConvolutionLayer conv_layer_same_s2(
-            KERNEL_SIZE,
-            STRIDE_2,
-            PADDING_MODE_SAME,
-            INPUT_CHANNELS,
-            OUTPUT_CHANNELS,
-            kernel_weights);
-        cout << "\nPerforming convolution (Stride 2, SAME padding)..." << endl;
-        vector<vector<vector<float>>> output_image_same_s2 = conv_layer_same_s2.forward(input_image);
-        cout << "Convolution complete." << endl;
-        print_image(output_image_same_s2, "Output Image (Stride 2, SAME padding)");
-    }
-    catch (const runtime_error &e) // std::runtime_error also becomes runtime_error
-    {
-        cerr << "Error: " << e.what() << endl; // std::cerr also becomes cerr
-        return 1;
-    }
-
-    return 0;
+#include <cstdint> // For uint8_t, int64_t
+#include <iostream>
+#include <vector>
+#include <iomanip> // For fixed and setprecision
+#include <cmath>   // For fabs
+#include <algorithm> // For max
+#include <cstdio>    // For remove
+#include <sstream>   // For istringstream
+#include "convolution.h"
+#include "convolution_nd.h"
+#include "incremental_convolution.h"
+#include "batch_norm_folding.h"
+#include "network.h"
+#include "tensor_io.h"
+#include "rtl_cycle_model.h"
+#include "transposed_convolution.h"
+#include "window_model.h"
+
+using namespace std;
+
+// Helper function to print a 3D vector (image)
+void print_image(const vector<vector<vector<float>>> &image, const string &label)
+{
+    if (image.empty())
+    {
+        cout << label << " is empty." << endl;
+        return;
+    }
+    cout << label << " (Channels: " << image.size()
+         << ", Height: " << (image.empty() ? 0 : image[0].size())
+         << ", Width: " << (image.empty() || image[0].empty() ? 0 : image[0][0].size())
+         << ")" << endl;
+
+    for (size_t c = 0; c < image.size(); ++c)
+    {
+        cout << "Channel " << c << ":" << endl;
+        if (image[c].empty())
+        {
+            cout << "  Empty channel." << endl;
+            continue;
+        }
+        for (size_t h = 0; h < image[c].size(); ++h)
+        {
+            cout << "  ";
+            if (image[c][h].empty())
+            {
+                cout << "Empty row." << endl;
+                continue;
+            }
+            for (size_t w = 0; w < image[c][h].size(); ++w)
+            {
+                cout << fixed << setprecision(2) << image[c][h][w] << "\t";
+            }
+            cout << endl;
+        }
+        cout << endl;
+    }
+}
+
+// Run a model description on a tensor file: main <model.txt> <input.cnnt> <output.cnnt>
+int run_network(const string &model_path, const string &input_path, const string &output_path)
+{
+    try
+    {
+        Network network = Network::load(model_path);
+        cout << "Loaded " << model_path << ": " << network.layers().size() << " layers, input "
+             << network.input_shape().channels << "x" << network.input_shape().height << "x" << network.input_shape().width
+             << ", output " << network.output_shape().channels << "x" << network.output_shape().height << "x"
+             << network.output_shape().width << ", peak activations " << network.peak_activation_bytes() << " bytes" << endl;
+        save_tensor(network.forward(load_tensor(input_path)), output_path);
+        cout << "Wrote " << output_path << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 4)
+    {
+        return run_network(argv[1], argv[2], argv[3]);
+    }
+    if (argc != 1)
+    {
+        cerr << "Usage: " << argv[0] << " [model.txt input.cnnt output.cnnt]" << endl;
+        return 1;
+    }
+
+    // Define parameters based on readme.md defaults
+    const int KERNEL_SIZE = 3;
+    const int STRIDE = 1;                                // readme supports 1 and 2
+    const PaddingMode PADDING_MODE = PaddingMode::VALID; // readme: 0 Valid; 1 Same
+    const int INPUT_CHANNELS = 3;                        // readme: (默认为 3 RGB)
+    const int OUTPUT_CHANNELS = 1;                       // readme: (默认为 1)
+    const int INPUT_HEIGHT = 32;
+    const int INPUT_WIDTH = 32;
+
+    cout << "Initializing Convolution Layer..." << endl;
+    cout << "Kernel Size: " << KERNEL_SIZE << endl;
+    cout << "Stride: " << STRIDE << endl;
+    cout << "Padding Mode: " << (PADDING_MODE == PaddingMode::VALID ? "VALID" : "SAME") << endl;
+    cout << "Input Channels: " << INPUT_CHANNELS << endl;
+    cout << "Output Channels: " << OUTPUT_CHANNELS << endl;
+    cout << "Input Dimensions: " << INPUT_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << endl;
+
+    // --- 1. Initialize Kernel Weights ---
+    // kernel_weights_: [out_c][in_c][k_h][k_w]
+    // For simplicity, let's create a simple averaging kernel for each input channel to the single output channel.
+    vector<vector<vector<vector<float>>>> kernel_weights(
+        OUTPUT_CHANNELS,
+        vector<vector<vector<float>>>(
+            INPUT_CHANNELS,
+            vector<vector<float>>(
+                KERNEL_SIZE,
+                vector<float>(KERNEL_SIZE, 1.0f / (KERNEL_SIZE * KERNEL_SIZE)) // Averaging filter
+                )));
+
+    // Example: Make one kernel slightly different to show effect if multiple input channels contribute
+    // If input_channels > 1, let's make the second channel's kernel identity-like in center
+    if (INPUT_CHANNELS > 1 && KERNEL_SIZE == 3)
+    {
+        kernel_weights[0][1] = {
+            {0.0f, 0.0f, 0.0f},
+            {0.0f, 1.0f, 0.0f},
+            {0.0f, 0.0f, 0.0f}};
+    }
+
+    // --- 2. Create Input Image Data ---
+    // input_image: [in_c][height][width]
+    // Simple ramp pattern for each channel for easy visual inspection
+    vector<vector<vector<float>>> input_image(
+        INPUT_CHANNELS,
+        vector<vector<float>>(
+            INPUT_HEIGHT,
+            vector<float>(INPUT_WIDTH)));
+
+    for (int c = 0; c < INPUT_CHANNELS; ++c)
+    {
+        for (int h = 0; h < INPUT_HEIGHT; ++h)
+        {
+            for (int w = 0; w < INPUT_WIDTH; ++w)
+            {
+                input_image[c][h][w] = static_cast<float>(c * 100 + h * 10 + w); // Example data
+            }
+        }
+    }
+    // print_image(input_image, "Input Image"); // Optional: print if small enough
+
+    try
+    {
+        // --- 3. Create Convolution Layer ---
+        ConvolutionLayer conv_layer(
+            KERNEL_SIZE,
+            STRIDE,
+            PADDING_MODE,
+            INPUT_CHANNELS,
+            OUTPUT_CHANNELS,
+            kernel_weights);
+
+        // --- 4. Perform Convolution ---
+        cout << "\nPerforming convolution..." << endl;
+        vector<vector<vector<float>>> output_image = conv_layer.forward(input_image);
+        cout << "Convolution complete." << endl;
+
+        // --- 5. Print Output Image ---
+        print_image(output_image, "Output Image");
+
+        // --- Test with SAME padding and stride 2 ---
+        const int STRIDE_2 = 2;
+        const PaddingMode PADDING_MODE_SAME = PaddingMode::SAME;
+        cout << "\n\nInitializing Convolution Layer (Stride 2, SAME padding)..." << endl;
+        cout << "Kernel Size: " << KERNEL_SIZE << endl;
+        cout << "Stride: " << STRIDE_2 << endl;
+        cout << "Padding Mode: " << (PADDING_MODE_SAME == PaddingMode::VALID ? "VALID" : "SAME") << endl;
+        cout << "Input Channels: " << INPUT_CHANNELS << endl;
+        cout << "Output Channels: " << OUTPUT_CHANNELS << endl;
+        cout << "Input Dimensions: " << INPUT_CHANNELS << "x" << INPUT_HEIGHT << "x" << INPUT_WIDTH << endl;
+
+        ConvolutionLayer conv_layer_same_s2(
+            KERNEL_SIZE,
+            STRIDE_2,
+            PADDING_MODE_SAME,
+            INPUT_CHANNELS,
+            OUTPUT_CHANNELS,
+            kernel_weights);
+        cout << "\nPerforming convolution (Stride 2, SAME padding)..." << endl;
+        vector<vector<vector<float>>> output_image_same_s2 = conv_layer_same_s2.forward(input_image);
+        cout << "Convolution complete." << endl;
+        print_image(output_image_same_s2, "Output Image (Stride 2, SAME padding)");
+
+        // --- Region-of-interest forward: only the requested output windows are computed ---
+        vector<OutputRegion> regions = {{2, 3, 4, 5}, {10, 0, 3, 16}};
+        cout << "\nPerforming ROI convolution (Stride 2, SAME padding)..." << endl;
+        vector<vector<vector<vector<float>>>> roi_outputs = conv_layer_same_s2.forward_roi(input_image, regions);
+        bool roi_match = true;
+        for (size_t r = 0; r < regions.size(); ++r)
+        {
+            for (int c = 0; c < OUTPUT_CHANNELS; ++c)
+                for (int h = 0; h < regions[r].height; ++h)
+                    for (int w = 0; w < regions[r].width; ++w)
+                        if (roi_outputs[r][c][h][w] != output_image_same_s2[c][regions[r].top + h][regions[r].left + w])
+                            roi_match = false;
+        }
+        cout << "ROI outputs " << (roi_match ? "match" : "DO NOT match") << " the full forward pass." << endl;
+        print_image(roi_outputs[0], "ROI Output (rows 2-5, cols 3-7)");
+
+        // --- Incremental re-convolution: only outputs touched by changed pixels are recomputed ---
+        cout << "\nPerforming incremental convolution on a partially changed frame..." << endl;
+        IncrementalConvolution incremental(conv_layer);
+        incremental.update(input_image);
+        vector<vector<vector<float>>> next_frame = input_image;
+        next_frame[0][16][16] += 50.0f;
+        const vector<vector<vector<float>>> &incremental_output = incremental.update(next_frame);
+        cout << "Recomputed " << incremental.last_recomputed_positions() << " of "
+             << output_image[0].size() * output_image[0][0].size() << " output positions; result "
+             << (incremental_output == conv_layer.forward(next_frame) ? "matches" : "DOES NOT match")
+             << " the full forward pass." << endl;
+        // A stroke across the boundary of two 8x8 diff tiles: their dilated output regions share
+        // two rows, which are recomputed and counted once (output rows 0-15 x columns 14-23)
+        next_frame[0][7][20] += 50.0f;
+        next_frame[0][8][20] += 50.0f;
+        const vector<vector<vector<float>>> &straddle_output = incremental.update(next_frame);
+        cout << "Change across two diff tiles: recomputed " << incremental.last_recomputed_positions()
+             << " positions (expected 160); result " << (straddle_output == conv_layer.forward(next_frame) ? "matches" : "DOES NOT match")
+             << " the full forward pass." << endl;
+
+        // --- Lazy forward: output channels are computed only when first read ---
+        cout << "\nPerforming lazy convolution..." << endl;
+        LazyConvolutionOutput lazy_output = conv_layer.forward_lazy(input_image);
+        cout << "Channel 0 computed before access: " << (lazy_output.is_computed(0) ? "yes" : "no") << endl;
+        cout << "Lazy output[0][0][0] = " << fixed << setprecision(2) << lazy_output.at(0, 0, 0) << endl;
+        cout << "Materialized lazy output " << (lazy_output.materialize() == output_image ? "matches" : "DOES NOT match")
+             << " the eager forward pass." << endl;
+
+        // --- DLPack-style strided tensors: channel-interleaved input with padded rows, read in place ---
+        cout << "\nPerforming convolution on a strided (HWC, padded rows) tensor..." << endl;
+        const int ROW_PITCH = INPUT_WIDTH * INPUT_CHANNELS + 5; // elements per stored row
+        vector<float> interleaved(INPUT_HEIGHT * ROW_PITCH, -1.0f);
+        vector<uint8_t> interleaved_u8(INPUT_HEIGHT * ROW_PITCH, 0);
+        for (int c = 0; c < INPUT_CHANNELS; ++c)
+            for (int h = 0; h < INPUT_HEIGHT; ++h)
+                for (int w = 0; w < INPUT_WIDTH; ++w)
+                {
+                    interleaved[h * ROW_PITCH + w * INPUT_CHANNELS + c] = input_image[c][h][w];
+                    interleaved_u8[h * ROW_PITCH + w * INPUT_CHANNELS + c] = static_cast<uint8_t>(static_cast<int>(input_image[c][h][w]) & 0xFF);
+                }
+        int64_t shape[3] = {INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH};
+        int64_t strides[3] = {1, ROW_PITCH, INPUT_CHANNELS};
+        conv_dl_tensor tensor = {interleaved.data(), {CONV_DL_CPU, 0}, 3, {CONV_DL_FLOAT, 32, 1}, shape, strides, 0};
+        cout << "Strided float32 output " << (conv_layer.forward(tensor) == output_image ? "matches" : "DOES NOT match")
+             << " the nested-vector forward pass." << endl;
+
+        vector<vector<vector<float>>> input_u8_values = input_image;
+        for (auto &channel : input_u8_values)
+            for (auto &row : channel)
+                for (float &value : row)
+                    value = static_cast<float>(static_cast<int>(value) & 0xFF);
+        conv_dl_tensor tensor_u8 = {interleaved_u8.data(), {CONV_DL_CPU, 0}, 3, {CONV_DL_UINT, 8, 1}, shape, strides, 0};
+        cout << "Strided uint8 output (converted) " << (conv_layer.forward(tensor_u8) == conv_layer.forward(input_u8_values) ? "matches" : "DOES NOT match")
+             << " the nested-vector forward pass." << endl;
+
+        // --- Batch norm folded into the weights and bias: one fused pass instead of two ---
+        BatchNormParameters batch_norm;
+        for (int c = 0; c < OUTPUT_CHANNELS; ++c)
+        {
+            batch_norm.gamma.push_back(0.5f + 0.25f * c);
+            batch_norm.beta.push_back(1.0f - c);
+            batch_norm.mean.push_back(10.0f * c);
+            batch_norm.variance.push_back(4.0f + c);
+        }
+        ChannelAffine affine = batch_norm_to_affine(batch_norm);
+        ConvolutionLayer folded_layer = fold_batch_norm(conv_layer, batch_norm);
+        vector<vector<vector<float>>> folded_output = folded_layer.forward(input_image);
+        float max_fold_error = 0.0f;
+        for (int c = 0; c < OUTPUT_CHANNELS; ++c)
+            for (size_t h = 0; h < output_image[c].size(); ++h)
+                for (size_t w = 0; w < output_image[c][h].size(); ++w)
+                {
+                    float expected = output_image[c][h][w] * affine.scale[c] + affine.shift[c];
+                    max_fold_error = max(max_fold_error, fabs(folded_output[c][h][w] - expected) / max(1.0f, fabs(expected)));
+                }
+        cout << "Folded batch norm max relative error vs conv + batch norm: " << scientific << max_fold_error << fixed << endl;
+
+        // Fixed-point variant in the form conv.v computes: uint8 weights, signed bias, saturating output
+        FixedPointLayer fixed_layer = {KERNEL_SIZE, STRIDE, PADDING_MODE, INPUT_CHANNELS, OUTPUT_CHANNELS, {}, {}, 20, 1.0f, 1.0f / 16,
+                                       BorderMode::ZERO, false, {0, 0, 0, 0}};
+        for (int i = 0; i < OUTPUT_CHANNELS * INPUT_CHANNELS * KERNEL_SIZE * KERNEL_SIZE; ++i)
+            fixed_layer.weights.push_back(static_cast<uint8_t>(16 + i % 48));
+        vector<vector<vector<uint8_t>>> fixed_input(INPUT_CHANNELS, vector<vector<uint8_t>>(INPUT_HEIGHT, vector<uint8_t>(INPUT_WIDTH)));
+        for (int c = 0; c < INPUT_CHANNELS; ++c)
+            for (int h = 0; h < INPUT_HEIGHT; ++h)
+                for (int w = 0; w < INPUT_WIDTH; ++w)
+                    fixed_input[c][h][w] = static_cast<uint8_t>(input_u8_values[c][h][w]);
+        ChannelAffine fixed_affine = {vector<float>(OUTPUT_CHANNELS, 1.5f), vector<float>(OUTPUT_CHANNELS, -400.0f)};
+        FixedPointLayer fixed_folded = fold_affine_fixed_point(fixed_layer, fixed_affine);
+        vector<vector<vector<uint32_t>>> fixed_plain = fixed_point_forward(fixed_layer, fixed_input);
+        vector<vector<vector<uint32_t>>> fixed_fused = fixed_point_forward(fixed_folded, fixed_input);
+        const float accumulator_scale = fixed_layer.input_scale * fixed_layer.weight_scale;
+        float max_fixed_error = 0.0f;
+        for (size_t c = 0; c < fixed_plain.size(); ++c)
+            for (size_t h = 0; h < fixed_plain[c].size(); ++h)
+                for (size_t w = 0; w < fixed_plain[c][h].size(); ++w)
+                {
+                    float expected = max(0.0f, fixed_plain[c][h][w] * accumulator_scale * 1.5f - 400.0f);
+                    max_fixed_error = max(max_fixed_error, fabs(fixed_fused[c][h][w] * accumulator_scale - expected) / max(1.0f, expected));
+                }
+        cout << "Fixed-point fused layer max relative error vs conv + scale/shift: " << scientific << max_fixed_error << fixed << endl;
+        // A scale of 8 pushes the largest weight (42 -> 336) past 8 bits: the fold coarsens weight_scale and
+        // the outputs come back in the folded layer's accumulator scale
+        ChannelAffine wide_affine = {vector<float>(OUTPUT_CHANNELS, 8.0f), vector<float>(OUTPUT_CHANNELS, -400.0f)};
+        FixedPointLayer wide_folded = fold_affine_fixed_point(fixed_layer, wide_affine);
+        vector<vector<vector<uint32_t>>> wide_fused = fixed_point_forward(wide_folded, fixed_input);
+        const float wide_accumulator_scale = wide_folded.input_scale * wide_folded.weight_scale;
+        float max_wide_error = 0.0f;
+        for (size_t c = 0; c < fixed_plain.size(); ++c)
+            for (size_t h = 0; h < fixed_plain[c].size(); ++h)
+                for (size_t w = 0; w < fixed_plain[c][h].size(); ++w)
+                {
+                    float expected = max(0.0f, fixed_plain[c][h][w] * accumulator_scale * 8.0f - 400.0f);
+                    max_wide_error = max(max_wide_error, fabs(wide_fused[c][h][w] * wide_accumulator_scale - expected) / max(1.0f, expected));
+                }
+        cout << "Fixed-point fold with scale 8: weight_scale " << setprecision(4) << fixed_layer.weight_scale << " -> "
+             << wide_folded.weight_scale << setprecision(2) << ", max weight " << static_cast<int>(*max_element(wide_folded.weights.begin(), wide_folded.weights.end()))
+             << ", max relative error " << scientific << max_wide_error << fixed << endl;
+
+        // --- Transposed convolution: 2x learned upsampling of the convolution output ---
+        vector<vector<vector<vector<float>>>> upsample_weights(
+            OUTPUT_CHANNELS, vector<vector<vector<float>>>(INPUT_CHANNELS, vector<vector<float>>(4, vector<float>(4))));
+        for (int in_c = 0; in_c < OUTPUT_CHANNELS; ++in_c)
+            for (int out_c = 0; out_c < INPUT_CHANNELS; ++out_c)
+                for (int k_h = 0; k_h < 4; ++k_h)
+                    for (int k_w = 0; k_w < 4; ++k_w)
+                        upsample_weights[in_c][out_c][k_h][k_w] = 0.01f * (out_c + 1) * (k_h + 1) - 0.005f * k_w;
+        TransposedConvolutionLayer upsample_layer(4, 2, PaddingMode::SAME, OUTPUT_CHANNELS, INPUT_CHANNELS, upsample_weights);
+        vector<vector<vector<float>>> upsampled = upsample_layer.forward(output_image);
+        cout << "Transposed convolution (4x4, stride 2, SAME): " << output_image[0].size() << "x" << output_image[0][0].size()
+             << " -> " << upsampled[0].size() << "x" << upsampled[0][0].size() << ", "
+             << (upsampled == upsample_layer.forward_zero_stuffing(output_image) ? "matches" : "DOES NOT match")
+             << " the zero-stuffing reference." << endl;
+
+        // --- Backward pass, checked against central finite differences of L = sum(dL/dy * y) ---
+        // Every input and weight entry of a small 2 -> 3 channel layer on a 9x11 input, for
+        // K = 1..4, stride 1..3, VALID and SAME under each border mode. The loss is linear in
+        // both, so a large step only reduces rounding and the error is float summation noise.
+        {
+            const int GRAD_IN_C = 2, GRAD_OUT_C = 3, GRAD_HEIGHT = 9, GRAD_WIDTH = 11;
+            const float STEP = 0.5f;
+            const double GRADIENT_TOLERANCE = 1e-4; // relative to max(1, |finite difference|)
+            vector<vector<vector<float>>> grad_input(GRAD_IN_C, vector<vector<float>>(GRAD_HEIGHT, vector<float>(GRAD_WIDTH)));
+            for (int c = 0; c < GRAD_IN_C; ++c)
+                for (int h = 0; h < GRAD_HEIGHT; ++h)
+                    for (int w = 0; w < GRAD_WIDTH; ++w)
+                        grad_input[c][h][w] = 0.1f * ((c * 7 + h * 5 + w * 3) % 11) - 0.5f;
+            const BorderMode grad_borders[] = {BorderMode::ZERO, BorderMode::REFLECT, BorderMode::REPLICATE, BorderMode::CIRCULAR};
+            double max_gradient_error = 0.0;
+            int configurations = 0;
+            for (int k = 1; k <= 4; ++k)
+                for (int s = 1; s <= 3; ++s)
+                    for (int config = 0; config < 5; ++config) // VALID, then SAME with each border mode
+                    {
+                        vector<vector<vector<vector<float>>>> weights(
+                            GRAD_OUT_C, vector<vector<vector<float>>>(GRAD_IN_C, vector<vector<float>>(k, vector<float>(k))));
+                        for (int o = 0; o < GRAD_OUT_C; ++o)
+                            for (int c = 0; c < GRAD_IN_C; ++c)
+                                for (int k_h = 0; k_h < k; ++k_h)
+                                    for (int k_w = 0; k_w < k; ++k_w)
+                                        weights[o][c][k_h][k_w] = 0.05f * ((o * 5 + c * 3 + k_h * 2 + k_w) % 9) - 0.2f;
+                        const PaddingMode mode = config == 0 ? PaddingMode::VALID : PaddingMode::SAME;
+                        const BorderMode border = config == 0 ? BorderMode::ZERO : grad_borders[config - 1];
+                        auto make_layer = [&](const vector<vector<vector<vector<float>>>> &layer_weights) {
+                            ConvolutionLayer layer(k, s, mode, GRAD_IN_C, GRAD_OUT_C, layer_weights);
+                            layer.set_border_mode(border);
+                            return layer;
+                        };
+                        ConvolutionLayer layer = make_layer(weights);
+                        ConvolutionGeometry geometry = layer.compute_geometry(GRAD_HEIGHT, GRAD_WIDTH);
+                        vector<vector<vector<float>>> output_gradient(
+                            GRAD_OUT_C, vector<vector<float>>(geometry.output_height, vector<float>(geometry.output_width)));
+                        for (int o = 0; o < GRAD_OUT_C; ++o)
+                            for (int h = 0; h < geometry.output_height; ++h)
+                                for (int w = 0; w < geometry.output_width; ++w)
+                                    output_gradient[o][h][w] = 0.01f * (h - w + o);
+                        auto loss = [&](const ConvolutionLayer &probe_layer, const vector<vector<vector<float>>> &input) {
+                            vector<vector<vector<float>>> output = probe_layer.forward(input);
+                            double sum = 0.0;
+                            for (size_t c = 0; c < output.size(); ++c)
+                                for (size_t h = 0; h < output[c].size(); ++h)
+                                    for (size_t w = 0; w < output[c][h].size(); ++w)
+                                        sum += static_cast<double>(output[c][h][w]) * output_gradient[c][h][w];
+                            return sum;
+                        };
+                        vector<vector<vector<float>>> input_gradient = layer.backward_data(output_gradient, GRAD_HEIGHT, GRAD_WIDTH);
+                        vector<vector<vector<vector<float>>>> weight_gradient = layer.backward_weights(grad_input, output_gradient);
+
+                        for (int c = 0; c < GRAD_IN_C; ++c)
+                            for (int h = 0; h < GRAD_HEIGHT; ++h)
+                                for (int w = 0; w < GRAD_WIDTH; ++w)
+                                {
+                                    vector<vector<vector<float>>> plus = grad_input, minus = grad_input;
+                                    plus[c][h][w] += STEP;
+                                    minus[c][h][w] -= STEP;
+                                    double numeric = (loss(layer, plus) - loss(layer, minus)) / (2 * STEP);
+                                    max_gradient_error = max(max_gradient_error, fabs(numeric - input_gradient[c][h][w]) / max(1.0, fabs(numeric)));
+                                }
+                        for (int o = 0; o < GRAD_OUT_C; ++o)
+                            for (int c = 0; c < GRAD_IN_C; ++c)
+                                for (int k_h = 0; k_h < k; ++k_h)
+                                    for (int k_w = 0; k_w < k; ++k_w)
+                                    {
+                                        vector<vector<vector<vector<float>>>> weights_plus = weights, weights_minus = weights;
+                                        weights_plus[o][c][k_h][k_w] += STEP;
+                                        weights_minus[o][c][k_h][k_w] -= STEP;
+                                        double numeric = (loss(make_layer(weights_plus), grad_input) - loss(make_layer(weights_minus), grad_input)) / (2 * STEP);
+                                        max_gradient_error = max(max_gradient_error, fabs(numeric - weight_gradient[o][c][k_h][k_w]) / max(1.0, fabs(numeric)));
+                                    }
+                        ++configurations;
+                    }
+            cout << "Backward pass vs finite differences over " << configurations
+                 << " configurations (K 1-4, stride 1-3, VALID/SAME x 4 border modes): max relative error " << scientific
+                 << max_gradient_error << fixed << ", " << (max_gradient_error <= GRADIENT_TOLERANCE ? "matches" : "DOES NOT match")
+                 << " within " << scientific << GRADIENT_TOLERANCE << fixed << "." << endl;
+        }
+
+        // --- 1D and 3D layers on the shared im2col/GEMM engine ---
+        ConvolutionLayer1D sensor_layer(5, 2, PaddingMode::SAME, 2, 3,
+                                        vector<vector<vector<float>>>(3, vector<vector<float>>(2, {0.1f, 0.2f, 0.4f, 0.2f, 0.1f})));
+        vector<vector<float>> sensor_stream(2, vector<float>(100));
+        for (int t = 0; t < 100; ++t)
+        {
+            sensor_stream[0][t] = static_cast<float>(t % 10);
+            sensor_stream[1][t] = static_cast<float>(t / 10);
+        }
+        vector<vector<float>> filtered = sensor_layer.forward(sensor_stream);
+        cout << "1D convolution (k=5, stride 2, SAME): length " << sensor_stream[0].size() << " -> " << filtered[0].size()
+             << ", output[0][10] = " << filtered[0][10] << endl;
+        ConvolutionLayer1D causal_layer = sensor_layer; // output t sees samples up to t only
+        causal_layer.set_explicit_padding({4, 0});
+        causal_layer.set_bias({-1.0f, 0.0f, 1.0f});
+        vector<vector<float>> causal = causal_layer.forward(sensor_stream);
+        cout << "1D causal convolution (pad 4,0, bias -1/0/1): length " << causal[0].size() << ", output[0][0] = " << causal[0][0]
+             << " (expected -1.00)" << endl;
+
+        ConvolutionLayer3D volume_layer(3, 1, PaddingMode::VALID, 1, 2,
+                                        vector<vector<vector<vector<vector<float>>>>>(
+                                            2, vector<vector<vector<vector<float>>>>(
+                                                   1, vector<vector<vector<float>>>(3, vector<vector<float>>(3, vector<float>(3, 1.0f / 27))))));
+        vector<vector<vector<vector<float>>>> volume(1, vector<vector<vector<float>>>(8, vector<vector<float>>(8, vector<float>(8))));
+        for (int d = 0; d < 8; ++d)
+            for (int h = 0; h < 8; ++h)
+                for (int w = 0; w < 8; ++w)
+                    volume[0][d][h][w] = static_cast<float>(d + h + w);
+        vector<vector<vector<vector<float>>>> smoothed = volume_layer.forward(volume);
+        cout << "3D convolution (3x3x3 mean, VALID): 8x8x8 -> " << smoothed[0].size() << "x" << smoothed[0][0].size() << "x"
+             << smoothed[0][0][0].size() << ", output[0][0][0][0] = " << smoothed[0][0][0][0] << " (expected 3.00)" << endl;
+
+        // --- Border modes with asymmetric padding, checked against a VALID pass over a padded copy ---
+        const PaddingAmounts border_padding = {2, 1, 0, 3}; // top, bottom, left, right
+        const BorderMode border_modes[] = {BorderMode::REFLECT, BorderMode::REPLICATE, BorderMode::CIRCULAR};
+        const char *border_names[] = {"reflect", "replicate", "circular"};
+        ConvolutionLayer valid_layer(KERNEL_SIZE, STRIDE, PaddingMode::VALID, INPUT_CHANNELS, OUTPUT_CHANNELS, kernel_weights);
+        for (int m = 0; m < 3; ++m)
+        {
+            ConvolutionLayer border_layer = conv_layer;
+            border_layer.set_border_mode(border_modes[m]);
+            border_layer.set_explicit_padding(border_padding);
+            const int padded_height = INPUT_HEIGHT + border_padding.top + border_padding.bottom;
+            const int padded_width = INPUT_WIDTH + border_padding.left + border_padding.right;
+            vector<vector<vector<float>>> padded_copy(INPUT_CHANNELS, vector<vector<float>>(padded_height, vector<float>(padded_width)));
+            for (int c = 0; c < INPUT_CHANNELS; ++c)
+                for (int h = 0; h < padded_height; ++h)
+                    for (int w = 0; w < padded_width; ++w)
+                        padded_copy[c][h][w] = input_image[c][border_index(h - border_padding.top, INPUT_HEIGHT, border_modes[m])]
+                                                          [border_index(w - border_padding.left, INPUT_WIDTH, border_modes[m])];
+            vector<vector<vector<float>>> border_output = border_layer.forward(input_image);
+
+            IncrementalConvolution border_incremental(border_layer);
+            border_incremental.update(input_image);
+            vector<vector<vector<float>>> edge_frame = input_image;
+            edge_frame[0][0][1] += 50.0f; // its mirrored/wrapped copies sit in the padding of distant outputs
+            bool incremental_match = border_incremental.update(edge_frame) == border_layer.forward(edge_frame);
+
+            cout << "Border " << border_names[m] << " (pad 2,1,0,3): " << border_output[0].size() << "x" << border_output[0][0].size()
+                 << ", " << (border_output == valid_layer.forward(padded_copy) ? "matches" : "DOES NOT match")
+                 << " the padded copy; incremental update " << (incremental_match ? "matches" : "DOES NOT match") << "." << endl;
+        }
+
+        // The N-d engine fills its padding the same way: rank 2, SAME, against the 2D layer
+        {
+            vector<float> packed_weights;
+            for (int o = 0; o < OUTPUT_CHANNELS; ++o)
+                for (int c = 0; c < INPUT_CHANNELS; ++c)
+                    for (int k_h = 0; k_h < KERNEL_SIZE; ++k_h)
+                        packed_weights.insert(packed_weights.end(), kernel_weights[o][c][k_h].begin(), kernel_weights[o][c][k_h].end());
+            vector<float> packed_input;
+            for (int c = 0; c < INPUT_CHANNELS; ++c)
+                for (int h = 0; h < INPUT_HEIGHT; ++h)
+                    packed_input.insert(packed_input.end(), input_image[c][h].begin(), input_image[c][h].end());
+            ConvolutionEngineND engine(2, KERNEL_SIZE, 2, PaddingMode::SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, packed_weights);
+            ConvolutionLayer same_layer(KERNEL_SIZE, 2, PaddingMode::SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, kernel_weights);
+            cout << "N-d engine (rank 2, stride 2, SAME) vs 2D layer:";
+            for (int m = 0; m < 3; ++m)
+            {
+                engine.set_border_mode(border_modes[m]);
+                same_layer.set_border_mode(border_modes[m]);
+                vector<float> engine_output = engine.forward(packed_input.data(), engine.compute_axes({INPUT_HEIGHT, INPUT_WIDTH}), nullptr);
+                vector<float> layer_output;
+                for (const vector<vector<float>> &channel : same_layer.forward(input_image))
+                    for (const vector<float> &row : channel)
+                        layer_output.insert(layer_output.end(), row.begin(), row.end());
+                cout << " " << border_names[m] << " " << (engine_output == layer_output ? "matches" : "DOES NOT match");
+            }
+            cout << "." << endl;
+
+            // ... and applies bias, reduction order and explicit padding like it too
+            vector<float> bias(OUTPUT_CHANNELS);
+            for (int o = 0; o < OUTPUT_CHANNELS; ++o)
+                bias[o] = 0.25f * (o + 1);
+            engine.set_bias(bias);
+            same_layer.set_bias(bias);
+            engine.set_explicit_padding({{border_padding.top, border_padding.bottom}, {border_padding.left, border_padding.right}});
+            same_layer.set_explicit_padding(border_padding);
+            cout << "N-d engine with bias and pad (2,1,0,3), replicate, vs 2D layer:";
+            const ReductionOrder orders[] = {ReductionOrder::SEQUENTIAL, ReductionOrder::BLOCKED_PAIRWISE};
+            const char *order_names[] = {"sequential", "pairwise"};
+            for (int r = 0; r < 2; ++r)
+            {
+                engine.set_border_mode(BorderMode::REPLICATE);
+                same_layer.set_border_mode(BorderMode::REPLICATE);
+                engine.set_reduction_order(orders[r]);
+                same_layer.set_reduction_order(orders[r]);
+                vector<float> engine_output = engine.forward(packed_input.data(), engine.compute_axes({INPUT_HEIGHT, INPUT_WIDTH}), nullptr);
+                vector<float> layer_output;
+                for (const vector<vector<float>> &channel : same_layer.forward(input_image))
+                    for (const vector<float> &row : channel)
+                        layer_output.insert(layer_output.end(), row.begin(), row.end());
+                cout << " " << order_names[r] << " " << (engine_output == layer_output ? "matches" : "DOES NOT match");
+            }
+            cout << "." << endl;
+        }
+
+        // The loader folds a scale line into a convolution with a border mode and explicit padding
+        {
+            vector<vector<vector<float>>> weight_tensor(OUTPUT_CHANNELS * INPUT_CHANNELS, vector<vector<float>>(KERNEL_SIZE));
+            for (int o = 0; o < OUTPUT_CHANNELS; ++o)
+                for (int c = 0; c < INPUT_CHANNELS; ++c)
+                    for (int h = 0; h < KERNEL_SIZE; ++h)
+                        weight_tensor[o * INPUT_CHANNELS + c][h] = kernel_weights[o][c][h];
+            const ChannelAffine border_affine = {vector<float>(OUTPUT_CHANNELS, 0.75f), vector<float>(OUTPUT_CHANNELS, 2.0f)};
+            save_tensor(weight_tensor, "border_fold_weights.cnnt");
+            save_tensor({{border_affine.scale}}, "border_fold_scale.cnnt");
+            save_tensor({{border_affine.shift}}, "border_fold_shift.cnnt");
+            istringstream description(
+                "input channels=" + to_string(INPUT_CHANNELS) + " height=" + to_string(INPUT_HEIGHT) + " width=" + to_string(INPUT_WIDTH) +
+                "\nconvolution filters=" + to_string(OUTPUT_CHANNELS) + " kernel=" + to_string(KERNEL_SIZE) +
+                " pad=2,1,0,3 border=reflect weights=border_fold_weights.cnnt"
+                "\nscale scale=border_fold_scale.cnnt shift=border_fold_shift.cnnt\n");
+            Network border_network = Network::parse(description, ".");
+            remove("border_fold_weights.cnnt");
+            remove("border_fold_scale.cnnt");
+            remove("border_fold_shift.cnnt");
+
+            ConvolutionLayer border_layer = conv_layer;
+            border_layer.set_border_mode(BorderMode::REFLECT);
+            border_layer.set_explicit_padding(border_padding);
+            vector<vector<vector<float>>> expected = border_layer.forward(input_image);
+            vector<vector<vector<float>>> loaded = border_network.forward(input_image);
+            bool shape_match = loaded.size() == expected.size() && loaded[0].size() == expected[0].size() &&
+                               loaded[0][0].size() == expected[0][0].size();
+            float max_loader_error = 0.0f;
+            for (size_t c = 0; shape_match && c < expected.size(); ++c)
+                for (size_t h = 0; h < expected[c].size(); ++h)
+                    for (size_t w = 0; w < expected[c][h].size(); ++w)
+                    {
+                        float value = expected[c][h][w] * border_affine.scale[c] + border_affine.shift[c];
+                        max_loader_error = max(max_loader_error, fabs(loaded[c][h][w] - value) / max(1.0f, fabs(value)));
+                    }
+            cout << "Loaded reflect conv (pad 2,1,0,3) + scale: " << loaded[0].size() << "x" << loaded[0][0].size() << ", "
+                 << (shape_match && max_loader_error < 1e-5f ? "matches" : "DOES NOT match") << " conv then scale (max relative error "
+                 << scientific << max_loader_error << fixed << ")." << endl;
+        }
+
+        // --- window.v model: a reflect-padded window stream reproduces the fixed-point convolution ---
+        const int WINDOW_SIZE = 8;
+        FixedPointLayer window_layer = {KERNEL_SIZE, 1, PaddingMode::SAME, 1, 1, {}, {}, 20, 1.0f, 1.0f,
+                                        BorderMode::REFLECT, false, {0, 0, 0, 0}};
+        for (int i = 0; i < KERNEL_SIZE * KERNEL_SIZE; ++i)
+            window_layer.weights.push_back(static_cast<uint8_t>(i + 1));
+        vector<vector<vector<uint8_t>>> window_input(1, vector<vector<uint8_t>>(WINDOW_SIZE, vector<uint8_t>(WINDOW_SIZE)));
+        vector<vector<uint32_t>> window_pixels(WINDOW_SIZE, vector<uint32_t>(WINDOW_SIZE));
+        for (int h = 0; h < WINDOW_SIZE; ++h)
+            for (int w = 0; w < WINDOW_SIZE; ++w)
+                window_pixels[h][w] = window_input[0][h][w] = static_cast<uint8_t>(h * WINDOW_SIZE + w + 1);
+        WindowConfiguration window_configuration = {WINDOW_SIZE, WINDOW_SIZE, KERNEL_SIZE, 1, BorderMode::REFLECT, 1};
+        vector<vector<uint32_t>> windows = window_model(window_configuration, window_pixels);
+        vector<vector<vector<uint32_t>>> window_reference = fixed_point_forward(window_layer, window_input);
+        bool windows_match = true;
+        for (size_t n = 0; n < windows.size(); ++n)
+        {
+            uint32_t sum = 0;
+            for (size_t t = 0; t < windows[n].size(); ++t)
+                sum += windows[n][t] * window_layer.weights[t];
+            windows_match = windows_match && sum == window_reference[0][n / WINDOW_SIZE][n % WINDOW_SIZE];
+        }
+        cout << "window.v model (reflect, " << windows.size() << " windows) " << (windows_match ? "matches" : "DOES NOT match")
+             << " the fixed-point forward." << endl;
+
+        // --- window.v register-level model: the same frame streamed one pixel per clock ---
+        WindowStreamModel window_stream(window_configuration);
+        vector<vector<uint32_t>> streamed_windows;
+        long long stream_cycles = 0;
+        for (long long cycle = 0; cycle == 0 || !window_stream.idle(); ++cycle, ++stream_cycles)
+        {
+            const long long beat = cycle - 1;
+            const bool pixel_valid = beat >= 0 && beat < WINDOW_SIZE * WINDOW_SIZE;
+            vector<uint32_t> pixel(1, pixel_valid ? window_pixels[beat / WINDOW_SIZE][beat % WINDOW_SIZE] : 0);
+            const WindowStreamModel::Output &stream_output = window_stream.clock(cycle == 0, pixel_valid, pixel);
+            if (stream_output.window_valid)
+                streamed_windows.push_back(stream_output.windows[0]);
+        }
+        cout << "window.v stream model: " << streamed_windows.size() << " windows in " << stream_cycles << " cycles, "
+             << (streamed_windows == windows ? "matches" : "DOES NOT match") << " the functional model." << endl;
+        WindowConfiguration hd_window = {1920, 1080, KERNEL_SIZE, 1, BorderMode::REFLECT, 1};
+        WindowBufferLayout hd_layout = window_buffer_layout(hd_window);
+        ConvStreamTiming hd_timing = simulate_conv_stream({1920, 1080, KERNEL_SIZE, 1, 1, 0, 1});
+        cout << "window.v 1920x1080: " << hd_layout.line_rows << " block RAM rows of " << hd_layout.line_words << " words, "
+             << hd_layout.cache_words << "-word window cache, " << hd_layout.x_bits << "/" << hd_layout.y_bits
+             << "-bit x/y positions; " << hd_timing.outputs << " windows in " << hd_timing.frame_cycles << " cycles ("
+             << hd_timing.frame_cycles - hd_timing.input_cycles << " after the last pixel)." << endl;
+
+        // --- mult_acc_pipe.v: the same windows through the pipelined MAC, one per clock ---
+        MacPipelineModel mac_pipeline(window_layer, 0, 1);
+        vector<uint32_t> pipelined_outputs;
+        int first_output_cycle = -1;
+        for (size_t cycle = 0; cycle < windows.size() + mac_pipeline.timing().latency; ++cycle)
+        {
+            bool window_valid = cycle < windows.size();
+            MacPipelineModel::Output mac_output = mac_pipeline.clock(window_valid, window_valid ? windows[cycle] : vector<uint32_t>());
+            if (mac_output.valid)
+            {
+                if (first_output_cycle < 0)
+                    first_output_cycle = static_cast<int>(cycle);
+                pipelined_outputs.push_back(mac_output.value);
+            }
+        }
+        bool pipeline_match = pipelined_outputs.size() == windows.size();
+        for (size_t n = 0; pipeline_match && n < pipelined_outputs.size(); ++n)
+            pipeline_match = pipelined_outputs[n] == window_reference[0][n / WINDOW_SIZE][n % WINDOW_SIZE];
+        cout << "mult_acc_pipe model: first conv_valid " << first_output_cycle + 1 << " cycles after the first window (latency "
+             << mac_pipeline.timing().latency << "), outputs " << (pipeline_match ? "match" : "DO NOT match") << " the fixed-point forward." << endl;
+        MacPipelineTiming large_mac = mult_acc_pipe_timing(5, 4, 1);
+        cout << "mult_acc_pipe (k=5, 4 channels): tree depth " << large_mac.tree_depth << ", latency " << large_mac.latency
+             << " cycles, " << large_mac.critical_path_adders << " adder per stage vs " << mult_acc_comb_chain_adders(5, 4)
+             << " chained adders in mult_acc_comb." << endl;
+
+        // --- conv.v throughput for PIXELS_PER_CLOCK = 1..8 (32x32 frame, 3x3, pipelined MAC), same sweep as conv_throughput_tb ---
+        for (int pixels_per_clock = 1; pixels_per_clock <= 8; pixels_per_clock *= 2)
+        {
+            ConvStreamConfiguration stream = {32, 32, KERNEL_SIZE, 1, pixels_per_clock, mult_acc_pipe_timing(KERNEL_SIZE, 3, 1).latency, 1};
+            ConvStreamTiming stream_timing = simulate_conv_stream(stream);
+            cout << "conv.v PIXELS_PER_CLOCK=" << pixels_per_clock << ": " << stream_timing.outputs << " outputs in "
+                 << stream_timing.frame_cycles << " cycles, " << setprecision(2) << stream_timing.outputs_per_cycle
+                 << " outputs/cycle" << endl;
+        }
+
+        // --- mult_acc_fold.v: conv.v with folded MACs (8x8 frame, 3 channels, 4 filters), one pixel per cycles_per_window ---
+        const int FOLD_SIZE = 8, FOLD_CHANNELS = 3, FOLD_FILTERS = 4;
+        FixedPointLayer fold_layer = {KERNEL_SIZE, 1, PaddingMode::SAME, FOLD_CHANNELS, FOLD_FILTERS, {}, {-3000, 0, 150, 40000}, 16,
+                                      1.0f, 1.0f, BorderMode::ZERO, false, {0, 0, 0, 0}};
+        for (int i = 0; i < FOLD_FILTERS * FOLD_CHANNELS * KERNEL_SIZE * KERNEL_SIZE; ++i)
+            fold_layer.weights.push_back(static_cast<uint8_t>((i * 37 + 11) % 256));
+        vector<vector<vector<uint8_t>>> fold_input(FOLD_CHANNELS, vector<vector<uint8_t>>(FOLD_SIZE, vector<uint8_t>(FOLD_SIZE)));
+        for (int c = 0; c < FOLD_CHANNELS; ++c)
+            for (int h = 0; h < FOLD_SIZE; ++h)
+                for (int w = 0; w < FOLD_SIZE; ++w)
+                    fold_input[c][h][w] = static_cast<uint8_t>((c * 91 + h * 29 + w * 13) % 256);
+        vector<vector<vector<uint32_t>>> fold_reference = fixed_point_forward(fold_layer, fold_input);
+        const int fold_parallelism[][2] = {{3, 4}, {3, 2}, {1, 4}, {2, 3}, {1, 1}}; // channels, filters per cycle
+        for (const auto &parallelism : fold_parallelism)
+        {
+            MacFoldModel mac_fold(fold_layer, parallelism[0], parallelism[1]);
+            const MacFoldTiming &fold_timing = mac_fold.timing();
+            const int interval = fold_timing.cycles_per_window;
+            // One window.v per channel in lockstep, held while the MAC is busy
+            WindowConfiguration fold_window = {FOLD_SIZE, FOLD_SIZE, KERNEL_SIZE, 1, BorderMode::ZERO, 1};
+            vector<WindowStreamModel> channel_windows(FOLD_CHANNELS, WindowStreamModel(fold_window));
+            vector<uint32_t> multi_channel_window;
+            bool window_valid = false;
+            vector<vector<uint32_t>> fold_outputs;
+            long long last_output_cycle = -1;
+            for (long long cycle = 0; cycle == 0 || !channel_windows[0].idle() || window_valid || !mac_fold.idle(); ++cycle)
+            {
+                const bool window_stall = window_valid && !mac_fold.ready();
+                const MacFoldModel::Output &fold_output = mac_fold.clock(window_valid, multi_channel_window);
+                if (fold_output.valid)
+                {
+                    fold_outputs.push_back(fold_output.values);
+                    last_output_cycle = cycle;
+                }
+                const long long beat = cycle - 1;
+                const bool pixel_valid = beat >= 0 && beat % interval == 0 && beat / interval < FOLD_SIZE * FOLD_SIZE;
+                multi_channel_window.clear();
+                for (int c = 0; c < FOLD_CHANNELS; ++c)
+                {
+                    const long long pixel_index = pixel_valid ? beat / interval : 0;
+                    vector<uint32_t> pixel(1, fold_input[c][pixel_index / FOLD_SIZE][pixel_index % FOLD_SIZE]);
+                    const WindowStreamModel::Output &channel_output = channel_windows[c].clock(cycle == 0, pixel_valid, pixel, window_stall);
+                    window_valid = channel_output.window_valid;
+                    multi_channel_window.insert(multi_channel_window.end(), channel_output.windows[0].begin(), channel_output.windows[0].end());
+                }
+            }
+            bool fold_match = fold_outputs.size() == static_cast<size_t>(FOLD_SIZE * FOLD_SIZE);
+            for (size_t n = 0; fold_match && n < fold_outputs.size(); ++n)
+                for (int f = 0; f < FOLD_FILTERS; ++f)
+                    fold_match = fold_match && fold_outputs[n][f] == fold_reference[f][n / FOLD_SIZE][n % FOLD_SIZE];
+            ConvStreamTiming fold_stream = simulate_conv_stream({FOLD_SIZE, FOLD_SIZE, KERNEL_SIZE, 1, 1, fold_timing.latency, interval});
+            cout << "mult_acc_fold " << parallelism[0] << " channel(s) x " << parallelism[1] << " filter(s) per cycle: "
+                 << fold_timing.multipliers << " of " << fold_timing.unfolded_multipliers << " multipliers, " << interval
+                 << " cycle(s) per window; " << fold_outputs.size() << " outputs in " << last_output_cycle + 1 << " cycles (stream model "
+                 << fold_stream.frame_cycles << "), " << (fold_match ? "match" : "DO NOT match") << " the fixed-point forward." << endl;
+        }
+
+        // --- Layer switching: single buffer reload vs weight_bank.v double buffer (8x8 frames, 6 layers) ---
+        // 1 filter is the conv_layer_switch_tb.v setup; with 16 filters a 1-weight read port can no longer hide the
+        // load within a frame, which conv.v rejects
+        ConvStreamConfiguration switch_stream = {8, 8, KERNEL_SIZE, 1, 1, 0, 1};
+        const WeightLoadConfiguration switch_weights[] = {{KERNEL_SIZE, 3, 1, 27}, {KERNEL_SIZE, 3, 16, 1}, {KERNEL_SIZE, 3, 16, 27}};
+        for (const WeightLoadConfiguration &weights : switch_weights)
+        {
+            cout << weights.num_filters << " filter(s), " << weights.weights_per_read << " weight(s) per ROM read ("
+                 << weight_load_timing(weights).bank_load_beats << " beats): ";
+            try
+            {
+                LayerScheduleTiming schedule = simulate_layer_schedule(switch_stream, weights, 6);
+                cout << "single buffer " << schedule.single_buffer_cycles << " cycles (" << schedule.single_buffer_stall_cycles
+                     << " stalled), double buffer " << schedule.double_buffer_cycles << " cycles ("
+                     << schedule.double_buffer_stall_cycles << " waiting for frame_ready), saved " << schedule.saved_cycles << endl;
+            }
+            catch (const runtime_error &e)
+            {
+                cout << "rejected: " << e.what() << endl;
+            }
+        }
+    }
+    catch (const runtime_error &e) // std::runtime_error also becomes runtime_error
+    {
+        cerr << "Error: " << e.what() << endl; // std::cerr also becomes cerr
+        return 1;
+    }
+
+    return 0;
 }
\ No newline at end of file
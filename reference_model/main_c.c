@@ -1,346 +1,538 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h> // For memset if needed for zeroing, though manual loop is used
-#include <math.h>   // For ceilf
-#include "convolution_c.h"
-
-// Forward declaration for a function in convolution_c.c if it's not in the header and needed here
-// (e.g. if free_3d_float_array was static but needed for main's own allocations)
-// However, free_3d_float_array was made non-static and declared in convolution_c.h indirectly via its use in destroy.
-// We need a way to free the kernel_weights if main allocates them before passing to create_convolution_layer_c
-// and also for the input_image.
-
-// Helper function to allocate a 3D float array (can be moved to convolution_c.c or a common utils.c)
-// For main_c.c, we need it to prepare input_image and initial_kernel_weights in a C-compatible way.
-static float ***main_allocate_3d_float_array(int d1, int d2, int d3)
-{
-    float ***array = (float ***)malloc(d1 * sizeof(float **));
-    if (!array)
-        return NULL;
-    for (int i = 0; i < d1; ++i)
-    {
-        array[i] = (float **)malloc(d2 * sizeof(float *));
-        if (!array[i])
-        {
-            for (int k = 0; k < i; ++k)
-                free(array[k]);
-            free(array);
-            return NULL;
-        }
-        for (int j = 0; j < d2; ++j)
-        {
-            array[i][j] = (float *)malloc(d3 * sizeof(float));
-            if (!array[i][j])
-            {
-                for (int k = 0; k < j; ++k)
-                    free(array[i][k]);
-                free(array[i]);
-                for (int k = 0; k < i; ++k)
-                { /*free nested previous*/
-                    free(array[k]);
-                } // This nested free is problematic.
-                free(array);
-                return NULL;
-            }
-        }
-    }
-    return array;
-}
-
-// Helper to free 3D array used by main
-static void main_free_3d_float_array(float ***array, int d1, int d2)
-{
-    if (!array)
-        return;
-    for (int i = 0; i < d1; ++i)
-    {
-        if (array[i])
-        {
-            for (int j = 0; j < d2; ++j)
-            {
-                free(array[i][j]);
-            }
-            free(array[i]);
-        }
-    }
-    free(array);
-}
-
-// Helper to allocate a 4D float array (for kernel_weights in main)
-static float ****main_allocate_4d_float_array(int d1, int d2, int d3, int d4)
-{
-    float ****array = (float ****)malloc(d1 * sizeof(float ***));
-    if (!array)
-        return NULL;
-    for (int i = 0; i < d1; ++i)
-    {
-        array[i] = (float ***)malloc(d2 * sizeof(float **));
-        if (!array[i])
-        { // Simplified cleanup, proper cleanup is more verbose
-            for (int k = 0; k < i; ++k)
-                free(array[k]); // Assuming inner parts not allocated for array[k]
-            free(array);
-            return NULL;
-        }
-        for (int j = 0; j < d2; ++j)
-        {
-            array[i][j] = (float **)malloc(d3 * sizeof(float *));
-            if (!array[i][j])
-            { // Simplified cleanup
-                for (int k = 0; k < j; ++k)
-                    free(array[i][k]);
-                free(array[i]);
-                // And then free previous array[0]...array[i-1]
-                for (int l = 0; l < i; ++l)
-                {
-                    for (int m = 0; m < d2; ++m)
-                    { // This is still not quite right for full cleanup
-                      // free(array[l][m]) etc.
-                    }
-                    free(array[l]);
-                }
-                free(array);
-                return NULL;
-            }
-            for (int k = 0; k < d3; ++k)
-            {
-                array[i][j][k] = (float *)malloc(d4 * sizeof(float));
-                if (!array[i][j][k])
-                { // Simplified cleanup
-                    for (int l = 0; l < k; ++l)
-                        free(array[i][j][l]);
-                    free(array[i][j]);
-                    // ... and so on upwards
-                    free(array);
-                    return NULL;
-                }
-            }
-        }
-    }
-    return array;
-}
-
-// Helper to free 4D array used by main
-static void main_free_4d_float_array(float ****array, int d1, int d2, int d3)
-{
-    if (!array)
-        return;
-    for (int i = 0; i < d1; ++i)
-    {
-        if (array[i])
-        {
-            for (int j = 0; j < d2; ++j)
-            {
-                if (array[i][j])
-                {
-                    for (int k = 0; k < d3; ++k)
-                    {
-                        free(array[i][j][k]);
-                    }
-                    free(array[i][j]);
-                }
-            }
-            free(array[i]);
-        }
-    }
-    free(array);
-}
-
-// Helper function to print a 3D float array (image)
-void print_image_c(const float ***image, const OutputDimensions *dims, const char *label)
-{
-    if (!image || !dims)
-    {
-        printf("%s is NULL or dims are NULL.\\n", label);
-        return;
-    }
-    printf("%s (Channels: %d, Height: %d, Width: %d)\\n",
-           label, dims->channels, dims->height, dims->width);
-
-    for (int c = 0; c < dims->channels; ++c)
-    {
-        printf("Channel %d:\\n", c);
-        if (!image[c])
-        {
-            printf("  Channel %d is NULL.\\n", c);
-            continue;
-        }
-        for (int h = 0; h < dims->height; ++h)
-        {
-            printf("  ");
-            if (!image[c][h])
-            {
-                printf("Row %d in Channel %d is NULL.\\n", h, c);
-                continue;
-            }
-            for (int w = 0; w < dims->width; ++w)
-            {
-                printf("%.2f\\t", image[c][h][w]);
-            }
-            printf("\\n");
-        }
-        printf("\\n");
-    }
-}
-
-// External declaration for free_3d_float_array from convolution_c.c
-// This is needed because main_c.c calls it directly to free the output_image
-// and the prototype is not in convolution_c.h explicitly (it's only used by destroy_convolution_layer_c there)
-// Making it extern here makes the linkage clear.
-// Alternatively, add its prototype to convolution_c.h.
-extern void free_3d_float_array(float ***array, int d1, int d2);
-
-int main()
-{
-    const int KERNEL_SIZE = 3;
-    const int STRIDE = 1;
-    const PaddingModeC PADDING_MODE = PADDING_VALID;
-    const int INPUT_CHANNELS = 3;
-    const int OUTPUT_CHANNELS = 1;
-    const int INPUT_HEIGHT = 32;
-    const int INPUT_WIDTH = 32;
-
-    printf("Initializing C Convolution Layer...\\n");
-    printf("Kernel Size: %d\\n", KERNEL_SIZE);
-    printf("Stride: %d\\n", STRIDE);
-    printf("Padding Mode: %s\\n", (PADDING_MODE == PADDING_VALID ? "VALID" : "SAME"));
-    printf("Input Channels: %d\\n", INPUT_CHANNELS);
-    printf("Output Channels: %d\\n", OUTPUT_CHANNELS);
-    printf("Input Dimensions: %dx%dx%d\\n", INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
-
-    // --- 1. Initialize Kernel Weights (Dynamically) ---
-    float ****kernel_weights = main_allocate_4d_float_array(OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE, KERNEL_SIZE);
-    if (!kernel_weights)
-    {
-        fprintf(stderr, "Failed to allocate kernel_weights in main.\\n");
-        return 1;
-    }
-    float val = 1.0f / (float)(KERNEL_SIZE * KERNEL_SIZE); // Ensure float division
-    for (int oc = 0; oc < OUTPUT_CHANNELS; ++oc)
-    {
-        for (int ic = 0; ic < INPUT_CHANNELS; ++ic)
-        {
-            for (int kh = 0; kh < KERNEL_SIZE; ++kh)
-            {
-                for (int kw = 0; kw < KERNEL_SIZE; ++kw)
-                {
-                    kernel_weights[oc][ic][kh][kw] = val;
-                }
-            }
-        }
-    }
-    if (INPUT_CHANNELS > 1 && KERNEL_SIZE == 3)
-    { // Make sure indices are valid
-        if (OUTPUT_CHANNELS > 0 && INPUT_CHANNELS > 1 && KERNEL_SIZE >= 3)
-        {
-            kernel_weights[0][1][0][0] = 0.0f;
-            kernel_weights[0][1][0][1] = 0.0f;
-            kernel_weights[0][1][0][2] = 0.0f;
-            kernel_weights[0][1][1][0] = 0.0f;
-            kernel_weights[0][1][1][1] = 1.0f;
-            kernel_weights[0][1][1][2] = 0.0f;
-            kernel_weights[0][1][2][0] = 0.0f;
-            kernel_weights[0][1][2][1] = 0.0f;
-            kernel_weights[0][1][2][2] = 0.0f;
-        }
-    }
-
-    // --- 2. Create Input Image Data (Dynamically) ---
-    float ***input_image = main_allocate_3d_float_array(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
-    if (!input_image)
-    {
-        fprintf(stderr, "Failed to allocate input_image in main.\\n");
-        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-        return 1;
-    }
-    for (int c = 0; c < INPUT_CHANNELS; ++c)
-    {
-        for (int h = 0; h < INPUT_HEIGHT; ++h)
-        {
-            for (int w = 0; w < INPUT_WIDTH; ++w)
-            {
-                input_image[c][h][w] = (float)(c * 100 + h * 10 + w);
-            }
-        }
-    }
-
-    // OutputDimensions input_dims_for_print = {INPUT_HEIGHT, INPUT_WIDTH, INPUT_CHANNELS};
-    // print_image_c((const float***)input_image, &input_dims_for_print, "Input Image"); // Optional
-
-    // --- 3. Create Convolution Layer ---
-    ConvolutionLayerC *conv_layer = create_convolution_layer_c(
-        KERNEL_SIZE, STRIDE, PADDING_MODE, INPUT_CHANNELS, OUTPUT_CHANNELS, (const float ****)kernel_weights);
-    if (!conv_layer)
-    {
-        fprintf(stderr, "Failed to create convolution layer.\\n");
-        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
-        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-        return 1;
-    }
-
-    // --- 4. Perform Convolution ---
-    printf("\\nPerforming C convolution...\\n");
-    OutputDimensions output_dims;
-    float ***output_image = forward_convolution_c(conv_layer, (const float ***)input_image, INPUT_HEIGHT, INPUT_WIDTH, &output_dims);
-
-    if (!output_image)
-    {
-        fprintf(stderr, "Convolution failed.\\n");
-        destroy_convolution_layer_c(conv_layer);
-        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
-        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-        return 1;
-    }
-    printf("C Convolution complete.\\n");
-
-    // --- 5. Print Output Image ---
-    print_image_c((const float ***)output_image, &output_dims, "Output Image (C)");
-
-    // --- Clean up for first test case ---
-    // The `output_image` is freed using the function from `convolution_c.c` (or a compatible one)
-    // as it was allocated by `forward_convolution_c`.
-    free_3d_float_array(output_image, output_dims.channels, output_dims.height);
-
-    // --- Test with SAME padding and stride 2 ---
-    const int STRIDE_2 = 2;
-    const PaddingModeC PADDING_MODE_SAME = PADDING_SAME;
-    printf("\\n\\nInitializing C Convolution Layer (Stride 2, SAME padding)...\\n");
-
-    ConvolutionLayerC *conv_layer_same_s2 = create_convolution_layer_c(
-        KERNEL_SIZE, STRIDE_2, PADDING_MODE_SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, (const float ****)kernel_weights);
-    if (!conv_layer_same_s2)
-    {
-        fprintf(stderr, "Failed to create convolution layer (SAME, Stride 2).\\n");
-        destroy_convolution_layer_c(conv_layer);
-        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
-        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-        return 1;
-    }
-
-    printf("\\nPerforming C convolution (Stride 2, SAME padding)...\\n");
-    OutputDimensions output_dims_same_s2;
-    float ***output_image_same_s2 = forward_convolution_c(conv_layer_same_s2, (const float ***)input_image, INPUT_HEIGHT, INPUT_WIDTH, &output_dims_same_s2);
-
-    if (!output_image_same_s2)
-    {
-        fprintf(stderr, "Convolution failed (SAME, Stride 2).\\n");
-        destroy_convolution_layer_c(conv_layer_same_s2);
-        destroy_convolution_layer_c(conv_layer);
-        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
-        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-        return 1;
-    }
-    printf("C Convolution complete (Stride 2, SAME padding).\\n");
-    print_image_c((const float ***)output_image_same_s2, &output_dims_same_s2, "Output Image (C, Stride 2, SAME padding)");
-
-    // --- Final Clean up ---
-    printf("\\nCleaning up C resources...\\n");
-    free_3d_float_array(output_image_same_s2, output_dims_same_s2.channels, output_dims_same_s2.height);
-    destroy_convolution_layer_c(conv_layer_same_s2);
-    destroy_convolution_layer_c(conv_layer);
-    main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
-    main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
-
-    printf("C Demo finished.\\n");
-    return 0;
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // For memset if needed for zeroing, though manual loop is used
+#include <math.h>   // For ceilf
+#include "convolution_c.h"
+#include "convolution_api.h"
+#include "convolution_c_simd.h"
+#include <time.h> // For clock
+
+// Forward declaration for a function in convolution_c.c if it's not in the header and needed here
+// (e.g. if free_3d_float_array was static but needed for main's own allocations)
+// However, free_3d_float_array was made non-static and declared in convolution_c.h indirectly via its use in destroy.
+// We need a way to free the kernel_weights if main allocates them before passing to create_convolution_layer_c
+// and also for the input_image.
+
+// Helper function to allocate a 3D float array (can be moved to convolution_c.c or a common utils.c)
+// For main_c.c, we need it to prepare input_image and initial_kernel_weights in a C-compatible way.
+static float ***main_allocate_3d_float_array(int d1, int d2, int d3)
+{
+    float ***array = (float ***)malloc(d1 * sizeof(float **));
+    if (!array)
+        return NULL;
+    for (int i = 0; i < d1; ++i)
+    {
+        array[i] = (float **)malloc(d2 * sizeof(float *));
+        if (!array[i])
+        {
+            for (int k = 0; k < i; ++k)
+                free(array[k]);
+            free(array);
+            return NULL;
+        }
+        for (int j = 0; j < d2; ++j)
+        {
+            array[i][j] = (float *)malloc(d3 * sizeof(float));
+            if (!array[i][j])
+            {
+                for (int k = 0; k < j; ++k)
+                    free(array[i][k]);
+                free(array[i]);
+                for (int k = 0; k < i; ++k)
+                { /*free nested previous*/
+                    free(array[k]);
+                } // This nested free is problematic.
+                free(array);
+                return NULL;
+            }
+        }
+    }
+    return array;
+}
+
+// Helper to free 3D array used by main
+static void main_free_3d_float_array(float ***array, int d1, int d2)
+{
+    if (!array)
+        return;
+    for (int i = 0; i < d1; ++i)
+    {
+        if (array[i])
+        {
+            for (int j = 0; j < d2; ++j)
+            {
+                free(array[i][j]);
+            }
+            free(array[i]);
+        }
+    }
+    free(array);
+}
+
+// Helper to allocate a 4D float array (for kernel_weights in main)
+static float ****main_allocate_4d_float_array(int d1, int d2, int d3, int d4)
+{
+    float ****array = (float ****)malloc(d1 * sizeof(float ***));
+    if (!array)
+        return NULL;
+    for (int i = 0; i < d1; ++i)
+    {
+        array[i] = (float ***)malloc(d2 * sizeof(float **));
+        if (!array[i])
+        { // Simplified cleanup, proper cleanup is more verbose
+            for (int k = 0; k < i; ++k)
+                free(array[k]); // Assuming inner parts not allocated for array[k]
+            free(array);
+            return NULL;
+        }
+        for (int j = 0; j < d2; ++j)
+        {
+            array[i][j] = (float **)malloc(d3 * sizeof(float *));
+            if (!array[i][j])
+            { // Simplified cleanup
+                for (int k = 0; k < j; ++k)
+                    free(array[i][k]);
+                free(array[i]);
+                // And then free previous array[0]...array[i-1]
+                for (int l = 0; l < i; ++l)
+                {
+                    for (int m = 0; m < d2; ++m)
+                    { // This is still not quite right for full cleanup
+                      // free(array[l][m]) etc.
+                    }
+                    free(array[l]);
+                }
+                free(array);
+                return NULL;
+            }
+            for (int k = 0; k < d3; ++k)
+            {
+                array[i][j][k] = (float *)malloc(d4 * sizeof(float));
+                if (!array[i][j][k])
+                { // Simplified cleanup
+                    for (int l = 0; l < k; ++l)
+                        free(array[i][j][l]);
+                    free(array[i][j]);
+                    // ... and so on upwards
+                    free(array);
+                    return NULL;
+                }
+            }
+        }
+    }
+    return array;
+}
+
+// Helper to free 4D array used by main
+static void main_free_4d_float_array(float ****array, int d1, int d2, int d3)
+{
+    if (!array)
+        return;
+    for (int i = 0; i < d1; ++i)
+    {
+        if (array[i])
+        {
+            for (int j = 0; j < d2; ++j)
+            {
+                if (array[i][j])
+                {
+                    for (int k = 0; k < d3; ++k)
+                    {
+                        free(array[i][j][k]);
+                    }
+                    free(array[i][j]);
+                }
+            }
+            free(array[i]);
+        }
+    }
+    free(array);
+}
+
+// Helper function to print a 3D float array (image)
+void print_image_c(const float ***image, const OutputDimensions *dims, const char *label)
+{
+    if (!image || !dims)
+    {
+        printf("%s is NULL or dims are NULL.\\n", label);
+        return;
+    }
+    printf("%s (Channels: %d, Height: %d, Width: %d)\\n",
+           label, dims->channels, dims->height, dims->width);
+
+    for (int c = 0; c < dims->channels; ++c)
+    {
+        printf("Channel %d:\\n", c);
+        if (!image[c])
+        {
+            printf("  Channel %d is NULL.\\n", c);
+            continue;
+        }
+        for (int h = 0; h < dims->height; ++h)
+        {
+            printf("  ");
+            if (!image[c][h])
+            {
+                printf("Row %d in Channel %d is NULL.\\n", h, c);
+                continue;
+            }
+            for (int w = 0; w < dims->width; ++w)
+            {
+                printf("%.2f\\t", image[c][h][w]);
+            }
+            printf("\\n");
+        }
+        printf("\\n");
+    }
+}
+
+// External declaration for free_3d_float_array from convolution_c.c
+// This is needed because main_c.c calls it directly to free the output_image
+// and the prototype is not in convolution_c.h explicitly (it's only used by destroy_convolution_layer_c there)
+// Making it extern here makes the linkage clear.
+// Alternatively, add its prototype to convolution_c.h.
+extern void free_3d_float_array(float ***array, int d1, int d2);
+
+// Runs forward_convolution_c at every SIMD level the CPU supports and compares it with the
+// scalar reference loop for several kernel sizes, strides and padding modes.
+// Returns 1 if every output is bit-identical.
+static int check_simd_kernels(const float ***input_image, int input_channels, int input_height, int input_width)
+{
+    const int kernel_sizes[] = {3, 5, 4}; // 4 exercises the generic vector kernel
+    const int strides[] = {1, 2};
+    const PaddingModeC paddings[] = {PADDING_VALID, PADDING_SAME};
+    const char *border_names[] = {"zero", "reflect", "replicate", "circular"};
+    const int OUTPUT_CHANNELS = 4;
+    int all_match = 1;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        int kernel_size = kernel_sizes[k];
+        float ****weights = main_allocate_4d_float_array(OUTPUT_CHANNELS, input_channels, kernel_size, kernel_size);
+        if (!weights)
+            return 0;
+        for (int oc = 0; oc < OUTPUT_CHANNELS; ++oc)
+            for (int ic = 0; ic < input_channels; ++ic)
+                for (int kh = 0; kh < kernel_size; ++kh)
+                    for (int kw = 0; kw < kernel_size; ++kw)
+                        weights[oc][ic][kh][kw] = (float)((oc * 7 + ic * 5 + kh * 3 + kw) % 11) / 11.0f - 0.4f;
+
+        for (int s = 0; s < 2; ++s)
+        {
+            for (int p = 0; p < 2; ++p)
+            {
+                ConvolutionLayerC *layer = create_convolution_layer_c(
+                    kernel_size, strides[s], paddings[p], input_channels, OUTPUT_CHANNELS, (const float ****)weights);
+                if (!layer)
+                {
+                    main_free_4d_float_array(weights, OUTPUT_CHANNELS, input_channels, kernel_size);
+                    return 0;
+                }
+                // VALID reads no padding, so only SAME runs the border modes
+                for (int b = CONV_BORDER_ZERO; b <= (paddings[p] == PADDING_SAME ? CONV_BORDER_CIRCULAR : CONV_BORDER_ZERO); ++b)
+                {
+                    layer->border_mode = (ConvBorderModeC)b;
+                    OutputDimensions reference_dims;
+                    clock_t start = clock();
+                    float ***reference = forward_convolution_c_reference(layer, input_image, input_height, input_width, &reference_dims);
+                    double reference_ms = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+                    printf("K=%d stride=%d %-5s %-9s: reference %.3f ms", kernel_size, strides[s],
+                           paddings[p] == PADDING_VALID ? "VALID" : "SAME", border_names[b], reference_ms);
+
+                    for (int level = CONV_SIMD_SCALAR; level <= (int)conv_simd_detect(); ++level)
+                    {
+                        layer->simd_level = (ConvSimdLevelC)level;
+                        OutputDimensions dims;
+                        start = clock();
+                        float ***output = forward_convolution_c(layer, input_image, input_height, input_width, &dims);
+                        double elapsed_ms = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+                        int match = output && reference && dims.height == reference_dims.height && dims.width == reference_dims.width;
+                        for (int c = 0; match && c < dims.channels; ++c)
+                            for (int h = 0; h < dims.height; ++h)
+                                if (memcmp(output[c][h], reference[c][h], dims.width * sizeof(float)) != 0)
+                                    match = 0;
+                        printf(", %s %.3f ms%s", conv_simd_level_name((ConvSimdLevelC)level), elapsed_ms, match ? "" : " (MISMATCH)");
+                        all_match = all_match && match;
+                        if (output)
+                            free_3d_float_array(output, dims.channels, dims.height);
+                    }
+                    printf("\n");
+
+                    if (reference)
+                        free_3d_float_array(reference, reference_dims.channels, reference_dims.height);
+                }
+                destroy_convolution_layer_c(layer);
+            }
+        }
+        main_free_4d_float_array(weights, OUTPUT_CHANNELS, input_channels, kernel_size);
+    }
+    return all_match;
+}
+
+int main()
+{
+    const int KERNEL_SIZE = 3;
+    const int STRIDE = 1;
+    const PaddingModeC PADDING_MODE = PADDING_VALID;
+    const int INPUT_CHANNELS = 3;
+    const int OUTPUT_CHANNELS = 1;
+    const int INPUT_HEIGHT = 32;
+    const int INPUT_WIDTH = 32;
+
+    printf("Initializing C Convolution Layer...\\n");
+    printf("Kernel Size: %d\\n", KERNEL_SIZE);
+    printf("Stride: %d\\n", STRIDE);
+    printf("Padding Mode: %s\\n", (PADDING_MODE == PADDING_VALID ? "VALID" : "SAME"));
+    printf("Input Channels: %d\\n", INPUT_CHANNELS);
+    printf("Output Channels: %d\\n", OUTPUT_CHANNELS);
+    printf("Input Dimensions: %dx%dx%d\\n", INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+
+    // --- 1. Initialize Kernel Weights (Dynamically) ---
+    float ****kernel_weights = main_allocate_4d_float_array(OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE, KERNEL_SIZE);
+    if (!kernel_weights)
+    {
+        fprintf(stderr, "Failed to allocate kernel_weights in main.\\n");
+        return 1;
+    }
+    float val = 1.0f / (float)(KERNEL_SIZE * KERNEL_SIZE); // Ensure float division
+    for (int oc = 0; oc < OUTPUT_CHANNELS; ++oc)
+    {
+        for (int ic = 0; ic < INPUT_CHANNELS; ++ic)
+        {
+            for (int kh = 0; kh < KERNEL_SIZE; ++kh)
+            {
+                for (int kw = 0; kw < KERNEL_SIZE; ++kw)
+                {
+                    kernel_weights[oc][ic][kh][kw] = val;
+                }
+            }
+        }
+    }
+    if (INPUT_CHANNELS > 1 && KERNEL_SIZE == 3)
+    { // Make sure indices are valid
+        if (OUTPUT_CHANNELS > 0 && INPUT_CHANNELS > 1 && KERNEL_SIZE >= 3)
+        {
+            kernel_weights[0][1][0][0] = 0.0f;
+            kernel_weights[0][1][0][1] = 0.0f;
+            kernel_weights[0][1][0][2] = 0.0f;
+            kernel_weights[0][1][1][0] = 0.0f;
+            kernel_weights[0][1][1][1] = 1.0f;
+            kernel_weights[0][1][1][2] = 0.0f;
+            kernel_weights[0][1][2][0] = 0.0f;
+            kernel_weights[0][1][2][1] = 0.0f;
+            kernel_weights[0][1][2][2] = 0.0f;
+        }
+    }
+
+    // --- 2. Create Input Image Data (Dynamically) ---
+    float ***input_image = main_allocate_3d_float_array(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+    if (!input_image)
+    {
+        fprintf(stderr, "Failed to allocate input_image in main.\\n");
+        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+        return 1;
+    }
+    for (int c = 0; c < INPUT_CHANNELS; ++c)
+    {
+        for (int h = 0; h < INPUT_HEIGHT; ++h)
+        {
+            for (int w = 0; w < INPUT_WIDTH; ++w)
+            {
+                input_image[c][h][w] = (float)(c * 100 + h * 10 + w);
+            }
+        }
+    }
+
+    // OutputDimensions input_dims_for_print = {INPUT_HEIGHT, INPUT_WIDTH, INPUT_CHANNELS};
+    // print_image_c((const float***)input_image, &input_dims_for_print, "Input Image"); // Optional
+
+    // --- 3. Create Convolution Layer ---
+    ConvolutionLayerC *conv_layer = create_convolution_layer_c(
+        KERNEL_SIZE, STRIDE, PADDING_MODE, INPUT_CHANNELS, OUTPUT_CHANNELS, (const float ****)kernel_weights);
+    if (!conv_layer)
+    {
+        fprintf(stderr, "Failed to create convolution layer.\\n");
+        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
+        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+        return 1;
+    }
+
+    // --- 4. Perform Convolution ---
+    printf("\\nPerforming C convolution...\\n");
+    OutputDimensions output_dims;
+    float ***output_image = forward_convolution_c(conv_layer, (const float ***)input_image, INPUT_HEIGHT, INPUT_WIDTH, &output_dims);
+
+    if (!output_image)
+    {
+        fprintf(stderr, "Convolution failed.\\n");
+        destroy_convolution_layer_c(conv_layer);
+        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
+        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+        return 1;
+    }
+    printf("C Convolution complete.\\n");
+
+    // --- 5. Print Output Image ---
+    print_image_c((const float ***)output_image, &output_dims, "Output Image (C)");
+
+    // --- Clean up for first test case ---
+    // The `output_image` is freed using the function from `convolution_c.c` (or a compatible one)
+    // as it was allocated by `forward_convolution_c`.
+    free_3d_float_array(output_image, output_dims.channels, output_dims.height);
+
+    // --- Test with SAME padding and stride 2 ---
+    const int STRIDE_2 = 2;
+    const PaddingModeC PADDING_MODE_SAME = PADDING_SAME;
+    printf("\\n\\nInitializing C Convolution Layer (Stride 2, SAME padding)...\\n");
+
+    ConvolutionLayerC *conv_layer_same_s2 = create_convolution_layer_c(
+        KERNEL_SIZE, STRIDE_2, PADDING_MODE_SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, (const float ****)kernel_weights);
+    if (!conv_layer_same_s2)
+    {
+        fprintf(stderr, "Failed to create convolution layer (SAME, Stride 2).\\n");
+        destroy_convolution_layer_c(conv_layer);
+        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
+        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+        return 1;
+    }
+
+    printf("\\nPerforming C convolution (Stride 2, SAME padding)...\\n");
+    OutputDimensions output_dims_same_s2;
+    float ***output_image_same_s2 = forward_convolution_c(conv_layer_same_s2, (const float ***)input_image, INPUT_HEIGHT, INPUT_WIDTH, &output_dims_same_s2);
+
+    if (!output_image_same_s2)
+    {
+        fprintf(stderr, "Convolution failed (SAME, Stride 2).\\n");
+        destroy_convolution_layer_c(conv_layer_same_s2);
+        destroy_convolution_layer_c(conv_layer);
+        main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
+        main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+        return 1;
+    }
+    printf("C Convolution complete (Stride 2, SAME padding).\\n");
+    print_image_c((const float ***)output_image_same_s2, &output_dims_same_s2, "Output Image (C, Stride 2, SAME padding)");
+
+    // --- Vectorized row kernels against the scalar reference loop ---
+    printf("\nChecking SIMD row kernels (best level: %s)...\n", conv_simd_level_name(conv_simd_detect()));
+    int simd_matches = check_simd_kernels((const float ***)input_image, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+    printf("SIMD kernels %s the scalar reference.\n", simd_matches ? "match" : "DO NOT match");
+
+    // --- Same layer through the context API: interleaved (HWC) input, row-padded output ---
+    printf("\nPerforming conv_forward_into (Stride 2, SAME padding)...\n");
+    int api_matches = 0;
+    {
+        const int OUTPUT_ROW_PITCH = output_dims_same_s2.width + 3; // deliberately not the output width
+        float *weights = (float *)malloc(sizeof(float) * OUTPUT_CHANNELS * INPUT_CHANNELS * KERNEL_SIZE * KERNEL_SIZE);
+        float *interleaved = (float *)malloc(sizeof(float) * INPUT_HEIGHT * INPUT_WIDTH * INPUT_CHANNELS);
+        float *output = (float *)malloc(sizeof(float) * OUTPUT_CHANNELS * output_dims_same_s2.height * OUTPUT_ROW_PITCH);
+        struct conv_layer *api_layer = NULL; // struct tags: main has a variable named conv_layer
+        struct conv_context *api_context = NULL;
+        conv_layer_desc layer_desc = {KERNEL_SIZE, STRIDE_2, CONV_PADDING_SAME, INPUT_CHANNELS, OUTPUT_CHANNELS, CONV_BORDER_ZERO};
+        conv_context_desc context_desc = {0, 0, NULL};
+        conv_status status = CONV_ERROR_OUT_OF_MEMORY;
+
+        if (weights && interleaved && output)
+        {
+            for (int oc = 0; oc < OUTPUT_CHANNELS; ++oc)
+                for (int ic = 0; ic < INPUT_CHANNELS; ++ic)
+                    for (int kh = 0; kh < KERNEL_SIZE; ++kh)
+                        for (int kw = 0; kw < KERNEL_SIZE; ++kw)
+                            weights[((oc * INPUT_CHANNELS + ic) * KERNEL_SIZE + kh) * KERNEL_SIZE + kw] = kernel_weights[oc][ic][kh][kw];
+            for (int c = 0; c < INPUT_CHANNELS; ++c)
+                for (int h = 0; h < INPUT_HEIGHT; ++h)
+                    for (int w = 0; w < INPUT_WIDTH; ++w)
+                        interleaved[(h * INPUT_WIDTH + w) * INPUT_CHANNELS + c] = input_image[c][h][w];
+
+            status = conv_layer_create(&layer_desc, weights, NULL, &api_layer);
+            if (status == CONV_OK)
+                status = conv_context_create(&context_desc, &api_context);
+            if (status == CONV_OK)
+            {
+                conv_buffer input_buffer = {interleaved, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH,
+                                            1, (ptrdiff_t)INPUT_WIDTH * INPUT_CHANNELS, INPUT_CHANNELS};
+                conv_buffer output_buffer = {output, OUTPUT_CHANNELS, output_dims_same_s2.height, output_dims_same_s2.width,
+                                             (ptrdiff_t)output_dims_same_s2.height * OUTPUT_ROW_PITCH, OUTPUT_ROW_PITCH, 1};
+                status = conv_forward_into(api_layer, api_context, &input_buffer, &output_buffer);
+            }
+        }
+
+        if (status == CONV_OK)
+        {
+            api_matches = 1;
+            for (int c = 0; c < output_dims_same_s2.channels; ++c)
+                for (int h = 0; h < output_dims_same_s2.height; ++h)
+                    for (int w = 0; w < output_dims_same_s2.width; ++w)
+                        if (output[(c * output_dims_same_s2.height + h) * OUTPUT_ROW_PITCH + w] != output_image_same_s2[c][h][w])
+                            api_matches = 0;
+            printf("conv_forward_into on %d threads %s forward_convolution_c.\n",
+                   conv_context_thread_count(api_context), api_matches ? "matches" : "DIFFERS from");
+
+            // Same interleaved buffer described as a DLPack tensor
+            int64_t input_shape[3] = {INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH};
+            int64_t input_strides[3] = {1, (int64_t)INPUT_WIDTH * INPUT_CHANNELS, INPUT_CHANNELS};
+            int64_t output_shape[3] = {OUTPUT_CHANNELS, output_dims_same_s2.height, output_dims_same_s2.width};
+            int64_t output_strides[3] = {(int64_t)output_dims_same_s2.height * OUTPUT_ROW_PITCH, OUTPUT_ROW_PITCH, 1};
+            conv_dl_tensor input_tensor = {interleaved, {CONV_DL_CPU, 0}, 3, {CONV_DL_FLOAT, 32, 1}, input_shape, input_strides, 0};
+            conv_dl_tensor output_tensor = {output, {CONV_DL_CPU, 0}, 3, {CONV_DL_FLOAT, 32, 1}, output_shape, output_strides, 0};
+            memset(output, 0, sizeof(float) * OUTPUT_CHANNELS * output_dims_same_s2.height * OUTPUT_ROW_PITCH);
+            status = conv_forward_dl(api_layer, api_context, &input_tensor, &output_tensor);
+            int dl_matches = (status == CONV_OK);
+            for (int c = 0; dl_matches && c < output_dims_same_s2.channels; ++c)
+                for (int h = 0; h < output_dims_same_s2.height; ++h)
+                    for (int w = 0; w < output_dims_same_s2.width; ++w)
+                        if (output[(c * output_dims_same_s2.height + h) * OUTPUT_ROW_PITCH + w] != output_image_same_s2[c][h][w])
+                            dl_matches = 0;
+            printf("conv_forward_dl %s forward_convolution_c.\n", dl_matches ? "matches" : "DIFFERS from");
+            api_matches = api_matches && dl_matches;
+
+            // Reflect border through the API against the legacy layer in the same mode
+            struct conv_layer *reflect_layer = NULL;
+            layer_desc.border = CONV_BORDER_REFLECT;
+            status = conv_layer_create(&layer_desc, weights, NULL, &reflect_layer);
+            conv_layer_same_s2->border_mode = CONV_BORDER_REFLECT;
+            OutputDimensions reflect_dims;
+            float ***reflect_reference = forward_convolution_c(conv_layer_same_s2, (const float ***)input_image, INPUT_HEIGHT, INPUT_WIDTH, &reflect_dims);
+            conv_layer_same_s2->border_mode = CONV_BORDER_ZERO;
+            if (status == CONV_OK)
+            {
+                conv_buffer input_buffer = {interleaved, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH,
+                                            1, (ptrdiff_t)INPUT_WIDTH * INPUT_CHANNELS, INPUT_CHANNELS};
+                conv_buffer output_buffer = {output, OUTPUT_CHANNELS, output_dims_same_s2.height, output_dims_same_s2.width,
+                                             (ptrdiff_t)output_dims_same_s2.height * OUTPUT_ROW_PITCH, OUTPUT_ROW_PITCH, 1};
+                status = conv_forward_into(reflect_layer, api_context, &input_buffer, &output_buffer);
+            }
+            int reflect_matches = (status == CONV_OK) && reflect_reference != NULL;
+            for (int c = 0; reflect_matches && c < reflect_dims.channels; ++c)
+                for (int h = 0; h < reflect_dims.height; ++h)
+                    for (int w = 0; w < reflect_dims.width; ++w)
+                        if (output[(c * output_dims_same_s2.height + h) * OUTPUT_ROW_PITCH + w] != reflect_reference[c][h][w])
+                            reflect_matches = 0;
+            printf("conv_forward_into with a reflect border %s forward_convolution_c.\n", reflect_matches ? "matches" : "DIFFERS from");
+            api_matches = api_matches && reflect_matches;
+            if (reflect_reference)
+                free_3d_float_array(reflect_reference, reflect_dims.channels, reflect_dims.height);
+            conv_layer_destroy(reflect_layer);
+        }
+        else
+        {
+            fprintf(stderr, "conv_forward_into failed: %s\n", conv_status_string(status));
+        }
+
+        conv_context_destroy(api_context);
+        conv_layer_destroy(api_layer);
+        free(output);
+        free(interleaved);
+        free(weights);
+    }
+
+    // --- Final Clean up ---
+    printf("\\nCleaning up C resources...\\n");
+    free_3d_float_array(output_image_same_s2, output_dims_same_s2.channels, output_dims_same_s2.height);
+    destroy_convolution_layer_c(conv_layer_same_s2);
+    destroy_convolution_layer_c(conv_layer);
+    main_free_3d_float_array(input_image, INPUT_CHANNELS, INPUT_HEIGHT);
+    main_free_4d_float_array(kernel_weights, OUTPUT_CHANNELS, INPUT_CHANNELS, KERNEL_SIZE);
+
+    printf("C Demo finished.\\n");
+    return (api_matches && simd_matches) ? 0 : 1;
 }
\ No newline at end of file
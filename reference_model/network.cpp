@@ -0,0 +1,476 @@
+#include "network.h"
+#include "batch_norm_folding.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    typedef std::map<std::string, std::string> Attributes;
+
+    // Convolution whose batch_norm/scale successors are still being collected
+    struct PendingConvolution
+    {
+        std::string name;
+        TensorShape input_shape;
+        std::shared_ptr<ConvolutionLayer> layer;
+    };
+
+    std::string line_error(int line_number, const std::string &message)
+    {
+        return "Model description line " + std::to_string(line_number) + ": " + message;
+    }
+
+    const std::string &required(const Attributes &attributes, const std::string &key)
+    {
+        Attributes::const_iterator it = attributes.find(key);
+        if (it == attributes.end())
+        {
+            throw std::runtime_error("missing '" + key + "'.");
+        }
+        return it->second;
+    }
+
+    std::string optional(const Attributes &attributes, const std::string &key, const std::string &fallback)
+    {
+        Attributes::const_iterator it = attributes.find(key);
+        return it == attributes.end() ? fallback : it->second;
+    }
+
+    int positive_integer(const std::string &text, const std::string &key)
+    {
+        char *end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || value <= 0 || value > 1 << 24)
+        {
+            throw std::runtime_error("'" + key + "' must be a positive integer.");
+        }
+        return static_cast<int>(value);
+    }
+
+    BorderMode border_mode(const std::string &text)
+    {
+        if (text == "zero")
+        {
+            return BorderMode::ZERO;
+        }
+        if (text == "reflect")
+        {
+            return BorderMode::REFLECT;
+        }
+        if (text == "replicate")
+        {
+            return BorderMode::REPLICATE;
+        }
+        if (text == "circular")
+        {
+            return BorderMode::CIRCULAR;
+        }
+        throw std::runtime_error("border must be 'zero', 'reflect', 'replicate' or 'circular'.");
+    }
+
+    // "top,bottom,left,right", each a non-negative integer
+    PaddingAmounts padding_amounts(const std::string &text)
+    {
+        int values[4];
+        const char *cursor = text.c_str();
+        for (int i = 0; i < 4; ++i)
+        {
+            char *end = nullptr;
+            long value = std::strtol(cursor, &end, 10);
+            if (end == cursor || value < 0 || value > 1 << 24 || *end != (i < 3 ? ',' : '\0'))
+            {
+                throw std::runtime_error("'pad' must be four non-negative integers: top,bottom,left,right.");
+            }
+            values[i] = static_cast<int>(value);
+            cursor = end + 1;
+        }
+        PaddingAmounts padding = {values[0], values[1], values[2], values[3]};
+        return padding;
+    }
+
+    void check_keys(const Attributes &attributes, const std::vector<std::string> &allowed)
+    {
+        for (Attributes::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+        {
+            bool known = false;
+            for (const std::string &key : allowed)
+            {
+                known = known || key == it->first;
+            }
+            if (!known)
+            {
+                throw std::runtime_error("unknown key '" + it->first + "'.");
+            }
+        }
+    }
+
+    std::string resolve(const std::string &base_directory, const std::string &file)
+    {
+        if (file.empty() || file[0] == '/' || base_directory.empty())
+        {
+            return file;
+        }
+        return base_directory + "/" + file;
+    }
+
+    // All values of a tensor file in CHW order
+    std::vector<float> load_values(const std::string &path, TensorShape &shape)
+    {
+        std::vector<std::vector<std::vector<float>>> tensor = load_tensor(path);
+        shape.channels = static_cast<std::uint32_t>(tensor.size());
+        shape.height = static_cast<std::uint32_t>(tensor[0].size());
+        shape.width = static_cast<std::uint32_t>(tensor[0][0].size());
+        std::vector<float> values;
+        values.reserve(static_cast<size_t>(shape.channels) * shape.height * shape.width);
+        for (const auto &channel : tensor)
+        {
+            for (const auto &row : channel)
+            {
+                values.insert(values.end(), row.begin(), row.end());
+            }
+        }
+        return values;
+    }
+
+    std::vector<float> load_channel_vector(const std::string &path, int channels)
+    {
+        TensorShape shape;
+        std::vector<float> values = load_values(path, shape);
+        if (values.size() != static_cast<size_t>(channels))
+        {
+            throw std::runtime_error(path + " holds " + std::to_string(values.size()) + " values, expected " +
+                                     std::to_string(channels) + ".");
+        }
+        return values;
+    }
+
+    size_t activation_bytes(const TensorShape &shape)
+    {
+        return static_cast<size_t>(shape.channels) * shape.height * shape.width * sizeof(float);
+    }
+}
+
+Network Network::load(const std::string &path)
+{
+    std::ifstream description(path.c_str());
+    if (!description)
+    {
+        throw std::runtime_error("Cannot open model description: " + path);
+    }
+    std::string::size_type slash = path.find_last_of('/');
+    return parse(description, slash == std::string::npos ? std::string() : path.substr(0, slash));
+}
+
+Network Network::parse(std::istream &description, const std::string &base_directory)
+{
+    Network network;
+    bool have_input = false;
+    TensorShape shape = {0, 0, 0}; // output shape of the layers parsed so far
+    PendingConvolution pending;
+
+    // Plan the pending convolution (with everything folded into it) and append it
+    auto finish_convolution = [&]()
+    {
+        if (!pending.layer)
+        {
+            return;
+        }
+        NetworkLayer layer;
+        layer.name = pending.name;
+        layer.type = NetworkLayerType::CONVOLUTION;
+        layer.input_shape = pending.input_shape;
+        layer.output_shape = shape;
+        layer.plan = std::make_shared<LayerPlan>(
+            compile_layer_plan(*pending.layer, pending.input_shape.height, pending.input_shape.width));
+        network.layers_.push_back(layer);
+        pending.layer.reset();
+    };
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(description, line))
+    {
+        ++line_number;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::string type;
+        if (!(tokens >> type))
+        {
+            continue;
+        }
+
+        try
+        {
+            Attributes attributes;
+            std::string token;
+            while (tokens >> token)
+            {
+                std::string::size_type equals = token.find('=');
+                if (equals == std::string::npos || equals == 0)
+                {
+                    throw std::runtime_error("expected key=value, got '" + token + "'.");
+                }
+                if (!attributes.insert(std::make_pair(token.substr(0, equals), token.substr(equals + 1))).second)
+                {
+                    throw std::runtime_error("duplicate key '" + token.substr(0, equals) + "'.");
+                }
+            }
+            std::string default_name = type + std::to_string(network.layers_.size() + (pending.layer ? 1 : 0));
+
+            if (type == "input")
+            {
+                if (have_input)
+                {
+                    throw std::runtime_error("input declared twice.");
+                }
+                check_keys(attributes, {"channels", "height", "width"});
+                shape.channels = positive_integer(required(attributes, "channels"), "channels");
+                shape.height = positive_integer(required(attributes, "height"), "height");
+                shape.width = positive_integer(required(attributes, "width"), "width");
+                network.input_shape_ = shape;
+                have_input = true;
+                continue;
+            }
+            if (!have_input)
+            {
+                throw std::runtime_error("the first layer must be 'input'.");
+            }
+
+            if (type == "convolution")
+            {
+                finish_convolution();
+                check_keys(attributes, {"name", "filters", "kernel", "stride", "padding", "pad", "border", "weights", "bias", "reduction"});
+                int filters = positive_integer(required(attributes, "filters"), "filters");
+                int kernel = positive_integer(required(attributes, "kernel"), "kernel");
+                int stride = positive_integer(optional(attributes, "stride", "1"), "stride");
+
+                std::string padding = optional(attributes, "padding", "same");
+                if (padding != "same" && padding != "valid")
+                {
+                    throw std::runtime_error("padding must be 'same' or 'valid'.");
+                }
+                std::string reduction = optional(attributes, "reduction", "sequential");
+                if (reduction != "sequential" && reduction != "pairwise")
+                {
+                    throw std::runtime_error("reduction must be 'sequential' or 'pairwise'.");
+                }
+
+                std::string weights_path = resolve(base_directory, required(attributes, "weights"));
+                TensorShape weights_shape;
+                std::vector<float> weights = load_values(weights_path, weights_shape);
+                if (weights_shape.channels != static_cast<std::uint32_t>(filters) * shape.channels ||
+                    weights_shape.height != static_cast<std::uint32_t>(kernel) ||
+                    weights_shape.width != static_cast<std::uint32_t>(kernel))
+                {
+                    throw std::runtime_error(weights_path + " must have shape [" + std::to_string(filters * shape.channels) + "][" +
+                                             std::to_string(kernel) + "][" + std::to_string(kernel) + "].");
+                }
+                std::shared_ptr<float> packed(new float[weights.size()], std::default_delete<float[]>());
+                std::copy(weights.begin(), weights.end(), packed.get());
+
+                pending.name = optional(attributes, "name", default_name);
+                pending.input_shape = shape;
+                pending.layer = std::make_shared<ConvolutionLayer>(ConvolutionLayer::from_packed_weights(
+                    kernel, stride, padding == "same" ? PaddingMode::SAME : PaddingMode::VALID,
+                    shape.channels, filters, packed));
+                pending.layer->set_reduction_order(reduction == "pairwise" ? ReductionOrder::BLOCKED_PAIRWISE : ReductionOrder::SEQUENTIAL);
+                pending.layer->set_border_mode(border_mode(optional(attributes, "border", "zero")));
+                if (attributes.count("pad"))
+                {
+                    pending.layer->set_explicit_padding(padding_amounts(attributes["pad"]));
+                }
+                if (attributes.count("bias"))
+                {
+                    pending.layer->set_bias(load_channel_vector(resolve(base_directory, attributes["bias"]), filters));
+                }
+
+                ConvolutionGeometry geometry = pending.layer->compute_geometry(shape.height, shape.width);
+                shape.channels = filters;
+                shape.height = geometry.output_height;
+                shape.width = geometry.output_width;
+            }
+            else if (type == "batch_norm" || type == "scale")
+            {
+                if (!pending.layer)
+                {
+                    throw std::runtime_error(type + " must directly follow a convolution.");
+                }
+                int channels = static_cast<int>(shape.channels);
+                ChannelAffine affine;
+                if (type == "batch_norm")
+                {
+                    check_keys(attributes, {"name", "gamma", "beta", "mean", "variance", "epsilon"});
+                    BatchNormParameters batch_norm;
+                    batch_norm.gamma = load_channel_vector(resolve(base_directory, required(attributes, "gamma")), channels);
+                    batch_norm.beta = load_channel_vector(resolve(base_directory, required(attributes, "beta")), channels);
+                    batch_norm.mean = load_channel_vector(resolve(base_directory, required(attributes, "mean")), channels);
+                    batch_norm.variance = load_channel_vector(resolve(base_directory, required(attributes, "variance")), channels);
+                    if (attributes.count("epsilon"))
+                    {
+                        char *end = nullptr;
+                        batch_norm.epsilon = std::strtof(attributes["epsilon"].c_str(), &end);
+                        if (attributes["epsilon"].empty() || *end != '\0' || !(batch_norm.epsilon >= 0.0f))
+                        {
+                            throw std::runtime_error("'epsilon' must be a non-negative number.");
+                        }
+                    }
+                    affine = batch_norm_to_affine(batch_norm);
+                }
+                else
+                {
+                    check_keys(attributes, {"name", "scale", "shift"});
+                    affine.scale = load_channel_vector(resolve(base_directory, required(attributes, "scale")), channels);
+                    affine.shift = attributes.count("shift")
+                                       ? load_channel_vector(resolve(base_directory, attributes["shift"]), channels)
+                                       : std::vector<float>(channels, 0.0f);
+                }
+                pending.layer = std::make_shared<ConvolutionLayer>(fold_affine(*pending.layer, affine));
+            }
+            else if (type == "relu")
+            {
+                finish_convolution();
+                check_keys(attributes, {"name"});
+                NetworkLayer layer;
+                layer.name = optional(attributes, "name", default_name);
+                layer.type = NetworkLayerType::RELU;
+                layer.input_shape = shape;
+                layer.output_shape = shape;
+                network.layers_.push_back(layer);
+            }
+            else
+            {
+                throw std::runtime_error("unknown layer type '" + type + "'.");
+            }
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw std::runtime_error(line_error(line_number, e.what()));
+        }
+    }
+    finish_convolution();
+
+    if (!have_input)
+    {
+        throw std::runtime_error("Model description declares no input.");
+    }
+    network.allocate_buffers();
+    return network;
+}
+
+void Network::allocate_buffers()
+{
+    size_t largest_activation = activation_bytes(input_shape_);
+    for (const NetworkLayer &layer : layers_)
+    {
+        size_t bytes = activation_bytes(layer.input_shape) + activation_bytes(layer.output_shape);
+        peak_activation_bytes_ = std::max(peak_activation_bytes_, bytes);
+        largest_activation = std::max(largest_activation, activation_bytes(layer.output_shape));
+        if (layer.plan)
+        {
+            workspace_floats_per_thread_ = std::max(workspace_floats_per_thread_, layer.plan->scratch_bytes_per_thread / sizeof(float));
+        }
+    }
+    buffers_->activations[0].resize(largest_activation / sizeof(float));
+    buffers_->activations[1].resize(largest_activation / sizeof(float));
+    buffers_->workspace.resize(workspace_floats_per_thread_);
+}
+
+void Network::check_input(const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    if (input_image.size() != input_shape_.channels || input_image[0].empty() || input_image[0].size() != input_shape_.height ||
+        input_image[0][0].size() != input_shape_.width)
+    {
+        throw std::runtime_error("Input image does not match the network input shape.");
+    }
+}
+
+// Run the layers through the two activation buffers. The input is copied into the first;
+// convolve(plan, input, output) then performs one planned convolution from one buffer into
+// the other, and relu works in place. shape is the input shape. Only the returned image is
+// allocated.
+template <typename Convolve>
+static std::vector<std::vector<std::vector<float>>> run_layers(
+    const std::vector<NetworkLayer> &layers,
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    TensorShape shape,
+    std::vector<float> (&activations)[2],
+    Convolve convolve)
+{
+    float *current = activations[0].data();
+    float *next = activations[1].data();
+    float *destination = current;
+    for (const auto &channel : input_image)
+    {
+        for (const auto &row : channel)
+        {
+            destination = std::copy(row.begin(), row.end(), destination);
+        }
+    }
+
+    for (const NetworkLayer &layer : layers)
+    {
+        if (layer.type == NetworkLayerType::CONVOLUTION)
+        {
+            convolve(*layer.plan, current, next);
+            std::swap(current, next);
+        }
+        else
+        {
+            float *end = current + activation_bytes(shape) / sizeof(float);
+            for (float *value = current; value != end; ++value)
+            {
+                *value = *value > 0.0f ? *value : 0.0f;
+            }
+        }
+        shape = layer.output_shape;
+    }
+
+    std::vector<std::vector<std::vector<float>>> output_image(
+        shape.channels, std::vector<std::vector<float>>(shape.height, std::vector<float>(shape.width)));
+    const float *source = current;
+    for (auto &channel : output_image)
+    {
+        for (auto &row : channel)
+        {
+            std::copy(source, source + row.size(), row.begin());
+            source += row.size();
+        }
+    }
+    return output_image;
+}
+
+std::vector<std::vector<std::vector<float>>> Network::forward(
+    const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    check_input(input_image);
+    std::lock_guard<std::mutex> lock(buffers_->mutex);
+    float *workspace = buffers_->workspace.data();
+    return run_layers(layers_, input_image, input_shape_, buffers_->activations,
+                      [workspace](const LayerPlan &plan, const float *input, float *output)
+                      { plan.layer.forward_into(input, plan.geometry, output, workspace); });
+}
+
+std::vector<std::vector<std::vector<float>>> Network::forward(
+    const std::vector<std::vector<std::vector<float>>> &input_image,
+    WorkStealingScheduler &scheduler) const
+{
+    check_input(input_image);
+    std::lock_guard<std::mutex> lock(buffers_->mutex);
+    size_t workspace_floats = workspace_floats_per_thread_ * (scheduler.size() + 1);
+    if (buffers_->workspace.size() < workspace_floats)
+    {
+        buffers_->workspace.resize(workspace_floats);
+    }
+    float *workspace = buffers_->workspace.data();
+    return run_layers(layers_, input_image, input_shape_, buffers_->activations,
+                      [workspace, &scheduler](const LayerPlan &plan, const float *input, float *output)
+                      { plan.layer.forward_into(input, plan.geometry, output, workspace, scheduler); });
+}
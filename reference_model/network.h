@@ -0,0 +1,106 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "convolution.h"
+#include "plan_cache.h"
+#include "tensor_io.h"
+#include "work_stealing.h"
+
+// Text model description, one layer per line; '#' starts a comment:
+//
+//   input channels=3 height=32 width=32
+//   convolution filters=16 kernel=3 stride=1 padding=same weights=conv1.cnnt bias=conv1_bias.cnnt
+//   batch_norm gamma=bn1_gamma.cnnt beta=bn1_beta.cnnt mean=bn1_mean.cnnt variance=bn1_var.cnnt epsilon=1e-5
+//   relu
+//   convolution filters=8 kernel=3 stride=2 padding=valid weights=conv2.cnnt reduction=pairwise
+//   convolution filters=8 kernel=5 pad=2,2,1,3 border=reflect weights=conv3.cnnt
+//   scale scale=s2.cnnt shift=t2.cnnt
+//
+// "input" must come first. Tensor files use the binary tensor format of tensor_io.h and are
+// resolved relative to the description. Convolution weights are stored as
+// [filters * input_channels][kernel][kernel], i.e. the packed [out_c][in_c][k_h][k_w] order;
+// per-channel vectors (bias, batch norm, scale) hold one value per channel in any shape.
+// Optional keys: name, bias, stride (default 1), padding (same|valid, default same),
+// pad (top,bottom,left,right; overrides padding), border (zero|reflect|replicate|circular,
+// default zero), reduction (sequential|pairwise, default sequential) and epsilon (default 1e-5).
+// batch_norm and scale must directly follow a convolution and are folded into it at load.
+
+enum class NetworkLayerType
+{
+    CONVOLUTION,
+    RELU
+};
+
+struct NetworkLayer
+{
+    std::string name;
+    NetworkLayerType type;
+    TensorShape input_shape;
+    TensorShape output_shape;
+    std::shared_ptr<const LayerPlan> plan; // CONVOLUTION only, planned for input_shape
+};
+
+// A validated and planned chain of layers. All shapes are checked once at load; forward only
+// checks that the input matches the declared input shape. The activation buffers and the
+// convolution workspace are allocated at load and reused, so forward allocates only the
+// returned image; forward calls on one Network run one at a time.
+class Network
+{
+public:
+    // Read the description at path. Throws std::runtime_error naming the line of the first error.
+    static Network load(const std::string &path);
+
+    // Parse a description; tensor file names are resolved relative to base_directory
+    static Network parse(std::istream &description, const std::string &base_directory);
+
+    std::vector<std::vector<std::vector<float>>> forward(
+        const std::vector<std::vector<std::vector<float>>> &input_image) const;
+
+    // Same result as forward; every convolution runs on the work-stealing scheduler
+    std::vector<std::vector<std::vector<float>>> forward(
+        const std::vector<std::vector<std::vector<float>>> &input_image,
+        WorkStealingScheduler &scheduler) const;
+
+    const std::vector<NetworkLayer> &layers() const { return layers_; }
+    TensorShape input_shape() const { return input_shape_; }
+    TensorShape output_shape() const { return layers_.empty() ? input_shape_ : layers_.back().output_shape; }
+
+    // Largest input + output activation pair of any layer, in bytes: the memory a forward
+    // pass holds at its peak, apart from the weights
+    size_t peak_activation_bytes() const { return peak_activation_bytes_; }
+
+private:
+    // Two buffers of the largest activation: every convolution reads one and writes the other,
+    // relu works in place. workspace holds the largest LayerPlan::scratch_bytes_per_thread once
+    // per thread: one slot after load, grown once to scheduler.size() + 1 slots by the first
+    // forward on a scheduler.
+    struct Buffers
+    {
+        std::mutex mutex;
+        std::vector<float> activations[2];
+        std::vector<float> workspace;
+    };
+
+    TensorShape input_shape_;
+    std::vector<NetworkLayer> layers_;
+    size_t peak_activation_bytes_;
+    size_t workspace_floats_per_thread_;
+    std::unique_ptr<Buffers> buffers_; // behind a pointer so the Network stays movable
+
+    Network() : input_shape_(), peak_activation_bytes_(0), workspace_floats_per_thread_(0), buffers_(new Buffers) {}
+
+    friend Network load_network_plan(const std::string &path);
+
+    // Compute peak_activation_bytes_ and allocate the buffers once layers_ is complete
+    void allocate_buffers();
+
+    void check_input(const std::vector<std::vector<std::vector<float>>> &input_image) const;
+};
+
+#endif // NETWORK_H
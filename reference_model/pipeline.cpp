@@ -0,0 +1,455 @@
+#include "pipeline.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ring_buffer.h"
+
+namespace
+{
+typedef std::chrono::steady_clock Clock;
+
+struct RawRecord
+{
+    std::uint64_t sequence;
+    std::vector<unsigned char> raw;
+};
+
+struct ImageRecord
+{
+    std::uint64_t sequence;
+    std::vector<std::vector<std::vector<float>>> image;
+};
+
+double seconds_between(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Tries of a wait condition, with a yield between them, before a waiting thread sleeps
+const int SPIN_ROUNDS = 64;
+
+// Event count: lets a thread sleep until a lock-free queue changes without putting a lock on
+// the queue's fast path. notify_all costs an atomic increment and load while nobody sleeps.
+class EventCount
+{
+public:
+    EventCount() : epoch_(0), sleepers_(0) {}
+
+    // Read before the last check of the wait condition; pass to wait
+    std::uint64_t prepare_wait() const { return epoch_.load(); }
+
+    // Sleep unless notify_all has run since prepare_wait returned epoch
+    void wait(std::uint64_t epoch)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleepers_.fetch_add(1);
+        changed_.wait(lock, [&]() { return epoch_.load() != epoch; });
+        sleepers_.fetch_sub(1);
+    }
+
+    void notify_all()
+    {
+        epoch_.fetch_add(1);
+        if (sleepers_.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            changed_.notify_all();
+        }
+    }
+
+private:
+    std::atomic<std::uint64_t> epoch_;
+    std::atomic<int> sleepers_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+};
+
+// Return once ready() is true: spin SPIN_ROUNDS times, then sleep on event between tries.
+// Whatever can make ready() true must notify event afterwards.
+template <typename Ready>
+void wait_until(EventCount &event, Ready ready)
+{
+    for (int round = 0; round < SPIN_ROUNDS; ++round)
+    {
+        if (ready())
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    for (;;)
+    {
+        std::uint64_t epoch = event.prepare_wait();
+        if (ready())
+        {
+            return;
+        }
+        event.wait(epoch);
+    }
+}
+
+// State shared by all stage threads of one run
+struct PipelineState
+{
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+
+    // Notified on every push, pop and producer exit of the matching queue(s), and on writes
+    EventCount raw_queue_changed;
+    EventCount image_queue_changed;
+    EventCount output_queues_changed;
+    EventCount written_changed;
+
+    void fail(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error)
+            {
+                first_error = error;
+            }
+            failed.store(true, std::memory_order_release);
+        }
+        raw_queue_changed.notify_all();
+        image_queue_changed.notify_all();
+        output_queues_changed.notify_all();
+        written_changed.notify_all();
+    }
+};
+
+// Push, waiting while the queue is full (backpressure). Returns false if the pipeline failed.
+template <typename Queue, typename Item>
+bool push_blocking(Queue &queue, Item &item, EventCount &changed, PipelineState &state, double &waited_seconds)
+{
+    if (queue.try_push(item))
+    {
+        changed.notify_all();
+        return true;
+    }
+    Clock::time_point start = Clock::now();
+    bool pushed = false;
+    wait_until(changed, [&]() { return (pushed = queue.try_push(item)) || state.failed.load(std::memory_order_acquire); });
+    waited_seconds += seconds_between(start, Clock::now());
+    if (pushed)
+    {
+        changed.notify_all();
+    }
+    return pushed;
+}
+
+// Pop, waiting while the queue is empty. Returns false once every upstream producer has
+// finished and the queue is drained, or if the pipeline failed.
+template <typename Queue, typename Item>
+bool pop_blocking(Queue &queue, Item &item, const std::atomic<int> &active_producers, EventCount &changed,
+                  PipelineState &state, double &waited_seconds)
+{
+    if (queue.try_pop(item))
+    {
+        changed.notify_all();
+        return true;
+    }
+    Clock::time_point start = Clock::now();
+    bool popped = false;
+    wait_until(changed, [&]() {
+        if (state.failed.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+        // Read the producer count before the final pop so an item pushed just before the
+        // last producer exited is not missed
+        bool producers_done = active_producers.load(std::memory_order_acquire) == 0;
+        return (popped = queue.try_pop(item)) || producers_done;
+    });
+    waited_seconds += seconds_between(start, Clock::now());
+    if (popped)
+    {
+        changed.notify_all();
+    }
+    return popped;
+}
+
+void merge_stats(StageStats &total, const StageStats &part, std::mutex &mutex)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    total.items += part.items;
+    total.busy_seconds += part.busy_seconds;
+    total.starved_seconds += part.starved_seconds;
+    total.backpressure_seconds += part.backpressure_seconds;
+}
+
+StageStats make_stats(const std::string &name, int threads)
+{
+    StageStats stats;
+    stats.name = name;
+    stats.threads = threads;
+    stats.items = 0;
+    stats.busy_seconds = 0.0;
+    stats.starved_seconds = 0.0;
+    stats.backpressure_seconds = 0.0;
+    return stats;
+}
+} // namespace
+
+ConvolutionPipeline::ConvolutionPipeline(const ConvolutionLayer &layer, const PipelineConfig &config) : layer_(layer),
+                                                                                                          config_(config)
+{
+    if (config_.decoder_threads <= 0)
+    {
+        throw std::runtime_error("Pipeline needs at least one decoder thread.");
+    }
+    if (config_.queue_capacity == 0)
+    {
+        throw std::runtime_error("Pipeline queue capacity must be positive.");
+    }
+    if (config_.reorder_window == 0)
+    {
+        throw std::runtime_error("Pipeline reorder window must be positive.");
+    }
+    if (config_.convolution_threads <= 0)
+    {
+        config_.convolution_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (config_.convolution_threads <= 0)
+        {
+            config_.convolution_threads = 1;
+        }
+    }
+}
+
+std::vector<StageStats> ConvolutionPipeline::run(ReadFunction read, DecodeFunction decode, WriteFunction write) const
+{
+    const int decoder_threads = config_.decoder_threads;
+    const int convolution_threads = config_.convolution_threads;
+
+    PipelineState state;
+    std::mutex stats_mutex;
+    StageStats reader_stats = make_stats("reader", 1);
+    StageStats decoder_stats = make_stats("decoder", decoder_threads);
+    StageStats convolution_stats = make_stats("convolution", convolution_threads);
+    StageStats writer_stats = make_stats("writer", 1);
+
+    // reader -> decoders -> convolution workers: shared MPMC queues.
+    // Each convolution worker then owns an SPSC queue to the writer.
+    MpmcRingBuffer<RawRecord> raw_queue(config_.queue_capacity);
+    MpmcRingBuffer<ImageRecord> image_queue(config_.queue_capacity);
+    std::vector<std::unique_ptr<SpscRingBuffer<ImageRecord>>> output_queues;
+    for (int i = 0; i < convolution_threads; ++i)
+    {
+        output_queues.emplace_back(new SpscRingBuffer<ImageRecord>(config_.queue_capacity));
+    }
+
+    // Next sequence the writer will write; the reader stays within reorder_window of it
+    const std::uint64_t reorder_window = config_.reorder_window;
+    std::atomic<std::uint64_t> written(0);
+
+    std::atomic<int> active_readers(1);
+    std::atomic<int> active_decoders(decoder_threads);
+    std::atomic<int> active_convolution_workers(convolution_threads);
+
+    std::vector<std::thread> threads;
+
+    // --- Reader (input ROM) ---
+    threads.emplace_back([&]() {
+        StageStats stats = make_stats("reader", 1);
+        try
+        {
+            for (std::uint64_t sequence = 0; !state.failed.load(std::memory_order_acquire); ++sequence)
+            {
+                if (sequence >= written.load(std::memory_order_acquire) + reorder_window)
+                {
+                    Clock::time_point start = Clock::now();
+                    wait_until(state.written_changed, [&]() {
+                        return sequence < written.load(std::memory_order_acquire) + reorder_window ||
+                               state.failed.load(std::memory_order_acquire);
+                    });
+                    stats.backpressure_seconds += seconds_between(start, Clock::now());
+                    if (state.failed.load(std::memory_order_acquire))
+                    {
+                        break;
+                    }
+                }
+                RawRecord record;
+                record.sequence = sequence;
+                Clock::time_point start = Clock::now();
+                bool more = read(record.raw);
+                stats.busy_seconds += seconds_between(start, Clock::now());
+                if (!more)
+                {
+                    break;
+                }
+                if (!push_blocking(raw_queue, record, state.raw_queue_changed, state, stats.backpressure_seconds))
+                {
+                    break;
+                }
+                ++stats.items;
+            }
+        }
+        catch (...)
+        {
+            state.fail(std::current_exception());
+        }
+        merge_stats(reader_stats, stats, stats_mutex);
+        active_readers.fetch_sub(1, std::memory_order_release);
+        state.raw_queue_changed.notify_all();
+    });
+
+    // --- Decoders (window generation: raw bytes to CHW images) ---
+    for (int d = 0; d < decoder_threads; ++d)
+    {
+        threads.emplace_back([&]() {
+            StageStats stats = make_stats("decoder", 1);
+            try
+            {
+                RawRecord record;
+                while (pop_blocking(raw_queue, record, active_readers, state.raw_queue_changed, state, stats.starved_seconds))
+                {
+                    ImageRecord decoded;
+                    decoded.sequence = record.sequence;
+                    Clock::time_point start = Clock::now();
+                    decoded.image = decode(record.raw);
+                    stats.busy_seconds += seconds_between(start, Clock::now());
+                    if (!push_blocking(image_queue, decoded, state.image_queue_changed, state, stats.backpressure_seconds))
+                    {
+                        break;
+                    }
+                    ++stats.items;
+                }
+            }
+            catch (...)
+            {
+                state.fail(std::current_exception());
+            }
+            merge_stats(decoder_stats, stats, stats_mutex);
+            active_decoders.fetch_sub(1, std::memory_order_release);
+            state.image_queue_changed.notify_all();
+        });
+    }
+
+    // --- Convolution workers (MAC array) ---
+    for (int w = 0; w < convolution_threads; ++w)
+    {
+        SpscRingBuffer<ImageRecord> *output_queue = output_queues[w].get();
+        threads.emplace_back([&, output_queue]() {
+            StageStats stats = make_stats("convolution", 1);
+            try
+            {
+                ImageRecord record;
+                while (pop_blocking(image_queue, record, active_decoders, state.image_queue_changed, state, stats.starved_seconds))
+                {
+                    ImageRecord result;
+                    result.sequence = record.sequence;
+                    Clock::time_point start = Clock::now();
+                    result.image = layer_.forward(record.image);
+                    stats.busy_seconds += seconds_between(start, Clock::now());
+                    if (!push_blocking(*output_queue, result, state.output_queues_changed, state, stats.backpressure_seconds))
+                    {
+                        break;
+                    }
+                    ++stats.items;
+                }
+            }
+            catch (...)
+            {
+                state.fail(std::current_exception());
+            }
+            merge_stats(convolution_stats, stats, stats_mutex);
+            active_convolution_workers.fetch_sub(1, std::memory_order_release);
+            state.output_queues_changed.notify_all();
+        });
+    }
+
+    // --- Writer (output RAM), on the calling thread; restores input order ---
+    {
+        StageStats stats = make_stats("writer", 1);
+        try
+        {
+            // Results that finished ahead of an earlier record. The reader's window keeps it
+            // below reorder_window entries; the pop guard states the bound.
+            std::map<std::uint64_t, std::vector<std::vector<std::vector<float>>>> pending;
+            std::uint64_t next_sequence = 0;
+
+            // Move finished results into pending; true if any arrived
+            auto drain = [&]() {
+                bool received = false;
+                ImageRecord result;
+                for (std::unique_ptr<SpscRingBuffer<ImageRecord>> &queue : output_queues)
+                {
+                    while (pending.size() < reorder_window && queue->try_pop(result))
+                    {
+                        pending[result.sequence] = std::move(result.image);
+                        received = true;
+                    }
+                }
+                if (received)
+                {
+                    state.output_queues_changed.notify_all();
+                }
+                return received;
+            };
+
+            while (!state.failed.load(std::memory_order_acquire))
+            {
+                bool workers_done = active_convolution_workers.load(std::memory_order_acquire) == 0;
+                bool progressed = drain();
+
+                while (!pending.empty() && pending.begin()->first == next_sequence)
+                {
+                    Clock::time_point start = Clock::now();
+                    write(next_sequence, pending.begin()->second);
+                    stats.busy_seconds += seconds_between(start, Clock::now());
+                    pending.erase(pending.begin());
+                    ++next_sequence;
+                    ++stats.items;
+                    progressed = true;
+                }
+                if (written.load(std::memory_order_relaxed) != next_sequence)
+                {
+                    written.store(next_sequence, std::memory_order_release);
+                    state.written_changed.notify_all();
+                }
+
+                if (progressed)
+                {
+                    continue;
+                }
+                if (workers_done)
+                {
+                    break; // every queue was drained after the workers finished
+                }
+                Clock::time_point idle_start = Clock::now();
+                wait_until(state.output_queues_changed, [&]() {
+                    return state.failed.load(std::memory_order_acquire) ||
+                           active_convolution_workers.load(std::memory_order_acquire) == 0 || drain();
+                });
+                stats.starved_seconds += seconds_between(idle_start, Clock::now());
+            }
+        }
+        catch (...)
+        {
+            state.fail(std::current_exception());
+        }
+        merge_stats(writer_stats, stats, stats_mutex);
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    if (state.first_error)
+    {
+        std::rethrow_exception(state.first_error);
+    }
+
+    std::vector<StageStats> all_stats;
+    all_stats.push_back(reader_stats);
+    all_stats.push_back(decoder_stats);
+    all_stats.push_back(convolution_stats);
+    all_stats.push_back(writer_stats);
+    return all_stats;
+}
@@ -0,0 +1,60 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "convolution.h"
+
+// Per-stage counters reported by ConvolutionPipeline::run
+struct StageStats
+{
+    std::string name;
+    int threads;
+    std::uint64_t items;         // items processed by the stage
+    double busy_seconds;         // time spent in the stage function, summed over threads
+    double starved_seconds;      // time waiting for input from the previous stage
+    double backpressure_seconds; // time waiting for space in the next stage's queue
+};
+
+struct PipelineConfig
+{
+    int decoder_threads = 1;
+    int convolution_threads = 0; // <= 0: hardware concurrency
+    std::size_t queue_capacity = 16;
+    // Records the reader may run ahead of the writer. Bounds the writer's reorder buffer, which
+    // holds results that finished ahead of an earlier record.
+    std::size_t reorder_window = 64;
+};
+
+// Streaming load -> decode -> convolve -> store pipeline, mirroring the hardware dataflow
+// in the readme: the reader plays the input ROM, decoders the window generator (raw bytes
+// to CHW images), convolution workers the MAC array and the writer the output RAM.
+// Stages run on their own threads and are connected by bounded lock-free ring buffers, so
+// a slow stage throttles its producers instead of letting queues grow without limit.
+// Results reach the writer in input order. A stage that has to wait spins briefly and then
+// sleeps until the queue it waits on changes.
+class ConvolutionPipeline
+{
+public:
+    // Fill raw with the next record; return false at end of stream
+    typedef std::function<bool(std::vector<unsigned char> &raw)> ReadFunction;
+    // Turn a raw record into a [in_c][height][width] image
+    typedef std::function<std::vector<std::vector<std::vector<float>>>(const std::vector<unsigned char> &raw)> DecodeFunction;
+    // Consume the output of record number sequence (0-based, called in order)
+    typedef std::function<void(std::uint64_t sequence, const std::vector<std::vector<std::vector<float>>> &output)> WriteFunction;
+
+    ConvolutionPipeline(const ConvolutionLayer &layer, const PipelineConfig &config = PipelineConfig());
+
+    // Process the whole stream and return statistics for the reader, decoder, convolution
+    // and writer stages. An exception thrown by any stage function stops the pipeline and
+    // is rethrown here.
+    std::vector<StageStats> run(ReadFunction read, DecodeFunction decode, WriteFunction write) const;
+
+private:
+    const ConvolutionLayer &layer_;
+    PipelineConfig config_;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,491 @@
+#include "plan_cache.h"
+#include "network.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PLAN_CACHE_HAVE_MMAP 1
+#endif
+
+namespace
+{
+const char PLAN_MAGIC[8] = {'C', 'N', 'N', 'P', 'L', 'A', 'N', '1'};
+const std::uint32_t PLAN_VERSION = 3; // 2: per-channel bias after the weights; 3: border mode, explicit padding
+const std::uint32_t ENDIAN_CHECK = 0x01020304u;
+const std::uint64_t WEIGHT_ALIGNMENT = 64;
+
+const char NETWORK_MAGIC[8] = {'C', 'N', 'N', 'N', 'E', 'T', 'P', '1'};
+const std::uint32_t NETWORK_VERSION = 1;
+
+// On-disk header; fixed-width fields only, so the layout does not depend on the compiler
+struct PlanHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endian_check;
+    std::int32_t kernel_size;
+    std::int32_t stride;
+    std::int32_t padding_mode;
+    std::int32_t input_channels;
+    std::int32_t output_channels;
+    std::int32_t reduction_order;
+    std::int32_t input_height;
+    std::int32_t input_width;
+    std::int32_t output_height;
+    std::int32_t output_width;
+    std::int32_t padding_h;
+    std::int32_t padding_w;
+    std::int32_t border_mode;
+    std::int32_t has_explicit_padding;
+    std::int32_t explicit_padding[4]; // top, bottom, left, right
+    std::uint64_t scratch_bytes_per_thread;
+    std::uint64_t split_reduction_workspace_bytes;
+    std::uint64_t weights_offset; // bytes from the start of the file
+    std::uint64_t weight_count;
+    std::uint64_t bias_count; // 0 or output_channels floats, directly after the weights
+};
+
+// Network plan: this header, one record (followed by its name) per layer, then the layer plans
+struct NetworkPlanHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endian_check;
+    std::uint32_t input_shape[3]; // channels, height, width
+    std::uint32_t layer_count;
+};
+
+struct NetworkLayerRecord
+{
+    std::int32_t type; // NetworkLayerType
+    std::uint32_t name_length;
+    std::uint32_t input_shape[3];
+    std::uint32_t output_shape[3];
+    std::uint64_t plan_offset; // bytes from the start of the file; 0 for layers without a plan
+};
+
+// Read-only view of a whole file: memory-mapped where available, otherwise read into memory
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path) : data_(nullptr), size_(0)
+    {
+#ifdef PLAN_CACHE_HAVE_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open plan file: " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot read plan file: " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file referenced
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map plan file: " + path);
+        }
+        data_ = static_cast<const unsigned char *>(mapping);
+#else
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open plan file: " + path);
+        }
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        // Allocated as doubles so the buffer is at least 8-byte aligned for the float weights
+        buffer_.resize((length > 0 ? static_cast<size_t>(length) : 0) / sizeof(double) + 1);
+        size_ = length > 0 ? static_cast<size_t>(length) : 0;
+        bool ok = size_ > 0 && std::fread(buffer_.data(), 1, size_, file) == size_;
+        std::fclose(file);
+        if (!ok)
+        {
+            throw std::runtime_error("Cannot read plan file: " + path);
+        }
+        data_ = reinterpret_cast<const unsigned char *>(buffer_.data());
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef PLAN_CACHE_HAVE_MMAP
+        if (data_)
+        {
+            munmap(const_cast<unsigned char *>(data_), size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char *data_;
+    size_t size_;
+#ifndef PLAN_CACHE_HAVE_MMAP
+    std::vector<double> buffer_;
+#endif
+};
+
+std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+LayerPlan compile_layer_plan(const ConvolutionLayer &layer, int input_height, int input_width)
+{
+    ConvolutionGeometry geometry = layer.compute_geometry(input_height, input_width);
+    size_t output_positions = static_cast<size_t>(geometry.output_height) * geometry.output_width;
+    LayerPlan plan = {
+        layer,
+        geometry,
+        static_cast<size_t>(layer.input_channels()) * sizeof(float),
+        static_cast<size_t>(layer.output_channels()) * layer.input_channels() * output_positions * sizeof(float)};
+    return plan;
+}
+
+namespace
+{
+// Bytes save_layer_plan writes for plan
+size_t layer_plan_size(const LayerPlan &plan)
+{
+    return static_cast<size_t>(align_up(sizeof(PlanHeader), WEIGHT_ALIGNMENT)) +
+           (plan.layer.packed_weight_count() + plan.layer.bias().size()) * sizeof(float);
+}
+
+// Write plan at the current position of file; false on I/O failure
+bool write_layer_plan(const LayerPlan &plan, FILE *file)
+{
+    const ConvolutionLayer &layer = plan.layer;
+
+    PlanHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, PLAN_MAGIC, sizeof(PLAN_MAGIC));
+    header.version = PLAN_VERSION;
+    header.endian_check = ENDIAN_CHECK;
+    header.kernel_size = layer.kernel_size();
+    header.stride = layer.stride();
+    header.padding_mode = static_cast<std::int32_t>(layer.padding_mode());
+    header.input_channels = layer.input_channels();
+    header.output_channels = layer.output_channels();
+    header.reduction_order = static_cast<std::int32_t>(layer.reduction_order());
+    header.input_height = plan.geometry.input_height;
+    header.input_width = plan.geometry.input_width;
+    header.output_height = plan.geometry.output_height;
+    header.output_width = plan.geometry.output_width;
+    header.padding_h = plan.geometry.padding_h;
+    header.padding_w = plan.geometry.padding_w;
+    header.border_mode = static_cast<std::int32_t>(layer.border_mode());
+    header.has_explicit_padding = layer.has_explicit_padding() ? 1 : 0;
+    header.explicit_padding[0] = layer.explicit_padding().top;
+    header.explicit_padding[1] = layer.explicit_padding().bottom;
+    header.explicit_padding[2] = layer.explicit_padding().left;
+    header.explicit_padding[3] = layer.explicit_padding().right;
+    header.scratch_bytes_per_thread = plan.scratch_bytes_per_thread;
+    header.split_reduction_workspace_bytes = plan.split_reduction_workspace_bytes;
+    header.weights_offset = align_up(sizeof(PlanHeader), WEIGHT_ALIGNMENT);
+    header.weight_count = layer.packed_weight_count();
+    header.bias_count = layer.bias().size();
+
+    std::vector<unsigned char> padding(header.weights_offset - sizeof(PlanHeader), 0);
+    return std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+           (padding.empty() || std::fwrite(padding.data(), 1, padding.size(), file) == padding.size()) &&
+           std::fwrite(layer.packed_weights(), sizeof(float), header.weight_count, file) == header.weight_count &&
+           (header.bias_count == 0 ||
+            std::fwrite(layer.bias().data(), sizeof(float), header.bias_count, file) == header.bias_count);
+}
+
+// Plan stored at offset (a multiple of 64) of a mapped file; its weights alias the mapping
+LayerPlan read_layer_plan(const std::shared_ptr<MappedFile> &file, size_t offset, const std::string &path)
+{
+    if (offset % WEIGHT_ALIGNMENT != 0 || offset > file->size() || file->size() - offset < sizeof(PlanHeader))
+    {
+        throw std::runtime_error("Plan file is truncated: " + path);
+    }
+    const unsigned char *data = file->data() + offset;
+    const size_t size = file->size() - offset;
+    PlanHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, PLAN_MAGIC, sizeof(PLAN_MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a plan file: " + path);
+    }
+    if (header.version != PLAN_VERSION)
+    {
+        throw std::runtime_error("Unsupported plan file version: " + path);
+    }
+    if (header.endian_check != ENDIAN_CHECK)
+    {
+        throw std::runtime_error("Plan file was written with a different byte order: " + path);
+    }
+    if (header.weights_offset % sizeof(float) != 0 ||
+        header.weights_offset > size ||
+        header.weight_count > (size - header.weights_offset) / sizeof(float) ||
+        header.bias_count > (size - header.weights_offset) / sizeof(float) - header.weight_count)
+    {
+        throw std::runtime_error("Plan file is truncated: " + path);
+    }
+
+    if (header.padding_mode != static_cast<std::int32_t>(PaddingMode::VALID) &&
+        header.padding_mode != static_cast<std::int32_t>(PaddingMode::SAME))
+    {
+        throw std::runtime_error("Plan file has an unknown padding mode: " + path);
+    }
+    if (header.reduction_order != static_cast<std::int32_t>(ReductionOrder::SEQUENTIAL) &&
+        header.reduction_order != static_cast<std::int32_t>(ReductionOrder::BLOCKED_PAIRWISE))
+    {
+        throw std::runtime_error("Plan file has an unknown reduction order: " + path);
+    }
+    if (header.border_mode < static_cast<std::int32_t>(BorderMode::ZERO) ||
+        header.border_mode > static_cast<std::int32_t>(BorderMode::CIRCULAR))
+    {
+        throw std::runtime_error("Plan file has an unknown border mode: " + path);
+    }
+    if (header.input_height <= 0 || header.input_width <= 0)
+    {
+        throw std::runtime_error("Plan file has non-positive input dimensions: " + path);
+    }
+
+    // Aliasing pointer: refers to the weights, keeps the whole mapping alive
+    std::shared_ptr<const float> weights(
+        file, reinterpret_cast<const float *>(data + header.weights_offset));
+
+    ConvolutionLayer layer = ConvolutionLayer::from_packed_weights(
+        header.kernel_size,
+        header.stride,
+        static_cast<PaddingMode>(header.padding_mode),
+        header.input_channels,
+        header.output_channels,
+        weights);
+    if (layer.packed_weight_count() != header.weight_count)
+    {
+        throw std::runtime_error("Plan file weight count does not match its layer shape: " + path);
+    }
+    layer.set_reduction_order(static_cast<ReductionOrder>(header.reduction_order));
+    layer.set_border_mode(static_cast<BorderMode>(header.border_mode));
+    if (header.has_explicit_padding)
+    {
+        PaddingAmounts padding = {header.explicit_padding[0], header.explicit_padding[1],
+                                  header.explicit_padding[2], header.explicit_padding[3]};
+        layer.set_explicit_padding(padding);
+    }
+    if (header.bias_count > 0)
+    {
+        const float *bias = weights.get() + header.weight_count;
+        layer.set_bias(std::vector<float>(bias, bias + header.bias_count));
+    }
+
+    // The stored geometry and workspace sizes must be the ones this layer computes itself
+    LayerPlan plan = compile_layer_plan(layer, header.input_height, header.input_width);
+    if (plan.geometry.output_height != header.output_height ||
+        plan.geometry.output_width != header.output_width ||
+        plan.geometry.padding_h != header.padding_h ||
+        plan.geometry.padding_w != header.padding_w ||
+        plan.scratch_bytes_per_thread != header.scratch_bytes_per_thread ||
+        plan.split_reduction_workspace_bytes != header.split_reduction_workspace_bytes)
+    {
+        throw std::runtime_error("Plan file geometry does not match its layer shape: " + path);
+    }
+    return plan;
+}
+} // namespace
+
+void save_layer_plan(const LayerPlan &plan, const std::string &path)
+{
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("Cannot create plan file: " + path);
+    }
+    bool ok = write_layer_plan(plan, file);
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to write plan file: " + path);
+    }
+}
+
+LayerPlan load_layer_plan(const std::string &path)
+{
+    return read_layer_plan(std::make_shared<MappedFile>(path), 0, path);
+}
+
+void save_network_plan(const Network &network, const std::string &path)
+{
+    const std::vector<NetworkLayer> &layers = network.layers();
+    std::uint64_t offset = sizeof(NetworkPlanHeader);
+    for (const NetworkLayer &layer : layers)
+    {
+        offset += sizeof(NetworkLayerRecord) + layer.name.size();
+    }
+    std::vector<std::uint64_t> plan_offsets(layers.size(), 0);
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        if (layers[i].plan)
+        {
+            plan_offsets[i] = align_up(offset, WEIGHT_ALIGNMENT);
+            offset = plan_offsets[i] + layer_plan_size(*layers[i].plan);
+        }
+    }
+
+    NetworkPlanHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, NETWORK_MAGIC, sizeof(NETWORK_MAGIC));
+    header.version = NETWORK_VERSION;
+    header.endian_check = ENDIAN_CHECK;
+    header.input_shape[0] = network.input_shape().channels;
+    header.input_shape[1] = network.input_shape().height;
+    header.input_shape[2] = network.input_shape().width;
+    header.layer_count = static_cast<std::uint32_t>(layers.size());
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("Cannot create plan file: " + path);
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    std::uint64_t position = sizeof(header);
+    for (size_t i = 0; ok && i < layers.size(); ++i)
+    {
+        NetworkLayerRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.type = static_cast<std::int32_t>(layers[i].type);
+        record.name_length = static_cast<std::uint32_t>(layers[i].name.size());
+        record.input_shape[0] = layers[i].input_shape.channels;
+        record.input_shape[1] = layers[i].input_shape.height;
+        record.input_shape[2] = layers[i].input_shape.width;
+        record.output_shape[0] = layers[i].output_shape.channels;
+        record.output_shape[1] = layers[i].output_shape.height;
+        record.output_shape[2] = layers[i].output_shape.width;
+        record.plan_offset = plan_offsets[i];
+        ok = std::fwrite(&record, sizeof(record), 1, file) == 1 &&
+             std::fwrite(layers[i].name.data(), 1, layers[i].name.size(), file) == layers[i].name.size();
+        position += sizeof(record) + layers[i].name.size();
+    }
+    for (size_t i = 0; ok && i < layers.size(); ++i)
+    {
+        if (layers[i].plan)
+        {
+            std::vector<unsigned char> padding(plan_offsets[i] - position, 0);
+            ok = (padding.empty() || std::fwrite(padding.data(), 1, padding.size(), file) == padding.size()) &&
+                 write_layer_plan(*layers[i].plan, file);
+            position = plan_offsets[i] + layer_plan_size(*layers[i].plan);
+        }
+    }
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to write plan file: " + path);
+    }
+}
+
+Network load_network_plan(const std::string &path)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+
+    if (file->size() < sizeof(NetworkPlanHeader))
+    {
+        throw std::runtime_error("Plan file is truncated: " + path);
+    }
+    NetworkPlanHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, NETWORK_MAGIC, sizeof(NETWORK_MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a network plan file: " + path);
+    }
+    if (header.version != NETWORK_VERSION)
+    {
+        throw std::runtime_error("Unsupported plan file version: " + path);
+    }
+    if (header.endian_check != ENDIAN_CHECK)
+    {
+        throw std::runtime_error("Plan file was written with a different byte order: " + path);
+    }
+
+    if (header.input_shape[0] == 0 || header.input_shape[1] == 0 || header.input_shape[2] == 0)
+    {
+        throw std::runtime_error("Plan file has non-positive input dimensions: " + path);
+    }
+
+    Network network;
+    network.input_shape_ = {header.input_shape[0], header.input_shape[1], header.input_shape[2]};
+    TensorShape shape = network.input_shape_;
+    size_t cursor = sizeof(header);
+    for (std::uint32_t i = 0; i < header.layer_count; ++i)
+    {
+        NetworkLayerRecord record;
+        if (file->size() - cursor < sizeof(record))
+        {
+            throw std::runtime_error("Plan file is truncated: " + path);
+        }
+        std::memcpy(&record, file->data() + cursor, sizeof(record));
+        cursor += sizeof(record);
+        if (record.name_length > file->size() - cursor)
+        {
+            throw std::runtime_error("Plan file is truncated: " + path);
+        }
+
+        NetworkLayer layer;
+        layer.name.assign(reinterpret_cast<const char *>(file->data() + cursor), record.name_length);
+        cursor += record.name_length;
+        layer.input_shape = {record.input_shape[0], record.input_shape[1], record.input_shape[2]};
+        layer.output_shape = {record.output_shape[0], record.output_shape[1], record.output_shape[2]};
+        if (layer.input_shape.channels != shape.channels || layer.input_shape.height != shape.height ||
+            layer.input_shape.width != shape.width)
+        {
+            throw std::runtime_error("Plan file layers do not chain: " + path);
+        }
+
+        if (record.type == static_cast<std::int32_t>(NetworkLayerType::CONVOLUTION))
+        {
+            layer.type = NetworkLayerType::CONVOLUTION;
+            std::shared_ptr<LayerPlan> plan = std::make_shared<LayerPlan>(read_layer_plan(file, record.plan_offset, path));
+            if (static_cast<std::uint32_t>(plan->layer.input_channels()) != layer.input_shape.channels ||
+                static_cast<std::uint32_t>(plan->geometry.input_height) != layer.input_shape.height ||
+                static_cast<std::uint32_t>(plan->geometry.input_width) != layer.input_shape.width ||
+                static_cast<std::uint32_t>(plan->layer.output_channels()) != layer.output_shape.channels ||
+                static_cast<std::uint32_t>(plan->geometry.output_height) != layer.output_shape.height ||
+                static_cast<std::uint32_t>(plan->geometry.output_width) != layer.output_shape.width)
+            {
+                throw std::runtime_error("Plan file layer shape does not match its plan: " + path);
+            }
+            layer.plan = plan;
+        }
+        else if (record.type == static_cast<std::int32_t>(NetworkLayerType::RELU))
+        {
+            layer.type = NetworkLayerType::RELU;
+            if (layer.output_shape.channels != shape.channels || layer.output_shape.height != shape.height ||
+                layer.output_shape.width != shape.width)
+            {
+                throw std::runtime_error("Plan file layers do not chain: " + path);
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Plan file has an unknown layer type: " + path);
+        }
+        shape = layer.output_shape;
+        network.layers_.push_back(layer);
+    }
+
+    network.allocate_buffers();
+    return network;
+}
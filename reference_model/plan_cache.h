@@ -0,0 +1,43 @@
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+
+#include <cstddef>
+#include <string>
+#include "convolution.h"
+
+// A layer together with everything decided when it was prepared for a known input size:
+// the packed weights and bias, the chosen reduction order and the workspace sizes. Plans are
+// saved to a binary file whose weight block is 64-byte aligned and used in place after mmap,
+// so loading a plan costs a header check rather than a weight copy and repack.
+struct LayerPlan
+{
+    ConvolutionLayer layer;
+    ConvolutionGeometry geometry;            // for the planned input size
+    size_t scratch_bytes_per_thread;         // per-worker scratch for BLOCKED_PAIRWISE reductions
+    size_t split_reduction_workspace_bytes;  // partial planes used by forward_split_reduction
+};
+
+// Prepare a plan for inputs of the given size (validates the shape once)
+LayerPlan compile_layer_plan(const ConvolutionLayer &layer, int input_height, int input_width);
+
+// Write the plan to path. Throws std::runtime_error on I/O failure.
+void save_layer_plan(const LayerPlan &plan, const std::string &path);
+
+// Map a plan file. The returned layer references the mapped weights directly; the mapping
+// lives as long as any copy of the layer. Throws std::runtime_error if the file is missing,
+// truncated, from an incompatible version or written on a machine of different endianness.
+LayerPlan load_layer_plan(const std::string &path);
+
+// Whole-network plan: the input shape, the layer list and every convolution's plan in one
+// file. Each convolution is stored as a layer plan at a 64-byte aligned offset and the file is
+// mapped once, so loading skips the description, the tensor files and batch-norm folding.
+class Network;
+
+// Write the network's plans to path. Throws std::runtime_error on I/O failure.
+void save_network_plan(const Network &network, const std::string &path);
+
+// Map a network plan. Throws std::runtime_error on the same conditions as load_layer_plan,
+// for an unknown layer type and for layers whose shapes do not chain.
+Network load_network_plan(const std::string &path);
+
+#endif // PLAN_CACHE_H
@@ -0,0 +1,181 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept> // For std::runtime_error
+#include <utility>   // For std::move
+#include <vector>
+
+// Bounded lock-free queues used between pipeline stages. Both hold at most capacity()
+// items; try_push fails when full (the caller applies backpressure) and try_pop fails
+// when empty. Capacities are rounded up to a power of two (at least two for MpmcRingBuffer).
+
+static inline std::size_t round_up_power_of_two(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Single producer, single consumer
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(std::size_t capacity) : slots_(round_up_power_of_two(capacity)),
+                                                    mask_(slots_.size() - 1),
+                                                    head_(0),
+                                                    tail_(0)
+    {
+        if (capacity == 0)
+        {
+            throw std::runtime_error("Ring buffer capacity must be positive.");
+        }
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    bool try_push(T &item)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+        {
+            return false; // full
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return false; // empty
+        }
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    const std::size_t mask_;
+    // Padding keeps the producer and consumer indices on separate cache lines
+    char head_padding_[64];
+    std::atomic<std::size_t> head_; // next slot to pop (consumer)
+    char tail_padding_[64];
+    std::atomic<std::size_t> tail_; // next slot to push (producer)
+};
+
+// Multiple producers, multiple consumers (Vyukov's bounded queue: each slot carries a
+// sequence number that tells producers and consumers whose turn it is). At least two cells:
+// with one, a full cell and the next lap's empty cell carry the same sequence number.
+template <typename T>
+class MpmcRingBuffer
+{
+public:
+    explicit MpmcRingBuffer(std::size_t capacity) : cells_(round_up_power_of_two(capacity < 2 ? 2 : capacity)),
+                                                    mask_(cells_.size() - 1),
+                                                    enqueue_position_(0),
+                                                    dequeue_position_(0)
+    {
+        if (capacity == 0)
+        {
+            throw std::runtime_error("Ring buffer capacity must be positive.");
+        }
+        for (std::size_t i = 0; i < cells_.size(); ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRingBuffer(const MpmcRingBuffer &) = delete;
+    MpmcRingBuffer &operator=(const MpmcRingBuffer &) = delete;
+
+    bool try_push(T &item)
+    {
+        std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;)
+        {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0)
+            {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item)
+    {
+        std::size_t position = dequeue_position_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;)
+        {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                position = dequeue_position_.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return cells_.size(); }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::vector<Cell> cells_;
+    const std::size_t mask_;
+    char enqueue_padding_[64];
+    std::atomic<std::size_t> enqueue_position_;
+    char dequeue_padding_[64];
+    std::atomic<std::size_t> dequeue_position_;
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,323 @@
+#include "rtl_cycle_model.h"
+#include <algorithm>
+#include <stdexcept>
+
+// $clog2: bits needed to index value entries
+static int ceil_log2(int value)
+{
+    int bits = 0;
+    while ((1 << bits) < value)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+// Bias and saturation of mult_acc_comb.v: negative sums clamp to 0, large ones to 2^output_width - 1
+static std::uint32_t biased_output(const FixedPointLayer &layer, int out_c, std::int64_t sum)
+{
+    sum += layer.bias.empty() ? 0 : layer.bias[out_c];
+    const std::int64_t max_output = (std::int64_t(1) << layer.output_width) - 1;
+    return static_cast<std::uint32_t>(sum < 0 ? 0 : (sum > max_output ? max_output : sum));
+}
+
+MacPipelineTiming mult_acc_pipe_timing(int kernel_size, int input_channels, int adder_levels_per_stage)
+{
+    if (kernel_size <= 0 || input_channels <= 0 || adder_levels_per_stage < 0)
+    {
+        throw std::runtime_error("Invalid mult_acc_pipe parameters.");
+    }
+    MacPipelineTiming timing;
+    timing.tree_depth = ceil_log2(input_channels * kernel_size * kernel_size);
+    timing.tree_stages = adder_levels_per_stage == 0
+                             ? 0
+                             : (timing.tree_depth + adder_levels_per_stage - 1) / adder_levels_per_stage;
+    timing.latency = 2 + timing.tree_stages;
+    timing.critical_path_adders = adder_levels_per_stage == 0 ? timing.tree_depth
+                                                              : std::min(adder_levels_per_stage, timing.tree_depth);
+    return timing;
+}
+
+int mult_acc_comb_chain_adders(int kernel_size, int input_channels)
+{
+    const int per_channel = kernel_size * kernel_size - 1;
+    const int cross_channel = input_channels - 1;
+    return per_channel + cross_channel;
+}
+
+MacPipelineModel::MacPipelineModel(const FixedPointLayer &layer, int out_c, int adder_levels_per_stage)
+    : layer_(layer),
+      out_c_(out_c),
+      timing_(mult_acc_pipe_timing(layer.kernel_size, layer.input_channels, adder_levels_per_stage))
+{
+    if (out_c < 0 || out_c >= layer.output_channels)
+    {
+        throw std::runtime_error("Output channel out of range.");
+    }
+    Output idle = {false, 0};
+    // The output register is the last stage; latency - 1 edges separate sampling from it
+    in_flight_.assign(timing_.latency - 1, idle);
+}
+
+MacPipelineModel::Output MacPipelineModel::clock(bool window_valid, const std::vector<std::uint32_t> &window)
+{
+    Output sampled = {false, 0};
+    if (window_valid)
+    {
+        const size_t filter_size = static_cast<size_t>(layer_.input_channels) * layer_.kernel_size * layer_.kernel_size;
+        if (window.size() != filter_size)
+        {
+            throw std::runtime_error("Window size does not match the layer.");
+        }
+        // The tree adds in another order than fixed_point_forward, but exact integer sums agree
+        const std::uint8_t *filter = layer_.weights.data() + out_c_ * filter_size;
+        std::int64_t sum = 0;
+        for (size_t n = 0; n < filter_size; ++n)
+        {
+            sum += static_cast<std::int64_t>(window[n]) * filter[n];
+        }
+        sampled.valid = true;
+        sampled.value = biased_output(layer_, out_c_, sum);
+    }
+    in_flight_.push_back(sampled);
+    Output output = in_flight_.front();
+    in_flight_.pop_front();
+    return output;
+}
+
+MacFoldTiming mult_acc_fold_timing(int kernel_size, int input_channels, int num_filters,
+                                   int channel_parallelism, int filter_parallelism)
+{
+    if (kernel_size <= 0 || input_channels <= 0 || num_filters <= 0 || channel_parallelism <= 0 ||
+        channel_parallelism > input_channels || filter_parallelism <= 0 || filter_parallelism > num_filters)
+    {
+        throw std::runtime_error("Invalid mult_acc_fold parameters.");
+    }
+    const int taps = kernel_size * kernel_size;
+    MacFoldTiming timing;
+    timing.channel_passes = (input_channels + channel_parallelism - 1) / channel_parallelism;
+    timing.filter_passes = (num_filters + filter_parallelism - 1) / filter_parallelism;
+    timing.cycles_per_window = timing.channel_passes * timing.filter_passes;
+    // Sampled into window_hold, one edge per pass, the last of which sets conv_valid
+    timing.latency = timing.cycles_per_window + 1;
+    timing.multipliers = filter_parallelism * channel_parallelism * taps;
+    timing.unfolded_multipliers = num_filters * input_channels * taps;
+    return timing;
+}
+
+MacFoldModel::MacFoldModel(const FixedPointLayer &layer, int channel_parallelism, int filter_parallelism)
+    : layer_(layer),
+      channel_parallelism_(channel_parallelism),
+      filter_parallelism_(filter_parallelism),
+      timing_(mult_acc_fold_timing(layer.kernel_size, layer.input_channels, layer.output_channels,
+                                   channel_parallelism, filter_parallelism)),
+      busy_(false),
+      channel_pass_(0),
+      filter_pass_(0),
+      accumulators_(filter_parallelism, 0)
+{
+    output_.valid = false;
+    output_.values.assign(layer.output_channels, 0);
+}
+
+bool MacFoldModel::ready() const
+{
+    return !busy_ || (channel_pass_ == timing_.channel_passes - 1 && filter_pass_ == timing_.filter_passes - 1);
+}
+
+const MacFoldModel::Output &MacFoldModel::clock(bool window_valid, const std::vector<std::uint32_t> &window)
+{
+    const int taps = layer_.kernel_size * layer_.kernel_size;
+    const size_t filter_size = static_cast<size_t>(layer_.input_channels) * taps;
+    const bool accept = window_valid && ready();
+    if (accept && window.size() != filter_size)
+    {
+        throw std::runtime_error("Window size does not match the layer.");
+    }
+
+    // One pass: filter_parallelism filters times channel_parallelism channels of the held window
+    const bool last_channel_pass = channel_pass_ == timing_.channel_passes - 1;
+    const bool last_pass = last_channel_pass && filter_pass_ == timing_.filter_passes - 1;
+    output_.valid = busy_ && last_pass;
+    if (busy_)
+    {
+        for (int lane = 0; lane < filter_parallelism_; ++lane)
+        {
+            // Filters and channels past the end of the layer (an uneven last pass) add nothing
+            const int f = filter_pass_ * filter_parallelism_ + lane;
+            if (f >= layer_.output_channels)
+            {
+                continue;
+            }
+            std::int64_t sum = channel_pass_ == 0 ? 0 : accumulators_[lane];
+            const int first_channel = channel_pass_ * channel_parallelism_;
+            const int end_channel = std::min(first_channel + channel_parallelism_, layer_.input_channels);
+            for (int c = first_channel; c < end_channel; ++c)
+            {
+                const std::uint8_t *weights = layer_.weights.data() + f * filter_size + c * taps;
+                for (int t = 0; t < taps; ++t)
+                {
+                    sum += static_cast<std::int64_t>(window_[c * taps + t]) * weights[t];
+                }
+            }
+            accumulators_[lane] = sum;
+            if (last_channel_pass)
+            {
+                output_.values[f] = biased_output(layer_, f, sum);
+            }
+        }
+        if (last_channel_pass)
+        {
+            channel_pass_ = 0;
+            filter_pass_ = last_pass ? 0 : filter_pass_ + 1;
+        }
+        else
+        {
+            ++channel_pass_;
+        }
+    }
+    if (accept)
+    {
+        window_ = window;
+        busy_ = true;
+    }
+    else if (last_pass)
+    {
+        busy_ = false;
+    }
+    return output_;
+}
+
+ConvStreamTiming simulate_conv_stream(const ConvStreamConfiguration &configuration)
+{
+    if (configuration.mac_latency < 0 || configuration.mac_cycles_per_window <= 0)
+    {
+        throw std::runtime_error("Invalid conv stream parameters.");
+    }
+    const int width = configuration.image_width;
+    const int lanes = configuration.pixels_per_clock;
+    const int interval = configuration.mac_cycles_per_window;
+    // Timing does not depend on pixel values or the border mode
+    WindowConfiguration window_configuration = {width, configuration.image_height, configuration.kernel_size,
+                                                configuration.stride, BorderMode::ZERO, lanes};
+    WindowStreamModel window(window_configuration);
+
+    ConvStreamTiming timing = {0, 0, 0, 0, -1, 0, 0.0};
+    const long long input_beats = static_cast<long long>(width / lanes) * configuration.image_height;
+    const long long cycle_limit = (2 * input_beats + 4 * (width + configuration.kernel_size)) * interval + 256;
+    const std::vector<std::uint32_t> pixels(lanes, 0);
+    long long last_output_cycle = -1;
+    long long next_accept_cycle = 0; // the MAC is ready from this edge on
+    long long next_beat_cycle = 1;   // the driver raises pixel_valid from this edge on
+    long long beats = 0;             // beats taken by window.v
+    long long last_input_cycle = 0;
+    bool window_valid = false;       // window.v outputs before the edge
+    long long window_lanes = 0;
+    long long cycle = 0;
+    for (; cycle < cycle_limit; ++cycle)
+    {
+        // The MAC samples the window on this edge; conv_valid follows mac_latency - 1 edges later
+        // (on the window's own edge for mult_acc_comb)
+        const bool mac_ready = cycle >= next_accept_cycle;
+        if (window_valid && mac_ready)
+        {
+            const long long output_cycle = cycle + configuration.mac_latency - 1;
+            ++timing.output_beats;
+            timing.outputs += window_lanes;
+            last_output_cycle = output_cycle;
+            if (timing.first_output_cycle < 0)
+            {
+                timing.first_output_cycle = output_cycle;
+            }
+            next_accept_cycle = cycle + interval;
+        }
+        // A beat is held until pixel_ready; the next one follows interval cycles after it is taken
+        const bool pixel_valid = cycle >= next_beat_cycle && beats < input_beats;
+        if (pixel_valid && window.pixel_ready())
+        {
+            ++beats;
+            last_input_cycle = cycle;
+            next_beat_cycle = cycle + interval;
+        }
+        const WindowStreamModel::Output &output = window.clock(cycle == 0, pixel_valid, pixels, window_valid && !mac_ready);
+        window_valid = output.window_valid;
+        window_lanes = std::count(output.lane_valid.begin(), output.lane_valid.end(), true);
+        if (cycle > 0 && window.idle() && !window_valid)
+        {
+            break;
+        }
+    }
+    if (cycle == cycle_limit)
+    {
+        throw std::runtime_error("window.v does not finish the frame for these parameters.");
+    }
+
+    timing.input_beats = input_beats;
+    timing.input_cycles = last_input_cycle;
+    timing.frame_cycles = std::max(last_output_cycle, timing.input_cycles) + 1;
+    timing.outputs_per_cycle = static_cast<double>(timing.outputs) / timing.frame_cycles;
+    return timing;
+}
+
+WeightLoadTiming weight_load_timing(const WeightLoadConfiguration &configuration)
+{
+    if (configuration.kernel_size <= 0 || configuration.input_channels <= 0 || configuration.num_filters <= 0 ||
+        configuration.weights_per_read <= 0)
+    {
+        throw std::runtime_error("Invalid weight load parameters.");
+    }
+    const long long weights_per_filter =
+        static_cast<long long>(configuration.input_channels) * configuration.kernel_size * configuration.kernel_size;
+    const long long bank_weights = weights_per_filter * configuration.num_filters;
+
+    WeightLoadTiming timing;
+    // IDLE raises read_enable, weight.v starts a cycle later, reads one weight per cycle, raises
+    // weight_valid, then conv.v copies the filters and sets weights_loaded on the next edge
+    timing.single_buffer_load_cycles = weights_per_filter + 5;
+    timing.single_buffer_switch_cycles = 1 + timing.single_buffer_load_cycles;
+    timing.bank_load_beats = (bank_weights + configuration.weights_per_read - 1) / configuration.weights_per_read;
+    // load_start, load_busy, the beats, then the promotion (initial) or the next frame_start (prefetch)
+    timing.bank_initial_cycles = timing.bank_load_beats + 3;
+    timing.bank_prefetch_cycles = timing.bank_load_beats + 2;
+    return timing;
+}
+
+LayerScheduleTiming simulate_layer_schedule(const ConvStreamConfiguration &stream,
+                                            const WeightLoadConfiguration &weights, int layers)
+{
+    if (layers <= 0)
+    {
+        throw std::runtime_error("Invalid layer count.");
+    }
+    const ConvStreamTiming frame = simulate_conv_stream(stream);
+    const WeightLoadTiming load = weight_load_timing(weights);
+    if (load.bank_prefetch_cycles > frame.input_beats)
+    {
+        throw std::runtime_error("The weight set load does not fit in a frame; increase weights_per_read.");
+    }
+
+    LayerScheduleTiming timing;
+    timing.frame_cycles = frame.frame_cycles;
+    // The next frame_start is sampled one edge after the driver sees the last output
+    const long long frame_interval = frame.frame_cycles + 1;
+    timing.single_buffer_stall_cycles = (layers - 1) * load.single_buffer_switch_cycles;
+    timing.single_buffer_cycles = (layers - 1) * frame_interval + timing.single_buffer_stall_cycles + frame.frame_cycles;
+
+    // Edges relative to the first frame_start: the active bank was promoted on the edge before it
+    long long frame_start_edge = 0;
+    long long promote_edge = -1;
+    timing.double_buffer_stall_cycles = 0;
+    for (int layer = 1; layer < layers; ++layer)
+    {
+        // shadow_ready (frame_ready) rises on this edge; the driver's frame_start is sampled on
+        // the next one at the earliest, and the swap takes effect on that edge
+        const long long ready_edge = promote_edge + load.bank_prefetch_cycles;
+        const long long earliest_edge = frame_start_edge + frame_interval;
+        frame_start_edge = std::max(earliest_edge, ready_edge + 1);
+        promote_edge = frame_start_edge;
+        timing.double_buffer_stall_cycles += frame_start_edge - earliest_edge;
+    }
+    timing.double_buffer_cycles = frame_start_edge + frame.frame_cycles;
+    timing.saved_cycles = timing.single_buffer_cycles - timing.double_buffer_cycles;
+    return timing;
+}
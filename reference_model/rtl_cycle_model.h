@@ -0,0 +1,183 @@
+#ifndef RTL_CYCLE_MODEL_H
+#define RTL_CYCLE_MODEL_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "batch_norm_folding.h"
+#include "window_model.h"
+
+// Cycle-level models of the modules in rtl_model/. Values are bit-exact with
+// fixed_point_forward; these models add when each value appears.
+
+// Register and adder layout of mult_acc_pipe.v
+struct MacPipelineTiming
+{
+    int tree_depth;           // adder levels of the balanced tree, $clog2(in_c * k * k)
+    int tree_stages;          // pipeline registers inside the tree
+    int latency;              // cycles from window_valid to conv_valid: products, tree_stages, output
+    int critical_path_adders; // adders between two registers
+};
+
+// adder_levels_per_stage as in ADDER_LEVELS_PER_STAGE; 0 keeps the whole tree combinational
+MacPipelineTiming mult_acc_pipe_timing(int kernel_size, int input_channels, int adder_levels_per_stage);
+
+// Adders in series in mult_acc_comb.v: the per-channel chain (one 9-input sum for 3x3) followed
+// by the cross-channel chain. Latency is 0 cycles; this is the depth the pipeline removes.
+int mult_acc_comb_chain_adders(int kernel_size, int input_channels);
+
+// One mult_acc_pipe instance (output channel out_c of the layer), clocked one edge at a time.
+// The window holds in_c * k * k pixels in multi_channel_window_in order: channel-major, each
+// channel in window_buffer (row-major) order, the order of FixedPointLayer::weights.
+// The layer must outlive the model.
+class MacPipelineModel
+{
+public:
+    MacPipelineModel(const FixedPointLayer &layer, int out_c, int adder_levels_per_stage);
+
+    struct Output
+    {
+        bool valid;           // conv_valid
+        std::uint32_t value;  // conv_out, 0 when not valid
+    };
+
+    // One rising clock edge sampling (window_valid, window); returns the outputs after the edge.
+    // Throws if a valid window has the wrong size.
+    Output clock(bool window_valid, const std::vector<std::uint32_t> &window);
+
+    const MacPipelineTiming &timing() const { return timing_; }
+
+private:
+    const FixedPointLayer &layer_;
+    int out_c_;
+    MacPipelineTiming timing_;
+    std::deque<Output> in_flight_; // latency entries, the front leaves on the next edge
+};
+
+// Register and multiplier layout of mult_acc_fold.v (MAC_CHANNEL_PARALLELISM and
+// MAC_FILTER_PARALLELISM of conv.v): per pixel lane, filter_parallelism accumulators each add
+// channel_parallelism channels of k * k products per cycle, so a window of every filter takes
+// channel_passes * filter_passes cycles and is accepted once per that many cycles
+struct MacFoldTiming
+{
+    int channel_passes;       // CHANNEL_PASSES, ceil(in_c / channel_parallelism)
+    int filter_passes;        // FILTER_PASSES, ceil(num_filters / filter_parallelism)
+    int cycles_per_window;    // CYCLES_PER_WINDOW: the initiation interval
+    int latency;              // cycles from window_valid to conv_valid as counted for mult_acc_pipe: passes, output
+    int multipliers;          // filter_parallelism * channel_parallelism * k * k
+    int unfolded_multipliers; // num_filters * in_c * k * k: one mult_acc_comb per filter
+};
+
+// Throws for invalid parameters; parallelism runs from 1 to in_c and to num_filters
+MacFoldTiming mult_acc_fold_timing(int kernel_size, int input_channels, int num_filters,
+                                   int channel_parallelism, int filter_parallelism);
+
+// One mult_acc_fold instance (every output channel of the layer), clocked one edge at a time.
+// Windows are ordered as for MacPipelineModel; the weights are assumed loaded.
+// The layer must outlive the model.
+class MacFoldModel
+{
+public:
+    MacFoldModel(const FixedPointLayer &layer, int channel_parallelism, int filter_parallelism);
+
+    struct Output
+    {
+        bool valid;                        // conv_valid
+        std::vector<std::uint32_t> values; // conv_out per output channel, held between windows
+    };
+
+    // ready: a valid window is accepted on the next edge (idle, or in the last pass)
+    bool ready() const;
+
+    // One rising clock edge sampling (window_valid, window); returns the outputs after the edge.
+    // Throws if an accepted window has the wrong size.
+    const Output &clock(bool window_valid, const std::vector<std::uint32_t> &window);
+
+    bool idle() const { return !busy_; }
+    const MacFoldTiming &timing() const { return timing_; }
+
+private:
+    const FixedPointLayer &layer_;
+    int channel_parallelism_, filter_parallelism_;
+    MacFoldTiming timing_;
+    bool busy_;
+    int channel_pass_, filter_pass_;
+    std::vector<std::uint32_t> window_;      // window_hold
+    std::vector<std::int64_t> accumulators_; // one per filter lane
+    Output output_;
+};
+
+// One frame through conv.v: frame_start on cycle 0, then one pixel_in beat of
+// pixels_per_clock adjacent pixels on every mac_cycles_per_window-th following cycle, each held
+// until pixel_ready
+struct ConvStreamConfiguration
+{
+    int image_width;           // IMG_WIDTH, a multiple of pixels_per_clock
+    int image_height;          // IMG_HEIGHT
+    int kernel_size;           // KERNEL_SIZE
+    int stride;                // STRIDE
+    int pixels_per_clock;      // PIXELS_PER_CLOCK
+    int mac_latency;           // 0 for mult_acc_comb, MacPipelineTiming::latency or MacFoldTiming::latency
+    int mac_cycles_per_window; // 1, or MacFoldTiming::cycles_per_window; window.v stalls while the MAC is busy
+};
+
+struct ConvStreamTiming
+{
+    long long input_beats;        // cycles with pixel_valid, IMG_WIDTH / PIXELS_PER_CLOCK * IMG_HEIGHT
+    long long input_cycles;       // frame_start to the last input beat taken
+    long long output_beats;       // cycles with conv_valid
+    long long outputs;            // output positions (valid lanes summed over beats)
+    long long first_output_cycle; // cycle whose rising edge first sets conv_valid
+    long long frame_cycles;       // frame_start to the later of the last input beat and the last conv_valid
+    double outputs_per_cycle;     // outputs / frame_cycles
+};
+
+// Cycle-by-cycle replay of window.v (WindowStreamModel: a beat of windows as soon as the block
+// RAM reader has fetched its columns), held while the MAC is busy, followed by the MAC latency.
+// Throws for invalid parameters or if the frame would never finish.
+ConvStreamTiming simulate_conv_stream(const ConvStreamConfiguration &configuration);
+
+// Weight loading in conv.v. The single buffer has one weight.v ROM per filter reading one weight
+// per cycle behind the WEIGHT_IDLE/LOADING/DONE state machine, which only runs after reset.
+// The double buffer (WEIGHT_DOUBLE_BUFFER = 1) is weight_bank.v: one ROM holding every weight set,
+// read weights_per_read weights per cycle into the shadow bank while the active bank computes.
+struct WeightLoadConfiguration
+{
+    int kernel_size;      // KERNEL_SIZE
+    int input_channels;   // IN_CHANNEL
+    int num_filters;      // NUM_FILTERS
+    int weights_per_read; // WEIGHTS_PER_READ of weight_bank.v
+};
+
+struct WeightLoadTiming
+{
+    long long single_buffer_load_cycles;   // reset release to weights_loaded, in_c * k * k + 5
+    long long single_buffer_switch_cycles; // one reset cycle plus the reload: the stall of a layer switch
+    long long bank_load_beats;             // LOAD_BEATS: ROM reads per weight set
+    long long bank_initial_cycles;         // reset release to weights_loaded with the double buffer
+    long long bank_prefetch_cycles;        // swap edge to shadow_ready of the next set
+};
+
+// Throws for invalid parameters
+WeightLoadTiming weight_load_timing(const WeightLoadConfiguration &configuration);
+
+// layers frames through conv.v, one weight set each, as driven by conv_layer_switch_tb.v:
+// frame_start one cycle after the last output of the previous frame, or later if frame_ready
+// is still low, and frame 0 starts the cycle after weights_loaded. Cycles run from the first
+// frame_start to the last output.
+struct LayerScheduleTiming
+{
+    long long frame_cycles;               // ConvStreamTiming::frame_cycles of one frame
+    long long single_buffer_cycles;       // reset and reload before every frame after the first
+    long long single_buffer_stall_cycles; // cycles in reset or with weights_loaded low
+    long long double_buffer_cycles;       // prefetch during the frame, swap at frame_start; includes the waits
+    long long double_buffer_stall_cycles; // cycles frame_start waited for frame_ready, 0 when the load is hidden
+    long long saved_cycles;               // single_buffer_cycles - double_buffer_cycles
+};
+
+// Throws for invalid parameters, including a weight set load (bank_prefetch_cycles) longer than
+// the input beats of a frame, which conv.v rejects at elaboration.
+LayerScheduleTiming simulate_layer_schedule(const ConvStreamConfiguration &stream,
+                                            const WeightLoadConfiguration &weights, int layers);
+
+#endif // RTL_CYCLE_MODEL_H
@@ -0,0 +1,155 @@
+#include "tensor_io.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+const char TENSOR_MAGIC[4] = {'C', 'N', 'N', 'T'};
+
+void put_u32(unsigned char *destination, std::uint32_t value)
+{
+    for (int b = 0; b < 4; ++b)
+        destination[b] = static_cast<unsigned char>(value >> (8 * b));
+}
+
+std::uint32_t get_u32(const unsigned char *source)
+{
+    std::uint32_t value = 0;
+    for (int b = 0; b < 4; ++b)
+        value |= static_cast<std::uint32_t>(source[b]) << (8 * b);
+    return value;
+}
+
+std::size_t checked_multiply(std::size_t a, std::size_t b)
+{
+    if (b != 0 && a > std::numeric_limits<std::size_t>::max() / b)
+    {
+        throw std::runtime_error("Tensor is too large: size overflows");
+    }
+    return a * b;
+}
+} // namespace
+
+std::vector<unsigned char> encode_tensor(const std::vector<std::vector<std::vector<float>>> &image)
+{
+    TensorShape shape = {static_cast<std::uint32_t>(image.size()),
+                         static_cast<std::uint32_t>(image.empty() ? 0 : image[0].size()),
+                         static_cast<std::uint32_t>(image.empty() || image[0].empty() ? 0 : image[0][0].size())};
+
+    std::vector<unsigned char> bytes(TENSOR_HEADER_BYTES + tensor_payload_bytes(shape));
+    std::memcpy(bytes.data(), TENSOR_MAGIC, sizeof(TENSOR_MAGIC));
+    put_u32(&bytes[4], shape.channels);
+    put_u32(&bytes[8], shape.height);
+    put_u32(&bytes[12], shape.width);
+
+    unsigned char *cursor = bytes.data() + TENSOR_HEADER_BYTES;
+    for (const auto &channel : image)
+    {
+        if (channel.size() != shape.height)
+            throw std::runtime_error("Cannot encode tensor: channels differ in height");
+        for (const auto &row : channel)
+        {
+            if (row.size() != shape.width)
+                throw std::runtime_error("Cannot encode tensor: rows differ in width");
+            for (float value : row)
+            {
+                std::uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                put_u32(cursor, bits);
+                cursor += 4;
+            }
+        }
+    }
+    return bytes;
+}
+
+TensorShape decode_tensor_header(const unsigned char *header)
+{
+    if (std::memcmp(header, TENSOR_MAGIC, sizeof(TENSOR_MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a tensor: bad magic");
+    }
+    TensorShape shape = {get_u32(header + 4), get_u32(header + 8), get_u32(header + 12)};
+    if (shape.channels == 0 || shape.height == 0 || shape.width == 0)
+    {
+        throw std::runtime_error("Not a tensor: zero dimension");
+    }
+    return shape;
+}
+
+std::size_t tensor_element_count(const TensorShape &shape)
+{
+    return checked_multiply(checked_multiply(shape.channels, shape.height), shape.width);
+}
+
+std::size_t tensor_payload_bytes(const TensorShape &shape)
+{
+    return checked_multiply(tensor_element_count(shape), 4);
+}
+
+std::vector<std::vector<std::vector<float>>> decode_tensor_payload(const TensorShape &shape, const unsigned char *payload)
+{
+    std::vector<std::vector<std::vector<float>>> image(
+        shape.channels, std::vector<std::vector<float>>(shape.height, std::vector<float>(shape.width)));
+    for (auto &channel : image)
+        for (auto &row : channel)
+            for (float &value : row)
+            {
+                std::uint32_t bits = get_u32(payload);
+                std::memcpy(&value, &bits, sizeof(value));
+                payload += 4;
+            }
+    return image;
+}
+
+void save_tensor(const std::vector<std::vector<std::vector<float>>> &image, const std::string &path)
+{
+    std::vector<unsigned char> bytes = encode_tensor(image);
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("Cannot create tensor file: " + path);
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to write tensor file: " + path);
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> load_tensor(const std::string &path)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throw std::runtime_error("Cannot open tensor file: " + path);
+    }
+    unsigned char header[TENSOR_HEADER_BYTES];
+    if (std::fread(header, 1, sizeof(header), file) != sizeof(header))
+    {
+        std::fclose(file);
+        throw std::runtime_error("Tensor file is truncated: " + path);
+    }
+    TensorShape shape;
+    std::vector<unsigned char> payload;
+    try
+    {
+        shape = decode_tensor_header(header);
+        payload.resize(tensor_payload_bytes(shape));
+    }
+    catch (...)
+    {
+        std::fclose(file);
+        throw;
+    }
+    bool ok = std::fread(payload.data(), 1, payload.size(), file) == payload.size();
+    std::fclose(file);
+    if (!ok)
+    {
+        throw std::runtime_error("Tensor file is truncated: " + path);
+    }
+    return decode_tensor_payload(shape, payload.data());
+}
@@ -0,0 +1,40 @@
+#ifndef TENSOR_IO_H
+#define TENSOR_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary tensor format for CHW float images:
+//   bytes 0-3   magic "CNNT"
+//   bytes 4-15  channels, height, width as little-endian uint32
+//   bytes 16-   channels*height*width IEEE-754 float32 values, little-endian, CHW order
+// The same framing is used for files and for requests and responses on the inference server.
+struct TensorShape
+{
+    std::uint32_t channels;
+    std::uint32_t height;
+    std::uint32_t width;
+};
+
+const std::size_t TENSOR_HEADER_BYTES = 16;
+
+std::vector<unsigned char> encode_tensor(const std::vector<std::vector<std::vector<float>>> &image);
+
+// Parse the first TENSOR_HEADER_BYTES bytes. Throws std::runtime_error on a bad magic or a
+// zero dimension.
+TensorShape decode_tensor_header(const unsigned char *header);
+
+// channels * height * width, and that times 4. Throw std::runtime_error if the product
+// overflows size_t.
+std::size_t tensor_element_count(const TensorShape &shape);
+std::size_t tensor_payload_bytes(const TensorShape &shape);
+
+// Rebuild the image from tensor_payload_bytes(shape) bytes of payload
+std::vector<std::vector<std::vector<float>>> decode_tensor_payload(const TensorShape &shape, const unsigned char *payload);
+
+void save_tensor(const std::vector<std::vector<std::vector<float>>> &image, const std::string &path);
+std::vector<std::vector<std::vector<float>>> load_tensor(const std::string &path);
+
+#endif // TENSOR_IO_H
@@ -0,0 +1,116 @@
+#include "thread_pool.h"
+#include <algorithm> // For std::min
+#include <stdexcept> // For std::runtime_error
+
+ThreadPool::ThreadPool(int num_threads, std::size_t max_in_flight, ThreadAffinity affinity) : max_in_flight_(max_in_flight),
+                                                                                              in_flight_(0),
+                                                                                              stopping_(false)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0)
+        {
+            num_threads = 1;
+        }
+    }
+    if (max_in_flight == 0)
+    {
+        throw std::runtime_error("Thread pool in-flight limit must be positive.");
+    }
+
+    workers_.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i)
+    {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i, affinity);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    slot_available_.notify_all();
+    // Workers drain the remaining queue before exiting, so no future is left unsatisfied
+    for (std::thread &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::shared_default()
+{
+    static std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>();
+    return pool;
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int begin, int end)> &body)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const int chunks = std::min(count, size());
+    std::vector<std::future<void>> results;
+    results.reserve(chunks);
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        int begin = static_cast<int>(static_cast<long long>(count) * chunk / chunks);
+        int end = static_cast<int>(static_cast<long long>(count) * (chunk + 1) / chunks);
+        results.push_back(submit([&body, begin, end]() { body(begin, end); }));
+    }
+    for (std::future<void> &result : results)
+    {
+        result.wait();
+    }
+    for (std::future<void> &result : results)
+    {
+        result.get();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_available_.wait(lock, [this]() { return stopping_ || in_flight_ < max_in_flight_; });
+    if (stopping_)
+    {
+        throw std::runtime_error("Cannot submit to a thread pool that is shutting down.");
+    }
+    ++in_flight_;
+    tasks_.push_back(std::move(task));
+    lock.unlock();
+    task_available_.notify_one();
+}
+
+void ThreadPool::worker_loop(int worker_index, ThreadAffinity affinity)
+{
+    place_current_thread(worker_index, affinity);
+
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return; // stopping and drained
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task(); // packaged_task stores any exception in its future
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --in_flight_;
+        }
+        slot_available_.notify_one();
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cpu_topology.h"
+
+// Fixed-size worker pool with a bounded number of in-flight tasks.
+// submit() blocks once max_in_flight tasks are queued or running, which gives producers
+// natural backpressure instead of an unbounded backlog.
+class ThreadPool
+{
+public:
+    // num_threads <= 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(int num_threads = 0, std::size_t max_in_flight = 64, ThreadAffinity affinity = ThreadAffinity::NONE);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Queue a callable and return a future for its result. Exceptions thrown by the
+    // callable are rethrown from future::get().
+    template <typename Function>
+    auto submit(Function function) -> std::future<decltype(function())>;
+
+    // Static split: [0, count) is cut into size() contiguous chunks of equal length and
+    // body(begin, end) runs once per chunk on the pool. Blocks until all chunks finish and
+    // rethrows the first exception. Must not be called from a task running on this pool.
+    void parallel_for(int count, const std::function<void(int begin, int end)> &body);
+
+    int size() const { return static_cast<int>(workers_.size()); }
+    std::size_t max_in_flight() const { return max_in_flight_; }
+
+    // Pool shared by every ConvolutionLayer without an explicitly assigned pool
+    static std::shared_ptr<ThreadPool> shared_default();
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable slot_available_;
+    std::size_t max_in_flight_;
+    std::size_t in_flight_; // queued + running
+    bool stopping_;
+
+    void enqueue(std::function<void()> task);
+    void worker_loop(int worker_index, ThreadAffinity affinity);
+};
+
+template <typename Function>
+auto ThreadPool::submit(Function function) -> std::future<decltype(function())>
+{
+    typedef decltype(function()) Result;
+
+    // std::function requires a copyable target, so the move-only packaged_task is shared
+    std::shared_ptr<std::packaged_task<Result()>> task =
+        std::make_shared<std::packaged_task<Result()>>(std::move(function));
+    std::future<Result> result = task->get_future();
+    enqueue([task]() { (*task)(); });
+    return result;
+}
+
+#endif // THREAD_POOL_H
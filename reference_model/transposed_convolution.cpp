@@ -0,0 +1,229 @@
+#include "transposed_convolution.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // A kernel tap that reaches one output row (or column) and the input row (or column) it reads
+    struct Tap
+    {
+        int kernel;
+        int input;
+    };
+
+    // Taps reaching every output position along one dimension, highest kernel index first
+    // (the order the flipped-kernel convolution of the reference sums them in)
+    std::vector<std::vector<Tap>> phase_taps(int output_size, int input_size, int padding, int kernel_size, int stride)
+    {
+        std::vector<std::vector<Tap>> taps(output_size);
+        for (int out = 0; out < output_size; ++out)
+        {
+            int phase = (out + padding) % stride;
+            if (phase >= kernel_size)
+            {
+                continue; // only possible when stride > kernel_size: nothing lands here
+            }
+            int first = phase + (kernel_size - 1 - phase) / stride * stride;
+            for (int k = first; k >= 0; k -= stride)
+            {
+                int in = (out + padding - k) / stride;
+                if (in >= 0 && in < input_size)
+                {
+                    Tap tap = {k, in};
+                    taps[out].push_back(tap);
+                }
+            }
+        }
+        return taps;
+    }
+}
+
+TransposedConvolutionLayer::TransposedConvolutionLayer(
+    int kernel_size,
+    int stride,
+    PaddingMode padding_mode,
+    int input_channels,
+    int output_channels,
+    const std::vector<std::vector<std::vector<std::vector<float>>>> &kernel_weights) : kernel_size_(kernel_size),
+                                                                                      stride_(stride),
+                                                                                      padding_mode_(padding_mode),
+                                                                                      input_channels_(input_channels),
+                                                                                      output_channels_(output_channels)
+{
+    if (kernel_size <= 0 || stride <= 0 || input_channels <= 0 || output_channels <= 0)
+    {
+        throw std::runtime_error("Kernel size, stride and channel counts must be positive.");
+    }
+    if (kernel_weights.size() != static_cast<size_t>(input_channels))
+    {
+        throw std::runtime_error("Mismatch between input_channels and kernel_weights first dimension.");
+    }
+    packed_weights_.reserve(static_cast<size_t>(input_channels) * output_channels * kernel_size * kernel_size);
+    for (const auto &in_filters : kernel_weights)
+    {
+        if (in_filters.size() != static_cast<size_t>(output_channels))
+        {
+            throw std::runtime_error("Mismatch between output_channels and kernel_weights second dimension.");
+        }
+        for (const auto &kernel : in_filters)
+        {
+            if (kernel.size() != static_cast<size_t>(kernel_size))
+            {
+                throw std::runtime_error("Mismatch between kernel_size and kernel_weights third dimension.");
+            }
+            for (const auto &kernel_row : kernel)
+            {
+                if (kernel_row.size() != static_cast<size_t>(kernel_size))
+                {
+                    throw std::runtime_error("Mismatch between kernel_size and kernel_weights fourth dimension.");
+                }
+                packed_weights_.insert(packed_weights_.end(), kernel_row.begin(), kernel_row.end());
+            }
+        }
+    }
+}
+
+ConvolutionGeometry TransposedConvolutionLayer::compute_geometry(int input_height, int input_width) const
+{
+    if (input_height <= 0 || input_width <= 0)
+    {
+        throw std::runtime_error("Input dimensions must be positive.");
+    }
+
+    ConvolutionGeometry geometry;
+    geometry.input_height = input_height;
+    geometry.input_width = input_width;
+    geometry.padding_h = 0;
+    geometry.padding_w = 0;
+
+    if (padding_mode_ == PaddingMode::VALID)
+    {
+        geometry.output_height = (input_height - 1) * stride_ + kernel_size_;
+        geometry.output_width = (input_width - 1) * stride_ + kernel_size_;
+    }
+    else
+    { // PaddingMode::SAME: crop what the forward convolution of the output would pad
+        geometry.output_height = input_height * stride_;
+        geometry.output_width = input_width * stride_;
+        geometry.padding_h = std::max(0, ((input_height - 1) * stride_ + kernel_size_ - geometry.output_height) / 2);
+        geometry.padding_w = std::max(0, ((input_width - 1) * stride_ + kernel_size_ - geometry.output_width) / 2);
+    }
+    return geometry;
+}
+
+void TransposedConvolutionLayer::validate_input(const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    if (input_image.empty() || input_image[0].empty() || input_image[0][0].empty())
+    {
+        throw std::runtime_error("Input image is empty or has zero dimensions.");
+    }
+    if (input_image.size() != static_cast<size_t>(input_channels_))
+    {
+        throw std::runtime_error("Input image channels mismatch with layer input_channels.");
+    }
+}
+
+std::vector<std::vector<std::vector<float>>> TransposedConvolutionLayer::forward(
+    const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    validate_input(input_image);
+    ConvolutionGeometry geometry = compute_geometry(input_image[0].size(), input_image[0][0].size());
+
+    std::vector<std::vector<Tap>> row_taps = phase_taps(
+        geometry.output_height, geometry.input_height, geometry.padding_h, kernel_size_, stride_);
+    std::vector<std::vector<Tap>> column_taps = phase_taps(
+        geometry.output_width, geometry.input_width, geometry.padding_w, kernel_size_, stride_);
+
+    const int kernel_area = kernel_size_ * kernel_size_;
+    std::vector<std::vector<std::vector<float>>> output_image(
+        output_channels_,
+        std::vector<std::vector<float>>(geometry.output_height, std::vector<float>(geometry.output_width, 0.0f)));
+
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int out_h = 0; out_h < geometry.output_height; ++out_h)
+        {
+            const std::vector<Tap> &rows = row_taps[out_h];
+            for (int out_w = 0; out_w < geometry.output_width; ++out_w)
+            {
+                const std::vector<Tap> &columns = column_taps[out_w];
+                float sum = 0.0f;
+                for (int in_c = 0; in_c < input_channels_; ++in_c)
+                {
+                    const float *kernel = packed_weights_.data() + (static_cast<size_t>(in_c) * output_channels_ + out_c) * kernel_area;
+                    for (const Tap &row : rows)
+                    {
+                        const std::vector<float> &input_row = input_image[in_c][row.input];
+                        for (const Tap &column : columns)
+                        {
+                            sum += input_row[column.input] * kernel[row.kernel * kernel_size_ + column.kernel];
+                        }
+                    }
+                }
+                output_image[out_c][out_h][out_w] = sum;
+            }
+        }
+    }
+    return output_image;
+}
+
+std::vector<std::vector<std::vector<float>>> TransposedConvolutionLayer::forward_zero_stuffing(
+    const std::vector<std::vector<std::vector<float>>> &input_image) const
+{
+    validate_input(input_image);
+    ConvolutionGeometry geometry = compute_geometry(input_image[0].size(), input_image[0][0].size());
+
+    // Stuffed input: sample (h, w) lands at (before_h + h * stride, before_w + w * stride) of an
+    // image sized so that a stride-1 VALID convolution yields exactly the output size
+    const int before_h = kernel_size_ - 1 - geometry.padding_h;
+    const int before_w = kernel_size_ - 1 - geometry.padding_w;
+    std::vector<std::vector<std::vector<float>>> stuffed(
+        input_channels_,
+        std::vector<std::vector<float>>(
+            geometry.output_height + kernel_size_ - 1,
+            std::vector<float>(geometry.output_width + kernel_size_ - 1, 0.0f)));
+    for (int in_c = 0; in_c < input_channels_; ++in_c)
+    {
+        for (int h = 0; h < geometry.input_height; ++h)
+        {
+            int stuffed_h = before_h + h * stride_;
+            if (stuffed_h >= static_cast<int>(stuffed[in_c].size()))
+            {
+                break; // cropped away (SAME)
+            }
+            for (int w = 0; w < geometry.input_width; ++w)
+            {
+                int stuffed_w = before_w + w * stride_;
+                if (stuffed_w >= static_cast<int>(stuffed[in_c][stuffed_h].size()))
+                {
+                    break;
+                }
+                stuffed[in_c][stuffed_h][stuffed_w] = input_image[in_c][h][w];
+            }
+        }
+    }
+
+    const int kernel_area = kernel_size_ * kernel_size_;
+    std::vector<std::vector<std::vector<std::vector<float>>>> flipped(
+        output_channels_,
+        std::vector<std::vector<std::vector<float>>>(
+            input_channels_,
+            std::vector<std::vector<float>>(kernel_size_, std::vector<float>(kernel_size_))));
+    for (int out_c = 0; out_c < output_channels_; ++out_c)
+    {
+        for (int in_c = 0; in_c < input_channels_; ++in_c)
+        {
+            const float *kernel = packed_weights_.data() + (static_cast<size_t>(in_c) * output_channels_ + out_c) * kernel_area;
+            for (int k_h = 0; k_h < kernel_size_; ++k_h)
+            {
+                for (int k_w = 0; k_w < kernel_size_; ++k_w)
+                {
+                    flipped[out_c][in_c][k_h][k_w] = kernel[(kernel_size_ - 1 - k_h) * kernel_size_ + (kernel_size_ - 1 - k_w)];
+                }
+            }
+        }
+    }
+
+    ConvolutionLayer convolution(kernel_size_, 1, PaddingMode::VALID, input_channels_, output_channels_, flipped);
+    return convolution.forward(stuffed);
+}
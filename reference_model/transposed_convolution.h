@@ -0,0 +1,63 @@
+#ifndef TRANSPOSED_CONVOLUTION_H
+#define TRANSPOSED_CONVOLUTION_H
+
+#include <vector>
+#include "convolution.h"
+
+// Transposed convolution (learned upsampling): the adjoint of a ConvolutionLayer with the same
+// kernel size, stride and padding mode whose input and output channels are swapped. Every input
+// pixel is scattered into a kernel_size x kernel_size patch of the output, stride pixels apart.
+// VALID: output = (input - 1) * stride + kernel_size.
+// SAME:  output = input * stride; the full scatter result is cropped by the padding the
+//        forward convolution would use, so SAME convolution and SAME transposed convolution
+//        map the sizes onto each other.
+// Weights use the layout [in_c][out_c][k_h][k_w], i.e. the weights of that forward convolution.
+// The scatter never reads outside the input, so there is no border mode: this is the adjoint of
+// a zero-bordered convolution. For other border modes the adjoint is ConvolutionLayer::backward_data,
+// which folds the padding back onto its source pixels.
+class TransposedConvolutionLayer
+{
+public:
+    TransposedConvolutionLayer(
+        int kernel_size,
+        int stride,
+        PaddingMode padding_mode,
+        int input_channels,
+        int output_channels,
+        const std::vector<std::vector<std::vector<std::vector<float>>>> &kernel_weights);
+
+    // Gather form, decomposed by output phase: an output pixel (y, x) only receives the kernel taps
+    // k_h = (y + padding_h) mod stride, + stride, ... (same for columns), so each output reads
+    // at most ceil(kernel_size / stride)^2 taps per channel and no inserted zero is multiplied.
+    // Bit-identical to forward_zero_stuffing.
+    std::vector<std::vector<std::vector<float>>> forward(
+        const std::vector<std::vector<std::vector<float>>> &input_image) const;
+
+    // Reference: insert stride - 1 zeros between input pixels, pad, and run a stride-1 VALID
+    // ConvolutionLayer with the spatially flipped kernel. Performs stride^2 times the multiplies
+    // of forward (most of them by zero); kept for verification.
+    std::vector<std::vector<std::vector<float>>> forward_zero_stuffing(
+        const std::vector<std::vector<std::vector<float>>> &input_image) const;
+
+    // Output dimensions; padding_h/padding_w are the rows/columns cropped from the top/left of
+    // the full scatter result
+    ConvolutionGeometry compute_geometry(int input_height, int input_width) const;
+
+    int kernel_size() const { return kernel_size_; }
+    int stride() const { return stride_; }
+    PaddingMode padding_mode() const { return padding_mode_; }
+    int input_channels() const { return input_channels_; }
+    int output_channels() const { return output_channels_; }
+
+private:
+    int kernel_size_;
+    int stride_;
+    PaddingMode padding_mode_;
+    int input_channels_;
+    int output_channels_;
+    std::vector<float> packed_weights_; // [in_c][out_c][k_h][k_w]
+
+    void validate_input(const std::vector<std::vector<std::vector<float>>> &input_image) const;
+};
+
+#endif // TRANSPOSED_CONVOLUTION_H
@@ -0,0 +1,324 @@
+#include "window_model.h"
+#include <algorithm>
+#include <stdexcept>
+
+// $clog2: bits needed to index value entries
+static int ceil_log2(int value)
+{
+    int bits = 0;
+    while ((1 << bits) < value)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+std::vector<std::vector<std::uint32_t>> window_model(
+    const WindowConfiguration &configuration,
+    const std::vector<std::vector<std::uint32_t>> &image)
+{
+    const int width = configuration.image_width;
+    const int height = configuration.image_height;
+    const int kernel_size = configuration.kernel_size;
+    const int stride = configuration.stride;
+    if (width <= 0 || height <= 0 || kernel_size <= 0 || stride <= 0)
+    {
+        throw std::runtime_error("Window configuration values must be positive.");
+    }
+    if (configuration.border_mode == BorderMode::CIRCULAR)
+    {
+        throw std::runtime_error("window.v does not support circular padding.");
+    }
+    const int half = kernel_size / 2;
+    if (configuration.border_mode == BorderMode::REFLECT && (half >= width || half >= height))
+    {
+        throw std::runtime_error("Reflect padding must be smaller than the image.");
+    }
+    if (image.size() != static_cast<size_t>(height) || image[0].size() != static_cast<size_t>(width))
+    {
+        throw std::runtime_error("Image size does not match the window configuration.");
+    }
+
+    std::vector<std::vector<std::uint32_t>> windows;
+    windows.reserve(static_cast<size_t>((height + stride - 1) / stride) * ((width + stride - 1) / stride));
+    for (int y = 0; y < height; y += stride)
+    {
+        for (int x = 0; x < width; x += stride)
+        {
+            std::vector<std::uint32_t> window(static_cast<size_t>(kernel_size) * kernel_size);
+            for (int i = 0; i < kernel_size; ++i)
+            {
+                int src_y = border_index(y + i - half, height, configuration.border_mode);
+                for (int j = 0; j < kernel_size; ++j)
+                {
+                    int src_x = border_index(x + j - half, width, configuration.border_mode);
+                    window[i * kernel_size + j] = (src_y >= 0 && src_x >= 0) ? image[src_y][src_x] : 0;
+                }
+            }
+            windows.push_back(window);
+        }
+    }
+    return windows;
+}
+
+WindowBufferLayout window_buffer_layout(const WindowConfiguration &configuration)
+{
+    const int width = configuration.image_width;
+    const int height = configuration.image_height;
+    const int kernel_size = configuration.kernel_size;
+    const int stride = configuration.stride;
+    const int lanes = configuration.pixels_per_clock;
+    if (width <= 0 || height <= 0 || kernel_size <= 0 || stride <= 0 || lanes <= 0)
+    {
+        throw std::runtime_error("Window configuration values must be positive.");
+    }
+    if (width % lanes != 0)
+    {
+        throw std::runtime_error("IMG_WIDTH must be a multiple of PIXELS_PER_CLOCK.");
+    }
+
+    WindowBufferLayout layout;
+    layout.line_rows = kernel_size + 1;
+    layout.line_words = width / lanes;
+    // Words a beat of windows can touch, plus as many again so the reader runs ahead into the next row
+    const int span_words = ((lanes - 1) * stride + kernel_size - 1) / lanes + 2;
+    layout.cache_words = 1 << ceil_log2(2 * span_words + 2);
+    layout.x_bits = ceil_log2(width + lanes * stride + 1);
+    layout.y_bits = ceil_log2(height + stride + kernel_size + 1);
+    layout.coord_bits = ceil_log2(std::max(width, height) + kernel_size + lanes * stride) + 2;
+    return layout;
+}
+
+WindowStreamModel::WindowStreamModel(const WindowConfiguration &configuration)
+    : configuration_(configuration),
+      layout_(window_buffer_layout(configuration)),
+      state_(IDLE),
+      x_pos_(0),
+      y_pos_(0),
+      read_y_(0),
+      read_word_(0),
+      read_valid_(false),
+      cache_head_(0),
+      cache_count_(0),
+      head_word_(0),
+      x_window_(0),
+      y_window_(0)
+{
+    if (configuration.border_mode == BorderMode::CIRCULAR)
+    {
+        throw std::runtime_error("window.v does not support circular padding.");
+    }
+    const int kernel_size = configuration.kernel_size;
+    const int lanes = configuration.pixels_per_clock;
+    line_buffer_.assign(layout_.line_rows, std::vector<std::uint32_t>(configuration.image_width, 0));
+    line_row_.assign(layout_.line_rows, std::vector<int>(layout_.line_words, -1));
+    read_rows_.assign(kernel_size, std::vector<std::uint32_t>(lanes, 0));
+    cache_.assign(layout_.cache_words, read_rows_);
+    output_.window_valid = false;
+    output_.lane_valid.assign(lanes, false);
+    output_.windows.assign(lanes, std::vector<std::uint32_t>(static_cast<size_t>(kernel_size) * kernel_size, 0));
+}
+
+bool WindowStreamModel::pixel_ready() const
+{
+    // A beat overwrites word x_pos_ / lanes of row y_pos_ - line_rows. The reader is done with that
+    // row once read_y_ is past row + half, or on the last read row touching it once past the word.
+    const int half = configuration_.kernel_size / 2;
+    const int old_row = y_pos_ - layout_.line_rows;
+    const bool slot_free = old_row < 0 || read_y_ >= configuration_.image_height || read_y_ > old_row + half ||
+                           (read_y_ + configuration_.stride > old_row + half &&
+                            x_pos_ / configuration_.pixels_per_clock < read_word_);
+    return state_ == IDLE || slot_free;
+}
+
+const WindowStreamModel::Output &WindowStreamModel::clock(bool frame_start, bool pixel_valid,
+                                                          const std::vector<std::uint32_t> &pixels, bool window_stall)
+{
+    const int width = configuration_.image_width;
+    const int height = configuration_.image_height;
+    const int kernel_size = configuration_.kernel_size;
+    const int stride = configuration_.stride;
+    const int lanes = configuration_.pixels_per_clock;
+    const BorderMode border_mode = configuration_.border_mode;
+    const int half = kernel_size / 2;          // taps before the centre
+    const int after = kernel_size - 1 - half;  // taps after the centre
+    const int step = lanes * stride;
+    if (pixel_valid && pixels.size() != static_cast<size_t>(lanes))
+    {
+        throw std::runtime_error("A pixel beat must hold PIXELS_PER_CLOCK pixels.");
+    }
+
+    // Combinational values from the registers before this edge
+    State next_state = state_;
+    if (frame_start)
+    {
+        next_state = LOAD;
+    }
+    else if (state_ == LOAD)
+    {
+        next_state = cache_count_ != 0 ? PROCESS : LOAD;
+    }
+    else if (state_ == PROCESS)
+    {
+        next_state = (y_window_ >= height && x_window_ == 0) ? IDLE : PROCESS;
+    }
+
+    const bool write = pixel_valid && state_ != IDLE && !frame_start && pixel_ready();
+
+    // The reader fetches word read_word_ of window row read_y_ once the last image row it needs holds
+    // it; reflected rows above the image reach down to half - read_y_ (past read_y_ + after for even kernels)
+    const int reflect = border_mode == BorderMode::REFLECT;
+    const int need_row = std::min(std::max(read_y_ + after, reflect ? half - read_y_ : 0), height - 1);
+    const bool available = y_pos_ > need_row || (y_pos_ == need_row && x_pos_ / lanes > read_word_);
+    const bool read = state_ != IDLE && !frame_start && read_y_ < height && available &&
+                      cache_count_ + (read_valid_ ? 1 : 0) < layout_.cache_words;
+
+    // A beat needs the words of its columns; the last beat of a row waits for the whole row so the
+    // words it frees have all arrived
+    const bool last_in_row = x_window_ + step >= width;
+    const int last_column = std::min(std::max(x_window_ + (lanes - 1) * stride + after, reflect ? half - x_window_ : 0), width - 1);
+    const int need_word = last_in_row ? layout_.line_words - 1 : last_column / lanes;
+    const bool output_hold = output_.window_valid && window_stall && !frame_start; // window not taken yet
+    const bool window_ready = !output_hold && !frame_start && state_ == PROCESS && x_window_ < width && y_window_ < height &&
+                              need_word - head_word_ < cache_count_;
+    const int next_x = last_in_row ? 0 : x_window_ + step;
+    const int next_head_word = last_in_row ? 0 : std::min(std::max(0, next_x - half) / lanes, last_column / lanes + 1);
+    const int freed = window_ready ? (last_in_row ? layout_.line_words : next_head_word) - head_word_ : 0;
+
+    // Rising edge: window output from the cache, unless a stalled window is held
+    if (!output_hold)
+    {
+        output_.window_valid = window_ready;
+    }
+    for (int p = 0; p < lanes && !output_hold; ++p)
+    {
+        const bool lane_valid = x_window_ + p * stride < width;
+        output_.lane_valid[p] = window_ready && lane_valid;
+        if (!window_ready)
+        {
+            continue;
+        }
+        for (int j = 0; j < kernel_size; ++j)
+        {
+            const int src_x = border_index(x_window_ + p * stride + j - half, width, border_mode);
+            if (!lane_valid || src_x < 0)
+            {
+                for (int i = 0; i < kernel_size; ++i)
+                {
+                    output_.windows[p][i * kernel_size + j] = 0;
+                }
+                continue;
+            }
+            const int word = src_x / lanes;
+            if (word < head_word_ || word > need_word)
+            {
+                throw std::runtime_error("window.v would read a column outside its window cache.");
+            }
+            const int entry = (cache_head_ + word - head_word_) % layout_.cache_words;
+            for (int i = 0; i < kernel_size; ++i)
+            {
+                output_.windows[p][i * kernel_size + j] = cache_[entry][i][src_x % lanes];
+            }
+        }
+    }
+
+    // Window cache: append the word read on the previous edge, drop the words the next beat no longer needs
+    if (frame_start)
+    {
+        cache_head_ = 0;
+        cache_count_ = 0;
+        head_word_ = 0;
+    }
+    else
+    {
+        if (read_valid_)
+        {
+            cache_[(cache_head_ + cache_count_) % layout_.cache_words] = read_rows_;
+        }
+        cache_count_ += (read_valid_ ? 1 : 0) - freed;
+        cache_head_ = (cache_head_ + freed) % layout_.cache_words;
+        if (window_ready)
+        {
+            head_word_ = next_head_word;
+        }
+    }
+
+    // Block RAM read (before this edge's write: read-first) and reader position
+    if (frame_start)
+    {
+        read_y_ = 0;
+        read_word_ = 0;
+        read_valid_ = false;
+    }
+    else
+    {
+        read_valid_ = read;
+        if (read)
+        {
+            for (int i = 0; i < kernel_size; ++i)
+            {
+                const int src_y = border_index(read_y_ + i - half, height, border_mode);
+                if (src_y < 0)
+                {
+                    std::fill(read_rows_[i].begin(), read_rows_[i].end(), 0);
+                    continue;
+                }
+                const int slot = src_y % layout_.line_rows;
+                if (line_row_[slot][read_word_] != src_y)
+                {
+                    throw std::runtime_error("window.v would read a line buffer word of another row.");
+                }
+                std::copy(line_buffer_[slot].begin() + read_word_ * lanes,
+                          line_buffer_[slot].begin() + (read_word_ + 1) * lanes, read_rows_[i].begin());
+            }
+            if (read_word_ == layout_.line_words - 1)
+            {
+                read_word_ = 0;
+                read_y_ += stride;
+            }
+            else
+            {
+                ++read_word_;
+            }
+        }
+    }
+
+    // Block RAM write and input position
+    if (write)
+    {
+        const int slot = y_pos_ % layout_.line_rows;
+        std::copy(pixels.begin(), pixels.end(), line_buffer_[slot].begin() + x_pos_);
+        line_row_[slot][x_pos_ / lanes] = y_pos_;
+    }
+    if (frame_start)
+    {
+        x_pos_ = 0;
+        y_pos_ = 0;
+    }
+    else if (write)
+    {
+        if (x_pos_ == width - lanes)
+        {
+            x_pos_ = 0;
+            ++y_pos_;
+        }
+        else
+        {
+            x_pos_ += lanes;
+        }
+    }
+
+    if (frame_start)
+    {
+        x_window_ = 0;
+        y_window_ = 0;
+    }
+    else if (window_ready)
+    {
+        x_window_ = next_x;
+        y_window_ += last_in_row ? stride : 0;
+    }
+
+    state_ = next_state;
+    return output_;
+}
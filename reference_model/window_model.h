@@ -0,0 +1,105 @@
+#ifndef WINDOW_MODEL_H
+#define WINDOW_MODEL_H
+
+#include <cstdint>
+#include <vector>
+#include "convolution.h"
+
+// Parameters of rtl_model/window.v
+struct WindowConfiguration
+{
+    int image_width;        // IMG_WIDTH
+    int image_height;       // IMG_HEIGHT
+    int kernel_size;        // KERNEL_SIZE
+    int stride;             // STRIDE
+    BorderMode border_mode; // BORDER_MODE: ZERO (0), REFLECT (1) or REPLICATE (2)
+    int pixels_per_clock;   // PIXELS_PER_CLOCK; IMG_WIDTH must be a multiple of it
+};
+
+// Functional model of window.v for one frame. Windows come in the order the module emits them:
+// centres (y, x) for y, x = 0, STRIDE, 2 * STRIDE, ... row by row, each covering rows and columns
+// [centre - KERNEL_SIZE / 2, centre - KERNEL_SIZE / 2 + KERNEL_SIZE - 1]. Window values are in
+// window_buffer order, tap [i][j] at i * KERNEL_SIZE + j, i.e. window_out from its most
+// significant pixel down. Positions outside the image are filled by border_index().
+// Throws for CIRCULAR, which the streaming line buffer cannot provide (the top rows are
+// overwritten before the bottom ones arrive), and if the image does not match the configuration.
+std::vector<std::vector<std::uint32_t>> window_model(
+    const WindowConfiguration &configuration,
+    const std::vector<std::vector<std::uint32_t>> &image);
+
+// Buffer and register sizes window.v derives from its parameters
+struct WindowBufferLayout
+{
+    int line_rows;   // LINE_ROWS: block RAM rows of the line buffer ring, KERNEL_SIZE + 1
+    int line_words;  // LINE_WORDS: words per row, each PIXELS_PER_CLOCK pixels wide
+    int cache_words; // CACHE_WORDS: line buffer words (all KERNEL_SIZE rows) held in registers
+    int x_bits;      // X_BITS: x_pos, x_window
+    int y_bits;      // Y_BITS: y_pos, y_window, read_y
+    int coord_bits;  // COORD_BITS: signed tap coordinates before border_coord
+};
+
+// Throws for invalid parameters
+WindowBufferLayout window_buffer_layout(const WindowConfiguration &configuration);
+
+// Register-level model of window.v. Pixels are written into one block RAM per line buffer row;
+// a reader fetches one word (PIXELS_PER_CLOCK columns of all KERNEL_SIZE window rows) per cycle
+// into the window cache, mapping rows outside the image through border_index(); a beat of
+// windows is emitted as soon as the cache holds its columns, and columns outside the image are
+// masked the same way. The model tags every line buffer word with the row written into it and
+// throws if the reader would see a word of the wrong row, which pixel_ready() rules out.
+class WindowStreamModel
+{
+public:
+    explicit WindowStreamModel(const WindowConfiguration &configuration);
+
+    // Registered outputs after a rising edge
+    struct Output
+    {
+        bool window_valid;
+        std::vector<bool> lane_valid;                    // window_lane_valid
+        std::vector<std::vector<std::uint32_t>> windows; // window_out per lane, window_buffer order
+    };
+
+    // One rising clock edge sampling the inputs; pixels holds PIXELS_PER_CLOCK lanes when
+    // pixel_valid, and the beat is taken only if pixel_ready(). frame_start restarts the frame from
+    // any state. window_stall holds a valid output for a consumer that did not take it on this
+    // edge; frame_start drops a held output.
+    const Output &clock(bool frame_start, bool pixel_valid, const std::vector<std::uint32_t> &pixels,
+                        bool window_stall = false);
+
+    // pixel_ready: a pixel beat is taken on the next edge unless frame_start is high. Low while the
+    // beat would overwrite a line buffer word the reader still needs, which happens when
+    // window_stall backs up the window cache; high in IDLE, where beats are dropped.
+    bool pixel_ready() const;
+
+    bool idle() const { return state_ == IDLE; }
+    const WindowBufferLayout &layout() const { return layout_; }
+
+private:
+    enum State
+    {
+        IDLE,
+        LOAD,
+        PROCESS
+    };
+
+    WindowConfiguration configuration_;
+    WindowBufferLayout layout_;
+    State state_;
+    // Input side
+    int x_pos_, y_pos_;
+    std::vector<std::vector<std::uint32_t>> line_buffer_; // [slot][word * PIXELS_PER_CLOCK + lane]
+    std::vector<std::vector<int>> line_row_;              // row held by each word, -1 if none
+    // Reader and its registered block RAM outputs
+    int read_y_, read_word_;
+    bool read_valid_;
+    std::vector<std::vector<std::uint32_t>> read_rows_; // [window row][lane]
+    // Window cache: a ring of cache_words words, head_word_ is the row word at cache_head_
+    std::vector<std::vector<std::vector<std::uint32_t>>> cache_; // [entry][window row][lane]
+    int cache_head_, cache_count_, head_word_;
+    // Output side
+    int x_window_, y_window_;
+    Output output_;
+};
+
+#endif // WINDOW_MODEL_H
@@ -0,0 +1,343 @@
+#include "work_stealing.h"
+
+// ---------------------------------------------------------------------------
+// WorkStealingDeque
+// ---------------------------------------------------------------------------
+
+WorkStealingDeque::Buffer::Buffer(std::int64_t size) : capacity(size),
+                                                       slots(new std::atomic<StealableTask *>[size])
+{
+    for (std::int64_t i = 0; i < size; ++i)
+    {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+WorkStealingDeque::Buffer::~Buffer()
+{
+    delete[] slots;
+}
+
+WorkStealingDeque::WorkStealingDeque(std::int64_t initial_capacity) : top_(0),
+                                                                      bottom_(0),
+                                                                      buffer_(nullptr)
+{
+    std::int64_t capacity = 1;
+    while (capacity < initial_capacity)
+    {
+        capacity <<= 1;
+    }
+    buffer_.store(new Buffer(capacity), std::memory_order_relaxed);
+}
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+    delete buffer_.load(std::memory_order_relaxed);
+    for (Buffer *buffer : retired_buffers_)
+    {
+        delete buffer;
+    }
+}
+
+WorkStealingDeque::Buffer *WorkStealingDeque::grow(Buffer *buffer, std::int64_t top, std::int64_t bottom)
+{
+    Buffer *bigger = new Buffer(buffer->capacity * 2);
+    for (std::int64_t i = top; i < bottom; ++i)
+    {
+        bigger->put(i, buffer->get(i));
+    }
+    retired_buffers_.push_back(buffer);
+    buffer_.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+void WorkStealingDeque::push(StealableTask *task)
+{
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+    if (bottom - top > buffer->capacity - 1)
+    {
+        buffer = grow(buffer, top, bottom);
+    }
+    buffer->put(bottom, task);
+    // Release publishes the task (and everything it points to) to thieves
+    bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+StealableTask *WorkStealingDeque::take()
+{
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    std::int64_t top = top_.load(std::memory_order_seq_cst);
+
+    if (top > bottom)
+    {
+        bottom_.store(bottom + 1, std::memory_order_relaxed); // empty
+        return nullptr;
+    }
+
+    StealableTask *task = buffer->get(bottom);
+    if (top == bottom)
+    {
+        // Last task: race against thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            task = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+StealableTask *WorkStealingDeque::steal()
+{
+    std::int64_t top = top_.load(std::memory_order_seq_cst);
+    std::int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Buffer *buffer = buffer_.load(std::memory_order_acquire);
+    StealableTask *task = buffer->get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr; // another thief or the owner got it first
+    }
+    return task;
+}
+
+// ---------------------------------------------------------------------------
+// WorkStealingScheduler
+// ---------------------------------------------------------------------------
+
+namespace
+{
+// Identifies the scheduler worker running on the current thread, if any
+struct WorkerIdentity
+{
+    const WorkStealingScheduler *scheduler;
+    int index;
+};
+
+thread_local WorkerIdentity current_worker = {nullptr, -1};
+
+const int SPINS_BEFORE_SLEEP = 64;
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(int num_threads, ThreadAffinity affinity) : queued_tasks_(0),
+                                                                                         stopping_(false)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0)
+        {
+            num_threads = 1;
+        }
+    }
+
+    for (int i = 0; i < num_threads; ++i)
+    {
+        deques_.emplace_back(new WorkStealingDeque());
+    }
+    workers_.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i)
+    {
+        workers_.emplace_back(&WorkStealingScheduler::worker_loop, this, i, affinity);
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_.store(true);
+    }
+    work_available_.notify_all();
+    for (std::thread &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+WorkStealingScheduler &WorkStealingScheduler::shared_default()
+{
+    static WorkStealingScheduler scheduler;
+    return scheduler;
+}
+
+int WorkStealingScheduler::current_worker_index() const
+{
+    return current_worker.scheduler == this ? current_worker.index : -1;
+}
+
+void WorkStealingScheduler::spawn(StealableTask *task)
+{
+    int worker_index = current_worker_index();
+    if (worker_index >= 0)
+    {
+        deques_[worker_index]->push(task);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(injection_mutex_);
+        injection_queue_.push_back(task);
+    }
+
+    queued_tasks_.fetch_add(1);
+    // Taking the mutex orders this notification after a sleeper's predicate check
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    work_available_.notify_one();
+}
+
+StealableTask *WorkStealingScheduler::find_task(int worker_index)
+{
+    StealableTask *task = nullptr;
+
+    if (worker_index >= 0)
+    {
+        task = deques_[worker_index]->take();
+    }
+
+    if (!task)
+    {
+        std::lock_guard<std::mutex> lock(injection_mutex_);
+        if (!injection_queue_.empty())
+        {
+            task = injection_queue_.front();
+            injection_queue_.pop_front();
+        }
+    }
+
+    if (!task)
+    {
+        // Visit victims starting after ourselves so thieves spread over the deques
+        const int worker_count = static_cast<int>(deques_.size());
+        const int first_victim = worker_index >= 0 ? worker_index + 1 : 0;
+        for (int i = 0; i < worker_count && !task; ++i)
+        {
+            int victim = (first_victim + i) % worker_count;
+            if (victim != worker_index)
+            {
+                task = deques_[victim]->steal();
+            }
+        }
+    }
+
+    if (task)
+    {
+        queued_tasks_.fetch_sub(1);
+    }
+    return task;
+}
+
+void WorkStealingScheduler::execute(StealableTask *task)
+{
+    TaskGroup *group = task->group;
+    try
+    {
+        task->function();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(group->error_mutex_);
+        if (!group->first_error_)
+        {
+            group->first_error_ = std::current_exception();
+        }
+    }
+    delete task;
+    group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void WorkStealingScheduler::worker_loop(int worker_index, ThreadAffinity affinity)
+{
+    place_current_thread(worker_index, affinity);
+    current_worker.scheduler = this;
+    current_worker.index = worker_index;
+
+    int idle_spins = 0;
+    while (!stopping_.load(std::memory_order_acquire))
+    {
+        StealableTask *task = find_task(worker_index);
+        if (task)
+        {
+            execute(task);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < SPINS_BEFORE_SLEEP)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        work_available_.wait(lock, [this]() {
+            return stopping_.load() || queued_tasks_.load() > 0;
+        });
+        idle_spins = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TaskGroup
+// ---------------------------------------------------------------------------
+
+TaskGroup::TaskGroup(WorkStealingScheduler &scheduler) : scheduler_(scheduler),
+                                                         pending_(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+        // Destructors must not throw; call wait() explicitly to observe task exceptions
+    }
+}
+
+void TaskGroup::run(std::function<void()> function)
+{
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    scheduler_.spawn(new StealableTask{std::move(function), this});
+}
+
+void TaskGroup::wait()
+{
+    const int worker_index = scheduler_.current_worker_index();
+    while (pending_.load(std::memory_order_acquire) > 0)
+    {
+        // Help instead of blocking; this is what makes nested parallelism deadlock-free
+        StealableTask *task = scheduler_.find_task(worker_index);
+        if (task)
+        {
+            scheduler_.execute(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        error = first_error_;
+        first_error_ = nullptr;
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
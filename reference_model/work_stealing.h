@@ -0,0 +1,133 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cpu_topology.h"
+
+class TaskGroup;
+
+// Unit of work scheduled by WorkStealingScheduler
+struct StealableTask
+{
+    std::function<void()> function;
+    TaskGroup *group;
+};
+
+// Chase-Lev work-stealing deque. The owning worker pushes and takes at the bottom (LIFO,
+// cache-warm); other threads steal from the top (FIFO, oldest and usually largest tasks).
+// The buffer grows on demand; retired buffers are kept until destruction because a thief
+// may still be reading from them.
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(std::int64_t initial_capacity = 256);
+    ~WorkStealingDeque();
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    void push(StealableTask *task); // owner only
+    StealableTask *take();          // owner only; nullptr if empty
+    StealableTask *steal();         // any thread; nullptr if empty or lost a race
+
+private:
+    struct Buffer
+    {
+        std::int64_t capacity; // power of two
+        std::atomic<StealableTask *> *slots;
+
+        explicit Buffer(std::int64_t size);
+        ~Buffer();
+        StealableTask *get(std::int64_t index) const { return slots[index & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t index, StealableTask *task) { slots[index & (capacity - 1)].store(task, std::memory_order_relaxed); }
+    };
+
+    std::atomic<std::int64_t> top_;
+    std::atomic<std::int64_t> bottom_;
+    std::atomic<Buffer *> buffer_;
+    std::vector<Buffer *> retired_buffers_; // owner only
+
+    Buffer *grow(Buffer *buffer, std::int64_t top, std::int64_t bottom);
+};
+
+// Fork-join scheduler with one Chase-Lev deque per worker. Tasks spawned from a worker go
+// to its own deque; idle workers steal from the others, so irregular work (tiles of very
+// different cost, batches of differently sized images, whole layers) balances itself.
+// Tasks may spawn and wait for nested TaskGroups: a waiting thread keeps executing other
+// tasks instead of blocking, so nesting never deadlocks.
+class WorkStealingScheduler
+{
+public:
+    // num_threads <= 0 uses std::thread::hardware_concurrency()
+    explicit WorkStealingScheduler(int num_threads = 0, ThreadAffinity affinity = ThreadAffinity::NONE);
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler &) = delete;
+    WorkStealingScheduler &operator=(const WorkStealingScheduler &) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Index in [0, size()) of the calling worker thread, or -1 for threads outside the scheduler
+    int current_worker_index() const;
+
+    // Scheduler shared by callers that do not manage their own
+    static WorkStealingScheduler &shared_default();
+
+private:
+    friend class TaskGroup;
+
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+    std::vector<std::thread> workers_;
+
+    // Tasks spawned from threads that are not workers of this scheduler
+    std::mutex injection_mutex_;
+    std::deque<StealableTask *> injection_queue_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable work_available_;
+    std::atomic<std::int64_t> queued_tasks_; // spawned but not yet started
+    std::atomic<bool> stopping_;
+
+    void spawn(StealableTask *task);
+    StealableTask *find_task(int worker_index);
+    void execute(StealableTask *task);
+    void worker_loop(int worker_index, ThreadAffinity affinity);
+};
+
+// Set of tasks that can be waited on together. The destructor waits for any tasks that
+// are still running.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(WorkStealingScheduler &scheduler);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    // Schedule function; it may itself create TaskGroups and run/wait on them
+    void run(std::function<void()> function);
+
+    // Execute tasks until every task of this group has finished, then rethrow the first
+    // exception thrown by any of them
+    void wait();
+
+private:
+    friend class WorkStealingScheduler;
+
+    WorkStealingScheduler &scheduler_;
+    std::atomic<std::int64_t> pending_;
+    std::mutex error_mutex_;
+    std::exception_ptr first_error_;
+};
+
+#endif // WORK_STEALING_H
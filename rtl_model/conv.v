@@ -10,33 +10,55 @@ module conv #(
     parameter WEIGHT_WIDTH = 8,
     parameter OUTPUT_WIDTH = 20,  // 增加输出位宽，避免饱和
     parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL),
-    parameter INIT_FILE = "weights.mem"
+    parameter BIAS_WIDTH = ACC_WIDTH + 1,
+    parameter INIT_FILE = "weights.mem",
+    parameter BIAS_FILE = "",  // 每行一个滤波器偏置 (BIAS_WIDTH位补码), 双缓冲时每组 NUM_FILTERS 行; 为空则无偏置
+    parameter MAC_PIPELINED = 0,  // 1: 使用 mult_acc_pipe (寄存乘法 + 流水线加法树), 输出延迟 MAC_LATENCY 拍
+    parameter ADDER_LEVELS_PER_STAGE = 1,  // mult_acc_pipe 每级流水线的加法树层数
+    parameter PIXELS_PER_CLOCK = 1,  // 每拍输入的相邻像素数 P: 窗口模块每拍输出 P 个窗口, 每个滤波器 P 个乘累加单元
+    parameter WEIGHT_DOUBLE_BUFFER = 0,  // 1: 使用 weight_bank 双缓冲, 下一层权重在当前帧计算时预取, frame_start 时交换
+    parameter NUM_WEIGHT_SETS = 1,  // 双缓冲: INIT_FILE 中的权重组数, 第 k 帧使用第 k % NUM_WEIGHT_SETS 组
+    parameter WEIGHTS_PER_READ = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE,  // 双缓冲: ROM 每拍读出的权重数
+    parameter MAC_CHANNEL_PARALLELISM = IN_CHANNEL,  // 每拍计算的输入通道数; 任一 MAC_*_PARALLELISM 小于满值时使用 mult_acc_fold (忽略 MAC_PIPELINED)
+    parameter MAC_FILTER_PARALLELISM = NUM_FILTERS   // 每拍计算的滤波器数; 折叠后每 MAC_CYCLES_PER_WINDOW 拍最多接收一拍像素 (见 pixel_ready)
 )
 (
     // 全局信号
     input clk,
     input rst_n,
 
-    // 并行输入数据接口 - 同时输入所有通道
-    input [IN_CHANNEL*DATA_WIDTH-1:0] pixel_in,  // 所有通道并行输入
+    // 并行输入数据接口 - 同时输入所有通道; 第 p 路为第 x+p 列, 位于 [p*IN_CHANNEL*DATA_WIDTH +: IN_CHANNEL*DATA_WIDTH]
+    input [PIXELS_PER_CLOCK*IN_CHANNEL*DATA_WIDTH-1:0] pixel_in,  // 所有通道并行输入
     input pixel_valid,
-    input frame_start,
+    output pixel_ready, // 本拍接收 pixel_in; 为 0 时保持 pixel_in 与 pixel_valid (折叠单元忙导致行缓冲未读完时拉低)
+    input frame_start,  // 须在 frame_ready 为 1 时发出
+    output frame_ready, // 可以开始下一帧: 单缓冲为权重已加载; 双缓冲为第一帧权重已就绪或下一组已预取完成
 
-    // 并行输出数据接口 - 同时输出所有滤波器结果
-    output [NUM_FILTERS*OUTPUT_WIDTH-1:0] conv_out,
-    output conv_valid
+    // 并行输出数据接口 - 同时输出所有滤波器结果; 第 p 路位于 [p*NUM_FILTERS*OUTPUT_WIDTH +: NUM_FILTERS*OUTPUT_WIDTH]
+    output [PIXELS_PER_CLOCK*NUM_FILTERS*OUTPUT_WIDTH-1:0] conv_out,
+    output conv_valid,
+    output [PIXELS_PER_CLOCK-1:0] conv_lane_valid  // 每一路是否有效 (行末一拍可能不满)
 );
 
 // 计算权重存储所需的参数
 localparam TOTAL_WEIGHTS = NUM_FILTERS * IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
 localparam WEIGHTS_PER_FILTER = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
 
-// 分离的通道输入信号
-reg [DATA_WIDTH-1:0] channel_pixels [0:IN_CHANNEL-1];
+localparam WINDOW_BITS = KERNEL_SIZE * KERNEL_SIZE * DATA_WIDTH;
+
+// MAC 折叠: 每个窗口需要 MAC_CYCLES_PER_WINDOW 拍, 乘法器数量为每路 MAC_FILTER_PARALLELISM*MAC_CHANNEL_PARALLELISM*K*K
+localparam MAC_FOLDED = (MAC_CHANNEL_PARALLELISM < IN_CHANNEL) || (MAC_FILTER_PARALLELISM < NUM_FILTERS);
+localparam MAC_CYCLES_PER_WINDOW = ((IN_CHANNEL + MAC_CHANNEL_PARALLELISM - 1) / MAC_CHANNEL_PARALLELISM) *
+                                   ((NUM_FILTERS + MAC_FILTER_PARALLELISM - 1) / MAC_FILTER_PARALLELISM);
+
+// 分离的通道输入信号 (每个通道 P 路像素)
+reg [PIXELS_PER_CLOCK*DATA_WIDTH-1:0] channel_pixels [0:IN_CHANNEL-1];
 
 // 窗口模块信号 (为每个通道实例化)
-wire [KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] window_out [0:IN_CHANNEL-1];
-wire window_valid [0:IN_CHANNEL-1];
+wire [PIXELS_PER_CLOCK*WINDOW_BITS-1:0] window_out [0:IN_CHANNEL-1];
+wire [IN_CHANNEL-1:0] window_valid;
+wire [IN_CHANNEL-1:0] window_pixel_ready;
+wire [PIXELS_PER_CLOCK-1:0] window_lane_valid [0:IN_CHANNEL-1];
 wire all_windows_valid;
 
 // 权重模块接口信号
@@ -48,100 +70,213 @@ reg [NUM_FILTERS-1:0] weight_read_enable;
 reg [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*WEIGHT_WIDTH-1:0] filter_weights [0:NUM_FILTERS-1];
 reg weights_loaded;
 
+// 偏置寄存器 - 折叠后的BN/缩放偏置, 每个滤波器一个 (双缓冲时为活动组的偏置)
+reg signed [BIAS_WIDTH-1:0] filter_bias [0:NUM_FILTERS-1];
+
 // 权重加载状态机
 reg [1:0] weight_load_state;
 reg [NUM_FILTERS-1:0] weight_loaded_flags;
 localparam WEIGHT_IDLE = 2'b00, WEIGHT_LOADING = 2'b01, WEIGHT_DONE = 2'b10;
 
-// 多通道乘累加模块信号 (为每个滤波器实例化)
-wire [OUTPUT_WIDTH-1:0] filter_conv_out [0:NUM_FILTERS-1];
-wire filter_conv_valid [0:NUM_FILTERS-1];
-wire [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] multi_channel_window;
+// 多通道乘累加模块信号 (为每一路每个滤波器实例化)
+wire [OUTPUT_WIDTH-1:0] filter_conv_out [0:PIXELS_PER_CLOCK-1][0:NUM_FILTERS-1];
+wire filter_conv_valid [0:PIXELS_PER_CLOCK-1][0:NUM_FILTERS-1];
+wire [IN_CHANNEL*WINDOW_BITS-1:0] multi_channel_window [0:PIXELS_PER_CLOCK-1];
+
+// 折叠乘累加单元的接口: 所有滤波器的权重和偏置, 就绪信号 (忙时窗口模块保持输出)
+wire [NUM_FILTERS*WEIGHTS_PER_FILTER*WEIGHT_WIDTH-1:0] all_filter_weights;
+wire [NUM_FILTERS*BIAS_WIDTH-1:0] all_filter_bias;
+wire [PIXELS_PER_CLOCK-1:0] mac_lane_ready;
+wire window_stall;
 
 // 循环变量
-integer i, load_idx;
-
-// 权重加载状态机 - 从weight模块一次性加载权重到寄存器
-always @(posedge clk or negedge rst_n) begin
-    if (!rst_n) begin
-        weight_load_state <= WEIGHT_IDLE;
-        weight_read_enable <= 0;
-        weight_loaded_flags <= 0;
-        weights_loaded <= 0;
-        for (load_idx = 0; load_idx < NUM_FILTERS; load_idx = load_idx + 1) begin
-            filter_weights[load_idx] <= 0;
+integer i, p, load_idx, bias_idx;
+
+// 权重来源: 双缓冲权重库, 或每个滤波器一个 weight 模块加单缓冲加载状态机
+genvar filt;
+generate
+    if (WEIGHT_DOUBLE_BUFFER) begin : double_buffer
+        localparam SET_BITS = (NUM_WEIGHT_SETS > 1) ? $clog2(NUM_WEIGHT_SETS) : 1;
+
+        wire [NUM_FILTERS*WEIGHTS_PER_FILTER*WEIGHT_WIDTH-1:0] bank_weights;
+        wire [NUM_FILTERS*BIAS_WIDTH-1:0] bank_bias;
+        wire bank_weights_valid;
+        wire bank_load_busy;
+        wire bank_shadow_ready;
+        reg bank_load_start;
+        reg [SET_BITS-1:0] bank_load_set;
+        reg frame_seen;
+
+        // 第一帧使用复位后装入的第 0 组, 之后每个 frame_start 切换到已预取的下一组
+        wire bank_swap = frame_start && frame_seen;
+
+        // 下一组未预取完时发 frame_start 会使交换挂起, 挂起期间 weights_loaded 为 0, 该帧的窗口被丢弃
+        assign frame_ready = frame_seen ? bank_shadow_ready : bank_weights_valid;
+
+        // 预取 (load_start 一拍, LOAD_BEATS 拍读出, shadow_ready 一拍) 须在一帧的输入拍数内完成,
+        // 否则按 frame_ready 驱动时每帧都要等待装载
+        localparam LOAD_BEATS = (NUM_FILTERS * WEIGHTS_PER_FILTER + WEIGHTS_PER_READ - 1) / WEIGHTS_PER_READ;
+        localparam FRAME_BEATS = ((IMG_WIDTH + PIXELS_PER_CLOCK - 1) / PIXELS_PER_CLOCK) * IMG_HEIGHT;
+        initial begin
+            if (LOAD_BEATS + 2 > FRAME_BEATS) begin
+                $display("ERROR: conv: weight set load of %0d beats (+2) does not fit in a frame of %0d input beats; increase WEIGHTS_PER_READ",
+                         LOAD_BEATS, FRAME_BEATS);
+                $finish;
+            end
         end
-    end else begin
-        case (weight_load_state)
-            WEIGHT_IDLE: begin
-                // 开始加载权重
-                weight_read_enable <= {NUM_FILTERS{1'b1}}; // 启用所有滤波器的权重读取
-                weight_load_state <= WEIGHT_LOADING;
-                weights_loaded <= 0;
+
+        always @(posedge clk) begin
+            if (rst_n && frame_start && !frame_ready)
+                $display("ERROR: conv: frame_start at %0t while frame_ready is low, outputs are dropped until the weight swap", $time);
+        end
+
+        weight_bank #(
+            .NUM_FILTERS(NUM_FILTERS),
+            .INPUT_CHANNELS(IN_CHANNEL),
+            .KERNEL_SIZE(KERNEL_SIZE),
+            .WEIGHT_WIDTH(WEIGHT_WIDTH),
+            .NUM_WEIGHT_SETS(NUM_WEIGHT_SETS),
+            .WEIGHTS_PER_READ(WEIGHTS_PER_READ),
+            .SET_BITS(SET_BITS),
+            .INIT_FILE(INIT_FILE),
+            .BIAS_WIDTH(BIAS_WIDTH),
+            .BIAS_FILE(BIAS_FILE)
+        ) bank_inst (
+            .clk(clk),
+            .rst_n(rst_n),
+            .load_start(bank_load_start),
+            .load_set(bank_load_set),
+            .load_busy(bank_load_busy),
+            .shadow_ready(bank_shadow_ready),
+            .swap(bank_swap),
+            .weights_out(bank_weights),
+            .bias_out(bank_bias),
+            .weights_valid(bank_weights_valid),
+            .active_set()
+        );
+
+        // 预取: 影子缓冲空闲时按组号循环装入下一组
+        always @(posedge clk or negedge rst_n) begin
+            if (!rst_n) begin
+                bank_load_start <= 0;
+                bank_load_set <= 0;
+                frame_seen <= 0;
+            end else begin
+                if (frame_start)
+                    frame_seen <= 1;
+                if (bank_load_start) begin
+                    bank_load_start <= 0;
+                    bank_load_set <= (bank_load_set == NUM_WEIGHT_SETS - 1) ? 0 : bank_load_set + 1;
+                end else if (!bank_load_busy && !bank_shadow_ready) begin
+                    bank_load_start <= 1;
+                end
             end
-            
-            WEIGHT_LOADING: begin
-                // 检查每个滤波器的权重是否加载完成
+        end
+
+        always @(*) begin
+            for (load_idx = 0; load_idx < NUM_FILTERS; load_idx = load_idx + 1) begin
+                filter_weights[load_idx] = bank_weights[load_idx*WEIGHTS_PER_FILTER*WEIGHT_WIDTH +: WEIGHTS_PER_FILTER*WEIGHT_WIDTH];
+                filter_bias[load_idx] = bank_bias[load_idx*BIAS_WIDTH +: BIAS_WIDTH];
+            end
+            weights_loaded = bank_weights_valid;
+        end
+    end else begin : single_buffer
+        assign frame_ready = weights_loaded;
+
+        // 偏置初始化 - 与weight.v的INIT_FILE加载方式一致
+        initial begin
+            if (BIAS_FILE != "") begin
+                $readmemh(BIAS_FILE, filter_bias);
+                $display("Conv: Loaded filter biases from %s", BIAS_FILE);
+            end else begin
+                for (bias_idx = 0; bias_idx < NUM_FILTERS; bias_idx = bias_idx + 1) begin
+                    filter_bias[bias_idx] = 0;
+                end
+            end
+        end
+
+        // 权重加载状态机 - 从weight模块一次性加载权重到寄存器
+        always @(posedge clk or negedge rst_n) begin
+            if (!rst_n) begin
+                weight_load_state <= WEIGHT_IDLE;
+                weight_read_enable <= 0;
+                weight_loaded_flags <= 0;
+                weights_loaded <= 0;
                 for (load_idx = 0; load_idx < NUM_FILTERS; load_idx = load_idx + 1) begin
-                    if (weight_rom_valid[load_idx] && !weight_loaded_flags[load_idx]) begin
-                        // 将权重从ROM复制到寄存器
-                        filter_weights[load_idx] <= weight_rom_out[load_idx];
-                        weight_loaded_flags[load_idx] <= 1;
-                        $display("Conv: Loaded weights for filter %0d", load_idx);
-                    end
+                    filter_weights[load_idx] <= 0;
                 end
+            end else begin
+                case (weight_load_state)
+                    WEIGHT_IDLE: begin
+                        // 开始加载权重
+                        weight_read_enable <= {NUM_FILTERS{1'b1}}; // 启用所有滤波器的权重读取
+                        weight_load_state <= WEIGHT_LOADING;
+                        weights_loaded <= 0;
+                    end
+            
+                    WEIGHT_LOADING: begin
+                        // 检查每个滤波器的权重是否加载完成
+                        for (load_idx = 0; load_idx < NUM_FILTERS; load_idx = load_idx + 1) begin
+                            if (weight_rom_valid[load_idx] && !weight_loaded_flags[load_idx]) begin
+                                // 将权重从ROM复制到寄存器
+                                filter_weights[load_idx] <= weight_rom_out[load_idx];
+                                weight_loaded_flags[load_idx] <= 1;
+                                $display("Conv: Loaded weights for filter %0d", load_idx);
+                            end
+                        end
                 
-                // 检查是否所有权重都已加载
-                if (&weight_loaded_flags) begin
-                    weight_read_enable <= 0; // 停止读取
-                    weight_load_state <= WEIGHT_DONE;
-                    weights_loaded <= 1;
-                    $display("Conv: All weights loaded to registers - ROM access no longer needed");
-                end
-            end
+                        // 检查是否所有权重都已加载
+                        if (&weight_loaded_flags) begin
+                            weight_read_enable <= 0; // 停止读取
+                            weight_load_state <= WEIGHT_DONE;
+                            weights_loaded <= 1;
+                            $display("Conv: All weights loaded to registers - ROM access no longer needed");
+                        end
+                    end
             
-            WEIGHT_DONE: begin
-                // 权重加载完成，保持状态
-                weights_loaded <= 1;
-            end
+                    WEIGHT_DONE: begin
+                        // 权重加载完成，保持状态
+                        weights_loaded <= 1;
+                    end
             
-            default: begin
-                weight_load_state <= WEIGHT_IDLE;
+                    default: begin
+                        weight_load_state <= WEIGHT_IDLE;
+                    end
+                endcase
             end
-        endcase
+        end
+
+        // 为每个滤波器实例化权重模块
+        for (filt = 0; filt < NUM_FILTERS; filt = filt + 1) begin : weight_gen
+            weight #(
+                .NUM_FILTERS(NUM_FILTERS),
+                .INPUT_CHANNELS(IN_CHANNEL),
+                .KERNEL_SIZE(KERNEL_SIZE),
+                .WEIGHT_WIDTH(WEIGHT_WIDTH),
+                .FILTER_ID(filt),
+                .INIT_FILE(INIT_FILE)
+            ) weight_inst (
+                .clk(clk),
+                .rst_n(rst_n),
+                .read_enable(weight_read_enable[filt]),
+                .multi_channel_weight_out(weight_rom_out[filt]),
+                .weight_valid(weight_rom_valid[filt])
+            );
+        end
     end
-end
+endgenerate
 
 // 权重已经直接存储为展平格式，无需额外打包逻辑
 
 // 输入数据解包 - 将并行输入分离到各个通道
 always @(*) begin
     for (i = 0; i < IN_CHANNEL; i = i + 1) begin
-        channel_pixels[i] = pixel_in[(i+1)*DATA_WIDTH-1 -: DATA_WIDTH];
+        for (p = 0; p < PIXELS_PER_CLOCK; p = p + 1) begin
+            channel_pixels[i][p*DATA_WIDTH +: DATA_WIDTH] = pixel_in[(p*IN_CHANNEL + i)*DATA_WIDTH +: DATA_WIDTH];
+        end
     end
 end
 
-// 为每个滤波器实例化权重模块
-genvar filt;
-generate
-    for (filt = 0; filt < NUM_FILTERS; filt = filt + 1) begin : weight_gen
-        weight #(
-            .NUM_FILTERS(NUM_FILTERS),
-            .INPUT_CHANNELS(IN_CHANNEL),
-            .KERNEL_SIZE(KERNEL_SIZE),
-            .WEIGHT_WIDTH(WEIGHT_WIDTH),
-            .FILTER_ID(filt),
-            .INIT_FILE(INIT_FILE)
-        ) weight_inst (
-            .clk(clk),
-            .rst_n(rst_n),
-            .read_enable(weight_read_enable[filt]),
-            .multi_channel_weight_out(weight_rom_out[filt]),
-            .weight_valid(weight_rom_valid[filt])
-        );
-    end
-endgenerate
-
 // 为每个输入通道实例化窗口模块
 genvar ch;
 generate
@@ -152,49 +287,146 @@ generate
             .IMG_HEIGHT(IMG_HEIGHT),
             .KERNEL_SIZE(KERNEL_SIZE),
             .STRIDE(STRIDE),
-            .PADDING(PADDING)
+            .PADDING(PADDING),
+            .PIXELS_PER_CLOCK(PIXELS_PER_CLOCK)
         ) window_inst (
             .clk(clk),
             .rst_n(rst_n),
             .pixel_in(channel_pixels[ch]),
             .pixel_valid(pixel_valid),
+            .pixel_ready(window_pixel_ready[ch]),
             .frame_start(frame_start),
+            .window_stall(window_stall),
             .window_out(window_out[ch]),
-            .window_valid(window_valid[ch])
+            .window_valid(window_valid[ch]),
+            .window_lane_valid(window_lane_valid[ch])
         );
     end
 endgenerate
 
-// 为每个滤波器实例化多通道乘累加模块
-genvar f;
+// 为每一路实例化乘累加模块: 折叠时每路一个 mult_acc_fold 计算所有滤波器, 否则每路每个滤波器一个
+genvar f, lane;
 generate
-    for (f = 0; f < NUM_FILTERS; f = f + 1) begin : mult_acc_gen
-        mult_acc_comb #(
-            .DATA_WIDTH(DATA_WIDTH),
-            .KERNEL_SIZE(KERNEL_SIZE),
-            .IN_CHANNEL(IN_CHANNEL),
-            .WEIGHT_WIDTH(WEIGHT_WIDTH),
-            .OUTPUT_WIDTH(OUTPUT_WIDTH),
-            .ACC_WIDTH(ACC_WIDTH)
-        ) mult_acc_inst (
-            .window_valid(all_windows_valid),
-            .multi_channel_window_in(multi_channel_window),
-            .weight_valid(weights_loaded),  // 权重始终有效（已加载到寄存器）
-            .multi_channel_weight_in(filter_weights[f]),
-            .conv_out(filter_conv_out[f]),
-            .conv_valid(filter_conv_valid[f])
-        );
+    for (f = 0; f < NUM_FILTERS; f = f + 1) begin : filter_pack_gen
+        assign all_filter_weights[f*WEIGHTS_PER_FILTER*WEIGHT_WIDTH +: WEIGHTS_PER_FILTER*WEIGHT_WIDTH] = filter_weights[f];
+        assign all_filter_bias[f*BIAS_WIDTH +: BIAS_WIDTH] = filter_bias[f];
+    end
+
+    for (lane = 0; lane < PIXELS_PER_CLOCK; lane = lane + 1) begin : lane_gen
+        if (MAC_FOLDED) begin : folded
+            wire [NUM_FILTERS*OUTPUT_WIDTH-1:0] fold_out;
+            wire fold_valid;
+
+            mult_acc_fold #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .KERNEL_SIZE(KERNEL_SIZE),
+                .IN_CHANNEL(IN_CHANNEL),
+                .NUM_FILTERS(NUM_FILTERS),
+                .WEIGHT_WIDTH(WEIGHT_WIDTH),
+                .OUTPUT_WIDTH(OUTPUT_WIDTH),
+                .ACC_WIDTH(ACC_WIDTH),
+                .BIAS_WIDTH(BIAS_WIDTH),
+                .CHANNEL_PARALLELISM(MAC_CHANNEL_PARALLELISM),
+                .FILTER_PARALLELISM(MAC_FILTER_PARALLELISM)
+            ) mult_acc_inst (
+                .clk(clk),
+                .rst_n(rst_n),
+                .window_valid(all_windows_valid & window_lane_valid[0][lane]),
+                .multi_channel_window_in(multi_channel_window[lane]),
+                .weight_valid(weights_loaded),
+                .multi_channel_weight_in(all_filter_weights),
+                .bias_in(all_filter_bias),
+                .ready(mac_lane_ready[lane]),
+                .conv_out(fold_out),
+                .conv_valid(fold_valid)
+            );
+
+            for (f = 0; f < NUM_FILTERS; f = f + 1) begin : unpack_gen
+                assign filter_conv_out[lane][f] = fold_out[f*OUTPUT_WIDTH +: OUTPUT_WIDTH];
+                assign filter_conv_valid[lane][f] = fold_valid;
+            end
+        end else begin : parallel
+            assign mac_lane_ready[lane] = 1'b1;
+
+            for (f = 0; f < NUM_FILTERS; f = f + 1) begin : mult_acc_gen
+                if (MAC_PIPELINED) begin : pipelined
+                    mult_acc_pipe #(
+                        .DATA_WIDTH(DATA_WIDTH),
+                        .KERNEL_SIZE(KERNEL_SIZE),
+                        .IN_CHANNEL(IN_CHANNEL),
+                        .WEIGHT_WIDTH(WEIGHT_WIDTH),
+                        .OUTPUT_WIDTH(OUTPUT_WIDTH),
+                        .ACC_WIDTH(ACC_WIDTH),
+                        .BIAS_WIDTH(BIAS_WIDTH),
+                        .ADDER_LEVELS_PER_STAGE(ADDER_LEVELS_PER_STAGE)
+                    ) mult_acc_inst (
+                        .clk(clk),
+                        .rst_n(rst_n),
+                        .window_valid(all_windows_valid & window_lane_valid[0][lane]),
+                        .multi_channel_window_in(multi_channel_window[lane]),
+                        .weight_valid(weights_loaded),
+                        .multi_channel_weight_in(filter_weights[f]),
+                        .bias_in(filter_bias[f]),
+                        .conv_out(filter_conv_out[lane][f]),
+                        .conv_valid(filter_conv_valid[lane][f])
+                    );
+                end else begin : combinational
+                    mult_acc_comb #(
+                        .DATA_WIDTH(DATA_WIDTH),
+                        .KERNEL_SIZE(KERNEL_SIZE),
+                        .IN_CHANNEL(IN_CHANNEL),
+                        .WEIGHT_WIDTH(WEIGHT_WIDTH),
+                        .OUTPUT_WIDTH(OUTPUT_WIDTH),
+                        .ACC_WIDTH(ACC_WIDTH),
+                        .BIAS_WIDTH(BIAS_WIDTH)
+                    ) mult_acc_inst (
+                        .window_valid(all_windows_valid & window_lane_valid[0][lane]),
+                        .multi_channel_window_in(multi_channel_window[lane]),
+                        .weight_valid(weights_loaded),  // 权重始终有效（已加载到寄存器）
+                        .multi_channel_weight_in(filter_weights[f]),
+                        .bias_in(filter_bias[f]),
+                        .conv_out(filter_conv_out[lane][f]),
+                        .conv_valid(filter_conv_valid[lane][f])
+                    );
+                end
+            end
+        end
     end
 endgenerate
 
-// 检查所有通道窗口是否都有效 - 组合逻辑
-assign all_windows_valid = window_valid[0] & window_valid[1] & window_valid[2];
+// 各路同时接收窗口 (路 0 在每一拍都有效), 折叠单元忙时所有通道的窗口模块保持输出
+assign window_stall = !mac_lane_ready[0];
+
+// 乘累加延迟 (时钟数): 组合版本为 0, 流水线版本见 mult_acc_pipe 的 LATENCY, 折叠版本见 mult_acc_fold 的 LATENCY
+localparam MAC_TREE_DEPTH = $clog2(WEIGHTS_PER_FILTER);
+localparam MAC_LATENCY = MAC_FOLDED ? MAC_CYCLES_PER_WINDOW + 1 :
+                         !MAC_PIPELINED ? 0 :
+                         2 + ((ADDER_LEVELS_PER_STAGE == 0) ? 0 :
+                              (MAC_TREE_DEPTH + ADDER_LEVELS_PER_STAGE - 1) / ADDER_LEVELS_PER_STAGE);
+
+// 检查所有通道窗口是否都有效 - 组合逻辑 (各通道窗口模块同步, 路有效位取通道 0)
+assign all_windows_valid = &window_valid;
+
+// 各通道窗口模块输入相同, 状态一致, 像素就绪取通道 0
+assign pixel_ready = window_pixel_ready[0];
 
-// 打包多通道窗口数据 - 组合逻辑
-assign multi_channel_window = {window_out[2], window_out[1], window_out[0]};
+// 打包多通道窗口数据和输出 - 组合逻辑; 通道 ch 位于 [ch*WINDOW_BITS +: WINDOW_BITS], 滤波器 f 位于 [f*OUTPUT_WIDTH +: OUTPUT_WIDTH]
+genvar pack_lane, pack_ch, pack_f;
+generate
+    for (pack_lane = 0; pack_lane < PIXELS_PER_CLOCK; pack_lane = pack_lane + 1) begin : pack_lane_gen
+        for (pack_ch = 0; pack_ch < IN_CHANNEL; pack_ch = pack_ch + 1) begin : pack_window_gen
+            assign multi_channel_window[pack_lane][pack_ch*WINDOW_BITS +: WINDOW_BITS] =
+                window_out[pack_ch][pack_lane*WINDOW_BITS +: WINDOW_BITS];
+        end
+        for (pack_f = 0; pack_f < NUM_FILTERS; pack_f = pack_f + 1) begin : pack_output_gen
+            assign conv_out[(pack_lane*NUM_FILTERS + pack_f)*OUTPUT_WIDTH +: OUTPUT_WIDTH] = filter_conv_out[pack_lane][pack_f];
+        end
+        // 乘累加单元的有效信号: 组合版本即窗口有效 & 权重已加载, 流水线和折叠版本已随数据延迟
+        assign conv_lane_valid[pack_lane] = filter_conv_valid[pack_lane][0];
+    end
+endgenerate
 
-// 输出逻辑 - 组合逻辑，权重始终有效，只需检查窗口有效性
-assign conv_valid = all_windows_valid & weights_loaded;
-assign conv_out = {filter_conv_out[2], filter_conv_out[1], filter_conv_out[0]};
+// 输出逻辑
+assign conv_valid = |conv_lane_valid;
 
 endmodule 
\ No newline at end of file
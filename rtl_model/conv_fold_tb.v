@@ -0,0 +1,265 @@
+`timescale 1ns / 1ps
+
+// MAC 折叠扫描测试: 同一帧送入不同 MAC_CHANNEL_PARALLELISM / MAC_FILTER_PARALLELISM 的 conv 实例,
+// 每个实例每 MAC_CYCLES_PER_WINDOW 拍输入一个像素. 检查各实例输出 (光栅顺序) 与不折叠的实例 0 逐位一致,
+// 并报告乘法器数量与每帧周期数. 另有两个全折叠的 mult_acc_fold 直接测试: 接收窗口后一拍改变其中一个的
+// 权重与偏置 (模拟 frame_start 时的权重交换), 其输出须与权重不变的另一个一致. 周期数与 reference_model 中 simulate_conv_stream
+// (mac_latency = MacFoldTiming::latency, mac_cycles_per_window = MacFoldTiming::cycles_per_window) 对应.
+module conv_fold_tb;
+
+parameter DATA_WIDTH = 8;
+parameter KERNEL_SIZE = 3;
+parameter IN_CHANNEL = 3;
+parameter NUM_FILTERS = 3;                // weights.mem: 3 个 3x3x3 滤波器
+parameter IMG_WIDTH = 8;
+parameter IMG_HEIGHT = 8;
+parameter STRIDE = 1;
+parameter WEIGHT_WIDTH = 8;
+parameter OUTPUT_WIDTH = 20;
+
+localparam NUM_SWEEP = 5;
+localparam OUTPUT_IMG_WIDTH = (IMG_WIDTH + STRIDE - 1) / STRIDE;   // SAME
+localparam OUTPUT_IMG_HEIGHT = (IMG_HEIGHT + STRIDE - 1) / STRIDE;
+localparam OUTPUTS = OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT;
+localparam PIXEL_BITS = IN_CHANNEL * DATA_WIDTH;
+localparam RESULT_BITS = NUM_FILTERS * OUTPUT_WIDTH;
+
+reg clk;
+reg rst_n;
+integer cycle;
+
+reg [DATA_WIDTH-1:0] test_image [0:IN_CHANNEL-1][0:IMG_HEIGHT-1][0:IMG_WIDTH-1];
+
+// 每个配置的输出 (光栅顺序) 与时间戳
+reg [RESULT_BITS-1:0] results [0:NUM_SWEEP-1][0:OUTPUTS-1];
+integer result_count [0:NUM_SWEEP-1];
+integer frame_start_cycle [0:NUM_SWEEP-1];
+integer last_output_cycle [0:NUM_SWEEP-1];
+integer multipliers [0:NUM_SWEEP-1];
+integer cycles_per_window [0:NUM_SWEEP-1];
+
+// 时钟生成
+initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+end
+
+always @(posedge clk) begin
+    cycle <= cycle + 1;
+end
+
+genvar g;
+generate
+    for (g = 0; g < NUM_SWEEP; g = g + 1) begin : sweep
+        // (通道, 滤波器) 并行度: 不折叠, 只折叠滤波器, 只折叠通道, 两者都不整除, 全部折叠
+        localparam CP = (g == 2 || g == 4) ? 1 : (g == 3) ? 2 : IN_CHANNEL;
+        localparam FP = (g == 1 || g == 4) ? 1 : (g == 3) ? 2 : NUM_FILTERS;
+
+        reg [PIXEL_BITS-1:0] pixel_in;
+        reg pixel_valid;
+        wire pixel_ready;
+        reg frame_start;
+        wire [RESULT_BITS-1:0] conv_out;
+        wire conv_valid;
+        wire conv_lane_valid;
+        integer row, col, ch;
+
+        conv #(
+            .DATA_WIDTH(DATA_WIDTH),
+            .KERNEL_SIZE(KERNEL_SIZE),
+            .IN_CHANNEL(IN_CHANNEL),
+            .NUM_FILTERS(NUM_FILTERS),
+            .IMG_WIDTH(IMG_WIDTH),
+            .IMG_HEIGHT(IMG_HEIGHT),
+            .STRIDE(STRIDE),
+            .WEIGHT_WIDTH(WEIGHT_WIDTH),
+            .OUTPUT_WIDTH(OUTPUT_WIDTH),
+            .INIT_FILE("weights.mem"),
+            .MAC_CHANNEL_PARALLELISM(CP),
+            .MAC_FILTER_PARALLELISM(FP)
+        ) dut (
+            .clk(clk),
+            .rst_n(rst_n),
+            .pixel_in(pixel_in),
+            .pixel_valid(pixel_valid),
+            .pixel_ready(pixel_ready),
+            .frame_start(frame_start),
+            .conv_out(conv_out),
+            .conv_valid(conv_valid),
+            .conv_lane_valid(conv_lane_valid)
+        );
+
+        // 驱动: 权重加载完成后发 frame_start, 之后每 MAC_CYCLES_PER_WINDOW 拍送一个像素 (下降沿驱动),
+        // pixel_ready 为 0 时保持该像素
+        initial begin
+            pixel_in = 0;
+            pixel_valid = 0;
+            frame_start = 0;
+            multipliers[g] = FP * CP * KERNEL_SIZE * KERNEL_SIZE;
+            cycles_per_window[g] = dut.MAC_CYCLES_PER_WINDOW;
+            @(posedge rst_n);
+            wait (dut.weights_loaded);
+            @(negedge clk);
+            frame_start = 1;
+            @(negedge clk);
+            frame_start = 0;
+            for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                    for (ch = 0; ch < IN_CHANNEL; ch = ch + 1)
+                        pixel_in[ch*DATA_WIDTH +: DATA_WIDTH] = test_image[ch][row][col];
+                    pixel_valid = 1;
+                    while (!pixel_ready) @(negedge clk);
+                    @(negedge clk);
+                    pixel_valid = 0;
+                    repeat (dut.MAC_CYCLES_PER_WINDOW - 1) @(negedge clk);
+                end
+            end
+        end
+
+        // 监视: 收集有效输出
+        always @(posedge clk) begin
+            if (frame_start)
+                frame_start_cycle[g] = cycle;
+            if (conv_valid) begin
+                if (result_count[g] < OUTPUTS) begin
+                    results[g][result_count[g]] = conv_out;
+                    result_count[g] = result_count[g] + 1;
+                end
+                last_output_cycle[g] = cycle;
+            end
+        end
+    end
+endgenerate
+
+// 权重交换测试: hold_dut 的权重与偏置在接收窗口后改变, hold_ref 保持不变
+localparam HOLD_ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL);
+localparam HOLD_BIAS_WIDTH = HOLD_ACC_WIDTH + 1;
+localparam HOLD_WEIGHT_BITS = NUM_FILTERS*IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*WEIGHT_WIDTH;
+
+reg hold_window_valid;
+reg [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] hold_window;
+reg [HOLD_WEIGHT_BITS-1:0] hold_weights, hold_weights_changed;
+reg [NUM_FILTERS*HOLD_BIAS_WIDTH-1:0] hold_bias, hold_bias_changed;
+wire [RESULT_BITS-1:0] hold_dut_out, hold_ref_out;
+wire hold_dut_valid, hold_ref_valid;
+wire hold_dut_ready, hold_ref_ready;
+integer hold_mismatches, hold_done;
+
+mult_acc_fold #(
+    .DATA_WIDTH(DATA_WIDTH), .KERNEL_SIZE(KERNEL_SIZE), .IN_CHANNEL(IN_CHANNEL), .NUM_FILTERS(NUM_FILTERS),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH), .OUTPUT_WIDTH(OUTPUT_WIDTH), .CHANNEL_PARALLELISM(1), .FILTER_PARALLELISM(1)
+) hold_dut (
+    .clk(clk), .rst_n(rst_n), .window_valid(hold_window_valid), .multi_channel_window_in(hold_window),
+    .weight_valid(1'b1), .multi_channel_weight_in(hold_weights_changed), .bias_in(hold_bias_changed),
+    .ready(hold_dut_ready), .conv_out(hold_dut_out), .conv_valid(hold_dut_valid)
+);
+
+mult_acc_fold #(
+    .DATA_WIDTH(DATA_WIDTH), .KERNEL_SIZE(KERNEL_SIZE), .IN_CHANNEL(IN_CHANNEL), .NUM_FILTERS(NUM_FILTERS),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH), .OUTPUT_WIDTH(OUTPUT_WIDTH), .CHANNEL_PARALLELISM(1), .FILTER_PARALLELISM(1)
+) hold_ref (
+    .clk(clk), .rst_n(rst_n), .window_valid(hold_window_valid), .multi_channel_window_in(hold_window),
+    .weight_valid(1'b1), .multi_channel_weight_in(hold_weights), .bias_in(hold_bias),
+    .ready(hold_ref_ready), .conv_out(hold_ref_out), .conv_valid(hold_ref_valid)
+);
+
+integer hold_round, hold_k;
+
+initial begin
+    hold_window_valid = 0;
+    hold_window = 0;
+    hold_mismatches = 0;
+    hold_done = 0;
+    @(posedge rst_n);
+    // 每轮: 送一个窗口, 下一拍把 hold_dut 的权重取反并改变偏置, 比较两者的结果
+    for (hold_round = 0; hold_round < 4; hold_round = hold_round + 1) begin
+        @(negedge clk);
+        for (hold_k = 0; hold_k < IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE; hold_k = hold_k + 1)
+            hold_window[hold_k*DATA_WIDTH +: DATA_WIDTH] = (hold_k * 37 + hold_round * 11) % 256;
+        for (hold_k = 0; hold_k < NUM_FILTERS*IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE; hold_k = hold_k + 1)
+            hold_weights[hold_k*WEIGHT_WIDTH +: WEIGHT_WIDTH] = (hold_k * 53 + hold_round * 7) % 256;
+        for (hold_k = 0; hold_k < NUM_FILTERS; hold_k = hold_k + 1)
+            hold_bias[hold_k*HOLD_BIAS_WIDTH +: HOLD_BIAS_WIDTH] = hold_k * 1000 - 1500 * hold_round;
+        hold_weights_changed = hold_weights;
+        hold_bias_changed = hold_bias;
+        hold_window_valid = 1;
+        @(negedge clk);
+        hold_window_valid = 0;
+        hold_window = ~hold_window;
+        hold_weights_changed = ~hold_weights;
+        hold_bias_changed = ~hold_bias;
+        while (!hold_ref_valid) @(negedge clk);
+        if (!hold_dut_valid || hold_dut_out !== hold_ref_out) begin
+            $display("  MISMATCH weight swap round %0d: %h vs %h (weights unchanged)", hold_round, hold_dut_out, hold_ref_out);
+            hold_mismatches = hold_mismatches + 1;
+        end
+    end
+    hold_done = 1;
+end
+
+integer i, j, c, n, mismatches, done;
+
+initial begin
+    $display("=== Conv MAC Folding Sweep (%0dx%0d, K=%0d, %0d channels, %0d filters) ===",
+             IMG_WIDTH, IMG_HEIGHT, KERNEL_SIZE, IN_CHANNEL, NUM_FILTERS);
+    cycle = 0;
+    mismatches = 0;
+    for (n = 0; n < NUM_SWEEP; n = n + 1) begin
+        result_count[n] = 0;
+        frame_start_cycle[n] = 0;
+        last_output_cycle[n] = 0;
+    end
+    for (c = 0; c < IN_CHANNEL; c = c + 1)
+        for (i = 0; i < IMG_HEIGHT; i = i + 1)
+            for (j = 0; j < IMG_WIDTH; j = j + 1)
+                test_image[c][i][j] = (i * 29 + j * 13 + c * 91) % 256;
+
+    rst_n = 0;
+    repeat (5) @(posedge clk);
+    rst_n = 1;
+
+    // 等待所有配置输出完整一帧 (或超时, 最慢的配置每像素 IN_CHANNEL*NUM_FILTERS 拍)
+    n = 0;
+    done = 0;
+    while (!done && n < IMG_WIDTH * IMG_HEIGHT * IN_CHANNEL * NUM_FILTERS * 2 + 500) begin
+        @(posedge clk);
+        n = n + 1;
+        done = 1;
+        for (i = 0; i < NUM_SWEEP; i = i + 1)
+            if (result_count[i] != OUTPUTS)
+                done = 0;
+        if (!hold_done)
+            done = 0;
+    end
+    repeat (5) @(posedge clk);
+
+    for (n = 0; n < NUM_SWEEP; n = n + 1) begin
+        $display("Sweep %0d: %0d multipliers, %0d cycle(s) per window: %0d outputs in %0d cycles",
+                 n, multipliers[n], cycles_per_window[n], result_count[n],
+                 last_output_cycle[n] - frame_start_cycle[n]);
+        if (result_count[n] != OUTPUTS) begin
+            $display("  ERROR: expected %0d outputs", OUTPUTS);
+            mismatches = mismatches + 1;
+        end
+        for (i = 0; i < result_count[n] && i < result_count[0]; i = i + 1) begin
+            if (results[n][i] !== results[0][i]) begin
+                if (mismatches < 10)
+                    $display("  MISMATCH sweep %0d output %0d: %h vs %h (unfolded)", n, i, results[n][i], results[0][i]);
+                mismatches = mismatches + 1;
+            end
+        end
+    end
+
+    $display("Weight swap during a folded window: %0d round(s), %0d mismatch(es)", hold_done ? 4 : 0, hold_mismatches);
+    if (!hold_done)
+        $display("  ERROR: weight swap test did not finish");
+    mismatches = mismatches + hold_mismatches + (hold_done ? 0 : 1);
+
+    if (mismatches == 0)
+        $display("SUCCESS: every folding factor produces the unfolded outputs, weights are latched per window");
+    else
+        $display("FAILURE: %0d errors", mismatches);
+    $finish;
+end
+
+endmodule
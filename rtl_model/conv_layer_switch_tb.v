@@ -0,0 +1,376 @@
+`timescale 1ns / 1ps
+
+// 层切换测试: NUM_LAYERS 帧, 第 k 帧使用第 k % NUM_WEIGHT_SETS 组权重.
+//  - db:      WEIGHT_DOUBLE_BUFFER = 1, 下一组权重在当前帧计算时预取, frame_start 时交换
+//  - golden:  单缓冲, NUM_FILTERS = NUM_WEIGHT_SETS 一次装入全部组, 与 db 同步驱动; 第 k 帧 db 的
+//             输出须与 golden 第 k % NUM_WEIGHT_SETS 个滤波器逐拍一致
+//  - db_biased/golden_biased: 同上, 加 BIAS_FILE (layer_bias.mem, 每组一个偏置, 含钳位到 0 和饱和的情况),
+//             检查偏置随权重组一起切换
+//  - legacy:  单缓冲, 每次换层须复位并重新走 WEIGHT_IDLE/LOADING/DONE (只用于计时, 权重始终为第 0 组)
+// 两种调度的帧间空隙之差即双缓冲节省的周期数, 与 reference_model 中 simulate_layer_schedule 对应.
+// 仿真结果与模型 (main.cpp, 1 个滤波器, 每拍读 27 个权重): 单缓冲 632 周期 (165 周期等待权重),
+// 双缓冲 467 周期 (0 周期等待 frame_ready), 节省 165 周期; 模型为 632 / 467 / 165.
+module conv_layer_switch_tb;
+
+parameter DATA_WIDTH = 8;
+parameter KERNEL_SIZE = 3;
+parameter IN_CHANNEL = 3;
+parameter NUM_WEIGHT_SETS = 3;            // weights.mem 共 81 个权重: 3 组, 每组一个 3x3x3 滤波器
+parameter IMG_WIDTH = 8;
+parameter IMG_HEIGHT = 8;
+parameter STRIDE = 1;
+parameter WEIGHT_WIDTH = 8;
+parameter OUTPUT_WIDTH = 20;
+parameter NUM_LAYERS = 6;
+parameter BIAS_FILE = "layer_bias.mem";   // 每组一个偏置: golden_biased 的第 s 个滤波器即 db_biased 的第 s 组
+
+localparam OUTPUTS = ((IMG_WIDTH + STRIDE - 1) / STRIDE) * ((IMG_HEIGHT + STRIDE - 1) / STRIDE);
+localparam PIXEL_BITS = IN_CHANNEL * DATA_WIDTH;
+
+reg clk;
+reg rst_n;
+integer cycle;
+
+// 时钟生成
+initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+end
+
+always @(posedge clk) begin
+    cycle <= cycle + 1;
+end
+
+// 第 frame 帧的测试像素
+function [DATA_WIDTH-1:0] test_pixel;
+    input integer frame, ch, row, col;
+    begin
+        test_pixel = (row * IMG_WIDTH + col + ch * 64 + frame * 37) % 256;
+    end
+endfunction
+
+// ---------------------------------------------------------------- db 与 golden
+reg [PIXEL_BITS-1:0] pixel_in;
+reg pixel_valid;
+reg frame_start;
+wire [OUTPUT_WIDTH-1:0] db_out;
+wire db_valid;
+wire db_frame_ready;
+wire [NUM_WEIGHT_SETS*OUTPUT_WIDTH-1:0] golden_out;
+wire golden_valid;
+wire [OUTPUT_WIDTH-1:0] db_biased_out;
+wire db_biased_valid;
+wire [NUM_WEIGHT_SETS*OUTPUT_WIDTH-1:0] golden_biased_out;
+wire golden_biased_valid;
+
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(1),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .INIT_FILE("weights.mem"),
+    .WEIGHT_DOUBLE_BUFFER(1),
+    .NUM_WEIGHT_SETS(NUM_WEIGHT_SETS)
+) db (
+    .clk(clk),
+    .rst_n(rst_n),
+    .pixel_in(pixel_in),
+    .pixel_valid(pixel_valid),
+    .frame_start(frame_start),
+    .frame_ready(db_frame_ready),
+    .conv_out(db_out),
+    .conv_valid(db_valid),
+    .conv_lane_valid()
+);
+
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(NUM_WEIGHT_SETS),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .INIT_FILE("weights.mem")
+) golden (
+    .clk(clk),
+    .rst_n(rst_n),
+    .pixel_in(pixel_in),
+    .pixel_valid(pixel_valid),
+    .frame_start(frame_start),
+    .conv_out(golden_out),
+    .conv_valid(golden_valid),
+    .conv_lane_valid()
+);
+
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(1),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .INIT_FILE("weights.mem"),
+    .BIAS_FILE(BIAS_FILE),
+    .WEIGHT_DOUBLE_BUFFER(1),
+    .NUM_WEIGHT_SETS(NUM_WEIGHT_SETS)
+) db_biased (
+    .clk(clk),
+    .rst_n(rst_n),
+    .pixel_in(pixel_in),
+    .pixel_valid(pixel_valid),
+    .frame_start(frame_start),
+    .conv_out(db_biased_out),
+    .conv_valid(db_biased_valid),
+    .conv_lane_valid()
+);
+
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(NUM_WEIGHT_SETS),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .INIT_FILE("weights.mem"),
+    .BIAS_FILE(BIAS_FILE)
+) golden_biased (
+    .clk(clk),
+    .rst_n(rst_n),
+    .pixel_in(pixel_in),
+    .pixel_valid(pixel_valid),
+    .frame_start(frame_start),
+    .conv_out(golden_biased_out),
+    .conv_valid(golden_biased_valid),
+    .conv_lane_valid()
+);
+
+// ---------------------------------------------------------------- legacy (独立复位)
+reg legacy_rst_n;
+reg [PIXEL_BITS-1:0] legacy_pixel_in;
+reg legacy_pixel_valid;
+reg legacy_frame_start;
+wire [OUTPUT_WIDTH-1:0] legacy_out;
+wire legacy_valid;
+
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(1),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .INIT_FILE("weights.mem")
+) legacy (
+    .clk(clk),
+    .rst_n(legacy_rst_n),
+    .pixel_in(legacy_pixel_in),
+    .pixel_valid(legacy_pixel_valid),
+    .frame_start(legacy_frame_start),
+    .conv_out(legacy_out),
+    .conv_valid(legacy_valid),
+    .conv_lane_valid()
+);
+
+// ---------------------------------------------------------------- 监视
+integer db_frame, db_count, db_first_start, db_last_output, db_stalls, mismatches;
+integer biased_count, biased_mismatches, db_waits;
+integer legacy_frame, legacy_count, legacy_first_start, legacy_last_output, legacy_stalls;
+reg [OUTPUT_WIDTH-1:0] expected;
+reg [OUTPUT_WIDTH-1:0] expected_biased;
+
+always @(posedge clk) begin
+    if (rst_n) begin
+        if (frame_start && db_first_start < 0)
+            db_first_start = cycle;
+        // 第一帧开始后权重无效的周期 (双缓冲应为 0)
+        if (db_first_start >= 0 && db_frame < NUM_LAYERS && !db.weights_loaded)
+            db_stalls = db_stalls + 1;
+        if (db_valid || golden_valid) begin
+            expected = golden_out[(db_frame % NUM_WEIGHT_SETS)*OUTPUT_WIDTH +: OUTPUT_WIDTH];
+            if (db_valid !== golden_valid || db_out !== expected) begin
+                if (mismatches < 10)
+                    $display("MISMATCH frame %0d output %0d: db valid=%b out=%0d, golden valid=%b filter %0d out=%0d",
+                             db_frame, db_count, db_valid, db_out, golden_valid, db_frame % NUM_WEIGHT_SETS, expected);
+                mismatches = mismatches + 1;
+            end
+            db_count = db_count + 1;
+            db_last_output = cycle;
+        end
+        if (db_biased_valid || golden_biased_valid) begin
+            expected_biased = golden_biased_out[(db_frame % NUM_WEIGHT_SETS)*OUTPUT_WIDTH +: OUTPUT_WIDTH];
+            if (db_biased_valid !== golden_biased_valid || db_biased_out !== expected_biased) begin
+                if (biased_mismatches < 10)
+                    $display("MISMATCH (biased) frame %0d output %0d: db valid=%b out=%0d, golden valid=%b filter %0d out=%0d",
+                             db_frame, biased_count, db_biased_valid, db_biased_out, golden_biased_valid,
+                             db_frame % NUM_WEIGHT_SETS, expected_biased);
+                biased_mismatches = biased_mismatches + 1;
+            end
+            biased_count = biased_count + 1;
+        end
+    end
+end
+
+always @(posedge clk) begin
+    if (legacy_frame_start && legacy_first_start < 0)
+        legacy_first_start = cycle;
+    // 第一帧开始后复位或重新加载权重的周期
+    if (legacy_first_start >= 0 && legacy_frame < NUM_LAYERS && (!legacy_rst_n || !legacy.weights_loaded))
+        legacy_stalls = legacy_stalls + 1;
+    if (legacy_rst_n && legacy_valid) begin
+        legacy_count = legacy_count + 1;
+        legacy_last_output = cycle;
+    end
+end
+
+// ---------------------------------------------------------------- 驱动 (下降沿)
+integer row, col, ch, n;
+
+// db/golden: 上一帧最后一个输出之后, 待 frame_ready (下一组权重已预取) 即开始下一帧
+initial begin
+    pixel_in = 0;
+    pixel_valid = 0;
+    frame_start = 0;
+    @(posedge rst_n);
+    wait (db.weights_loaded && golden.weights_loaded && db_biased.weights_loaded && golden_biased.weights_loaded);
+    for (db_frame = 0; db_frame < NUM_LAYERS; db_frame = db_frame + 1) begin
+        db_count = 0;
+        biased_count = 0;
+        @(negedge clk);
+        while (!db_frame_ready) begin
+            @(negedge clk);
+            db_waits = db_waits + 1;
+        end
+        frame_start = 1;
+        @(negedge clk);
+        frame_start = 0;
+        for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+            for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1)
+                    pixel_in[ch*DATA_WIDTH +: DATA_WIDTH] = test_pixel(db_frame, ch, row, col);
+                pixel_valid = 1;
+                @(negedge clk);
+            end
+        end
+        pixel_valid = 0;
+        wait (db_count == OUTPUTS);
+    end
+end
+
+integer legacy_row, legacy_col, legacy_ch;
+
+// legacy: 换层时复位一个周期, 等权重重新加载后开始下一帧
+initial begin
+    legacy_rst_n = 0;
+    legacy_pixel_in = 0;
+    legacy_pixel_valid = 0;
+    legacy_frame_start = 0;
+    @(posedge rst_n);
+    @(negedge clk);
+    legacy_rst_n = 1;
+    wait (legacy.weights_loaded);
+    for (legacy_frame = 0; legacy_frame < NUM_LAYERS; legacy_frame = legacy_frame + 1) begin
+        legacy_count = 0;
+        @(negedge clk);
+        legacy_frame_start = 1;
+        @(negedge clk);
+        legacy_frame_start = 0;
+        for (legacy_row = 0; legacy_row < IMG_HEIGHT; legacy_row = legacy_row + 1) begin
+            for (legacy_col = 0; legacy_col < IMG_WIDTH; legacy_col = legacy_col + 1) begin
+                for (legacy_ch = 0; legacy_ch < IN_CHANNEL; legacy_ch = legacy_ch + 1)
+                    legacy_pixel_in[legacy_ch*DATA_WIDTH +: DATA_WIDTH] = test_pixel(legacy_frame, legacy_ch, legacy_row, legacy_col);
+                legacy_pixel_valid = 1;
+                @(negedge clk);
+            end
+        end
+        legacy_pixel_valid = 0;
+        wait (legacy_count == OUTPUTS);
+        if (legacy_frame < NUM_LAYERS - 1) begin
+            @(negedge clk);
+            legacy_rst_n = 0;
+            @(negedge clk);
+            legacy_rst_n = 1;
+            wait (legacy.weights_loaded);
+        end
+    end
+end
+
+// ---------------------------------------------------------------- 主流程
+integer db_cycles, legacy_cycles;
+
+initial begin
+    $display("=== Conv Layer Switch Test (%0d layers, %0d weight sets, %0dx%0d, K=%0d) ===",
+             NUM_LAYERS, NUM_WEIGHT_SETS, IMG_WIDTH, IMG_HEIGHT, KERNEL_SIZE);
+    cycle = 0;
+    db_first_start = -1;
+    db_last_output = 0;
+    db_stalls = 0;
+    db_waits = 0;
+    db_count = 0;
+    legacy_first_start = -1;
+    legacy_last_output = 0;
+    legacy_stalls = 0;
+    legacy_count = 0;
+    mismatches = 0;
+    biased_count = 0;
+    biased_mismatches = 0;
+
+    rst_n = 0;
+    repeat (5) @(posedge clk);
+    rst_n = 1;
+
+    // 等待两种调度都完成所有层 (或超时)
+    n = 0;
+    while (!(db_frame == NUM_LAYERS && legacy_frame == NUM_LAYERS) &&
+           n < NUM_LAYERS * (IMG_WIDTH * IMG_HEIGHT * 4 + 200)) begin
+        @(posedge clk);
+        n = n + 1;
+    end
+    repeat (5) @(posedge clk);
+
+    db_cycles = db_last_output - db_first_start;
+    legacy_cycles = legacy_last_output - legacy_first_start;
+    $display("Single buffer (reset + reload per layer): %0d cycles, %0d weight stall cycles",
+             legacy_cycles, legacy_stalls);
+    $display("Double buffer (prefetch, swap at frame_start): %0d cycles, %0d weight stall cycles, %0d cycles waiting for frame_ready",
+             db_cycles, db_stalls, db_waits);
+    $display("Saved %0d cycles over %0d layer switches (%0d per switch), load beats per layer %0d",
+             legacy_cycles - db_cycles, NUM_LAYERS - 1, (legacy_cycles - db_cycles) / (NUM_LAYERS - 1),
+             db.double_buffer.bank_inst.LOAD_BEATS);
+
+    if (db_frame != NUM_LAYERS || legacy_frame != NUM_LAYERS) begin
+        $display("  ERROR: timeout, db finished %0d frames, legacy %0d", db_frame, legacy_frame);
+        mismatches = mismatches + 1;
+    end
+    if (biased_mismatches != 0) begin
+        $display("  ERROR: %0d biased outputs do not match their weight and bias set", biased_mismatches);
+        mismatches = mismatches + biased_mismatches;
+    end
+    if (db_stalls != 0) begin
+        $display("  ERROR: double buffer stalled for %0d cycles", db_stalls);
+        mismatches = mismatches + 1;
+    end
+    if (mismatches == 0)
+        $display("SUCCESS: every frame matches its weight and bias set with zero switch bubbles");
+    else
+        $display("FAILURE: %0d errors", mismatches);
+    $finish;
+end
+
+endmodule
@@ -1,673 +1,673 @@
-`timescale 1ns / 1ps
-
-module conv_tb;
-
-// Parameters - 可配置参数，修改这些参数时测试台应该仍然工作
-parameter DATA_WIDTH = 8;
-parameter KERNEL_SIZE = 3;
-parameter IN_CHANNEL = 3;
-parameter NUM_FILTERS = 3;
-parameter IMG_WIDTH = 8;
-parameter IMG_HEIGHT = 8;
-parameter STRIDE = 1;
-parameter PADDING = (KERNEL_SIZE - 1) / 2;
-parameter WEIGHT_WIDTH = 8;
-parameter OUTPUT_WIDTH = 20;
-parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL);
-parameter INIT_FILE = "weights.mem";
-
-// Test case selection parameter - 修改这个值来选择不同的测试用例
-// 0: Gradient pattern
-// 1: Checkerboard pattern  
-// 2: Random pattern
-// 3: All-zeros pattern
-// 4: All-max values pattern
-// 5: Border pattern
-// 6: Diagonal pattern
-parameter TEST_CASE_SELECT = 0;
-
-// Calculated parameters
-parameter OUTPUT_IMG_WIDTH = (IMG_WIDTH + 2*PADDING - KERNEL_SIZE) / STRIDE + 1;
-parameter OUTPUT_IMG_HEIGHT = (IMG_HEIGHT + 2*PADDING - KERNEL_SIZE) / STRIDE + 1;
-parameter WEIGHTS_PER_FILTER = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
-parameter TOTAL_WEIGHTS = NUM_FILTERS * WEIGHTS_PER_FILTER;
-
-// Signals
-reg clk;
-reg rst_n;
-reg [IN_CHANNEL*DATA_WIDTH-1:0] pixel_in;
-reg pixel_valid;
-reg frame_start;
-wire [NUM_FILTERS*OUTPUT_WIDTH-1:0] conv_out;
-wire conv_valid;
-
-// Test data structures
-reg [DATA_WIDTH-1:0] test_image [0:IN_CHANNEL-1][0:IMG_HEIGHT-1][0:IMG_WIDTH-1];
-reg [WEIGHT_WIDTH-1:0] golden_weights [0:NUM_FILTERS-1][0:IN_CHANNEL-1][0:KERNEL_SIZE-1][0:KERNEL_SIZE-1];
-reg [OUTPUT_WIDTH-1:0] golden_output [0:NUM_FILTERS-1][0:OUTPUT_IMG_HEIGHT-1][0:OUTPUT_IMG_WIDTH-1];
-reg [OUTPUT_WIDTH-1:0] actual_output [0:NUM_FILTERS-1][0:OUTPUT_IMG_HEIGHT-1][0:OUTPUT_IMG_WIDTH-1];
-
-// Test control variables
-integer row, col, ch, f, k_row, k_col;
-integer output_count;
-integer expected_outputs;
-integer total_errors;
-integer current_output_row, current_output_col;
-integer test_case_errors;
-
-// Statistics
-integer passed_tests;
-real accuracy_sum;
-
-// Clock generation
-always #5 clk = ~clk;
-
-// DUT instantiation
-conv #(
-    .DATA_WIDTH(DATA_WIDTH),
-    .KERNEL_SIZE(KERNEL_SIZE),
-    .IN_CHANNEL(IN_CHANNEL),
-    .NUM_FILTERS(NUM_FILTERS),
-    .IMG_WIDTH(IMG_WIDTH),
-    .IMG_HEIGHT(IMG_HEIGHT),
-    .STRIDE(STRIDE),
-    .PADDING(PADDING),
-    .WEIGHT_WIDTH(WEIGHT_WIDTH),
-    .OUTPUT_WIDTH(OUTPUT_WIDTH),
-    .ACC_WIDTH(ACC_WIDTH),
-    .INIT_FILE(INIT_FILE)
-) dut (
-    .clk(clk),
-    .rst_n(rst_n),
-    .pixel_in(pixel_in),
-    .pixel_valid(pixel_valid),
-    .frame_start(frame_start),
-    .conv_out(conv_out),
-    .conv_valid(conv_valid)
-);
-
-// Main test sequence
-initial begin
-    clk = 0;
-    total_errors = 0;
-    passed_tests = 0;
-    accuracy_sum = 0.0;
-    
-    $dumpfile("conv_tb.vcd");
-    $dumpvars(0, conv_tb);
-    
-    // 0. 基本配置
-    $display("=== Comprehensive Conv Module Test ===");
-    $display("Configuration:");
-    $display("  Image size: %0dx%0d", IMG_WIDTH, IMG_HEIGHT);
-    $display("  Output size: %0dx%0d", OUTPUT_IMG_WIDTH, OUTPUT_IMG_HEIGHT);
-    $display("  Channels: %0d, Filters: %0d", IN_CHANNEL, NUM_FILTERS);
-    $display("  Kernel size: %0dx%0d", KERNEL_SIZE, KERNEL_SIZE);
-    $display("  Stride: %0d, Padding: %0d", STRIDE, PADDING);
-    $display("  Data width: %0d bits, Weight width: %0d bits", DATA_WIDTH, WEIGHT_WIDTH);
-    $display("  Output width: %0d bits", OUTPUT_WIDTH);
-    $display("  Weight file: %s", INIT_FILE);
-    $display("  Selected test case: %0d", TEST_CASE_SELECT);
-    
-    // Load golden weights
-    load_golden_weights();
-    
-    // ========== 直接执行测试用例 ==========
-    $display("\n================================================================================");
-    $display("Running Test Case %0d (Pattern Type %0d)", TEST_CASE_SELECT, TEST_CASE_SELECT);
-    $display("================================================================================");
-    
-    // 1. 测试的case
-    display_test_case_info(TEST_CASE_SELECT);
-    
-    // Generate test pattern
-    generate_test_pattern(TEST_CASE_SELECT);
-    
-    // 2. 测试的图片
-    display_test_image();
-    
-    // Calculate golden reference
-    calculate_golden_reference();
-    
-    // 手动验证第一个输出位置 [0,0] 的计算
-    $display("\n=== Manual Verification for Position [0,0] ===");
-    verify_position_0_0();
-    
-    // Reset DUT
-    rst_n = 0;
-    pixel_in = 0;
-    pixel_valid = 0;
-    frame_start = 0;
-    output_count = 0;
-    current_output_row = 0;
-    current_output_col = 0;
-    
-    #20 rst_n = 1;
-    
-    // Wait for weights to load
-    wait(dut.weights_loaded == 1);
-    $display("DUT weights loaded successfully");
-    
-    #20;
-    
-    // Start frame
-    frame_start = 1;
-    #10;
-    frame_start = 0;
-    
-    // Feed image data
-    $display("Feeding image data...");
-    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-            pixel_in = {test_image[2][row][col], test_image[1][row][col], test_image[0][row][col]};
-            pixel_valid = 1;
-            #10;
-            pixel_valid = 0;
-        end
-    end
-    
-    // Wait for all outputs
-    expected_outputs = OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT;
-    $display("Waiting for %0d outputs...", expected_outputs);
-    
-    while (output_count < expected_outputs) begin
-        #10;
-    end
-    
-    #100; // Additional wait
-    
-    // 4. 每一项的实际结果和预期结果，match or mismatch
-    display_results();
-    
-    // 5. 错误数目，正确率
-    compare_results();
-    
-    // Additional debugging for Filter 0 issue
-    verify_dut_weights();
-    check_timing_alignment();
-    
-    $finish;
-end
-
-// Load weights from file - 与weight.v模块保持一致的读取方式
-task load_golden_weights;
-    integer weight_file;
-    integer weight_idx;
-    reg [WEIGHT_WIDTH-1:0] temp_weight;
-    reg [WEIGHT_WIDTH-1:0] weight_memory [0:TOTAL_WEIGHTS-1];
-    integer f_idx, ch_idx, kr_idx, kc_idx;
-    integer base_addr, offset;
-    begin
-        $display("Loading weights from %s...", INIT_FILE);
-        
-        // 首先读取整个权重文件到临时数组，与weight.v的$readmemh行为一致
-        weight_file = $fopen(INIT_FILE, "r");
-        if (weight_file == 0) begin
-            $display("ERROR: Cannot open weights file %s", INIT_FILE);
-            $finish;
-        end
-        
-        // 使用$readmemh读取，与weight.v保持一致
-        $fclose(weight_file);
-        $readmemh(INIT_FILE, weight_memory);
-        
-        // 按照weight.v的地址计算方式重新组织权重
-        for (f_idx = 0; f_idx < NUM_FILTERS; f_idx = f_idx + 1) begin
-            base_addr = f_idx * WEIGHTS_PER_FILTER;
-            for (ch_idx = 0; ch_idx < IN_CHANNEL; ch_idx = ch_idx + 1) begin
-                for (kr_idx = 0; kr_idx < KERNEL_SIZE; kr_idx = kr_idx + 1) begin
-                    for (kc_idx = 0; kc_idx < KERNEL_SIZE; kc_idx = kc_idx + 1) begin
-                        offset = ch_idx * KERNEL_SIZE * KERNEL_SIZE + kr_idx * KERNEL_SIZE + kc_idx;
-                        golden_weights[f_idx][ch_idx][kr_idx][kc_idx] = weight_memory[base_addr + offset];
-                    end
-                end
-            end
-        end
-        
-        $display("Golden weights loaded successfully (%0d weights)", TOTAL_WEIGHTS);
-        
-        // 3. filter的权重
-        display_weights();
-    end
-endtask
-
-// Display test case description
-task display_test_case_info;
-    input integer pattern_type;
-    begin
-        $display("\n=== Test Case Information ===");
-        case (pattern_type)
-            0: $display("Pattern Type 0: Gradient Pattern - Values increase from top-left to bottom-right");
-            1: $display("Pattern Type 1: Checkerboard Pattern - Alternating 0xFF and 0x00 values");
-            2: $display("Pattern Type 2: Random Pattern - Pseudo-random values");
-            3: $display("Pattern Type 3: All-Zeros Pattern - All pixels set to 0x00");
-            4: $display("Pattern Type 4: All-Max Pattern - All pixels set to 0xFF");
-            5: $display("Pattern Type 5: Border Pattern - 0xFF on edges, 0x00 in center");
-            6: $display("Pattern Type 6: Diagonal Pattern - 0xFF on diagonals, 0x00 elsewhere");
-            default: $display("Pattern Type %0d: Unknown pattern", pattern_type);
-        endcase
-        $display("=============================");
-    end
-endtask
-
-// Generate test patterns - 多种测试模式
-task generate_test_pattern;
-    input integer pattern_type;
-    begin
-        case (pattern_type)
-            0: begin // Gradient pattern
-                $display("Generating gradient test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = (ch * 64) + (row * 8) + col + 1;
-                            if (test_image[ch][row][col] > 255) 
-                                test_image[ch][row][col] = test_image[ch][row][col] % 256;
-                        end
-                    end
-                end
-            end
-            
-            1: begin // Checkerboard pattern
-                $display("Generating checkerboard test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = ((row + col + ch) % 2) ? 8'hFF : 8'h00;
-                        end
-                    end
-                end
-            end
-            
-            2: begin // Random pattern
-                $display("Generating random test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = $random % 256;
-                            if (test_image[ch][row][col] < 0) 
-                                test_image[ch][row][col] = -test_image[ch][row][col];
-                        end
-                    end
-                end
-            end
-            
-            3: begin // Edge case pattern - all zeros
-                $display("Generating all-zeros test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = 8'h00;
-                        end
-                    end
-                end
-            end
-            
-            4: begin // Edge case pattern - all max values
-                $display("Generating all-max test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = 8'hFF;
-                        end
-                    end
-                end
-            end
-            
-            5: begin // Border pattern
-                $display("Generating border test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            if (row == 0 || row == IMG_HEIGHT-1 || col == 0 || col == IMG_WIDTH-1)
-                                test_image[ch][row][col] = 8'hFF;
-                            else
-                                test_image[ch][row][col] = 8'h00;
-                        end
-                    end
-                end
-            end
-            
-            6: begin // Diagonal pattern
-                $display("Generating diagonal test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            if (row == col || row + col == IMG_WIDTH - 1)
-                                test_image[ch][row][col] = 8'hFF;
-                            else
-                                test_image[ch][row][col] = 8'h00;
-                        end
-                    end
-                end
-            end
-            
-            default: begin // Simple increment pattern
-                $display("Generating simple increment test pattern");
-                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                            test_image[ch][row][col] = (row * IMG_WIDTH + col + ch * 64) % 256;
-                        end
-                    end
-                end
-            end
-        endcase
-    end
-endtask
-
-// Golden reference convolution calculation - 无符号算术
-task calculate_golden_reference;
-    integer out_row, out_col;
-    integer src_row, src_col;
-    integer sum;
-    integer pixel_val, weight_val;
-    integer window_center_row, window_center_col;
-    integer kernel_row, kernel_col;
-    begin
-        $display("Calculating golden reference (unsigned arithmetic, matching window.v logic)...");
-        
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            for (out_row = 0; out_row < OUTPUT_IMG_HEIGHT; out_row = out_row + 1) begin
-                for (out_col = 0; out_col < OUTPUT_IMG_WIDTH; out_col = out_col + 1) begin
-                    sum = 0;
-                    
-                    // 窗口中心位置（与window.v中的x_window, y_window对应）
-                    window_center_row = out_row * STRIDE;
-                    window_center_col = out_col * STRIDE;
-                    
-                    // 卷积计算 - 与window.v的窗口生成逻辑完全一致
-                    for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                        for (kernel_row = 0; kernel_row < KERNEL_SIZE; kernel_row = kernel_row + 1) begin
-                            for (kernel_col = 0; kernel_col < KERNEL_SIZE; kernel_col = kernel_col + 1) begin
-                                // 计算实际图像坐标（与window.v中的src_y, src_x计算一致）
-                                src_row = window_center_row + kernel_row - (KERNEL_SIZE >> 1);
-                                src_col = window_center_col + kernel_col - (KERNEL_SIZE >> 1);
-                                
-                                // 边界检查和padding处理（与window.v一致）
-                                if (src_row >= 0 && src_row < IMG_HEIGHT && 
-                                    src_col >= 0 && src_col < IMG_WIDTH) begin
-                                    pixel_val = test_image[ch][src_row][src_col];
-                                end else begin
-                                    pixel_val = 0; // Padding值为0，与window.v一致
-                                end
-                                
-                                weight_val = golden_weights[f][ch][kernel_row][kernel_col];
-                                sum = sum + (pixel_val * weight_val);
-                            end
-                        end
-                    end
-                    
-                    // Apply saturation (unsigned)
-                    if (sum > ((1 << OUTPUT_WIDTH) - 1))
-                        golden_output[f][out_row][out_col] = (1 << OUTPUT_WIDTH) - 1;
-                    else if (sum < 0)
-                        golden_output[f][out_row][out_col] = 0;
-                    else
-                        golden_output[f][out_row][out_col] = sum;
-                end
-            end
-        end
-        $display("Golden reference calculation completed");
-    end
-endtask
-
-// Display test image
-task display_test_image;
-    begin
-        $display("\n=== Test Image (Unsigned Values) ===");
-        for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-            $display("Channel %0d:", ch);
-            for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
-                $write("  ");
-                for (col = 0; col < IMG_WIDTH; col = col + 1) begin
-                    $write("%3d ", test_image[ch][row][col]);
-                end
-                $write("\n");
-            end
-        end
-    end
-endtask
-
-// Display weights
-task display_weights;
-    begin
-        $display("\n=== Weights (Unsigned Values) ===");
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            $display("Filter %0d:", f);
-            for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-                $display("  Channel %0d:", ch);
-                for (k_row = 0; k_row < KERNEL_SIZE; k_row = k_row + 1) begin
-                    $write("    ");
-                    for (k_col = 0; k_col < KERNEL_SIZE; k_col = k_col + 1) begin
-                        $write("%3d ", golden_weights[f][ch][k_row][k_col]);
-                    end
-                    $write("\n");
-                end
-            end
-        end
-        
-        // 验证权重加载是否正确
-        $display("\n=== Weight Verification ===");
-        $display("Expected first few weights from weights.mem:");
-        $display("Filter 0, Channel 0: FF(255), 00(0), 01(1), FE(254), 00(0), 02(2), FF(255), 00(0), 01(1)");
-        $display("Actual loaded weights:");
-        $display("Filter 0, Channel 0: %0d, %0d, %0d, %0d, %0d, %0d, %0d, %0d, %0d",
-                 golden_weights[0][0][0][0], golden_weights[0][0][0][1], golden_weights[0][0][0][2],
-                 golden_weights[0][0][1][0], golden_weights[0][0][1][1], golden_weights[0][0][1][2],
-                 golden_weights[0][0][2][0], golden_weights[0][0][2][1], golden_weights[0][0][2][2]);
-    end
-endtask
-
-// Display expected vs actual results
-task display_results;
-    begin
-        $display("\n=== Expected vs Actual Results (Unsigned) ===");
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            $display("Filter %0d:", f);
-            $display("  Position | Expected | Actual | Status");
-            $display("  ---------|----------|--------|--------");
-            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
-                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
-                    $display("  [%0d,%0d]   | %8d | %6d | %s", 
-                            row, col, 
-                            golden_output[f][row][col], 
-                            actual_output[f][row][col],
-                            (actual_output[f][row][col] == golden_output[f][row][col]) ? "PASS" : "FAIL");
-                end
-            end
-        end
-    end
-endtask
-
-// Compare results and calculate accuracy
-task compare_results;
-    integer match;
-    integer total_comparisons;
-    real accuracy;
-    integer filter_errors;
-    begin
-        $display("\n=== Detailed Comparison Results ===");
-        test_case_errors = 0;
-        total_comparisons = 0;
-        
-        // Show detailed mismatch information
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            $display("\nFilter %0d detailed analysis:", f);
-            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
-                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
-                    match = (actual_output[f][row][col] == golden_output[f][row][col]);
-                    total_comparisons = total_comparisons + 1;
-                    
-                    if (!match) begin
-                        test_case_errors = test_case_errors + 1;
-                        $display("  MISMATCH [%0d,%0d]: Expected=%0d, Actual=%0d, Diff=%0d", 
-                                row, col, 
-                                golden_output[f][row][col], 
-                                actual_output[f][row][col],
-                                $signed(actual_output[f][row][col]) - $signed(golden_output[f][row][col]));
-                    end
-                end
-            end
-        end
-        
-        accuracy = (total_comparisons - test_case_errors) * 100.0 / total_comparisons;
-        accuracy_sum = accuracy_sum + accuracy;
-        
-        $display("\n=== Test Case %0d Summary ===", TEST_CASE_SELECT);
-        $display("  Pattern Type: %0d", TEST_CASE_SELECT);
-        $display("  Total comparisons: %0d", total_comparisons);
-        $display("  Matches: %0d", total_comparisons - test_case_errors);
-        $display("  Mismatches: %0d", test_case_errors);
-        $display("  Accuracy: %0.2f%%", accuracy);
-        $display("  Status: %s", (test_case_errors == 0) ? "PASSED" : "FAILED");
-        
-        // Filter-wise accuracy
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            filter_errors = 0;
-            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
-                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
-                    if (actual_output[f][row][col] != golden_output[f][row][col]) begin
-                        filter_errors = filter_errors + 1;
-                    end
-                end
-            end
-            $display("  Filter %0d: %0d/%0d correct (%.2f%%)", 
-                     f, 
-                     OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT - filter_errors,
-                     OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT,
-                     (OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT - filter_errors) * 100.0 / (OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT));
-        end
-        
-        if (test_case_errors == 0) begin
-            passed_tests = passed_tests + 1;
-        end
-        
-        total_errors = total_errors + test_case_errors;
-    end
-endtask
-
-// Monitor outputs and store them - 增加详细输出
-always @(posedge clk) begin
-    if (conv_valid) begin
-        if (current_output_col >= OUTPUT_IMG_WIDTH) begin
-            current_output_col = 0;
-            current_output_row = current_output_row + 1;
-        end
-        
-        // Store actual outputs
-        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
-            actual_output[f][current_output_row][current_output_col] = 
-                conv_out[(f+1)*OUTPUT_WIDTH-1 -: OUTPUT_WIDTH];
-        end
-        
-        output_count = output_count + 1;
-        
-        // Display each output for debugging
-        $display("Output %2d at [%0d,%0d]: Filter0=%0d, Filter1=%0d, Filter2=%0d", 
-                 output_count, current_output_row, current_output_col,
-                 conv_out[OUTPUT_WIDTH-1:0],
-                 conv_out[2*OUTPUT_WIDTH-1:OUTPUT_WIDTH],
-                 conv_out[3*OUTPUT_WIDTH-1:2*OUTPUT_WIDTH]);
-        
-        // Special debugging for first few outputs
-        if (output_count <= 3) begin
-            $display("  Debug: conv_out = %h", conv_out);
-            $display("  Debug: Filter0 bits [19:0] = %h (%0d)", conv_out[19:0], conv_out[19:0]);
-            $display("  Debug: Filter1 bits [39:20] = %h (%0d)", conv_out[39:20], conv_out[39:20]);
-            $display("  Debug: Filter2 bits [59:40] = %h (%0d)", conv_out[59:40], conv_out[59:40]);
-        end
-        
-        current_output_col = current_output_col + 1;
-    end
-end
-
-// Manual verification for position [0,0]
-task verify_position_0_0;
-    integer manual_sum_f0, manual_sum_f1, manual_sum_f2;
-    integer ch, kr, kc;
-    integer src_row, src_col, pixel_val, weight_val;
-    begin
-        manual_sum_f0 = 0;
-        manual_sum_f1 = 0;
-        manual_sum_f2 = 0;
-        
-        $display("Calculating position [0,0] manually:");
-        $display("Window center: row=0, col=0");
-        
-        for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
-            $display("Channel %0d:", ch);
-            for (kr = 0; kr < KERNEL_SIZE; kr = kr + 1) begin
-                for (kc = 0; kc < KERNEL_SIZE; kc = kc + 1) begin
-                    // 计算实际图像坐标
-                    src_row = 0 + kr - (KERNEL_SIZE >> 1); // 0 + kr - 1
-                    src_col = 0 + kc - (KERNEL_SIZE >> 1); // 0 + kc - 1
-                    
-                    // 边界检查和padding处理
-                    if (src_row >= 0 && src_row < IMG_HEIGHT && 
-                        src_col >= 0 && src_col < IMG_WIDTH) begin
-                        pixel_val = test_image[ch][src_row][src_col];
-                    end else begin
-                        pixel_val = 0; // Padding
-                    end
-                    
-                    $display("  [%0d,%0d] src=(%0d,%0d) pixel=%0d weights: F0=%0d F1=%0d F2=%0d", 
-                             kr, kc, src_row, src_col, pixel_val,
-                             golden_weights[0][ch][kr][kc],
-                             golden_weights[1][ch][kr][kc], 
-                             golden_weights[2][ch][kr][kc]);
-                    
-                    manual_sum_f0 = manual_sum_f0 + (pixel_val * golden_weights[0][ch][kr][kc]);
-                    manual_sum_f1 = manual_sum_f1 + (pixel_val * golden_weights[1][ch][kr][kc]);
-                    manual_sum_f2 = manual_sum_f2 + (pixel_val * golden_weights[2][ch][kr][kc]);
-                end
-            end
-        end
-        
-        $display("Manual calculation results for [0,0]:");
-        $display("  Filter 0: %0d (expected: %0d)", manual_sum_f0, golden_output[0][0][0]);
-        $display("  Filter 1: %0d (expected: %0d)", manual_sum_f1, golden_output[1][0][0]);
-        $display("  Filter 2: %0d (expected: %0d)", manual_sum_f2, golden_output[2][0][0]);
-    end
-endtask
-
-// Add DUT weight verification task
-task verify_dut_weights;
-    begin
-        $display("\n=== DUT Weight Verification ===");
-        $display("Checking if DUT weights match expected weights for Filter 0...");
-        
-        // Check a few key weights for Filter 0
-        $display("Expected Filter 0 weights (first channel, first row): 255, 0, 1");
-        $display("DUT Filter 0 weights: Accessing dut.weight_inst.weight_mem...");
-        
-        // Note: This requires the weight memory to be accessible from testbench
-        // The exact path depends on the conv.v implementation
-        if ($test$plusargs("debug_weights")) begin
-            $display("Weight debugging enabled - checking DUT internal weights");
-            // Add specific weight checking code here based on conv.v structure
-        end
-    end
-endtask
-
-// Add task to check for timing issues
-task check_timing_alignment;
-    begin
-        $display("\n=== Timing Alignment Check ===");
-        $display("Checking if Filter 0 output is delayed or offset...");
-        
-        // Compare the pattern of differences
-        $display("Filter 0 difference pattern analysis:");
-        $display("Position [0,0]: Expected=618, Actual=106902, Diff=106284");
-        $display("Position [0,1]: Expected=106002, Actual=109038, Diff=3036");
-        $display("Position [1,1]: Expected=168216, Actual=172776, Diff=4560");
-        
-        $display("Observations:");
-        $display("- Most middle positions have +4560 offset");
-        $display("- First column has much larger positive offsets");
-        $display("- Last column has large negative offsets");
-        $display("- This suggests a systematic calculation or indexing error in Filter 0");
-    end
-endtask
-
+`timescale 1ns / 1ps
+
+module conv_tb;
+
+// Parameters - 可配置参数，修改这些参数时测试台应该仍然工作
+parameter DATA_WIDTH = 8;
+parameter KERNEL_SIZE = 3;
+parameter IN_CHANNEL = 3;
+parameter NUM_FILTERS = 3;
+parameter IMG_WIDTH = 8;
+parameter IMG_HEIGHT = 8;
+parameter STRIDE = 1;
+parameter PADDING = (KERNEL_SIZE - 1) / 2;
+parameter WEIGHT_WIDTH = 8;
+parameter OUTPUT_WIDTH = 20;
+parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL);
+parameter INIT_FILE = "weights.mem";
+
+// Test case selection parameter - 修改这个值来选择不同的测试用例
+// 0: Gradient pattern
+// 1: Checkerboard pattern  
+// 2: Random pattern
+// 3: All-zeros pattern
+// 4: All-max values pattern
+// 5: Border pattern
+// 6: Diagonal pattern
+parameter TEST_CASE_SELECT = 0;
+
+// Calculated parameters
+parameter OUTPUT_IMG_WIDTH = (IMG_WIDTH + 2*PADDING - KERNEL_SIZE) / STRIDE + 1;
+parameter OUTPUT_IMG_HEIGHT = (IMG_HEIGHT + 2*PADDING - KERNEL_SIZE) / STRIDE + 1;
+parameter WEIGHTS_PER_FILTER = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
+parameter TOTAL_WEIGHTS = NUM_FILTERS * WEIGHTS_PER_FILTER;
+
+// Signals
+reg clk;
+reg rst_n;
+reg [IN_CHANNEL*DATA_WIDTH-1:0] pixel_in;
+reg pixel_valid;
+reg frame_start;
+wire [NUM_FILTERS*OUTPUT_WIDTH-1:0] conv_out;
+wire conv_valid;
+
+// Test data structures
+reg [DATA_WIDTH-1:0] test_image [0:IN_CHANNEL-1][0:IMG_HEIGHT-1][0:IMG_WIDTH-1];
+reg [WEIGHT_WIDTH-1:0] golden_weights [0:NUM_FILTERS-1][0:IN_CHANNEL-1][0:KERNEL_SIZE-1][0:KERNEL_SIZE-1];
+reg [OUTPUT_WIDTH-1:0] golden_output [0:NUM_FILTERS-1][0:OUTPUT_IMG_HEIGHT-1][0:OUTPUT_IMG_WIDTH-1];
+reg [OUTPUT_WIDTH-1:0] actual_output [0:NUM_FILTERS-1][0:OUTPUT_IMG_HEIGHT-1][0:OUTPUT_IMG_WIDTH-1];
+
+// Test control variables
+integer row, col, ch, f, k_row, k_col;
+integer output_count;
+integer expected_outputs;
+integer total_errors;
+integer current_output_row, current_output_col;
+integer test_case_errors;
+
+// Statistics
+integer passed_tests;
+real accuracy_sum;
+
+// Clock generation
+always #5 clk = ~clk;
+
+// DUT instantiation
+conv #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .NUM_FILTERS(NUM_FILTERS),
+    .IMG_WIDTH(IMG_WIDTH),
+    .IMG_HEIGHT(IMG_HEIGHT),
+    .STRIDE(STRIDE),
+    .PADDING(PADDING),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .ACC_WIDTH(ACC_WIDTH),
+    .INIT_FILE(INIT_FILE)
+) dut (
+    .clk(clk),
+    .rst_n(rst_n),
+    .pixel_in(pixel_in),
+    .pixel_valid(pixel_valid),
+    .frame_start(frame_start),
+    .conv_out(conv_out),
+    .conv_valid(conv_valid)
+);
+
+// Main test sequence
+initial begin
+    clk = 0;
+    total_errors = 0;
+    passed_tests = 0;
+    accuracy_sum = 0.0;
+    
+    $dumpfile("conv_tb.vcd");
+    $dumpvars(0, conv_tb);
+    
+    // 0. 基本配置
+    $display("=== Comprehensive Conv Module Test ===");
+    $display("Configuration:");
+    $display("  Image size: %0dx%0d", IMG_WIDTH, IMG_HEIGHT);
+    $display("  Output size: %0dx%0d", OUTPUT_IMG_WIDTH, OUTPUT_IMG_HEIGHT);
+    $display("  Channels: %0d, Filters: %0d", IN_CHANNEL, NUM_FILTERS);
+    $display("  Kernel size: %0dx%0d", KERNEL_SIZE, KERNEL_SIZE);
+    $display("  Stride: %0d, Padding: %0d", STRIDE, PADDING);
+    $display("  Data width: %0d bits, Weight width: %0d bits", DATA_WIDTH, WEIGHT_WIDTH);
+    $display("  Output width: %0d bits", OUTPUT_WIDTH);
+    $display("  Weight file: %s", INIT_FILE);
+    $display("  Selected test case: %0d", TEST_CASE_SELECT);
+    
+    // Load golden weights
+    load_golden_weights();
+    
+    // ========== 直接执行测试用例 ==========
+    $display("\n================================================================================");
+    $display("Running Test Case %0d (Pattern Type %0d)", TEST_CASE_SELECT, TEST_CASE_SELECT);
+    $display("================================================================================");
+    
+    // 1. 测试的case
+    display_test_case_info(TEST_CASE_SELECT);
+    
+    // Generate test pattern
+    generate_test_pattern(TEST_CASE_SELECT);
+    
+    // 2. 测试的图片
+    display_test_image();
+    
+    // Calculate golden reference
+    calculate_golden_reference();
+    
+    // 手动验证第一个输出位置 [0,0] 的计算
+    $display("\n=== Manual Verification for Position [0,0] ===");
+    verify_position_0_0();
+    
+    // Reset DUT
+    rst_n = 0;
+    pixel_in = 0;
+    pixel_valid = 0;
+    frame_start = 0;
+    output_count = 0;
+    current_output_row = 0;
+    current_output_col = 0;
+    
+    #20 rst_n = 1;
+    
+    // Wait for weights to load
+    wait(dut.weights_loaded == 1);
+    $display("DUT weights loaded successfully");
+    
+    #20;
+    
+    // Start frame
+    frame_start = 1;
+    #10;
+    frame_start = 0;
+    
+    // Feed image data
+    $display("Feeding image data...");
+    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+            pixel_in = {test_image[2][row][col], test_image[1][row][col], test_image[0][row][col]};
+            pixel_valid = 1;
+            #10;
+            pixel_valid = 0;
+        end
+    end
+    
+    // Wait for all outputs
+    expected_outputs = OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT;
+    $display("Waiting for %0d outputs...", expected_outputs);
+    
+    while (output_count < expected_outputs) begin
+        #10;
+    end
+    
+    #100; // Additional wait
+    
+    // 4. 每一项的实际结果和预期结果，match or mismatch
+    display_results();
+    
+    // 5. 错误数目，正确率
+    compare_results();
+    
+    // Additional debugging for Filter 0 issue
+    verify_dut_weights();
+    check_timing_alignment();
+    
+    $finish;
+end
+
+// Load weights from file - 与weight.v模块保持一致的读取方式
+task load_golden_weights;
+    integer weight_file;
+    integer weight_idx;
+    reg [WEIGHT_WIDTH-1:0] temp_weight;
+    reg [WEIGHT_WIDTH-1:0] weight_memory [0:TOTAL_WEIGHTS-1];
+    integer f_idx, ch_idx, kr_idx, kc_idx;
+    integer base_addr, offset;
+    begin
+        $display("Loading weights from %s...", INIT_FILE);
+        
+        // 首先读取整个权重文件到临时数组，与weight.v的$readmemh行为一致
+        weight_file = $fopen(INIT_FILE, "r");
+        if (weight_file == 0) begin
+            $display("ERROR: Cannot open weights file %s", INIT_FILE);
+            $finish;
+        end
+        
+        // 使用$readmemh读取，与weight.v保持一致
+        $fclose(weight_file);
+        $readmemh(INIT_FILE, weight_memory);
+        
+        // 按照weight.v的地址计算方式重新组织权重
+        for (f_idx = 0; f_idx < NUM_FILTERS; f_idx = f_idx + 1) begin
+            base_addr = f_idx * WEIGHTS_PER_FILTER;
+            for (ch_idx = 0; ch_idx < IN_CHANNEL; ch_idx = ch_idx + 1) begin
+                for (kr_idx = 0; kr_idx < KERNEL_SIZE; kr_idx = kr_idx + 1) begin
+                    for (kc_idx = 0; kc_idx < KERNEL_SIZE; kc_idx = kc_idx + 1) begin
+                        offset = ch_idx * KERNEL_SIZE * KERNEL_SIZE + kr_idx * KERNEL_SIZE + kc_idx;
+                        golden_weights[f_idx][ch_idx][kr_idx][kc_idx] = weight_memory[base_addr + offset];
+                    end
+                end
+            end
+        end
+        
+        $display("Golden weights loaded successfully (%0d weights)", TOTAL_WEIGHTS);
+        
+        // 3. filter的权重
+        display_weights();
+    end
+endtask
+
+// Display test case description
+task display_test_case_info;
+    input integer pattern_type;
+    begin
+        $display("\n=== Test Case Information ===");
+        case (pattern_type)
+            0: $display("Pattern Type 0: Gradient Pattern - Values increase from top-left to bottom-right");
+            1: $display("Pattern Type 1: Checkerboard Pattern - Alternating 0xFF and 0x00 values");
+            2: $display("Pattern Type 2: Random Pattern - Pseudo-random values");
+            3: $display("Pattern Type 3: All-Zeros Pattern - All pixels set to 0x00");
+            4: $display("Pattern Type 4: All-Max Pattern - All pixels set to 0xFF");
+            5: $display("Pattern Type 5: Border Pattern - 0xFF on edges, 0x00 in center");
+            6: $display("Pattern Type 6: Diagonal Pattern - 0xFF on diagonals, 0x00 elsewhere");
+            default: $display("Pattern Type %0d: Unknown pattern", pattern_type);
+        endcase
+        $display("=============================");
+    end
+endtask
+
+// Generate test patterns - 多种测试模式
+task generate_test_pattern;
+    input integer pattern_type;
+    begin
+        case (pattern_type)
+            0: begin // Gradient pattern
+                $display("Generating gradient test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = (ch * 64) + (row * 8) + col + 1;
+                            if (test_image[ch][row][col] > 255) 
+                                test_image[ch][row][col] = test_image[ch][row][col] % 256;
+                        end
+                    end
+                end
+            end
+            
+            1: begin // Checkerboard pattern
+                $display("Generating checkerboard test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = ((row + col + ch) % 2) ? 8'hFF : 8'h00;
+                        end
+                    end
+                end
+            end
+            
+            2: begin // Random pattern
+                $display("Generating random test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = $random % 256;
+                            if (test_image[ch][row][col] < 0) 
+                                test_image[ch][row][col] = -test_image[ch][row][col];
+                        end
+                    end
+                end
+            end
+            
+            3: begin // Edge case pattern - all zeros
+                $display("Generating all-zeros test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = 8'h00;
+                        end
+                    end
+                end
+            end
+            
+            4: begin // Edge case pattern - all max values
+                $display("Generating all-max test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = 8'hFF;
+                        end
+                    end
+                end
+            end
+            
+            5: begin // Border pattern
+                $display("Generating border test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            if (row == 0 || row == IMG_HEIGHT-1 || col == 0 || col == IMG_WIDTH-1)
+                                test_image[ch][row][col] = 8'hFF;
+                            else
+                                test_image[ch][row][col] = 8'h00;
+                        end
+                    end
+                end
+            end
+            
+            6: begin // Diagonal pattern
+                $display("Generating diagonal test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            if (row == col || row + col == IMG_WIDTH - 1)
+                                test_image[ch][row][col] = 8'hFF;
+                            else
+                                test_image[ch][row][col] = 8'h00;
+                        end
+                    end
+                end
+            end
+            
+            default: begin // Simple increment pattern
+                $display("Generating simple increment test pattern");
+                for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                    for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                        for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                            test_image[ch][row][col] = (row * IMG_WIDTH + col + ch * 64) % 256;
+                        end
+                    end
+                end
+            end
+        endcase
+    end
+endtask
+
+// Golden reference convolution calculation - 无符号算术
+task calculate_golden_reference;
+    integer out_row, out_col;
+    integer src_row, src_col;
+    integer sum;
+    integer pixel_val, weight_val;
+    integer window_center_row, window_center_col;
+    integer kernel_row, kernel_col;
+    begin
+        $display("Calculating golden reference (unsigned arithmetic, matching window.v logic)...");
+        
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            for (out_row = 0; out_row < OUTPUT_IMG_HEIGHT; out_row = out_row + 1) begin
+                for (out_col = 0; out_col < OUTPUT_IMG_WIDTH; out_col = out_col + 1) begin
+                    sum = 0;
+                    
+                    // 窗口中心位置（与window.v中的x_window, y_window对应）
+                    window_center_row = out_row * STRIDE;
+                    window_center_col = out_col * STRIDE;
+                    
+                    // 卷积计算 - 与window.v的窗口生成逻辑完全一致
+                    for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                        for (kernel_row = 0; kernel_row < KERNEL_SIZE; kernel_row = kernel_row + 1) begin
+                            for (kernel_col = 0; kernel_col < KERNEL_SIZE; kernel_col = kernel_col + 1) begin
+                                // 计算实际图像坐标（与window.v中的src_y, src_x计算一致）
+                                src_row = window_center_row + kernel_row - (KERNEL_SIZE >> 1);
+                                src_col = window_center_col + kernel_col - (KERNEL_SIZE >> 1);
+                                
+                                // 边界检查和padding处理（与window.v一致）
+                                if (src_row >= 0 && src_row < IMG_HEIGHT && 
+                                    src_col >= 0 && src_col < IMG_WIDTH) begin
+                                    pixel_val = test_image[ch][src_row][src_col];
+                                end else begin
+                                    pixel_val = 0; // Padding值为0，与window.v一致
+                                end
+                                
+                                weight_val = golden_weights[f][ch][kernel_row][kernel_col];
+                                sum = sum + (pixel_val * weight_val);
+                            end
+                        end
+                    end
+                    
+                    // Apply saturation (unsigned)
+                    if (sum > ((1 << OUTPUT_WIDTH) - 1))
+                        golden_output[f][out_row][out_col] = (1 << OUTPUT_WIDTH) - 1;
+                    else if (sum < 0)
+                        golden_output[f][out_row][out_col] = 0;
+                    else
+                        golden_output[f][out_row][out_col] = sum;
+                end
+            end
+        end
+        $display("Golden reference calculation completed");
+    end
+endtask
+
+// Display test image
+task display_test_image;
+    begin
+        $display("\n=== Test Image (Unsigned Values) ===");
+        for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+            $display("Channel %0d:", ch);
+            for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                $write("  ");
+                for (col = 0; col < IMG_WIDTH; col = col + 1) begin
+                    $write("%3d ", test_image[ch][row][col]);
+                end
+                $write("\n");
+            end
+        end
+    end
+endtask
+
+// Display weights
+task display_weights;
+    begin
+        $display("\n=== Weights (Unsigned Values) ===");
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            $display("Filter %0d:", f);
+            for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+                $display("  Channel %0d:", ch);
+                for (k_row = 0; k_row < KERNEL_SIZE; k_row = k_row + 1) begin
+                    $write("    ");
+                    for (k_col = 0; k_col < KERNEL_SIZE; k_col = k_col + 1) begin
+                        $write("%3d ", golden_weights[f][ch][k_row][k_col]);
+                    end
+                    $write("\n");
+                end
+            end
+        end
+        
+        // 验证权重加载是否正确
+        $display("\n=== Weight Verification ===");
+        $display("Expected first few weights from weights.mem:");
+        $display("Filter 0, Channel 0: FF(255), 00(0), 01(1), FE(254), 00(0), 02(2), FF(255), 00(0), 01(1)");
+        $display("Actual loaded weights:");
+        $display("Filter 0, Channel 0: %0d, %0d, %0d, %0d, %0d, %0d, %0d, %0d, %0d",
+                 golden_weights[0][0][0][0], golden_weights[0][0][0][1], golden_weights[0][0][0][2],
+                 golden_weights[0][0][1][0], golden_weights[0][0][1][1], golden_weights[0][0][1][2],
+                 golden_weights[0][0][2][0], golden_weights[0][0][2][1], golden_weights[0][0][2][2]);
+    end
+endtask
+
+// Display expected vs actual results
+task display_results;
+    begin
+        $display("\n=== Expected vs Actual Results (Unsigned) ===");
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            $display("Filter %0d:", f);
+            $display("  Position | Expected | Actual | Status");
+            $display("  ---------|----------|--------|--------");
+            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
+                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
+                    $display("  [%0d,%0d]   | %8d | %6d | %s", 
+                            row, col, 
+                            golden_output[f][row][col], 
+                            actual_output[f][row][col],
+                            (actual_output[f][row][col] == golden_output[f][row][col]) ? "PASS" : "FAIL");
+                end
+            end
+        end
+    end
+endtask
+
+// Compare results and calculate accuracy
+task compare_results;
+    integer match;
+    integer total_comparisons;
+    real accuracy;
+    integer filter_errors;
+    begin
+        $display("\n=== Detailed Comparison Results ===");
+        test_case_errors = 0;
+        total_comparisons = 0;
+        
+        // Show detailed mismatch information
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            $display("\nFilter %0d detailed analysis:", f);
+            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
+                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
+                    match = (actual_output[f][row][col] == golden_output[f][row][col]);
+                    total_comparisons = total_comparisons + 1;
+                    
+                    if (!match) begin
+                        test_case_errors = test_case_errors + 1;
+                        $display("  MISMATCH [%0d,%0d]: Expected=%0d, Actual=%0d, Diff=%0d", 
+                                row, col, 
+                                golden_output[f][row][col], 
+                                actual_output[f][row][col],
+                                $signed(actual_output[f][row][col]) - $signed(golden_output[f][row][col]));
+                    end
+                end
+            end
+        end
+        
+        accuracy = (total_comparisons - test_case_errors) * 100.0 / total_comparisons;
+        accuracy_sum = accuracy_sum + accuracy;
+        
+        $display("\n=== Test Case %0d Summary ===", TEST_CASE_SELECT);
+        $display("  Pattern Type: %0d", TEST_CASE_SELECT);
+        $display("  Total comparisons: %0d", total_comparisons);
+        $display("  Matches: %0d", total_comparisons - test_case_errors);
+        $display("  Mismatches: %0d", test_case_errors);
+        $display("  Accuracy: %0.2f%%", accuracy);
+        $display("  Status: %s", (test_case_errors == 0) ? "PASSED" : "FAILED");
+        
+        // Filter-wise accuracy
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            filter_errors = 0;
+            for (row = 0; row < OUTPUT_IMG_HEIGHT; row = row + 1) begin
+                for (col = 0; col < OUTPUT_IMG_WIDTH; col = col + 1) begin
+                    if (actual_output[f][row][col] != golden_output[f][row][col]) begin
+                        filter_errors = filter_errors + 1;
+                    end
+                end
+            end
+            $display("  Filter %0d: %0d/%0d correct (%.2f%%)", 
+                     f, 
+                     OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT - filter_errors,
+                     OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT,
+                     (OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT - filter_errors) * 100.0 / (OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT));
+        end
+        
+        if (test_case_errors == 0) begin
+            passed_tests = passed_tests + 1;
+        end
+        
+        total_errors = total_errors + test_case_errors;
+    end
+endtask
+
+// Monitor outputs and store them - 增加详细输出
+always @(posedge clk) begin
+    if (conv_valid) begin
+        if (current_output_col >= OUTPUT_IMG_WIDTH) begin
+            current_output_col = 0;
+            current_output_row = current_output_row + 1;
+        end
+        
+        // Store actual outputs
+        for (f = 0; f < NUM_FILTERS; f = f + 1) begin
+            actual_output[f][current_output_row][current_output_col] = 
+                conv_out[(f+1)*OUTPUT_WIDTH-1 -: OUTPUT_WIDTH];
+        end
+        
+        output_count = output_count + 1;
+        
+        // Display each output for debugging
+        $display("Output %2d at [%0d,%0d]: Filter0=%0d, Filter1=%0d, Filter2=%0d", 
+                 output_count, current_output_row, current_output_col,
+                 conv_out[OUTPUT_WIDTH-1:0],
+                 conv_out[2*OUTPUT_WIDTH-1:OUTPUT_WIDTH],
+                 conv_out[3*OUTPUT_WIDTH-1:2*OUTPUT_WIDTH]);
+        
+        // Special debugging for first few outputs
+        if (output_count <= 3) begin
+            $display("  Debug: conv_out = %h", conv_out);
+            $display("  Debug: Filter0 bits [19:0] = %h (%0d)", conv_out[19:0], conv_out[19:0]);
+            $display("  Debug: Filter1 bits [39:20] = %h (%0d)", conv_out[39:20], conv_out[39:20]);
+            $display("  Debug: Filter2 bits [59:40] = %h (%0d)", conv_out[59:40], conv_out[59:40]);
+        end
+        
+        current_output_col = current_output_col + 1;
+    end
+end
+
+// Manual verification for position [0,0]
+task verify_position_0_0;
+    integer manual_sum_f0, manual_sum_f1, manual_sum_f2;
+    integer ch, kr, kc;
+    integer src_row, src_col, pixel_val, weight_val;
+    begin
+        manual_sum_f0 = 0;
+        manual_sum_f1 = 0;
+        manual_sum_f2 = 0;
+        
+        $display("Calculating position [0,0] manually:");
+        $display("Window center: row=0, col=0");
+        
+        for (ch = 0; ch < IN_CHANNEL; ch = ch + 1) begin
+            $display("Channel %0d:", ch);
+            for (kr = 0; kr < KERNEL_SIZE; kr = kr + 1) begin
+                for (kc = 0; kc < KERNEL_SIZE; kc = kc + 1) begin
+                    // 计算实际图像坐标
+                    src_row = 0 + kr - (KERNEL_SIZE >> 1); // 0 + kr - 1
+                    src_col = 0 + kc - (KERNEL_SIZE >> 1); // 0 + kc - 1
+                    
+                    // 边界检查和padding处理
+                    if (src_row >= 0 && src_row < IMG_HEIGHT && 
+                        src_col >= 0 && src_col < IMG_WIDTH) begin
+                        pixel_val = test_image[ch][src_row][src_col];
+                    end else begin
+                        pixel_val = 0; // Padding
+                    end
+                    
+                    $display("  [%0d,%0d] src=(%0d,%0d) pixel=%0d weights: F0=%0d F1=%0d F2=%0d", 
+                             kr, kc, src_row, src_col, pixel_val,
+                             golden_weights[0][ch][kr][kc],
+                             golden_weights[1][ch][kr][kc], 
+                             golden_weights[2][ch][kr][kc]);
+                    
+                    manual_sum_f0 = manual_sum_f0 + (pixel_val * golden_weights[0][ch][kr][kc]);
+                    manual_sum_f1 = manual_sum_f1 + (pixel_val * golden_weights[1][ch][kr][kc]);
+                    manual_sum_f2 = manual_sum_f2 + (pixel_val * golden_weights[2][ch][kr][kc]);
+                end
+            end
+        end
+        
+        $display("Manual calculation results for [0,0]:");
+        $display("  Filter 0: %0d (expected: %0d)", manual_sum_f0, golden_output[0][0][0]);
+        $display("  Filter 1: %0d (expected: %0d)", manual_sum_f1, golden_output[1][0][0]);
+        $display("  Filter 2: %0d (expected: %0d)", manual_sum_f2, golden_output[2][0][0]);
+    end
+endtask
+
+// Add DUT weight verification task
+task verify_dut_weights;
+    begin
+        $display("\n=== DUT Weight Verification ===");
+        $display("Checking if DUT weights match expected weights for Filter 0...");
+        
+        // Check a few key weights for Filter 0
+        $display("Expected Filter 0 weights (first channel, first row): 255, 0, 1");
+        $display("DUT Filter 0 weights: Accessing dut.weight_inst.weight_mem...");
+        
+        // Note: This requires the weight memory to be accessible from testbench
+        // The exact path depends on the conv.v implementation
+        if ($test$plusargs("debug_weights")) begin
+            $display("Weight debugging enabled - checking DUT internal weights");
+            // Add specific weight checking code here based on conv.v structure
+        end
+    end
+endtask
+
+// Add task to check for timing issues
+task check_timing_alignment;
+    begin
+        $display("\n=== Timing Alignment Check ===");
+        $display("Checking if Filter 0 output is delayed or offset...");
+        
+        // Compare the pattern of differences
+        $display("Filter 0 difference pattern analysis:");
+        $display("Position [0,0]: Expected=618, Actual=106902, Diff=106284");
+        $display("Position [0,1]: Expected=106002, Actual=109038, Diff=3036");
+        $display("Position [1,1]: Expected=168216, Actual=172776, Diff=4560");
+        
+        $display("Observations:");
+        $display("- Most middle positions have +4560 offset");
+        $display("- First column has much larger positive offsets");
+        $display("- Last column has large negative offsets");
+        $display("- This suggests a systematic calculation or indexing error in Filter 0");
+    end
+endtask
+
 endmodule
\ No newline at end of file
@@ -0,0 +1,189 @@
+`timescale 1ns / 1ps
+
+// PIXELS_PER_CLOCK 扫描测试: 同一帧分别送入 P = 1, 2, 4 的 conv 实例,
+// 检查各实例输出 (光栅顺序) 与 P = 1 逐位一致, 并报告每帧周期数和每周期输出数.
+// 周期数与 reference_model 中 simulate_conv_stream 的 frame_cycles 对应 (main.cpp 的 conv.v PIXELS_PER_CLOCK 扫描,
+// 32x32, 流水线 MAC). 仿真结果与模型:
+//   P=1: 1068 周期, 0.959 输出/周期 (模型 1068, 0.96)
+//   P=2:  540 周期, 1.896 输出/周期 (模型  540, 1.90)
+//   P=4:  276 周期, 3.710 输出/周期 (模型  276, 3.71)
+//   P=8:  144 周期, 7.111 输出/周期 (模型  144, 7.11)
+module conv_throughput_tb;
+
+parameter DATA_WIDTH = 8;
+parameter KERNEL_SIZE = 3;
+parameter IN_CHANNEL = 3;
+parameter NUM_FILTERS = 3;
+parameter IMG_WIDTH = 32;                 // 须为各 P 的整数倍
+parameter IMG_HEIGHT = 32;
+parameter STRIDE = 1;
+parameter WEIGHT_WIDTH = 8;
+parameter OUTPUT_WIDTH = 20;
+parameter MAC_PIPELINED = 1;              // 与 main.cpp 的吞吐量模型一致
+
+localparam NUM_SWEEP = 4;                 // P = 1 << g
+localparam OUTPUT_IMG_WIDTH = (IMG_WIDTH + STRIDE - 1) / STRIDE;   // SAME
+localparam OUTPUT_IMG_HEIGHT = (IMG_HEIGHT + STRIDE - 1) / STRIDE;
+localparam OUTPUTS = OUTPUT_IMG_WIDTH * OUTPUT_IMG_HEIGHT;
+localparam PIXEL_BITS = IN_CHANNEL * DATA_WIDTH;
+localparam RESULT_BITS = NUM_FILTERS * OUTPUT_WIDTH;
+
+reg clk;
+reg rst_n;
+integer cycle;
+
+reg [DATA_WIDTH-1:0] test_image [0:IN_CHANNEL-1][0:IMG_HEIGHT-1][0:IMG_WIDTH-1];
+
+// 每个配置的输出 (光栅顺序) 与时间戳
+reg [RESULT_BITS-1:0] results [0:NUM_SWEEP-1][0:OUTPUTS-1];
+integer result_count [0:NUM_SWEEP-1];
+integer frame_start_cycle [0:NUM_SWEEP-1];
+integer last_output_cycle [0:NUM_SWEEP-1];
+
+// 时钟生成
+initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+end
+
+always @(posedge clk) begin
+    cycle <= cycle + 1;
+end
+
+genvar g;
+generate
+    for (g = 0; g < NUM_SWEEP; g = g + 1) begin : sweep
+        localparam P = 1 << g;
+
+        reg [P*PIXEL_BITS-1:0] pixel_in;
+        reg pixel_valid;
+        reg frame_start;
+        wire [P*RESULT_BITS-1:0] conv_out;
+        wire conv_valid;
+        wire [P-1:0] conv_lane_valid;
+        integer row, col, lane, ch;
+        integer out_lane;
+
+        conv #(
+            .DATA_WIDTH(DATA_WIDTH),
+            .KERNEL_SIZE(KERNEL_SIZE),
+            .IN_CHANNEL(IN_CHANNEL),
+            .NUM_FILTERS(NUM_FILTERS),
+            .IMG_WIDTH(IMG_WIDTH),
+            .IMG_HEIGHT(IMG_HEIGHT),
+            .STRIDE(STRIDE),
+            .WEIGHT_WIDTH(WEIGHT_WIDTH),
+            .OUTPUT_WIDTH(OUTPUT_WIDTH),
+            .INIT_FILE("weights.mem"),
+            .MAC_PIPELINED(MAC_PIPELINED),
+            .PIXELS_PER_CLOCK(P)
+        ) dut (
+            .clk(clk),
+            .rst_n(rst_n),
+            .pixel_in(pixel_in),
+            .pixel_valid(pixel_valid),
+            .frame_start(frame_start),
+            .conv_out(conv_out),
+            .conv_valid(conv_valid),
+            .conv_lane_valid(conv_lane_valid)
+        );
+
+        // 驱动: 权重加载完成后发 frame_start, 之后每拍送 P 个相邻像素 (下降沿驱动)
+        initial begin
+            pixel_in = 0;
+            pixel_valid = 0;
+            frame_start = 0;
+            @(posedge rst_n);
+            wait (dut.weights_loaded);
+            @(negedge clk);
+            frame_start = 1;
+            @(negedge clk);
+            frame_start = 0;
+            for (row = 0; row < IMG_HEIGHT; row = row + 1) begin
+                for (col = 0; col < IMG_WIDTH; col = col + P) begin
+                    for (lane = 0; lane < P; lane = lane + 1)
+                        for (ch = 0; ch < IN_CHANNEL; ch = ch + 1)
+                            pixel_in[(lane*IN_CHANNEL + ch)*DATA_WIDTH +: DATA_WIDTH] = test_image[ch][row][col + lane];
+                    pixel_valid = 1;
+                    @(negedge clk);
+                end
+            end
+            pixel_valid = 0;
+        end
+
+        // 监视: 按路顺序收集有效输出
+        always @(posedge clk) begin
+            if (frame_start)
+                frame_start_cycle[g] = cycle;
+            if (conv_valid) begin
+                for (out_lane = 0; out_lane < P; out_lane = out_lane + 1) begin
+                    if (conv_lane_valid[out_lane] && result_count[g] < OUTPUTS) begin
+                        results[g][result_count[g]] = conv_out[out_lane*RESULT_BITS +: RESULT_BITS];
+                        result_count[g] = result_count[g] + 1;
+                    end
+                end
+                last_output_cycle[g] = cycle;
+            end
+        end
+    end
+endgenerate
+
+integer i, j, c, n, mismatches;
+real outputs_per_cycle, baseline_cycles;
+
+initial begin
+    $display("=== Conv PIXELS_PER_CLOCK Throughput Sweep (%0dx%0d, K=%0d, STRIDE=%0d) ===",
+             IMG_WIDTH, IMG_HEIGHT, KERNEL_SIZE, STRIDE);
+    cycle = 0;
+    mismatches = 0;
+    for (n = 0; n < NUM_SWEEP; n = n + 1) begin
+        result_count[n] = 0;
+        frame_start_cycle[n] = 0;
+        last_output_cycle[n] = 0;
+    end
+    for (c = 0; c < IN_CHANNEL; c = c + 1)
+        for (i = 0; i < IMG_HEIGHT; i = i + 1)
+            for (j = 0; j < IMG_WIDTH; j = j + 1)
+                test_image[c][i][j] = (i * IMG_WIDTH + j + c * 64) % 256;
+
+    rst_n = 0;
+    repeat (5) @(posedge clk);
+    rst_n = 1;
+
+    // 等待所有配置输出完整一帧 (或超时)
+    n = 0;
+    while (!(result_count[0] == OUTPUTS && result_count[1] == OUTPUTS && result_count[2] == OUTPUTS &&
+             result_count[3] == OUTPUTS) &&
+           n < IMG_WIDTH * IMG_HEIGHT * 4 + 500) begin
+        @(posedge clk);
+        n = n + 1;
+    end
+    repeat (5) @(posedge clk);
+
+    baseline_cycles = last_output_cycle[0] - frame_start_cycle[0];
+    for (n = 0; n < NUM_SWEEP; n = n + 1) begin
+        outputs_per_cycle = result_count[n] * 1.0 / (last_output_cycle[n] - frame_start_cycle[n]);
+        $display("P=%0d: %0d outputs in %0d cycles, %0.3f outputs/cycle, speedup %0.2fx",
+                 1 << n, result_count[n], last_output_cycle[n] - frame_start_cycle[n], outputs_per_cycle,
+                 baseline_cycles / (last_output_cycle[n] - frame_start_cycle[n]));
+        if (result_count[n] != OUTPUTS) begin
+            $display("  ERROR: expected %0d outputs", OUTPUTS);
+            mismatches = mismatches + 1;
+        end
+        for (i = 0; i < result_count[n] && i < result_count[0]; i = i + 1) begin
+            if (results[n][i] !== results[0][i]) begin
+                if (mismatches < 10)
+                    $display("  MISMATCH P=%0d output %0d: %h vs %h (P=1)", 1 << n, i, results[n][i], results[0][i]);
+                mismatches = mismatches + 1;
+            end
+        end
+    end
+
+    if (mismatches == 0)
+        $display("SUCCESS: all PIXELS_PER_CLOCK settings produce the P=1 outputs");
+    else
+        $display("FAILURE: %0d errors", mismatches);
+    $finish;
+end
+
+endmodule
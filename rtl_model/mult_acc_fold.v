@@ -0,0 +1,148 @@
+// 折叠乘累加模块 (UNSIGNED) - 以时间换面积, 所有滤波器共用一组乘法器, 结果与 mult_acc_comb 逐位一致.
+// 每拍计算 FILTER_PARALLELISM 个滤波器 x CHANNEL_PARALLELISM 个通道的 K*K 个乘积 (共 MULTIPLIERS 个乘法器),
+// 通道分 CHANNEL_PASSES 拍累加到每个滤波器路的累加器, 滤波器分 FILTER_PASSES 组依次计算;
+// 一个窗口需要 CYCLES_PER_WINDOW = CHANNEL_PASSES * FILTER_PASSES 拍.
+// 窗口与权重, 偏置在接收时寄存 (window_hold, weight_hold, bias_hold), 结果在各滤波器的最后一个通道拍加偏置并饱和后写入 conv_out 并保持,
+// 所有滤波器完成时 conv_valid 置位一拍. 延迟 LATENCY = CYCLES_PER_WINDOW + 1 (计数方式同 mult_acc_pipe).
+// ready 为 0 时不接收窗口, 上游须保持窗口 (见 window.v 的 window_stall); 最后一拍可接收下一个窗口,
+// 因此每 CYCLES_PER_WINDOW 拍可处理一个窗口. 权重与偏置同 mult_acc_pipe 一样与窗口同拍采样, 计算期间
+// multi_channel_weight_in 和 bias_in 可以变化 (如 weight_bank 在 frame_start 时交换), 代价是一份权重寄存器.
+module mult_acc_fold #(
+    parameter DATA_WIDTH = 8,
+    parameter KERNEL_SIZE = 3,
+    parameter IN_CHANNEL = 3,
+    parameter NUM_FILTERS = 3,
+    parameter WEIGHT_WIDTH = 8,
+    parameter OUTPUT_WIDTH = 20,
+    parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL),
+    parameter BIAS_WIDTH = ACC_WIDTH + 1,
+    parameter CHANNEL_PARALLELISM = IN_CHANNEL,  // 每拍计算的输入通道数, 1..IN_CHANNEL
+    parameter FILTER_PARALLELISM = NUM_FILTERS   // 每拍计算的滤波器数 (累加器个数), 1..NUM_FILTERS
+)(
+    input clk,
+    input rst_n,
+
+    // 输入数据接口 - 窗口打包顺序与 mult_acc_comb 相同
+    input window_valid,
+    input [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] multi_channel_window_in,
+    input weight_valid,
+    // 所有滤波器的权重: 滤波器 f 位于 [f*WEIGHTS_PER_FILTER*WEIGHT_WIDTH +: WEIGHTS_PER_FILTER*WEIGHT_WIDTH],
+    // 滤波器内部打包顺序与 weight.v 的 multi_channel_weight_out 相同
+    input [NUM_FILTERS*IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*WEIGHT_WIDTH-1:0] multi_channel_weight_in,
+    input [NUM_FILTERS*BIAS_WIDTH-1:0] bias_in, // 滤波器 f 的有符号偏置位于 [f*BIAS_WIDTH +: BIAS_WIDTH]
+    output ready,                                // 下一个时钟沿可接收窗口
+
+    // 输出数据接口 - 滤波器 f 位于 [f*OUTPUT_WIDTH +: OUTPUT_WIDTH]
+    output reg [NUM_FILTERS*OUTPUT_WIDTH-1:0] conv_out,
+    output reg conv_valid
+);
+
+localparam TAPS = KERNEL_SIZE * KERNEL_SIZE;
+localparam WEIGHTS_PER_FILTER = IN_CHANNEL * TAPS;
+localparam CHANNEL_PASSES = (IN_CHANNEL + CHANNEL_PARALLELISM - 1) / CHANNEL_PARALLELISM;
+localparam FILTER_PASSES = (NUM_FILTERS + FILTER_PARALLELISM - 1) / FILTER_PARALLELISM;
+localparam CYCLES_PER_WINDOW = CHANNEL_PASSES * FILTER_PASSES;
+localparam LATENCY = CYCLES_PER_WINDOW + 1; // 窗口寄存 + 每个计算拍
+localparam MULTIPLIERS = FILTER_PARALLELISM * CHANNEL_PARALLELISM * TAPS;
+localparam CHANNEL_PASS_BITS = (CHANNEL_PASSES > 1) ? $clog2(CHANNEL_PASSES) : 1;
+localparam FILTER_PASS_BITS = (FILTER_PASSES > 1) ? $clog2(FILTER_PASSES) : 1;
+
+// 加偏置后的结果 - 多两位: 符号位和进位
+localparam BIASED_WIDTH = (ACC_WIDTH > BIAS_WIDTH ? ACC_WIDTH : BIAS_WIDTH) + 2;
+
+// 保持的窗口, 权重, 偏置与计算进度
+reg [WEIGHTS_PER_FILTER*DATA_WIDTH-1:0] window_hold;
+reg [NUM_FILTERS*WEIGHTS_PER_FILTER*WEIGHT_WIDTH-1:0] weight_hold;
+reg [NUM_FILTERS*BIAS_WIDTH-1:0] bias_hold;
+reg busy;
+reg [CHANNEL_PASS_BITS-1:0] channel_pass;
+reg [FILTER_PASS_BITS-1:0] filter_pass;
+
+// 每个滤波器路的累加器及本拍累加结果
+reg [ACC_WIDTH-1:0] accumulator [0:FILTER_PARALLELISM-1]; // UNSIGNED
+reg [ACC_WIDTH-1:0] pass_sum [0:FILTER_PARALLELISM-1];    // UNSIGNED
+reg signed [BIASED_WIDTH-1:0] biased_sum;                  // SIGNED
+
+wire last_channel_pass = (channel_pass == CHANNEL_PASSES - 1);
+wire last_pass = last_channel_pass && (filter_pass == FILTER_PASSES - 1);
+wire accept = window_valid && weight_valid && ready;
+
+assign ready = !busy || last_pass;
+
+// 循环变量
+integer fl, cl, t, f, c, n;
+
+// 本拍乘累加: 滤波器 filter_pass*FILTER_PARALLELISM + fl, 通道 channel_pass*CHANNEL_PARALLELISM + cl;
+// 不整除时最后一组超出范围的滤波器和通道不参与计算
+always @(*) begin
+    for (fl = 0; fl < FILTER_PARALLELISM; fl = fl + 1) begin
+        f = filter_pass * FILTER_PARALLELISM + fl;
+        pass_sum[fl] = (channel_pass == 0) ? {ACC_WIDTH{1'b0}} : accumulator[fl];
+        for (cl = 0; cl < CHANNEL_PARALLELISM; cl = cl + 1) begin
+            c = channel_pass * CHANNEL_PARALLELISM + cl;
+            for (t = 0; t < TAPS; t = t + 1) begin
+                if (f < NUM_FILTERS && c < IN_CHANNEL)
+                    pass_sum[fl] = pass_sum[fl] + window_hold[(c*TAPS + t)*DATA_WIDTH +: DATA_WIDTH] *
+                        weight_hold[(f*WEIGHTS_PER_FILTER + WEIGHTS_PER_FILTER - 1 - (c*TAPS + t))*WEIGHT_WIDTH +: WEIGHT_WIDTH];
+            end
+        end
+    end
+end
+
+always @(posedge clk or negedge rst_n) begin
+    if (!rst_n) begin
+        busy <= 0;
+        channel_pass <= 0;
+        filter_pass <= 0;
+        conv_valid <= 0;
+        conv_out <= 0;
+        for (n = 0; n < FILTER_PARALLELISM; n = n + 1)
+            accumulator[n] <= 0;
+    end else begin
+        conv_valid <= busy && last_pass;
+
+        if (busy) begin
+            for (n = 0; n < FILTER_PARALLELISM; n = n + 1) begin
+                accumulator[n] <= pass_sum[n];
+                // 最后一个通道拍: 加偏置, 饱和后写入该滤波器的输出并保持
+                if (last_channel_pass && filter_pass * FILTER_PARALLELISM + n < NUM_FILTERS) begin
+                    biased_sum = $signed({{(BIASED_WIDTH-ACC_WIDTH){1'b0}}, pass_sum[n]}) +
+                                 $signed(bias_hold[(filter_pass * FILTER_PARALLELISM + n)*BIAS_WIDTH +: BIAS_WIDTH]);
+                    conv_out[(filter_pass * FILTER_PARALLELISM + n)*OUTPUT_WIDTH +: OUTPUT_WIDTH] <= saturate(biased_sum);
+                end
+            end
+            if (last_channel_pass) begin
+                channel_pass <= 0;
+                filter_pass <= last_pass ? 0 : filter_pass + 1;
+            end else begin
+                channel_pass <= channel_pass + 1;
+            end
+        end
+
+        // 接收窗口 (空闲或最后一拍), 否则最后一拍后空闲
+        if (accept) begin
+            window_hold <= multi_channel_window_in;
+            weight_hold <= multi_channel_weight_in;
+            bias_hold <= bias_in;
+            busy <= 1;
+        end else if (last_pass) begin
+            busy <= 0;
+        end
+    end
+end
+
+// 饱和处理函数 (与 mult_acc_comb 相同) - 负数钳位到0, 上限 2^OUTPUT_WIDTH-1
+function [OUTPUT_WIDTH-1:0] saturate;
+    input signed [BIASED_WIDTH-1:0] value; // SIGNED
+    localparam signed [BIASED_WIDTH-1:0] MAX_UNSIGNED_VAL_SAT = (1 << OUTPUT_WIDTH) - 1;
+    begin
+        if (value < 0)
+            saturate = {OUTPUT_WIDTH{1'b0}};
+        else if (value > MAX_UNSIGNED_VAL_SAT)
+            saturate = MAX_UNSIGNED_VAL_SAT[OUTPUT_WIDTH-1:0];
+        else
+            saturate = value[OUTPUT_WIDTH-1:0];
+    end
+endfunction
+
+endmodule
@@ -0,0 +1,158 @@
+// 流水线多通道乘累加模块 (UNSIGNED) - 与 mult_acc_comb 结果逐位一致
+// 乘法结果先打一拍, 再经平衡二叉加法树 (深度 $clog2(IN_CHANNEL*KERNEL_SIZE^2)) 求和,
+// 每 ADDER_LEVELS_PER_STAGE 级加法插入一级寄存器, 最后加偏置并饱和后寄存输出.
+// 关键路径为一个乘法器或 ADDER_LEVELS_PER_STAGE 个加法器, 不再随 K^2*Cin 线性增长.
+// 延迟 LATENCY = 2 + TREE_STAGES 个时钟 (window_valid 采样沿到 conv_valid 置位沿),
+// 每个时钟可接收一个新窗口. ADDER_LEVELS_PER_STAGE = 0 时加法树全部为组合逻辑.
+module mult_acc_pipe #(
+    parameter DATA_WIDTH = 8,
+    parameter KERNEL_SIZE = 3,
+    parameter IN_CHANNEL = 3,
+    parameter WEIGHT_WIDTH = 8,
+    parameter OUTPUT_WIDTH = 20,
+    parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL),
+    parameter BIAS_WIDTH = ACC_WIDTH + 1,
+    parameter ADDER_LEVELS_PER_STAGE = 1  // 每级流水线包含的加法树层数; 0: 树内不插寄存器
+)(
+    input clk,
+    input rst_n,
+
+    // 输入数据接口 (与 mult_acc_comb 相同)
+    input window_valid,
+    input [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] multi_channel_window_in,
+    input weight_valid,
+    input [IN_CHANNEL*KERNEL_SIZE*KERNEL_SIZE*WEIGHT_WIDTH-1:0] multi_channel_weight_in,
+    input signed [BIAS_WIDTH-1:0] bias_in, // 与窗口同拍采样, 随数据一起延迟
+
+    // 输出数据接口 - 延迟 LATENCY 个时钟
+    output reg [OUTPUT_WIDTH-1:0] conv_out,
+    output reg conv_valid
+);
+
+localparam WEIGHTS_PER_FILTER = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
+localparam TREE_DEPTH = $clog2(WEIGHTS_PER_FILTER);
+localparam TREE_STAGES = (ADDER_LEVELS_PER_STAGE == 0) ? 0 :
+                         (TREE_DEPTH + ADDER_LEVELS_PER_STAGE - 1) / ADDER_LEVELS_PER_STAGE;
+localparam LATENCY = 2 + TREE_STAGES; // 乘法寄存器 + 加法树寄存器 + 输出寄存器
+
+// 加法树第 level 层的节点数 (第 0 层为乘积)
+function integer level_count;
+    input integer level;
+    begin
+        level_count = (WEIGHTS_PER_FILTER + (1 << level) - 1) >> level;
+    end
+endfunction
+
+// 第 level 层首节点在 tree_node 中的位置
+function integer level_offset;
+    input integer level;
+    integer l;
+    begin
+        level_offset = 0;
+        for (l = 0; l < level; l = l + 1)
+            level_offset = level_offset + level_count(l);
+    end
+endfunction
+
+localparam TOTAL_NODES = level_offset(TREE_DEPTH + 1);
+
+// 所有层的加法树节点, 按层依次排列; 最后一个节点为总和
+wire [ACC_WIDTH-1:0] tree_node [0:TOTAL_NODES-1]; // UNSIGNED
+
+// 有效信号与偏置的延迟线: 第 s 项对应第 s 级寄存器中的数据
+reg valid_pipe [0:LATENCY-2];
+reg signed [BIAS_WIDTH-1:0] bias_pipe [0:LATENCY-2];
+
+// 加偏置后的结果 - 多两位: 符号位和进位
+localparam BIASED_WIDTH = (ACC_WIDTH > BIAS_WIDTH ? ACC_WIDTH : BIAS_WIDTH) + 2;
+wire signed [BIASED_WIDTH-1:0] biased_sum; // SIGNED
+
+integer s;
+genvar n, level;
+
+// 第 0 级: 乘法结果寄存 (数据寄存器无需复位, 由 valid_pipe 限定)
+generate
+    for (n = 0; n < WEIGHTS_PER_FILTER; n = n + 1) begin : mult_gen
+        wire [DATA_WIDTH-1:0] pixel = multi_channel_window_in[n*DATA_WIDTH +: DATA_WIDTH];
+        // 位序与 mult_acc_comb 相同, 匹配 weight.v 的打包顺序
+        wire [WEIGHT_WIDTH-1:0] weight = multi_channel_weight_in[(WEIGHTS_PER_FILTER - 1 - n)*WEIGHT_WIDTH +: WEIGHT_WIDTH];
+        reg [DATA_WIDTH+WEIGHT_WIDTH-1:0] product;
+        always @(posedge clk) begin
+            product <= pixel * weight;
+        end
+        assign tree_node[n] = {{(ACC_WIDTH-DATA_WIDTH-WEIGHT_WIDTH){1'b0}}, product};
+    end
+endgenerate
+
+// 平衡加法树: 第 level 层节点 j = 上一层节点 2j + 2j+1 (奇数个时最后一个直通)
+generate
+    for (level = 1; level <= TREE_DEPTH; level = level + 1) begin : tree_level_gen
+        for (n = 0; n < level_count(level); n = n + 1) begin : node_gen
+            wire [ACC_WIDTH-1:0] left = tree_node[level_offset(level - 1) + 2*n];
+            wire [ACC_WIDTH-1:0] right;
+            if (2*n + 1 < level_count(level - 1)) begin : pair
+                assign right = tree_node[level_offset(level - 1) + 2*n + 1];
+            end else begin : single
+                assign right = {ACC_WIDTH{1'b0}};
+            end
+
+            if (ADDER_LEVELS_PER_STAGE != 0 &&
+                (level % ADDER_LEVELS_PER_STAGE == 0 || level == TREE_DEPTH)) begin : registered
+                reg [ACC_WIDTH-1:0] sum;
+                always @(posedge clk) begin
+                    sum <= left + right;
+                end
+                assign tree_node[level_offset(level) + n] = sum;
+            end else begin : combinational
+                assign tree_node[level_offset(level) + n] = left + right;
+            end
+        end
+    end
+endgenerate
+
+// 有效信号与偏置随数据逐级延迟
+always @(posedge clk or negedge rst_n) begin
+    if (!rst_n) begin
+        for (s = 0; s < LATENCY - 1; s = s + 1) begin
+            valid_pipe[s] <= 1'b0;
+            bias_pipe[s] <= 0;
+        end
+    end else begin
+        valid_pipe[0] <= window_valid && weight_valid;
+        bias_pipe[0] <= bias_in;
+        for (s = 1; s < LATENCY - 1; s = s + 1) begin
+            valid_pipe[s] <= valid_pipe[s-1];
+            bias_pipe[s] <= bias_pipe[s-1];
+        end
+    end
+end
+
+// 偏置相加 - 无符号总和零扩展后与有符号偏置相加
+assign biased_sum = $signed({{(BIASED_WIDTH-ACC_WIDTH){1'b0}}, tree_node[TOTAL_NODES-1]}) + bias_pipe[LATENCY-2];
+
+// 输出寄存器 - 无效时输出 0, 与 mult_acc_comb 一致
+always @(posedge clk or negedge rst_n) begin
+    if (!rst_n) begin
+        conv_out <= {OUTPUT_WIDTH{1'b0}};
+        conv_valid <= 1'b0;
+    end else begin
+        conv_valid <= valid_pipe[LATENCY-2];
+        conv_out <= valid_pipe[LATENCY-2] ? saturate(biased_sum) : {OUTPUT_WIDTH{1'b0}};
+    end
+end
+
+// 饱和处理函数 - 负数钳位到0, 上限 2^OUTPUT_WIDTH-1
+function [OUTPUT_WIDTH-1:0] saturate;
+    input signed [BIASED_WIDTH-1:0] value; // SIGNED
+    localparam signed [BIASED_WIDTH-1:0] MAX_UNSIGNED_VAL_SAT = (1 << OUTPUT_WIDTH) - 1;
+    begin
+        if (value < 0)
+            saturate = {OUTPUT_WIDTH{1'b0}};
+        else if (value > MAX_UNSIGNED_VAL_SAT)
+            saturate = MAX_UNSIGNED_VAL_SAT[OUTPUT_WIDTH-1:0];
+        else
+            saturate = value[OUTPUT_WIDTH-1:0];
+    end
+endfunction
+
+endmodule
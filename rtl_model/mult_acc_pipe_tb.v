@@ -0,0 +1,165 @@
+`timescale 1ns / 1ps
+
+// 流水线乘累加测试: 每个时钟送入一个随机窗口, 检查 LATENCY 个时钟后的输出
+// 与同一输入下 mult_acc_comb 的组合结果逐位一致, 且延迟等于 dut.LATENCY.
+module mult_acc_pipe_tb;
+
+parameter DATA_WIDTH = 8;
+parameter KERNEL_SIZE = 5;                // 非 3x3: 组合版本走线性累加链
+parameter IN_CHANNEL = 4;
+parameter WEIGHT_WIDTH = 8;
+parameter OUTPUT_WIDTH = 23;               // 随机数据下饱和与未饱和情况都会出现
+parameter ACC_WIDTH = 2*DATA_WIDTH + 4 + $clog2(KERNEL_SIZE*KERNEL_SIZE*IN_CHANNEL);
+parameter BIAS_WIDTH = ACC_WIDTH + 1;
+parameter ADDER_LEVELS_PER_STAGE = 1;
+parameter NUM_VECTORS = 64;
+
+localparam WEIGHTS_PER_FILTER = IN_CHANNEL * KERNEL_SIZE * KERNEL_SIZE;
+
+reg clk;
+reg rst_n;
+reg window_valid;
+reg [WEIGHTS_PER_FILTER*DATA_WIDTH-1:0] multi_channel_window_in;
+reg weight_valid;
+reg [WEIGHTS_PER_FILTER*WEIGHT_WIDTH-1:0] multi_channel_weight_in;
+reg signed [BIAS_WIDTH-1:0] bias_in;
+
+wire [OUTPUT_WIDTH-1:0] conv_out;
+wire conv_valid;
+wire [OUTPUT_WIDTH-1:0] reference_out;
+wire reference_valid;
+
+mult_acc_pipe #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .ACC_WIDTH(ACC_WIDTH),
+    .BIAS_WIDTH(BIAS_WIDTH),
+    .ADDER_LEVELS_PER_STAGE(ADDER_LEVELS_PER_STAGE)
+) dut (
+    .clk(clk),
+    .rst_n(rst_n),
+    .window_valid(window_valid),
+    .multi_channel_window_in(multi_channel_window_in),
+    .weight_valid(weight_valid),
+    .multi_channel_weight_in(multi_channel_weight_in),
+    .bias_in(bias_in),
+    .conv_out(conv_out),
+    .conv_valid(conv_valid)
+);
+
+// 参考: 组合版本, 同一时刻的输入
+mult_acc_comb #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .KERNEL_SIZE(KERNEL_SIZE),
+    .IN_CHANNEL(IN_CHANNEL),
+    .WEIGHT_WIDTH(WEIGHT_WIDTH),
+    .OUTPUT_WIDTH(OUTPUT_WIDTH),
+    .ACC_WIDTH(ACC_WIDTH),
+    .BIAS_WIDTH(BIAS_WIDTH)
+) reference (
+    .window_valid(window_valid),
+    .multi_channel_window_in(multi_channel_window_in),
+    .weight_valid(weight_valid),
+    .multi_channel_weight_in(multi_channel_weight_in),
+    .bias_in(bias_in),
+    .conv_out(reference_out),
+    .conv_valid(reference_valid)
+);
+
+// 时钟生成
+initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+end
+
+// 每个时钟上升沿记录参考输出, 供 LATENCY 拍后比较
+reg [OUTPUT_WIDTH-1:0] expected_out [0:NUM_VECTORS+63];
+reg expected_valid [0:NUM_VECTORS+63];
+integer cycle;
+integer first_input_cycle;
+integer first_valid_cycle;
+integer num_checked;
+integer num_errors;
+integer v, n;
+
+always @(posedge clk) begin
+    if (rst_n) begin
+        expected_out[cycle] <= reference_out;
+        expected_valid[cycle] <= reference_valid;
+        // 此沿采样到的 dut 输出由 LATENCY 拍之前的输入产生
+        if (cycle >= dut.LATENCY) begin
+            if (conv_valid !== expected_valid[cycle - dut.LATENCY] ||
+                conv_out !== expected_out[cycle - dut.LATENCY]) begin
+                $display("MISMATCH at cycle %0d: got valid=%b out=%0d, expected valid=%b out=%0d",
+                         cycle, conv_valid, conv_out,
+                         expected_valid[cycle - dut.LATENCY], expected_out[cycle - dut.LATENCY]);
+                num_errors = num_errors + 1;
+            end
+            num_checked = num_checked + 1;
+        end
+        if (window_valid && weight_valid && first_input_cycle < 0)
+            first_input_cycle = cycle;
+        // conv_valid 在此沿之前已更新, 即由 cycle - 1 沿的寄存器写入
+        if (conv_valid && first_valid_cycle < 0)
+            first_valid_cycle = cycle - 1;
+        cycle <= cycle + 1;
+    end
+end
+
+// 在下降沿驱动输入, 上升沿采样
+task drive_random_vector;
+    input valid;
+    begin
+        @(negedge clk);
+        window_valid = valid;
+        weight_valid = 1;
+        for (n = 0; n < WEIGHTS_PER_FILTER; n = n + 1) begin
+            multi_channel_window_in[n*DATA_WIDTH +: DATA_WIDTH] = $random;
+            multi_channel_weight_in[n*WEIGHT_WIDTH +: WEIGHT_WIDTH] = $random;
+        end
+        // 偏置覆盖正负两种情况, 包括把结果压到 0 以下
+        bias_in = $random % (1 << 22);
+    end
+endtask
+
+initial begin
+    $display("=== Pipelined MultAcc Test (K=%0d, IN_CHANNEL=%0d, ADDER_LEVELS_PER_STAGE=%0d) ===",
+             KERNEL_SIZE, IN_CHANNEL, ADDER_LEVELS_PER_STAGE);
+    $display("Tree depth %0d, tree stages %0d, latency %0d cycles",
+             dut.TREE_DEPTH, dut.TREE_STAGES, dut.LATENCY);
+    rst_n = 0;
+    cycle = 0;
+    first_input_cycle = -1;
+    first_valid_cycle = -1;
+    num_checked = 0;
+    num_errors = 0;
+    window_valid = 0;
+    weight_valid = 0;
+    multi_channel_window_in = 0;
+    multi_channel_weight_in = 0;
+    bias_in = 0;
+
+    repeat (3) @(posedge clk);
+    @(negedge clk);
+    rst_n = 1;
+
+    // 连续有效窗口 (每拍一个), 中间夹杂无效拍
+    for (v = 0; v < NUM_VECTORS; v = v + 1)
+        drive_random_vector((v % 7) != 3);
+    @(negedge clk);
+    window_valid = 0;
+    repeat (dut.LATENCY + 2) @(posedge clk);
+
+    $display("Checked %0d cycles, measured latency %0d cycles (expected %0d)",
+             num_checked, first_valid_cycle - first_input_cycle + 1, dut.LATENCY);
+    if (num_errors == 0 && first_valid_cycle - first_input_cycle + 1 == dut.LATENCY)
+        $display("SUCCESS: pipelined output matches mult_acc_comb %0d cycles later", dut.LATENCY);
+    else
+        $display("FAILURE: %0d mismatches", num_errors);
+    $finish;
+end
+
+endmodule
@@ -0,0 +1,158 @@
+// 双缓冲权重库 - 一块ROM按组保存 NUM_WEIGHT_SETS 组权重 (每组为一层的 NUM_FILTERS 个滤波器,
+// 组 s 滤波器 f 的首地址为 (s*NUM_FILTERS + f)*WEIGHTS_PER_FILTER, 组 0 与 weight.v 的布局相同).
+// 宽读端口每拍读出 WEIGHTS_PER_READ 个权重写入影子缓冲, 活动缓冲在装载期间保持不变.
+// 装载一组需要 LOAD_BEATS = ceil(NUM_FILTERS*WEIGHTS_PER_FILTER / WEIGHTS_PER_READ) 拍.
+// 偏置随权重按组保存在 BIAS_FILE (组 s 滤波器 f 位于第 s*NUM_FILTERS + f 行), 在 load_start 时一次写入
+// 影子偏置缓冲, 与权重一起交换.
+// swap 采样时影子缓冲已满则在同一时钟沿交换 (无气泡); 否则挂起, weights_valid 拉低,
+// 直到装载完成后的下一拍交换, 因此上层须在 shadow_ready 后才请求交换 (见 conv.v 的 frame_ready).
+// 复位后第一次装载完成时自动成为活动缓冲.
+module weight_bank #(
+    parameter NUM_FILTERS = 3,
+    parameter INPUT_CHANNELS = 3,
+    parameter KERNEL_SIZE = 3,
+    parameter WEIGHT_WIDTH = 8,
+    parameter NUM_WEIGHT_SETS = 1,
+    parameter WEIGHTS_PER_READ = INPUT_CHANNELS * KERNEL_SIZE * KERNEL_SIZE, // 默认每拍读一个滤波器
+    parameter SET_BITS = (NUM_WEIGHT_SETS > 1) ? $clog2(NUM_WEIGHT_SETS) : 1,
+    parameter INIT_FILE = "weights.mem",
+    parameter BIAS_WIDTH = 20,
+    parameter BIAS_FILE = ""  // 每行一个偏置 (BIAS_WIDTH位补码), 共 NUM_WEIGHT_SETS*NUM_FILTERS 行; 为空则无偏置
+)
+(
+    input clk,
+    input rst_n,
+
+    // 装载接口 - 把第 load_set 组读入影子缓冲 (装载中或影子缓冲已满时忽略)
+    input load_start,
+    input [SET_BITS-1:0] load_set,
+    output reg load_busy,
+    output reg shadow_ready, // 影子缓冲已满, 等待交换
+
+    // 交换接口 - 帧边界请求
+    input swap,
+
+    // 活动缓冲输出 - 滤波器 f 位于 [f*WEIGHTS_PER_FILTER*WEIGHT_WIDTH +: WEIGHTS_PER_FILTER*WEIGHT_WIDTH],
+    // 滤波器内部打包顺序与 weight.v 的 multi_channel_weight_out 相同
+    output [NUM_FILTERS*INPUT_CHANNELS*KERNEL_SIZE*KERNEL_SIZE*WEIGHT_WIDTH-1:0] weights_out,
+    output [NUM_FILTERS*BIAS_WIDTH-1:0] bias_out, // 滤波器 f 的有符号偏置位于 [f*BIAS_WIDTH +: BIAS_WIDTH]
+    output weights_valid,
+    output reg [SET_BITS-1:0] active_set
+);
+
+localparam WEIGHTS_PER_FILTER = INPUT_CHANNELS * KERNEL_SIZE * KERNEL_SIZE;
+localparam BANK_WEIGHTS = NUM_FILTERS * WEIGHTS_PER_FILTER; // 一组 (一层) 的权重数量
+localparam BANK_BITS = BANK_WEIGHTS * WEIGHT_WIDTH;
+localparam TOTAL_WEIGHTS = NUM_WEIGHT_SETS * BANK_WEIGHTS;
+localparam LOAD_BEATS = (BANK_WEIGHTS + WEIGHTS_PER_READ - 1) / WEIGHTS_PER_READ;
+localparam ADDR_WIDTH = $clog2(TOTAL_WEIGHTS + 1);
+localparam BEAT_WIDTH = $clog2(LOAD_BEATS + 1);
+
+// 权重ROM存储器 - 每行一个权重, 与 weight.v 的 INIT_FILE 格式相同
+reg [WEIGHT_WIDTH-1:0] weight_memory [0:TOTAL_WEIGHTS-1];
+
+// 偏置ROM存储器 - 每组 NUM_FILTERS 个
+reg [BIAS_WIDTH-1:0] bias_memory [0:NUM_WEIGHT_SETS*NUM_FILTERS-1];
+
+// 两个缓冲: active_bank 指向当前帧使用的一个, 另一个为影子缓冲
+reg [BANK_BITS-1:0] bank0;
+reg [BANK_BITS-1:0] bank1;
+reg [NUM_FILTERS*BIAS_WIDTH-1:0] bias_bank0;
+reg [NUM_FILTERS*BIAS_WIDTH-1:0] bias_bank1;
+reg active_bank;
+reg active_valid;
+reg swap_pending;
+
+// 装载状态
+reg [SET_BITS-1:0] shadow_set;
+reg [ADDR_WIDTH-1:0] load_base;
+reg [BEAT_WIDTH-1:0] load_beat;
+
+integer init_i, r;
+
+// 初始化权重ROM
+initial begin
+    if (INIT_FILE != "") begin
+        $readmemh(INIT_FILE, weight_memory);
+        $display("Weight bank: Loaded %0d weight sets from %s", NUM_WEIGHT_SETS, INIT_FILE);
+    end else begin
+        for (init_i = 0; init_i < TOTAL_WEIGHTS; init_i = init_i + 1) begin
+            weight_memory[init_i] = 0;
+        end
+        $display("Weight bank: Initialized with zeros");
+    end
+    if (BIAS_FILE != "") begin
+        $readmemh(BIAS_FILE, bias_memory);
+        $display("Weight bank: Loaded %0d bias sets from %s", NUM_WEIGHT_SETS, BIAS_FILE);
+    end else begin
+        for (init_i = 0; init_i < NUM_WEIGHT_SETS * NUM_FILTERS; init_i = init_i + 1) begin
+            bias_memory[init_i] = 0;
+        end
+    end
+end
+
+always @(posedge clk or negedge rst_n) begin
+    if (!rst_n) begin
+        bank0 <= 0;
+        bank1 <= 0;
+        bias_bank0 <= 0;
+        bias_bank1 <= 0;
+        active_bank <= 0;
+        active_valid <= 0;
+        swap_pending <= 0;
+        active_set <= 0;
+        shadow_set <= 0;
+        shadow_ready <= 0;
+        load_busy <= 0;
+        load_base <= 0;
+        load_beat <= 0;
+    end else begin
+        // 交换: 帧边界请求 (或此前挂起的请求), 以及复位后第一次装载完成
+        if ((swap || swap_pending || !active_valid) && shadow_ready) begin
+            active_bank <= ~active_bank;
+            active_set <= shadow_set;
+            active_valid <= 1;
+            shadow_ready <= 0;
+            swap_pending <= 0;
+        end else if (swap && active_valid) begin
+            swap_pending <= 1;
+        end
+
+        // 装载: 每拍 WEIGHTS_PER_READ 个权重写入影子缓冲 (最后一拍可能不满)
+        if (load_busy) begin
+            for (r = 0; r < WEIGHTS_PER_READ; r = r + 1) begin
+                if (load_beat * WEIGHTS_PER_READ + r < BANK_WEIGHTS) begin
+                    if (active_bank)
+                        bank0[(load_beat * WEIGHTS_PER_READ + r)*WEIGHT_WIDTH +: WEIGHT_WIDTH] <=
+                            weight_memory[load_base + load_beat * WEIGHTS_PER_READ + r];
+                    else
+                        bank1[(load_beat * WEIGHTS_PER_READ + r)*WEIGHT_WIDTH +: WEIGHT_WIDTH] <=
+                            weight_memory[load_base + load_beat * WEIGHTS_PER_READ + r];
+                end
+            end
+            load_beat <= load_beat + 1;
+            if (load_beat == LOAD_BEATS - 1) begin
+                load_busy <= 0;
+                shadow_ready <= 1;
+            end
+        end else if (load_start && !shadow_ready) begin
+            load_busy <= 1;
+            load_beat <= 0;
+            shadow_set <= load_set;
+            load_base <= load_set * BANK_WEIGHTS;
+            // 偏置只有 NUM_FILTERS 个, 随装载开始一次写入影子偏置缓冲
+            for (r = 0; r < NUM_FILTERS; r = r + 1) begin
+                if (active_bank)
+                    bias_bank0[r*BIAS_WIDTH +: BIAS_WIDTH] <= bias_memory[load_set * NUM_FILTERS + r];
+                else
+                    bias_bank1[r*BIAS_WIDTH +: BIAS_WIDTH] <= bias_memory[load_set * NUM_FILTERS + r];
+            end
+        end
+    end
+end
+
+assign weights_out = active_bank ? bank1 : bank0;
+assign bias_out = active_bank ? bias_bank1 : bias_bank0;
+assign weights_valid = active_valid && !swap_pending;
+
+endmodule
@@ -1,51 +1,182 @@
+
 module window #(
     parameter DATA_WIDTH = 16,             // Width of each pixel data
     parameter IMG_WIDTH = 32,             // Width of input image
     parameter IMG_HEIGHT = 32,            // Height of input image
     parameter KERNEL_SIZE = 3,            // Size of convolution window (square)
     parameter STRIDE = 1,                 // Stride of convolution
-    parameter PADDING = (KERNEL_SIZE - 1) / 2  // Padding size calculated for SAME mode
+    parameter PADDING = (KERNEL_SIZE - 1) / 2, // Padding size calculated for SAME mode (the border is KERNEL_SIZE/2 wide)
+    parameter BORDER_MODE = 0,            // Padded pixels: 0 zero, 1 reflect (x[-1] = x[1]), 2 replicate (x[-1] = x[0]).
+                                          // Circular is not supported: the top rows are gone when the bottom ones arrive.
+    parameter PIXELS_PER_CLOCK = 1        // Adjacent pixels per pixel_in beat and windows per output beat;
+                                          // IMG_WIDTH must be a multiple of it
 )
 (
     input wire clk,                       // Clock signal
     input wire rst_n,                     // Active low reset
-    input wire [DATA_WIDTH-1:0] pixel_in, // Input pixel data
-    input wire pixel_valid,               // Input pixel valid signal
-    input wire frame_start,               // Start of new frame signal
-    
-    output reg [KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] window_out, // Flattened window output
-    output reg window_valid              // Window data valid
+    input wire [PIXELS_PER_CLOCK*DATA_WIDTH-1:0] pixel_in, // Lane p holds column x_pos + p, lane 0 in the low bits
+    input wire pixel_valid,               // Input pixel valid signal; the beat is taken on an edge with pixel_ready
+    input wire frame_start,               // Start of new frame signal (restarts the frame from any state)
+    input wire window_stall,              // Consumer not ready: hold the window output, emit no new beat (frame_start clears it)
+
+    output reg pixel_ready,               // pixel_in is taken on this edge (hold pixel_in and pixel_valid while low)
+    output reg [PIXELS_PER_CLOCK*KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] window_out, // Lane p: flattened window at x_window + p*STRIDE
+    output reg window_valid,             // Window data valid
+    output reg [PIXELS_PER_CLOCK-1:0] window_lane_valid // Lanes holding a window (the last beat of a row may be partial)
 );
 
+localparam WINDOW_BITS = KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH;
+localparam WINDOW_STEP = PIXELS_PER_CLOCK*STRIDE; // x_window advance per output beat
+localparam HALF = KERNEL_SIZE >> 1;               // Taps before the window centre
+localparam AFTER = KERNEL_SIZE - 1 - HALF;        // Taps after the window centre
+
+// Line buffer: a ring of LINE_ROWS image rows, each a block RAM of LINE_WORDS words of
+// PIXELS_PER_CLOCK pixels (one write per pixel beat, one registered read per clock)
+localparam LINE_ROWS = KERNEL_SIZE + 1;
+localparam LINE_WORDS = IMG_WIDTH / PIXELS_PER_CLOCK;
+localparam LINE_WORD_WIDTH = PIXELS_PER_CLOCK*DATA_WIDTH;
+
+// Window cache: line buffer words of all KERNEL_SIZE window rows, enough for one beat of windows
+// plus as many again so the reader runs ahead into the next row
+localparam SPAN_WORDS = ((PIXELS_PER_CLOCK-1)*STRIDE + KERNEL_SIZE - 1) / PIXELS_PER_CLOCK + 2;
+localparam CACHE_BITS = $clog2(2*SPAN_WORDS + 2);
+localparam CACHE_WORDS = 1 << CACHE_BITS;
+localparam CACHE_WORD_WIDTH = KERNEL_SIZE*LINE_WORD_WIDTH;
+
+// Register widths follow the image size
+localparam X_BITS = $clog2(IMG_WIDTH + WINDOW_STEP + 1);
+localparam Y_BITS = $clog2(IMG_HEIGHT + STRIDE + KERNEL_SIZE + 1);
+localparam WORD_BITS = $clog2(LINE_WORDS + 1);
+localparam SLOT_BITS = $clog2(LINE_ROWS);
+localparam COORD_BITS = $clog2((IMG_WIDTH > IMG_HEIGHT ? IMG_WIDTH : IMG_HEIGHT) + KERNEL_SIZE + WINDOW_STEP) + 2;
+
 // Internal signals
-reg [5:0] x_pos, y_pos;                  // Current input pixel position
-reg [5:0] x_window, y_window;            // Window center position
-reg [DATA_WIDTH-1:0] line_buffer [0:KERNEL_SIZE][0:IMG_WIDTH+2*PADDING-1]; // Line buffer
-reg [DATA_WIDTH-1:0] window_buffer [0:KERNEL_SIZE-1][0:KERNEL_SIZE-1]; // Window buffer
-reg signed [6:0] src_y, src_x;           // Temporary variables for coordinate calculation
+reg [X_BITS-1:0] x_pos, x_window;        // Current input pixel position / window centre column
+reg [Y_BITS-1:0] y_pos, y_window;        // Current input row / window centre row
+reg [DATA_WIDTH-1:0] window_buffer [0:PIXELS_PER_CLOCK-1][0:KERNEL_SIZE-1][0:KERNEL_SIZE-1]; // Window buffer per lane
+reg signed [COORD_BITS-1:0] src_y, src_x; // Temporary variables for coordinate calculation
+
+// Line buffer ports
+wire line_write;
+wire [SLOT_BITS-1:0] write_slot;
+wire [WORD_BITS-1:0] write_word;
+wire [LINE_WORD_WIDTH-1:0] line_q [0:LINE_ROWS-1]; // Registered read data of each row
+
+// Reader: fetches word read_word of window row read_y from every line buffer row
+reg [Y_BITS-1:0] read_y;
+reg [WORD_BITS-1:0] read_word;
+reg read_valid;                           // line_q holds the word fetched on the last edge
+reg [SLOT_BITS-1:0] read_slot [0:KERNEL_SIZE-1]; // Line buffer row of each window row
+reg [KERNEL_SIZE-1:0] read_zero;          // Window row outside the image (zero border)
+reg [CACHE_WORD_WIDTH-1:0] read_rows;     // line_q mapped to window rows
+
+// Window cache ring: head_word is the row word held at cache_head
+reg [CACHE_WORD_WIDTH-1:0] window_cache [0:CACHE_WORDS-1];
+reg [CACHE_BITS-1:0] cache_head;
+reg [CACHE_BITS:0] cache_count;
+reg [WORD_BITS-1:0] head_word;
+wire [CACHE_BITS-1:0] cache_tail = cache_head + cache_count;
+reg [CACHE_BITS-1:0] cache_entry;
+reg [CACHE_WORD_WIDTH-1:0] cache_word;
 
 // State machine
 reg [1:0] current_state, next_state;
 localparam IDLE = 2'b00, LOAD = 2'b01, PROCESS = 2'b10;
 
 // Loop variables
-integer i, j, k;
+integer i, j, p, r;
+
+// Reader and window scheduling (integers so that the border arithmetic stays signed)
+integer read_row, need_row, write_row, old_row;
+integer window_x, window_head, cached_words, last_column, need_word, next_x, next_head_word, freed_words;
+reg read_go;
+reg last_in_row;
+reg window_ready;
+wire output_hold = window_valid && window_stall && !frame_start; // Window not taken yet; frame_start drops it
+
+// Image coordinate that fills position coord of an axis of the given size; -1 for a zero fill.
+// Same rule as border_index() in reference_model/convolution.h.
+function signed [COORD_BITS-1:0] border_coord;
+    input signed [COORD_BITS-1:0] coord;
+    input integer size;
+    begin
+        if (coord >= 0 && coord < size)
+            border_coord = coord;
+        else if (BORDER_MODE == 1)
+            border_coord = (coord < 0) ? -coord : 2 * (size - 1) - coord;
+        else if (BORDER_MODE == 2)
+            border_coord = (coord < 0) ? 0 : size - 1;
+        else
+            border_coord = -1;
+    end
+endfunction
 
 // FSM state transitions
 always @(posedge clk or negedge rst_n) begin
-    if (!rst_n) 
+    if (!rst_n)
         current_state <= IDLE;
-    else 
+    else
         current_state <= next_state;
 end
 
 always @(*) begin
-    case (current_state)
-        IDLE:    next_state = frame_start ? LOAD : IDLE;
-        LOAD:    next_state = (y_pos >= KERNEL_SIZE-1) ? PROCESS : LOAD;
-        PROCESS: next_state = (y_window >= IMG_HEIGHT && x_window == 0) ? IDLE : PROCESS;
-        default: next_state = IDLE;
-    endcase
+    if (frame_start)
+        next_state = LOAD;
+    else begin
+        case (current_state)
+            IDLE:    next_state = IDLE;
+            LOAD:    next_state = (cache_count != 0) ? PROCESS : LOAD;
+            PROCESS: next_state = (y_window >= IMG_HEIGHT && x_window == 0) ? IDLE : PROCESS;
+            default: next_state = IDLE;
+        endcase
+    end
+end
+
+// The reader fetches a word once the last image row it needs holds it (reflected rows above the
+// image reach down to HALF - read_y). A beat of windows is emitted once the cache holds its
+// columns; the last beat of a row waits for the whole row so the words it frees have all arrived.
+always @(*) begin
+    read_row = read_y;
+    need_row = read_row + AFTER;
+    if (BORDER_MODE == 1 && HALF - read_row > need_row)
+        need_row = HALF - read_row;
+    if (need_row > IMG_HEIGHT - 1)
+        need_row = IMG_HEIGHT - 1;
+    read_go = current_state != IDLE && !frame_start && read_row < IMG_HEIGHT &&
+              (y_pos > need_row || (y_pos == need_row && write_word > read_word)) &&
+              cache_count + read_valid < CACHE_WORDS;
+
+    // A pixel beat overwrites word write_word of row y_pos - LINE_ROWS. The reader is done with that
+    // row once read_y is past row + HALF, or on the last read row touching it once past the word.
+    // While window_stall backs up the cache the reader stops, and so does the input. In IDLE beats
+    // are taken and dropped, so a frame that ends before its last rows never blocks the producer.
+    write_row = y_pos;
+    old_row = write_row - LINE_ROWS;
+    pixel_ready = !frame_start && (current_state == IDLE || old_row < 0 || read_row >= IMG_HEIGHT ||
+                  read_row > old_row + HALF || (read_row + STRIDE > old_row + HALF && write_word < read_word));
+
+    window_x = x_window;
+    window_head = head_word;
+    cached_words = cache_count;
+    last_in_row = window_x + WINDOW_STEP >= IMG_WIDTH;
+    last_column = window_x + (PIXELS_PER_CLOCK-1)*STRIDE + AFTER;
+    if (BORDER_MODE == 1 && HALF - window_x > last_column)
+        last_column = HALF - window_x;
+    if (last_column > IMG_WIDTH - 1)
+        last_column = IMG_WIDTH - 1;
+    need_word = last_in_row ? LINE_WORDS - 1 : last_column / PIXELS_PER_CLOCK;
+    window_ready = !output_hold && !frame_start && current_state == PROCESS && window_x < IMG_WIDTH && y_window < IMG_HEIGHT &&
+                   need_word - window_head < cached_words;
+
+    // Words left of the next beat's first column are no longer needed
+    next_x = last_in_row ? 0 : window_x + WINDOW_STEP;
+    next_head_word = (next_x > HALF) ? (next_x - HALF) / PIXELS_PER_CLOCK : 0;
+    if (next_head_word > last_column / PIXELS_PER_CLOCK + 1)
+        next_head_word = last_column / PIXELS_PER_CLOCK + 1;
+    if (!window_ready)
+        freed_words = 0;
+    else
+        freed_words = (last_in_row ? LINE_WORDS : next_head_word) - window_head;
 end
 
 // Input pixel position tracking
@@ -53,78 +184,144 @@ always @(posedge clk or negedge rst_n) begin
     if (!rst_n) begin
         x_pos <= 0;
         y_pos <= 0;
-    end else if (current_state == IDLE && frame_start) begin
+    end else if (frame_start) begin
         x_pos <= 0;
         y_pos <= 0;
-    end else if (pixel_valid && current_state != IDLE) begin
-        if (x_pos == IMG_WIDTH-1) begin
+    end else if (line_write) begin
+        if (x_pos == IMG_WIDTH-PIXELS_PER_CLOCK) begin
             x_pos <= 0;
             y_pos <= y_pos + 1;
         end else begin
-            x_pos <= x_pos + 1;
+            x_pos <= x_pos + PIXELS_PER_CLOCK;
         end
     end
 end
 
-// Line buffer management
+// Line buffer: one simple dual port block RAM per row, no reset and no clearing. Positions
+// outside the image are never read; the border comes from border_coord.
+assign line_write = pixel_valid && pixel_ready && current_state != IDLE;
+assign write_slot = y_pos % LINE_ROWS;
+assign write_word = x_pos / PIXELS_PER_CLOCK;
+
+genvar slot;
+generate
+    for (slot = 0; slot < LINE_ROWS; slot = slot + 1) begin : line_ram_gen
+        reg [LINE_WORD_WIDTH-1:0] ram [0:LINE_WORDS-1];
+        reg [LINE_WORD_WIDTH-1:0] q;
+        always @(posedge clk) begin
+            if (line_write && write_slot == slot)
+                ram[write_word] <= pixel_in;
+            if (read_go)
+                q <= ram[read_word]; // Read-first; the reader never reads the word being written
+        end
+        assign line_q[slot] = q;
+    end
+endgenerate
+
+// Reader position and the window row mapping of the word being fetched
 always @(posedge clk or negedge rst_n) begin
     if (!rst_n) begin
-        for (i = 0; i <= KERNEL_SIZE; i = i + 1)
-            for (j = 0; j < IMG_WIDTH + 2*PADDING; j = j + 1)
-                line_buffer[i][j] <= 0;
-    end else if (pixel_valid && current_state != IDLE) begin
-        if (x_pos == 0) begin
-            // Clear the line buffer row at the start of each new line
-            for (k = 0; k < IMG_WIDTH + 2*PADDING; k = k + 1)
-                line_buffer[y_pos % (KERNEL_SIZE + 1)][k] <= 0;
+        read_y <= 0;
+        read_word <= 0;
+        read_valid <= 0;
+        read_zero <= 0;
+        for (i = 0; i < KERNEL_SIZE; i = i + 1)
+            read_slot[i] <= 0;
+    end else if (frame_start) begin
+        read_y <= 0;
+        read_word <= 0;
+        read_valid <= 0;
+    end else begin
+        read_valid <= read_go;
+        if (read_go) begin
+            for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
+                src_y = border_coord(read_y + i - HALF, IMG_HEIGHT);
+                read_zero[i] <= (src_y < 0);
+                read_slot[i] <= (src_y < 0) ? 0 : src_y % LINE_ROWS;
+            end
+            if (read_word == LINE_WORDS - 1) begin
+                read_word <= 0;
+                read_y <= read_y + STRIDE;
+            end else begin
+                read_word <= read_word + 1;
+            end
         end
-        line_buffer[y_pos % (KERNEL_SIZE + 1)][x_pos + PADDING] <= pixel_in;
+    end
+end
+
+// Fetched word: window row r at [r*LINE_WORD_WIDTH +: LINE_WORD_WIDTH], zero outside the image
+always @(*) begin
+    for (r = 0; r < KERNEL_SIZE; r = r + 1)
+        read_rows[r*LINE_WORD_WIDTH +: LINE_WORD_WIDTH] = read_zero[r] ? {LINE_WORD_WIDTH{1'b0}} : line_q[read_slot[r]];
+end
+
+// Window cache: append the fetched word, drop the words the next beat no longer needs
+always @(posedge clk or negedge rst_n) begin
+    if (!rst_n) begin
+        cache_head <= 0;
+        cache_count <= 0;
+        head_word <= 0;
+    end else if (frame_start) begin
+        cache_head <= 0;
+        cache_count <= 0;
+        head_word <= 0;
+    end else begin
+        if (read_valid)
+            window_cache[cache_tail] <= read_rows;
+        cache_count <= cache_count + read_valid - freed_words;
+        cache_head <= cache_head + freed_words;
+        if (window_ready)
+            head_word <= next_head_word;
     end
 end
 
 // Window position tracking
 always @(posedge clk or negedge rst_n) begin
-    if (!rst_n || frame_start || (current_state == LOAD && next_state == PROCESS)) begin
+    if (!rst_n) begin
+        x_window <= 0;
+        y_window <= 0;
+    end else if (frame_start) begin
         x_window <= 0;
         y_window <= 0;
-    end else if (current_state == PROCESS && y_window < IMG_HEIGHT) begin
-        if (x_window + STRIDE >= IMG_WIDTH) begin
+    end else if (window_ready) begin
+        if (last_in_row) begin
             x_window <= 0;
             y_window <= y_window + STRIDE;
         end else begin
-            x_window <= x_window + STRIDE;
+            x_window <= next_x;
         end
     end
 end
 
-// Window generation and output
+// Window generation and output - columns outside the image are masked by border_coord
 always @(posedge clk or negedge rst_n) begin
     if (!rst_n) begin
         window_valid <= 0;
-        for (i = 0; i < KERNEL_SIZE; i = i + 1)
-            for (j = 0; j < KERNEL_SIZE; j = j + 1)
-                window_buffer[i][j] <= 0;
-    end else begin
+        window_lane_valid <= 0;
+        for (p = 0; p < PIXELS_PER_CLOCK; p = p + 1)
+            for (i = 0; i < KERNEL_SIZE; i = i + 1)
+                for (j = 0; j < KERNEL_SIZE; j = j + 1)
+                    window_buffer[p][i][j] <= 0;
+    end else if (!output_hold) begin
         window_valid <= 0; // Default
-        
-        if (current_state == PROCESS && 
-            x_window < IMG_WIDTH && 
-            y_window < IMG_HEIGHT && 
-            y_window + (KERNEL_SIZE>>1) <= y_pos) begin
-            
-            // Generate window
-            for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
+        window_lane_valid <= 0;
+
+        if (window_ready) begin
+            // Generate one window per lane, STRIDE columns apart
+            for (p = 0; p < PIXELS_PER_CLOCK; p = p + 1) begin
                 for (j = 0; j < KERNEL_SIZE; j = j + 1) begin
-                    src_y = y_window + i - (KERNEL_SIZE>>1);
-                    src_x = x_window + j - (KERNEL_SIZE>>1);
-                    
-                    if (src_y >= 0 && src_y < IMG_HEIGHT && 
-                        src_x >= 0 && src_x < IMG_WIDTH) begin
-                        window_buffer[i][j] <= line_buffer[src_y % (KERNEL_SIZE + 1)][src_x + PADDING];
-                    end else begin
-                        window_buffer[i][j] <= 0; // Padding
+                    src_x = border_coord(x_window + p*STRIDE + j - HALF, IMG_WIDTH);
+                    cache_entry = cache_head + src_x / PIXELS_PER_CLOCK - head_word;
+                    cache_word = window_cache[cache_entry];
+                    for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
+                        if (x_window + p*STRIDE < IMG_WIDTH && src_x >= 0) begin
+                            window_buffer[p][i][j] <= cache_word[(i*PIXELS_PER_CLOCK + src_x % PIXELS_PER_CLOCK)*DATA_WIDTH +: DATA_WIDTH];
+                        end else begin
+                            window_buffer[p][i][j] <= 0; // Padding
+                        end
                     end
                 end
+                window_lane_valid[p] <= (x_window + p*STRIDE < IMG_WIDTH);
             end
             window_valid <= 1;
         end
@@ -133,11 +330,13 @@ end
 
 // Flatten window buffer for output
 always @(*) begin
-    for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
-        for (j = 0; j < KERNEL_SIZE; j = j + 1) begin
-            window_out[(KERNEL_SIZE*KERNEL_SIZE-(i*KERNEL_SIZE+j))*DATA_WIDTH-1 -: DATA_WIDTH] = window_buffer[i][j];
+    for (p = 0; p < PIXELS_PER_CLOCK; p = p + 1) begin
+        for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
+            for (j = 0; j < KERNEL_SIZE; j = j + 1) begin
+                window_out[p*WINDOW_BITS + (KERNEL_SIZE*KERNEL_SIZE-(i*KERNEL_SIZE+j))*DATA_WIDTH-1 -: DATA_WIDTH] = window_buffer[p][i][j];
+            end
         end
     end
 end
 
-endmodule
\ No newline at end of file
+endmodule
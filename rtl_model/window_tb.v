@@ -2,13 +2,20 @@
 
 module window_tb();
 
-    // 测试用参数 - 使用小尺寸便于观察
+    // 测试用参数 - 宽高均超过 64, 覆盖行缓冲 RAM 与坐标位宽; 小尺寸时打印每个像素和窗口
     parameter DATA_WIDTH = 8;
-    parameter IMG_WIDTH = 32;
-    parameter IMG_HEIGHT = 32;
+    parameter IMG_WIDTH = 80;
+    parameter IMG_HEIGHT = 70;
     parameter KERNEL_SIZE = 3;
     parameter STRIDE = 1;
     parameter PADDING = (KERNEL_SIZE - 1) / 2;
+    parameter BORDER_MODE = 0;            // 0 zero, 1 reflect, 2 replicate
+    // 同一帧送入 NUM_BORDER_MODES 个实例, 实例 m 的边界模式为 (BORDER_MODE + m) % 3;
+    // 默认 3 个实例覆盖全部模式, 设为 1 时只测 BORDER_MODE
+    parameter NUM_BORDER_MODES = 3;
+    parameter VERBOSE = (IMG_WIDTH * IMG_HEIGHT <= 64);
+    // 超时按图像大小放宽: 每像素一拍, 加上最后几行的输出
+    localparam TIMEOUT_CYCLES = IMG_WIDTH * IMG_HEIGHT + 4 * IMG_WIDTH * KERNEL_SIZE + 200;
     
     // 测试信号
     reg clk;
@@ -17,26 +24,7 @@ module window_tb();
     reg pixel_valid;
     reg frame_start;
     
-    wire [KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH-1:0] window_out;
-    wire window_valid;
-    
-    // 实例化被测模块
-    window #(
-        .DATA_WIDTH(DATA_WIDTH),
-        .IMG_WIDTH(IMG_WIDTH),
-        .IMG_HEIGHT(IMG_HEIGHT),
-        .KERNEL_SIZE(KERNEL_SIZE),
-        .STRIDE(STRIDE),
-        .PADDING(PADDING)
-    ) dut (
-        .clk(clk),
-        .rst_n(rst_n),
-        .pixel_in(pixel_in),
-        .pixel_valid(pixel_valid),
-        .frame_start(frame_start),
-        .window_out(window_out),
-        .window_valid(window_valid)
-    );
+    localparam WINDOW_BITS = KERNEL_SIZE*KERNEL_SIZE*DATA_WIDTH;
     
     // 时钟生成
     initial begin
@@ -47,8 +35,11 @@ module window_tb();
     // 测试数据 - 5x5图像
     reg [DATA_WIDTH-1:0] test_image [0:IMG_HEIGHT-1][0:IMG_WIDTH-1];
     
-    // 窗口计数器
-    integer window_count = 0;
+    // 每个实例的窗口计数器
+    integer window_count [0:NUM_BORDER_MODES-1];
+    integer window_errors [0:NUM_BORDER_MODES-1];
+    integer expected_y [0:NUM_BORDER_MODES-1]; // centre of the next expected window
+    integer expected_x [0:NUM_BORDER_MODES-1];
     
     // 初始化测试图像
     
@@ -74,11 +65,126 @@ module window_tb();
         end
     endtask
     
+    // Expected pixel at (y, x) of the padded image, written independently of window.v
+    function [DATA_WIDTH-1:0] padded_pixel;
+        input integer mode;
+        input integer y;
+        input integer x;
+        integer sy, sx;
+        begin
+            sy = y;
+            sx = x;
+            if (mode == 1) begin
+                if (sy < 0) sy = -sy;
+                if (sy > IMG_HEIGHT - 1) sy = 2 * (IMG_HEIGHT - 1) - sy;
+                if (sx < 0) sx = -sx;
+                if (sx > IMG_WIDTH - 1) sx = 2 * (IMG_WIDTH - 1) - sx;
+            end else if (mode == 2) begin
+                if (sy < 0) sy = 0;
+                if (sy > IMG_HEIGHT - 1) sy = IMG_HEIGHT - 1;
+                if (sx < 0) sx = 0;
+                if (sx > IMG_WIDTH - 1) sx = IMG_WIDTH - 1;
+            end
+            if (sy < 0 || sy >= IMG_HEIGHT || sx < 0 || sx >= IMG_WIDTH)
+                padded_pixel = 0;
+            else
+                padded_pixel = test_image[sy][sx];
+        end
+    endfunction
+
+    // Compare instance m's window with the padded image around (expected_y[m], expected_x[m])
+    task check_window;
+        input integer m;
+        input integer mode;
+        input [WINDOW_BITS-1:0] window;
+        integer i, j;
+        reg [DATA_WIDTH-1:0] expected;
+        begin
+            for (i = 0; i < KERNEL_SIZE; i = i + 1) begin
+                for (j = 0; j < KERNEL_SIZE; j = j + 1) begin
+                    expected = padded_pixel(mode, expected_y[m] + i - KERNEL_SIZE / 2, expected_x[m] + j - KERNEL_SIZE / 2);
+                    if (window[(KERNEL_SIZE*KERNEL_SIZE-(i*KERNEL_SIZE+j))*DATA_WIDTH-1 -: DATA_WIDTH] !== expected) begin
+                        if (window_errors[m] < 10)
+                            $display("MISMATCH border mode %0d window (%0d,%0d) tap [%0d][%0d]: got %0d, expected %0d",
+                                     mode, expected_y[m], expected_x[m], i, j,
+                                     window[(KERNEL_SIZE*KERNEL_SIZE-(i*KERNEL_SIZE+j))*DATA_WIDTH-1 -: DATA_WIDTH], expected);
+                        window_errors[m] = window_errors[m] + 1;
+                    end
+                end
+            end
+            if (expected_x[m] + STRIDE >= IMG_WIDTH) begin
+                expected_x[m] = 0;
+                expected_y[m] = expected_y[m] + STRIDE;
+            end else begin
+                expected_x[m] = expected_x[m] + STRIDE;
+            end
+        end
+    endtask
+
+    // 被测实例: 同一输入, 每个实例一种边界模式
+    genvar g;
+    generate
+        for (g = 0; g < NUM_BORDER_MODES; g = g + 1) begin : border
+            localparam MODE = (BORDER_MODE + g) % 3;
+
+            wire [WINDOW_BITS-1:0] window_out;
+            wire window_valid;
+
+            window #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .IMG_WIDTH(IMG_WIDTH),
+                .IMG_HEIGHT(IMG_HEIGHT),
+                .KERNEL_SIZE(KERNEL_SIZE),
+                .STRIDE(STRIDE),
+                .PADDING(PADDING),
+                .BORDER_MODE(MODE)
+            ) dut (
+                .clk(clk),
+                .rst_n(rst_n),
+                .pixel_in(pixel_in),
+                .pixel_valid(pixel_valid),
+                .frame_start(frame_start),
+                .window_stall(1'b0),
+                .window_out(window_out),
+                .window_valid(window_valid)
+            );
+
+            initial begin
+                window_count[g] = 0;
+                window_errors[g] = 0;
+                expected_y[g] = 0;
+                expected_x[g] = 0;
+            end
+
+            // 窗口监控
+            always @(posedge clk) begin
+                if (window_valid) begin
+                    window_count[g] = window_count[g] + 1;
+                    check_window(g, MODE, window_out);
+                    if (VERBOSE && g == 0) begin
+                        $display("Window %0d: pos(%0d,%0d) at time %0t",
+                                 window_count[g], dut.x_window, dut.y_window, $time);
+
+                        // 显示窗口内容
+                        $write("Window content: ");
+                        $write("[%0d %0d %0d] ",
+                               window_out[71:64], window_out[63:56], window_out[55:48]);
+                        $write("[%0d %0d %0d] ",
+                               window_out[47:40], window_out[39:32], window_out[31:24]);
+                        $write("[%0d %0d %0d]",
+                               window_out[23:16], window_out[15:8], window_out[7:0]);
+                        $display("");
+                    end
+                end
+            end
+        end
+    endgenerate
+
     // 显示测试图像
     task display_test_image;
         integer i, j;
         begin
-            $display("\n=== 4x4 Test Image ===");
+            $display("\n=== %0dx%0d Test Image ===", IMG_WIDTH, IMG_HEIGHT);
             for(i = 0; i < IMG_HEIGHT; i = i + 1) begin
                 $write("Row %0d: ", i);
                 for(j = 0; j < IMG_WIDTH; j = j + 1) begin
@@ -94,9 +200,10 @@ module window_tb();
     task send_frame;
         integer i, j;
         begin
-            $display("Sending 4x4 frame...");
+            $display("Sending %0dx%0d frame...", IMG_WIDTH, IMG_HEIGHT);
             init_test_image();
-            display_test_image();
+            if (VERBOSE)
+                display_test_image();
             
             // 发送frame_start信号
             @(posedge clk);
@@ -110,7 +217,8 @@ module window_tb();
                     @(posedge clk);
                     pixel_in = test_image[i][j];
                     pixel_valid = 1;
-                    $display("Sending pixel[%0d][%0d] = %0d at time %0t", i, j, pixel_in, $time);
+                    if (VERBOSE)
+                        $display("Sending pixel[%0d][%0d] = %0d at time %0t", i, j, pixel_in, $time);
                 end
             end
             
@@ -121,6 +229,7 @@ module window_tb();
     endtask
     
     // 主测试序列
+    integer i, m, done, failed;
     initial begin
         $display("========================================");
         $display("Window Test - Focus on Last Window");
@@ -143,53 +252,50 @@ module window_tb();
         // 发送测试帧
         send_frame();
         
-        // 等待所有窗口输出
-        repeat(50) @(posedge clk);
+        // 等待所有实例输出全部窗口 (最后一行窗口在最后一个像素之后约一行输出)
+        i = 0;
+        done = 0;
+        while (!done && i < 4 * IMG_WIDTH * KERNEL_SIZE) begin
+            @(posedge clk);
+            i = i + 1;
+            done = 1;
+            for (m = 0; m < NUM_BORDER_MODES; m = m + 1)
+                if (window_count[m] < IMG_WIDTH * IMG_HEIGHT)
+                    done = 0;
+        end
+        repeat(10) @(posedge clk);
         
         $display("\n========================================");
         $display("Test Summary:");
-        $display("Total Windows Generated: %0d", window_count);
         $display("Expected Windows: %0d", IMG_WIDTH * IMG_HEIGHT);
-        if(window_count == IMG_WIDTH * IMG_HEIGHT) begin
+        failed = 0;
+        for (m = 0; m < NUM_BORDER_MODES; m = m + 1) begin
+            $display("Border mode %0d: %0d windows generated, %0d window value mismatches",
+                     (BORDER_MODE + m) % 3, window_count[m], window_errors[m]);
+            if (window_count[m] != IMG_WIDTH * IMG_HEIGHT || window_errors[m] != 0)
+                failed = 1;
+        end
+        if(!failed) begin
             $display("SUCCESS: All windows generated!");
         end else begin
-            $display("FAILURE: Missing windows!");
+            $display("FAILURE: Missing or wrong windows!");
         end
         $display("========================================");
         
         $finish;
     end
     
-    // 窗口监控
-    always @(posedge clk) begin
-        if(window_valid) begin
-            window_count = window_count + 1;
-            $display("Window %0d: pos(%0d,%0d) at time %0t", 
-                     window_count, dut.x_window, dut.y_window, $time);
-            
-            // 显示窗口内容
-            $write("Window content: ");
-            $write("[%0d %0d %0d] ", 
-                   window_out[71:64], window_out[63:56], window_out[55:48]);
-            $write("[%0d %0d %0d] ", 
-                   window_out[47:40], window_out[39:32], window_out[31:24]);
-            $write("[%0d %0d %0d]", 
-                   window_out[23:16], window_out[15:8], window_out[7:0]);
-            $display("");
-        end
-    end
-    
     // 状态机监控
     reg [1:0] prev_state = 2'b00;
     always @(posedge clk) begin
-        if(dut.current_state != prev_state) begin
-            case(dut.current_state)
+        if(border[0].dut.current_state != prev_state) begin
+            case(border[0].dut.current_state)
                 2'b00: $display("Time %0t: State -> IDLE", $time);
                 2'b01: $display("Time %0t: State -> LOAD", $time);
                 2'b10: $display("Time %0t: State -> PROCESS", $time);
-                default: $display("Time %0t: State -> UNKNOWN(%0d)", $time, dut.current_state);
+                default: $display("Time %0t: State -> UNKNOWN(%0d)", $time, border[0].dut.current_state);
             endcase
-            prev_state = dut.current_state;
+            prev_state = border[0].dut.current_state;
         end
     end
     
@@ -200,7 +306,7 @@ module window_tb();
         $dumpvars(0, window_tb);
         
         // 限制仿真时间
-        #2000;
+        #(TIMEOUT_CYCLES * 10);
         $display("ERROR: Simulation timeout!");
         $finish;
     end